@@ -1,11 +1,23 @@
-struct VertexInput {
-  @location(0) position: vec2f,
-  @location(1) tex_coords: vec2f,
+struct InstanceInput {
+  @builtin(vertex_index) vertex_index: u32,
+  // transform, texture and quad index
+  @location(0) indices: vec3u,
+  @location(1) opacity: f32,
+  @location(2) parallax: vec2f,
+  // animation (0 for none) and when it started, then how fast it's going
+  @location(3) animation: vec2u,
+  @location(4) animation_speed: f32,
 }
 
 struct VertexOutput {
   @builtin(position) position: vec4f,
   @location(0) tex_coords: vec2f,
+  @location(1) @interpolate(flat) texture_index: u32,
+}
+
+struct Vertex {
+  position: vec2f,
+  tex_coords: vec2f,
 }
 
 @group(0) @binding(0)
@@ -14,24 +26,90 @@ var<storage> transforms: array<mat4x4f>;
 var textures: binding_array<texture_2d<f32>>;
 @group(0) @binding(2)
 var tex_sampler: sampler;
+@group(0) @binding(3)
+var<storage> quads: array<Vertex>;
+
+// see sprite_animations.h
+struct SpriteAnimation {
+  first: u32,
+  count: u32,
+  cell_size: vec2u,
+  duration: u32,
+  looping: u32,
+}
+
+@group(0) @binding(4)
+var<storage> animations: array<SpriteAnimation>;
+// (cell, when the frame ends)
+@group(0) @binding(5)
+var<storage> animation_frames: array<vec2u>;
 
 struct PushConstants {
   camera: mat4x4f,
-  transform_index: u32,
-  texture_index: i32,
+  camera_position: vec2f,
+  time: u32,
 }
 
 var<push_constant> push_constants: PushConstants;
 
+// which corner of the quad each vertex is (same as the old index buffer)
+const QUAD_CORNERS = array<u32, 6>(0u, 1u, 2u, 0u, 2u, 3u);
+
+// same as animation_frame_at
+fn animation_cell(animation: SpriteAnimation, time: u32) -> u32 {
+    var elapsed = time;
+    if animation.looping != 0u && animation.duration > 0u {
+        elapsed = elapsed % animation.duration;
+    }
+    for (var i = 0u; i < animation.count; i++) {
+        let frame = animation_frames[animation.first + i];
+        if elapsed < frame.y {
+            return frame.x;
+        }
+    }
+    return animation_frames[animation.first + animation.count - 1u].x;
+}
+
+// same as tex_coords_for. `unit` goes from 0 to 1 across the cell
+fn animated_tex_coords(in: InstanceInput, unit: vec2f) -> vec2f {
+    let animation = animations[in.animation.x - 1u];
+    // an animation can start after the time pushed for this frame (if it was
+    // set mid-frame, or the timer was reset), which would wrap around
+    let elapsed = select(0u, push_constants.time - in.animation.y,
+                         push_constants.time >= in.animation.y);
+    let since = f32(elapsed) * in.animation_speed;
+    let cell = animation_cell(animation, u32(since));
+
+    let tex_size = textureDimensions(textures[in.indices.y]);
+    let unwrapped_x = cell * animation.cell_size.x;
+    let cell_min = vec2u(
+        unwrapped_x % tex_size.x,
+        (unwrapped_x / tex_size.x) * animation.cell_size.y
+    );
+    let cell_max = cell_min + animation.cell_size;
+    return mix(vec2f(cell_min), vec2f(cell_max), unit) / vec2f(tex_size);
+}
+
 @vertex
-fn vs_main(in: VertexInput) -> VertexOutput {
+fn vs_main(in: InstanceInput) -> VertexOutput {
     var out: VertexOutput;
 
-    let transform = transforms[push_constants.transform_index];
-    let world_position = transform * vec4f(in.position, 0.0, 1.0);
+    var corners = QUAD_CORNERS;
+    let vertex = quads[in.indices.z * 4u + corners[in.vertex_index]];
+
+    let transform = transforms[in.indices.x];
+    var world_position = transform * vec4f(vertex.position, 0.0, 1.0);
+    // moving the sprite along with the camera is the same as moving the camera
+    // less for this sprite
+    let parallax_offset = push_constants.camera_position * (1.0 - in.parallax);
+    world_position = vec4f(world_position.xy + parallax_offset, world_position.zw);
     out.position = push_constants.camera * world_position;
 
-    out.tex_coords = in.tex_coords;
+    out.tex_coords = vertex.tex_coords;
+    if in.animation.x != 0u {
+        out.tex_coords = animated_tex_coords(in, vertex.tex_coords);
+    }
+    out.texture_index = in.indices.y;
 
     return out;
 }
@@ -43,7 +121,7 @@ struct FragmentOutput {
 @fragment
 fn fs_main(in: VertexOutput) -> FragmentOutput {
     var out: FragmentOutput;
-    let texture = textures[push_constants.texture_index];
+    let texture = textures[in.texture_index];
     let color = textureSample(texture, tex_sampler, in.tex_coords);
 
     if color.a < 0.1 {
@@ -52,4 +130,4 @@ fn fs_main(in: VertexOutput) -> FragmentOutput {
     out.color = color;
 
     return out;
-}
\ No newline at end of file
+}
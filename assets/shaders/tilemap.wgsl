@@ -1,7 +1,7 @@
 struct VertexInput {
-  @location(0) tile_id: i32,
+  // packed, see tilemap_chunks.h
+  @location(0) tile: u32,
   @builtin(vertex_index) vertex_index: u32,
-  @builtin(instance_index) instance_index: u32,
 }
 
 struct VertexOutput {
@@ -16,66 +16,95 @@ var textures: binding_array<texture_2d<f32>>;
 @group(0) @binding(2)
 var tex_sampler: sampler;
 
+// where each tile is in the tileset, as (min, max)
+@group(1) @binding(0)
+var<storage> tile_uvs: array<vec4f>;
+// see tilemap_animations.h. per tile (first frame, frame count, duration, _),
+// and per frame (tile, duration)
+@group(1) @binding(1)
+var<storage> tile_animations: array<vec4u>;
+@group(1) @binding(2)
+var<storage> animation_frames: array<vec2u>;
+
 struct PushConstants {
   camera: mat4x4f,
   transform_index: u32,
   texture_index: i32,
-  map_width: u32,
+  // in tiles
+  chunk_origin: vec2u,
+  // in milliseconds
+  time: u32,
 }
 
 var<push_constant> push_constants: PushConstants;
 
-const VERTEX_POSITIONS = array<vec2f, 6>(
+const CORNERS = array<vec2f, 6>(
     vec2f(0.0, 0.0),
-    vec2f(8.0, 0.0),
-    vec2f(0.0, 8.0),
-    vec2f(8.0, 0.0),
-    vec2f(0.0, 8.0),
-    vec2f(8.0, 8.0),
-);
-const TEX_COORDS = array<vec2f, 6>(
-    // slightly smaller than 8x8 to reduce bleeding from adjacent pixels
-    vec2f(0.01, 0.01),
-    vec2f(7.99, 0.01),
-    vec2f(0.01, 7.99),
-    vec2f(7.99, 0.01),
-    vec2f(0.01, 7.99),
-    vec2f(7.99, 7.99),
+    vec2f(1.0, 0.0),
+    vec2f(0.0, 1.0),
+    vec2f(1.0, 0.0),
+    vec2f(0.0, 1.0),
+    vec2f(1.0, 1.0),
 );
 
+const FLIP_HORIZONTAL = 1u;
+const FLIP_VERTICAL = 2u;
+const FLIP_DIAGONAL = 4u;
+
+// same as tilemap_animations_frame
+fn animated_tile(tile_id: u32) -> u32 {
+    if tile_id >= arrayLength(&tile_animations) {
+        return tile_id;
+    }
+    let animation = tile_animations[tile_id];
+    if animation.y == 0u {
+        return tile_id;
+    }
+
+    var elapsed = push_constants.time % animation.z;
+    for (var i = 0u; i < animation.y; i++) {
+        let frame = animation_frames[animation.x + i];
+        if elapsed < frame.y {
+            return frame.x;
+        }
+        elapsed -= frame.y;
+    }
+    return tile_id;
+}
+
 @vertex
 fn vs_main(input: VertexInput) -> VertexOutput {
     var output: VertexOutput;
 
-    if input.tile_id == -1 {
-        return output;
-    }
-    let tile_id = u32(input.tile_id);
+    let tile_id = animated_tile(input.tile & 0xFFFFu);
+    let flips = (input.tile >> 16u) & 0x7u;
+    let local = vec2u((input.tile >> 19u) & 0x1Fu, (input.tile >> 24u) & 0x1Fu);
 
-    let tile_position = vec2f(
-        f32(input.instance_index % push_constants.map_width),
-        f32(input.instance_index / push_constants.map_width)
-    );
-    var vertex_positions = VERTEX_POSITIONS;
-    let vertex_position = vertex_positions[input.vertex_index] + (tile_position * 8.0);
+    var corners = CORNERS;
+    let corner = corners[input.vertex_index];
+    let tile_position = vec2f(push_constants.chunk_origin + local);
+    let vertex_position = (corner + tile_position) * 8.0;
 
     let transform = transforms[push_constants.transform_index];
     let world_position = transform * vec4f(vertex_position, 0.0, 1.0);
 
     output.position = push_constants.camera * world_position;
 
-    let tileset = textures[push_constants.texture_index];
-
-    var vertex_tex_coords = TEX_COORDS;
-    let tex_size = textureDimensions(tileset);
-    let tileset_width = tex_size.x / 8;
+    // same as Tiled: the diagonal flip happens first
+    var uv_corner = corner;
+    if (flips & FLIP_DIAGONAL) != 0u {
+        uv_corner = uv_corner.yx;
+    }
+    if (flips & FLIP_HORIZONTAL) != 0u {
+        uv_corner.x = 1.0 - uv_corner.x;
+    }
+    if (flips & FLIP_VERTICAL) != 0u {
+        uv_corner.y = 1.0 - uv_corner.y;
+    }
 
-    let vertex_tex_coord = vertex_tex_coords[input.vertex_index];
-    let tex_offset = vec2f(
-        f32(tile_id % tileset_width),
-        f32(tile_id / tileset_width)
-    ) * 8.0;
-    output.tex_coords = (vertex_tex_coord + tex_offset) / vec2f(tex_size);
+    // tiles past the end of the tileset just get the last one
+    let uv = tile_uvs[min(tile_id, arrayLength(&tile_uvs) - 1u)];
+    output.tex_coords = mix(uv.xy, uv.zw, uv_corner);
 
     return output;
 }
@@ -1,12 +1,22 @@
-struct VertexInput {
+struct InstanceInput {
   @builtin(vertex_index) vertex_index: u32,
-  @location(0) position: vec2f,
-  @location(1) tex_coords: vec2f,
+  // transform, texture and quad index
+  @location(0) indices: vec3u,
+  @location(1) opacity: f32,
+  // always 1 for ui sprites
+  @location(2) parallax: vec2f,
 }
 
 struct VertexOutput {
   @builtin(position) position: vec4f,
   @location(0) tex_coords: vec2f,
+  @location(1) @interpolate(flat) texture_index: u32,
+  @location(2) opacity: f32,
+}
+
+struct Vertex {
+  position: vec2f,
+  tex_coords: vec2f,
 }
 
 @group(0) @binding(0)
@@ -15,38 +25,45 @@ var<storage> transforms: array<mat4x4f>;
 var textures: binding_array<texture_2d<f32>>;
 @group(0) @binding(2)
 var tex_sampler: sampler;
+@group(0) @binding(3)
+var<storage> quads: array<Vertex>;
 
 struct PushConstants {
   camera: mat4x4f,
-  transform_index: u32,
-  texture_index: i32,
-
-  opacity: f32,
+  camera_position: vec2f,
 }
 
 var<push_constant> push_constants: PushConstants;
 
+// which corner of the quad each vertex is (same as the old index buffer)
+const QUAD_CORNERS = array<u32, 6>(0u, 1u, 2u, 0u, 2u, 3u);
+
 @vertex
-fn vs_main(in: VertexInput) -> VertexOutput {
+fn vs_main(in: InstanceInput) -> VertexOutput {
     var out: VertexOutput;
 
-    let transform = transforms[push_constants.transform_index];
-    let world_position = transform * vec4f(in.position, 0.0, 1.0);
+    var corners = QUAD_CORNERS;
+    let vertex = quads[in.indices.z * 4u + corners[in.vertex_index]];
+
+    let transform = transforms[in.indices.x];
+    let world_position = transform * vec4f(vertex.position, 0.0, 1.0);
 
     out.position = push_constants.camera * world_position;
-    out.tex_coords = in.tex_coords;
+    out.tex_coords = vertex.tex_coords;
+    out.texture_index = in.indices.y;
+    out.opacity = in.opacity;
     return out;
 }
 
 @fragment
 fn fs_main(in: VertexOutput) -> @location(0) vec4f {
-    let texture = textures[push_constants.texture_index];
+    let texture = textures[in.texture_index];
     let raw_color = textureSample(texture, tex_sampler, in.tex_coords);
-    let color = vec4(raw_color.rgb, raw_color.a * push_constants.opacity);
+    let color = vec4(raw_color.rgb, raw_color.a * in.opacity);
 
     if color.a < 0.1 {
       discard;
     }
 
     return color;
-}
\ No newline at end of file
+}
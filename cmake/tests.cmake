@@ -7,3 +7,387 @@ add_test(NAME vec_test         COMMAND $<TARGET_FILE:vec_test>)
 add_test(NAME linked_list_test COMMAND $<TARGET_FILE:linked_list_test>)
 add_test(NAME hashset_test     COMMAND $<TARGET_FILE:hashset_test>)
 add_test(NAME hashmap_test     COMMAND $<TARGET_FILE:hashmap_test>)
+
+# compares the vm against the aot translated scripts (see cmake/tools.cmake)
+add_executable(event_aot_test
+    tests/event_aot_test.c
+    tests/fake_commands.c
+    ${EVENT_AOT_OUTPUT}
+    src/events/lexer.c
+    src/events/keywords.c
+    src/events/compiler.c
+    src/events/instruction.c
+    src/events/typecheck.c
+    src/events/event.c
+    src/events/text_runs.c
+    src/events/globals.c
+    src/events/vm.c
+    src/events/profiler.c
+    src/events/vm_pool.c
+    src/events/aot.c
+    src/events/commands/command.c
+    src/utility/vec.c
+    src/utility/hashmap.c
+    src/utility/intern.c
+    src/utility/log.c
+    src/utility/time.cpp
+)
+target_link_libraries(event_aot_test SDL3::Headers SDL3_ttf::SDL3_ttf cglm box2d)
+add_test(NAME event_aot_test
+         COMMAND $<TARGET_FILE:event_aot_test>
+         WORKING_DIRECTORY ${CMAKE_SOURCE_DIR})
+
+# runs thousands of sleeping scripts through the scheduler
+add_executable(scheduler_test
+    tests/scheduler_test.c
+    tests/fake_commands.c
+    src/events/lexer.c
+    src/events/keywords.c
+    src/events/compiler.c
+    src/events/instruction.c
+    src/events/typecheck.c
+    src/events/event.c
+    src/events/text_runs.c
+    src/events/globals.c
+    src/events/vm.c
+    src/events/profiler.c
+    src/events/scheduler.c
+    src/events/vm_pool.c
+    src/events/commands/command.c
+    src/utility/vec.c
+    src/utility/hashmap.c
+    src/utility/intern.c
+    src/utility/log.c
+    src/utility/time.cpp
+)
+target_link_libraries(scheduler_test SDL3::Headers SDL3_ttf::SDL3_ttf cglm box2d)
+add_test(NAME scheduler_test COMMAND $<TARGET_FILE:scheduler_test>)
+
+# checks the compiled bytecode, and benchmarks the vm
+add_executable(bytecode_test
+    tests/bytecode_test.c
+    tests/fake_commands.c
+    src/events/lexer.c
+    src/events/keywords.c
+    src/events/compiler.c
+    src/events/instruction.c
+    src/events/typecheck.c
+    src/events/event.c
+    src/events/text_runs.c
+    src/events/globals.c
+    src/events/vm.c
+    src/events/profiler.c
+    src/events/vm_pool.c
+    src/events/commands/command.c
+    src/utility/vec.c
+    src/utility/hashmap.c
+    src/utility/intern.c
+    src/utility/log.c
+    src/utility/time.cpp
+)
+target_link_libraries(bytecode_test SDL3::Headers SDL3_ttf::SDL3_ttf cglm box2d)
+add_test(NAME bytecode_test
+         COMMAND $<TARGET_FILE:bytecode_test>
+         WORKING_DIRECTORY ${CMAKE_SOURCE_DIR})
+
+# checks the lexer/compiler front end, and benchmarks compiling a big script
+add_executable(compiler_test
+    tests/compiler_test.c
+    src/events/lexer.c
+    src/events/keywords.c
+    src/events/compiler.c
+    src/events/instruction.c
+    src/events/typecheck.c
+    src/events/event.c
+    src/events/text_runs.c
+    src/events/globals.c
+    src/events/commands/command.c
+    src/utility/vec.c
+    src/utility/hashmap.c
+    src/utility/intern.c
+)
+target_link_libraries(compiler_test SDL3::Headers SDL3_ttf::SDL3_ttf cglm box2d)
+add_test(NAME compiler_test COMMAND $<TARGET_FILE:compiler_test>)
+
+# checks lazily compiled events, and measures startup with lots of scripts
+add_executable(event_index_test
+    tests/event_index_test.c
+    tests/fake_commands.c
+    src/events/event_index.c
+    src/events/aot.c
+    src/events/lexer.c
+    src/events/keywords.c
+    src/events/compiler.c
+    src/events/instruction.c
+    src/events/typecheck.c
+    src/events/event.c
+    src/events/text_runs.c
+    src/events/globals.c
+    src/events/vm.c
+    src/events/profiler.c
+    src/events/scheduler.c
+    src/events/vm_pool.c
+    src/events/commands/command.c
+    src/utility/files.c
+    src/utility/vec.c
+    src/utility/hashmap.c
+    src/utility/intern.c
+    src/utility/log.c
+    src/utility/time.cpp
+)
+# needs the full SDL library for threads
+target_link_libraries(event_index_test SDL3::SDL3 SDL3::Headers SDL3_ttf::SDL3_ttf cglm box2d)
+add_test(NAME event_index_test COMMAND $<TARGET_FILE:event_index_test>)
+
+# checks what the script profiler counts, and how much it costs
+add_executable(profiler_test
+    tests/profiler_test.c
+    tests/fake_commands.c
+    src/events/lexer.c
+    src/events/keywords.c
+    src/events/compiler.c
+    src/events/instruction.c
+    src/events/typecheck.c
+    src/events/event.c
+    src/events/text_runs.c
+    src/events/globals.c
+    src/events/vm.c
+    src/events/profiler.c
+    src/events/scheduler.c
+    src/events/vm_pool.c
+    src/events/commands/command.c
+    src/utility/vec.c
+    src/utility/hashmap.c
+    src/utility/intern.c
+    src/utility/log.c
+    src/utility/time.cpp
+)
+target_link_libraries(profiler_test SDL3::Headers SDL3_ttf::SDL3_ttf cglm box2d)
+add_test(NAME profiler_test COMMAND $<TARGET_FILE:profiler_test>)
+
+# checks global script variables, and measures flag-heavy scripts
+add_executable(globals_test
+    tests/globals_test.c
+    tests/fake_commands.c
+    src/events/lexer.c
+    src/events/keywords.c
+    src/events/compiler.c
+    src/events/instruction.c
+    src/events/typecheck.c
+    src/events/event.c
+    src/events/text_runs.c
+    src/events/globals.c
+    src/events/vm.c
+    src/events/profiler.c
+    src/events/vm_pool.c
+    src/events/commands/command.c
+    src/utility/vec.c
+    src/utility/hashmap.c
+    src/utility/intern.c
+    src/utility/log.c
+    src/utility/time.cpp
+)
+target_link_libraries(globals_test SDL3::Headers SDL3_ttf::SDL3_ttf cglm box2d)
+add_test(NAME globals_test COMMAND $<TARGET_FILE:globals_test>)
+
+# checks textbox escape codes get split up when events are compiled
+add_executable(text_runs_test
+    tests/text_runs_test.c
+    src/events/lexer.c
+    src/events/keywords.c
+    src/events/compiler.c
+    src/events/instruction.c
+    src/events/typecheck.c
+    src/events/event.c
+    src/events/text_runs.c
+    src/events/globals.c
+    src/events/commands/command.c
+    src/utility/vec.c
+    src/utility/hashmap.c
+    src/utility/intern.c
+)
+target_link_libraries(text_runs_test SDL3::Headers SDL3_ttf::SDL3_ttf cglm box2d)
+add_test(NAME text_runs_test COMMAND $<TARGET_FILE:text_runs_test>)
+
+# checks bind groups aren't rebuilt on frames where nothing changed
+add_executable(bind_group_cache_test
+    tests/bind_group_cache_test.c
+    tests/fake_wgpu.c
+    src/graphics/bind_group_cache.c
+    src/graphics/tex_manager.c
+    src/graphics/tex_loader.c
+    src/graphics/atlas.c
+    src/graphics/quad_manager.c
+    src/graphics/transform_manager.c
+    src/core_types.c
+    src/utility/hashmap.c
+    src/utility/hashset.c
+    src/utility/log.c
+    src/utility/vec.c
+)
+# needs the full SDL library for the texture loader's threads
+target_link_libraries(bind_group_cache_test SDL3::SDL3 SDL3::Headers SDL3_image::SDL3_image cglm)
+add_test(NAME bind_group_cache_test COMMAND $<TARGET_FILE:bind_group_cache_test>)
+
+# checks sprite layers are drawn with one instanced draw call each
+add_executable(sprite_batch_test
+    tests/sprite_batch_test.c
+    tests/fake_wgpu.c
+    src/graphics/sprite_batch.c
+    src/graphics/layer.c
+    src/graphics/culling.c
+    src/graphics/transform_manager.c
+    src/graphics/quad_manager.c
+    src/graphics/render_state.c
+    src/core_types.c
+    src/utility/hashmap.c
+    src/utility/hashset.c
+    src/utility/vec.c
+)
+target_link_libraries(sprite_batch_test SDL3::Headers cglm)
+add_test(NAME sprite_batch_test COMMAND $<TARGET_FILE:sprite_batch_test>)
+
+# checks the render queue sorts draws by key and redundant state gets skipped
+add_executable(render_queue_test
+    tests/render_queue_test.c
+    tests/fake_wgpu.c
+    src/graphics/render_queue.c
+    src/graphics/render_state.c
+    src/utility/vec.c
+)
+target_link_libraries(render_queue_test SDL3::Headers)
+add_test(NAME render_queue_test COMMAND $<TARGET_FILE:render_queue_test>)
+
+# checks culled layers only batch what's on screen, and benchmarks a map full
+# of off screen props
+add_executable(culling_test
+    tests/culling_test.c
+    tests/fake_wgpu.c
+    src/graphics/culling.c
+    src/graphics/layer.c
+    src/graphics/transform_manager.c
+    src/graphics/quad_manager.c
+    src/core_types.c
+    src/utility/hashmap.c
+    src/utility/hashset.c
+    src/utility/vec.c
+)
+target_link_libraries(culling_test SDL3::Headers cglm)
+add_test(NAME culling_test COMMAND $<TARGET_FILE:culling_test>)
+
+# checks tilemaps only draw the non-empty tiles in chunks that are on screen
+add_executable(tilemap_chunks_test
+    tests/tilemap_chunks_test.c
+    src/graphics/tilemap_chunks.c
+    src/core_types.c
+    src/utility/vec.c
+)
+target_link_libraries(tilemap_chunks_test SDL3::Headers cglm)
+add_test(NAME tilemap_chunks_test COMMAND $<TARGET_FILE:tilemap_chunks_test>)
+
+# checks animated tiles pick the same frames the tilemap shader does
+add_executable(tilemap_animations_test
+    tests/tilemap_animations_test.c
+    src/graphics/tilemap_animations.c
+    src/utility/log.c
+    src/utility/vec.c
+)
+target_link_libraries(tilemap_animations_test SDL3::Headers cglm)
+add_test(NAME tilemap_animations_test COMMAND $<TARGET_FILE:tilemap_animations_test>)
+
+# checks sprites animated on the gpu land on the same frames as the cpu's
+# timing, and compares 5000 animated characters against updating their quads
+add_executable(sprite_animation_test
+    tests/sprite_animation_test.c
+    tests/fake_wgpu.c
+    src/animation/definition.c
+    src/graphics/binding_helper.c
+    src/graphics/sprite_animations.c
+    src/graphics/quad_manager.c
+    src/core_types.c
+    src/utility/hashmap.c
+    src/utility/hashset.c
+    src/utility/vec.c
+)
+target_link_libraries(sprite_animation_test SDL3::Headers cglm)
+add_test(NAME sprite_animation_test COMMAND $<TARGET_FILE:sprite_animation_test>)
+
+# checks compiled animation tables, catching up after hitches and loading
+# animations from ini files, and compares updating 5000 animations in one pass
+# against stepping each one along
+add_executable(animation_test
+    tests/animation_test.c
+    tests/fake_wgpu.c
+    src/animation/animations.c
+    src/animation/definition.c
+    src/animation/loader.c
+    src/parsers/ini.c
+    src/graphics/quad_manager.c
+    src/core_types.c
+    src/utility/files.c
+    src/utility/hashmap.c
+    src/utility/hashset.c
+    src/utility/linked_list.c
+    src/utility/vec.c
+)
+# needs the full SDL library for loading files
+target_link_libraries(animation_test SDL3::SDL3 SDL3::Headers cglm)
+add_test(NAME animation_test COMMAND $<TARGET_FILE:animation_test>)
+
+# checks streamed tilemaps upload the right chunks within budget, and walks a
+# camera across a generated 8192x8192 map
+add_executable(tilemap_stream_test
+    tests/tilemap_stream_test.c
+    tests/fake_wgpu.c
+    src/graphics/tilemap_stream.c
+    src/graphics/tilemap_chunks.c
+    src/core_types.c
+    src/utility/log.c
+    src/utility/vec.c
+)
+target_link_libraries(tilemap_stream_test SDL3::Headers cglm)
+add_test(NAME tilemap_stream_test COMMAND $<TARGET_FILE:tilemap_stream_test>)
+
+# checks the atlas packer never overlaps or loses space, and packs a game's
+# worth of icons and labels into pages
+add_executable(atlas_test
+    tests/atlas_test.c
+    src/graphics/atlas.c
+    src/utility/vec.c
+)
+target_link_libraries(atlas_test SDL3::Headers cglm)
+add_test(NAME atlas_test COMMAND $<TARGET_FILE:atlas_test>)
+
+# checks unused textures get cached and evicted least recently used first, and
+# goes back and forth between two maps with and without the cache
+add_executable(texture_cache_test
+    tests/texture_cache_test.c
+    tests/fake_wgpu.c
+    src/graphics/tex_manager.c
+    src/graphics/tex_loader.c
+    src/graphics/atlas.c
+    src/core_types.c
+    src/utility/hashmap.c
+    src/utility/log.c
+    src/utility/vec.c
+)
+# needs the full SDL library and SDL_image for writing and decoding pngs
+target_link_libraries(texture_cache_test SDL3::SDL3 SDL3::Headers SDL3_image::SDL3_image cglm)
+add_test(NAME texture_cache_test COMMAND $<TARGET_FILE:texture_cache_test>)
+
+# checks async texture loads stand in with the placeholder until they're
+# uploaded, and measures loading a texture heavy map with and without them
+add_executable(texture_loader_test
+    tests/texture_loader_test.c
+    tests/fake_wgpu.c
+    src/graphics/tex_manager.c
+    src/graphics/tex_loader.c
+    src/graphics/atlas.c
+    src/core_types.c
+    src/utility/hashmap.c
+    src/utility/log.c
+    src/utility/vec.c
+)
+# needs the full SDL library and SDL_image for threads and decoding pngs
+target_link_libraries(texture_loader_test SDL3::SDL3 SDL3::Headers SDL3_image::SDL3_image cglm)
+add_test(NAME texture_loader_test COMMAND $<TARGET_FILE:texture_loader_test>)
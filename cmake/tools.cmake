@@ -0,0 +1,35 @@
+# event_aot translates the shipped event scripts into C at build time.
+# see src/events/aot.h
+set(EVENT_SCRIPTS
+    assets/events.txt
+)
+set(EVENT_AOT_OUTPUT ${CMAKE_BINARY_DIR}/generated/event_aot.c)
+
+add_executable(event_aot
+    tools/event_aot.c
+    src/events/lexer.c
+    src/events/keywords.c
+    src/events/compiler.c
+    src/events/instruction.c
+    src/events/typecheck.c
+    src/events/event.c
+    src/events/text_runs.c
+    src/events/globals.c
+    src/events/commands/command.c
+    src/utility/vec.c
+    src/utility/hashmap.c
+    src/utility/intern.c
+)
+# the event headers pull in resources.h, so we need everything it includes
+target_link_libraries(event_aot SDL3::Headers SDL3_ttf::SDL3_ttf cglm box2d)
+
+add_custom_command(
+    OUTPUT ${EVENT_AOT_OUTPUT}
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${CMAKE_BINARY_DIR}/generated
+    COMMAND event_aot ${EVENT_AOT_OUTPUT} ${EVENT_SCRIPTS}
+    # script paths are recorded relative to the working directory, and have
+    # to match the paths the game loads them from
+    WORKING_DIRECTORY ${CMAKE_SOURCE_DIR}
+    DEPENDS event_aot ${EVENT_SCRIPTS}
+    COMMENT "Translating event scripts to C"
+)
@@ -3,81 +3,72 @@
 #include "core_types.h"
 #include "fmod_studio.h"
 #include "graphics/tex_manager.h"
-#include "time/time.h"
 #include "utility/macros.h"
 #include "webgpu.h"
 
-void animation_init(Animation *animation, AnimationType type)
+static u32 now(Resources *resources)
 {
-    animation->def = ANIMATIONS[type];
-    animation_reset(animation);
+    return graphics_animation_time(resources->time.virt.time.elapsed);
 }
 
-void animation_reset(Animation *animation)
+AnimationHandle animation_play_on_sprite(Resources *resources, Sprite *sprite,
+                                         AnimationType type, f32 speed)
 {
-    animation->current_frame = 0;
-    animation->wait_time = animation->def->frames[0].frame_time;
+    u32 start = now(resources);
+    sprite_play_animation(sprite, type, start, speed);
+    return animations_play(&resources->animations, type, start, speed);
+}
 
-    animation->needs_apply = true;
-    animation->finished = false;
+AnimationHandle animation_play_on_quad(Resources *resources, Sprite *sprite,
+                                       Quad quad, AnimationType type,
+                                       f32 speed)
+{
+    // the tex coords tables are for whole textures
+    if (sprite->texture->region.page != ATLAS_NONE)
+        FATAL("Can't animate %s, it's packed into the atlas\n",
+              sprite->texture->path);
+    return animations_play_quad(&resources->animations, type, now(resources),
+                                speed, sprite->quad, quad.rect,
+                                sprite->texture->width,
+                                sprite->texture->height);
 }
 
-void animation_update(Animation *animation, Resources *resources)
+static void play_frame_sound(Frame frame, Resources *resources)
 {
-    if (animation->finished)
-    {
+    if (!frame.sound)
         return;
-    }
 
-    animation->needs_apply = false;
+    FMOD_STUDIO_EVENTDESCRIPTION *desc;
+    FMOD_RESULT res = FMOD_Studio_System_GetEvent(resources->audio.system,
+                                                  frame.sound, &desc);
+    FMOD_ERRCHK(res, "Failed to fetch animation sound");
 
-    f32 delta = time_delta_seconds(resources->time.real.time);
-    animation->wait_time -= delta;
+    FMOD_STUDIO_EVENTINSTANCE *inst;
+    FMOD_Studio_EventDescription_CreateInstance(desc, &inst);
+    FMOD_Studio_EventInstance_Start(inst);
+    FMOD_Studio_EventInstance_Release(inst);
+}
 
-    if (animation->wait_time <= 0.0)
+void animations_play_sounds(Animations *animations, Resources *resources)
+{
+    AnimationChange *changed = (AnimationChange *)animations->changed.data;
+    for (usize i = 0; i < animations->changed.len; i++)
     {
-        animation->current_frame++;
-        if (animation->current_frame >= animation->def->frame_count)
-        {
-            if (animation->def->looping)
-                animation->current_frame = 0;
-            else
-                animation->finished = true;
-        }
-
-        Frame frame = animation->def->frames[animation->current_frame];
-        animation->wait_time = frame.frame_time;
-        animation->needs_apply = true;
+        if (changed[i].handle == ANIMATION_NONE)
+            continue;
+        CompiledAnimation *animation = *(CompiledAnimation **)vec_get(
+            &animations->animations, changed[i].handle);
+        if (!animation->has_sounds)
+            continue;
 
-        if (frame.sound)
+        // starting on the first frame doesn't play its sound, looping back
+        // round to it does
+        u32 current = changed[i].from == ANIMATION_NONE ? 0 : changed[i].from;
+        u32 frame = animations_frame(animations, changed[i].handle);
+        while (current != frame)
         {
-            FMOD_STUDIO_EVENTDESCRIPTION *desc;
-            FMOD_RESULT res = FMOD_Studio_System_GetEvent(
-                resources->audio.system, frame.sound, &desc);
-            FMOD_ERRCHK(res, "Failed to fetch animation sound");
-
-            FMOD_STUDIO_EVENTINSTANCE *inst;
-            FMOD_Studio_EventDescription_CreateInstance(desc, &inst);
-            FMOD_Studio_EventInstance_Start(inst);
-            FMOD_Studio_EventInstance_Release(inst);
+            current = (current + 1) % animation->def->frame_count;
+            play_frame_sound(animation->def->frames[current], resources);
         }
     }
 }
-
-void animation_apply(Animation *animation, Graphics *graphics, Quad *quad,
-                     Sprite *sprite)
-{
-    if (!animation->needs_apply)
-        return;
-
-    WGPUTexture texture = texture_manager_get_texture(
-        &graphics->texture_manager, sprite->texture);
-    u32 texture_width = wgpuTextureGetWidth(texture);
-    u32 texture_height = wgpuTextureGetHeight(texture);
-
-    quad->tex_coords = tex_coords_for(animation->def, animation->current_frame,
-                                      texture_width, texture_height);
-    quad_manager_update(&graphics->quad_manager, sprite->quad, *quad);
-}
-
-void animation_free(Animation *animation) { (void)animation; }
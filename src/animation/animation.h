@@ -1,27 +1,22 @@
 #pragma once
 
-#include "animation/definition.h"
-#include "graphics/graphics.h"
+#include "animation/animations.h"
 #include "graphics/sprite.h"
 #include "resources.h"
 
-typedef struct
-{
-    const AnimationDef *def;
+// animations are all updated together, in Resources.animations (see
+// animations.h). these start them from wherever Graphics.animation_time is now
 
-    f32 wait_time;
-    u32 current_frame;
-    bool needs_apply, finished;
-} Animation;
+// the sprite's shader works out which frame it's on from the time, so nothing
+// needs updating or uploading as it plays. `sprite`'s quad should have tex
+// coords from 0 to 1
+AnimationHandle animation_play_on_sprite(Resources *resources, Sprite *sprite,
+                                         AnimationType type, f32 speed);
+// the other way: `quad`'s tex coords get replaced whenever the frame changes
+AnimationHandle animation_play_on_quad(Resources *resources, Sprite *sprite,
+                                       Quad quad, AnimationType type,
+                                       f32 speed);
 
-void animation_init(Animation *animation, AnimationType type);
-
-void animation_reset(Animation *animation);
-
-void animation_update(Animation *animation, Resources *resources);
-// i'd prefer to remove the Quad pointer arg but fetching quads is quite
-// expensive
-void animation_apply(Animation *animation, Graphics *graphics, Quad *quad,
-                     Sprite *sprite);
-
-void animation_free(Animation *animation);
+// plays the sounds for every frame reached in the last animations_update,
+// including any a slow frame skipped right over
+void animations_play_sounds(Animations *animations, Resources *resources);
@@ -0,0 +1,195 @@
+#include "animations.h"
+#include "utility/macros.h"
+#include <string.h>
+
+void animations_init(Animations *animations)
+{
+    vec_init(&animations->animations, sizeof(CompiledAnimation *));
+    vec_init(&animations->start_times, sizeof(u32));
+    vec_init(&animations->speeds, sizeof(f32));
+    vec_init(&animations->frames, sizeof(u32));
+    vec_init(&animations->next_changes, sizeof(u32));
+    vec_init(&animations->flags, sizeof(u8));
+
+    vec_init(&animations->quads, sizeof(QuadEntry));
+    vec_init(&animations->rects, sizeof(Rect));
+    vec_init(&animations->tex_coords, sizeof(const Rect *));
+
+    vec_init(&animations->free_handles, sizeof(AnimationHandle));
+    vec_init(&animations->changed, sizeof(AnimationChange));
+}
+
+void animations_free(Animations *animations)
+{
+    vec_free(&animations->animations);
+    vec_free(&animations->start_times);
+    vec_free(&animations->speeds);
+    vec_free(&animations->frames);
+    vec_free(&animations->next_changes);
+    vec_free(&animations->flags);
+
+    vec_free(&animations->quads);
+    vec_free(&animations->rects);
+    vec_free(&animations->tex_coords);
+
+    vec_free(&animations->free_handles);
+    vec_free(&animations->changed);
+}
+
+static void set(vec *v, usize index, const void *value)
+{
+    memcpy(vec_get(v, index), value, v->ele_size);
+}
+
+static AnimationHandle add(Animations *animations, AnimationType type,
+                           u32 start, f32 speed, u8 flags)
+{
+    CompiledAnimation *animation = animation_get(type);
+    // so the first update counts as a change, and the first frame gets applied
+    u32 frame = ANIMATION_NONE;
+    u32 next_change = 0;
+    QuadEntry quad = 0;
+    Rect rect = {0};
+    const Rect *tex_coords = NULL;
+
+    AnimationHandle handle;
+    if (animations->free_handles.len > 0)
+    {
+        vec_pop(&animations->free_handles, &handle);
+        set(&animations->animations, handle, &animation);
+        set(&animations->start_times, handle, &start);
+        set(&animations->speeds, handle, &speed);
+        set(&animations->frames, handle, &frame);
+        set(&animations->next_changes, handle, &next_change);
+        set(&animations->flags, handle, &flags);
+        set(&animations->quads, handle, &quad);
+        set(&animations->rects, handle, &rect);
+        set(&animations->tex_coords, handle, &tex_coords);
+        return handle;
+    }
+
+    handle = animations->animations.len;
+    vec_push(&animations->animations, &animation);
+    vec_push(&animations->start_times, &start);
+    vec_push(&animations->speeds, &speed);
+    vec_push(&animations->frames, &frame);
+    vec_push(&animations->next_changes, &next_change);
+    vec_push(&animations->flags, &flags);
+    vec_push(&animations->quads, &quad);
+    vec_push(&animations->rects, &rect);
+    vec_push(&animations->tex_coords, &tex_coords);
+    return handle;
+}
+
+AnimationHandle animations_play(Animations *animations, AnimationType type,
+                                u32 start, f32 speed)
+{
+    return add(animations, type, start, speed, AnimFlag_Playing);
+}
+
+AnimationHandle animations_play_quad(Animations *animations,
+                                     AnimationType type, u32 start, f32 speed,
+                                     QuadEntry quad, Rect rect,
+                                     u32 texture_width, u32 texture_height)
+{
+    AnimationHandle handle = add(animations, type, start, speed,
+                                 AnimFlag_Playing | AnimFlag_Quad);
+    const Rect *tex_coords = animation_tex_coords(
+        animation_get(type), texture_width, texture_height);
+    set(&animations->quads, handle, &quad);
+    set(&animations->rects, handle, &rect);
+    set(&animations->tex_coords, handle, &tex_coords);
+    return handle;
+}
+
+void animations_stop(Animations *animations, AnimationHandle handle)
+{
+    u8 *flags = vec_get(&animations->flags, handle);
+    if (!flags || !(*flags & AnimFlag_Playing))
+        return;
+    *flags = 0;
+    u32 never = UINT32_MAX;
+    set(&animations->next_changes, handle, &never);
+    vec_push(&animations->free_handles, &handle);
+
+    // so nothing gets applied to a quad that might not be there anymore
+    AnimationChange *changed = (AnimationChange *)animations->changed.data;
+    for (usize i = 0; i < animations->changed.len; i++)
+        if (changed[i].handle == handle)
+            changed[i].handle = ANIMATION_NONE;
+}
+
+u32 animations_frame(Animations *animations, AnimationHandle handle)
+{
+    return *(u32 *)vec_get(&animations->frames, handle);
+}
+
+bool animations_finished(Animations *animations, AnimationHandle handle)
+{
+    return *(u8 *)vec_get(&animations->flags, handle) & AnimFlag_Finished;
+}
+
+void animations_update(Animations *animations, u32 time)
+{
+    vec_clear(&animations->changed);
+
+    CompiledAnimation **compiled =
+        (CompiledAnimation **)animations->animations.data;
+    u32 *start_times = (u32 *)animations->start_times.data;
+    f32 *speeds = (f32 *)animations->speeds.data;
+    u32 *frames = (u32 *)animations->frames.data;
+    u32 *next_changes = (u32 *)animations->next_changes.data;
+    u8 *flags = (u8 *)animations->flags.data;
+
+    for (usize i = 0; i < animations->animations.len; i++)
+    {
+        // stopped and finished animations never change
+        if (time < next_changes[i])
+            continue;
+
+        // the same sums as sprite.wgsl, so they round the same way
+        u32 since = (u32)((f32)(time - start_times[i]) * speeds[i]);
+        u32 frame = animation_frame_at(compiled[i], since);
+        u32 remaining = animation_frame_remaining(compiled[i], since, frame);
+
+        // rounded down, so it might be looked at a little early, but never
+        // late
+        if (remaining == UINT32_MAX || speeds[i] <= 0.0)
+            next_changes[i] = UINT32_MAX;
+        else
+            next_changes[i] = time + (u32)((f32)remaining / speeds[i]);
+
+        if (frame != frames[i])
+        {
+            AnimationChange change = {.handle = i, .from = frames[i]};
+            vec_push(&animations->changed, &change);
+            frames[i] = frame;
+        }
+        if (!compiled[i]->def->looping &&
+            frame == compiled[i]->def->frame_count - 1)
+            flags[i] |= AnimFlag_Finished;
+    }
+}
+
+void animations_update_quads(Animations *animations, QuadManager *quads)
+{
+    AnimationChange *changed = (AnimationChange *)animations->changed.data;
+    u8 *flags = (u8 *)animations->flags.data;
+    u32 *frames = (u32 *)animations->frames.data;
+    QuadEntry *entries = (QuadEntry *)animations->quads.data;
+    Rect *rects = (Rect *)animations->rects.data;
+    const Rect **tex_coords = (const Rect **)animations->tex_coords.data;
+
+    for (usize i = 0; i < animations->changed.len; i++)
+    {
+        AnimationHandle handle = changed[i].handle;
+        if (handle == ANIMATION_NONE || !(flags[handle] & AnimFlag_Quad))
+            continue;
+
+        Quad quad = {
+            .rect = rects[handle],
+            .tex_coords = tex_coords[handle][frames[handle]],
+        };
+        quad_manager_update(quads, entries[handle], quad);
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "animation/definition.h"
+#include "graphics/quad_manager.h"
+#include "sensible_nums.h"
+#include "utility/vec.h"
+
+// every playing animation, updated all at once.
+//
+// it's a struct of arrays (one vec per field, all indexed by handle). each
+// animation knows when its frame is next going to change, so most updates
+// only read that, and only the animations that changed frame get looked at
+// again after that.
+//
+// frames are worked out from how long an animation has been playing, rather
+// than stepped forward each update, so after a hitch they skip ahead to
+// where they should be instead of lagging behind.
+
+typedef u32 AnimationHandle;
+#define ANIMATION_NONE UINT32_MAX
+
+typedef enum
+{
+    AnimFlag_Playing = 1 << 0,
+    AnimFlag_Finished = 1 << 1,
+    // the quad's tex coords get updated on the cpu (see animations_play_quad)
+    AnimFlag_Quad = 1 << 2,
+} AnimationFlags;
+
+typedef struct
+{
+    AnimationHandle handle;
+    // the frame it was on before, or ANIMATION_NONE if it's just started
+    u32 from;
+} AnimationChange;
+
+typedef struct
+{
+    vec animations;  // vec<CompiledAnimation *>
+    vec start_times; // vec<u32>, in Graphics.animation_time
+    vec speeds;      // vec<f32>
+    vec frames;      // vec<u32>, as of the last update
+    // vec<u32>, when the frame's next going to change. UINT32_MAX if it won't
+    vec next_changes;
+    vec flags;       // vec<u8>, AnimationFlags
+
+    // only used by animations played with animations_play_quad
+    vec quads;      // vec<QuadEntry>
+    vec rects;      // vec<Rect>
+    vec tex_coords; // vec<const Rect *>, see animation_tex_coords
+
+    vec free_handles; // vec<AnimationHandle>
+    // what changed frame in the last update
+    vec changed; // vec<AnimationChange>
+} Animations;
+
+void animations_init(Animations *animations);
+void animations_free(Animations *animations);
+
+// only keeps track of the frame (for sounds, and anything else that cares).
+// use this for sprites that are animated on the gpu (see
+// sprite_play_animation), with the same start and speed
+AnimationHandle animations_play(Animations *animations, AnimationType type,
+                                u32 start, f32 speed);
+// animates `quad` on the cpu, by replacing its tex coords whenever the frame
+// changes. the tex coords are looked up from a table made for the texture's
+// size (see animation_tex_coords)
+AnimationHandle animations_play_quad(Animations *animations,
+                                     AnimationType type, u32 start, f32 speed,
+                                     QuadEntry quad, Rect rect,
+                                     u32 texture_width, u32 texture_height);
+void animations_stop(Animations *animations, AnimationHandle handle);
+
+// ANIMATION_NONE until the first update after it starts
+u32 animations_frame(Animations *animations, AnimationHandle handle);
+// only non-looping animations finish
+bool animations_finished(Animations *animations, AnimationHandle handle);
+
+// works out every animation's frame at `time` (in Graphics.animation_time),
+// and remembers which ones changed
+void animations_update(Animations *animations, u32 time);
+// gives every quad animation that changed frame in the last update its new
+// tex coords
+void animations_update_quads(Animations *animations, QuadManager *quads);
@@ -1,5 +1,7 @@
 #include "definition.h"
 #include "utility/macros.h"
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
 // while this is a gnu C extension clang will compile it just fine
@@ -32,11 +34,89 @@ const AnimationDef *ANIMATIONS[Anim_Max] = {
     [Anim_Test] = &TEST,
 };
 
-AnimationType anim_type_for(const char *name)
+// vec<CompiledAnimation *>, indexed by AnimationType
+static vec compiled = {0};
+
+static void compile(CompiledAnimation *animation, const AnimationDef *def)
+{
+    animation->def = def;
+    animation->has_sounds = false;
+    animation->frame_ends = malloc(sizeof(u32) * def->frame_count);
+    for (u32 i = 0; i < def->frame_count; i++)
+    {
+        animation->frame_ends[i] = animation_frame_end(def, i);
+        if (def->frames[i].sound)
+            animation->has_sounds = true;
+    }
+    animation->duration = animation->frame_ends[def->frame_count - 1];
+    vec_init(&animation->tex_coords, sizeof(AnimationTexCoords));
+}
+
+void animation_defs_init(void)
 {
+    vec_init(&compiled, sizeof(CompiledAnimation *));
     for (AnimationType type = 0; type < Anim_Max; type++)
+        animation_defs_add(ANIMATIONS[type], false);
+}
+
+AnimationType animation_defs_add(const AnimationDef *def, bool owned)
+{
+    if (def->frame_count == 0)
+        FATAL("Animation %s has no frames\n", def->name);
+    for (u32 i = 0; i < compiled.len; i++)
+    {
+        CompiledAnimation *other = *(CompiledAnimation **)vec_get(&compiled, i);
+        if (!strcmp(other->def->name, def->name))
+            FATAL("Animation %s is defined twice\n", def->name);
+    }
+
+    CompiledAnimation *animation = malloc(sizeof(CompiledAnimation));
+    compile(animation, def);
+    animation->owned = owned;
+    vec_push(&compiled, &animation);
+    return compiled.len - 1;
+}
+
+void animation_defs_free(void)
+{
+    for (u32 i = 0; i < compiled.len; i++)
+    {
+        CompiledAnimation *animation =
+            *(CompiledAnimation **)vec_get(&compiled, i);
+        AnimationTexCoords *coords =
+            (AnimationTexCoords *)animation->tex_coords.data;
+        for (u32 j = 0; j < animation->tex_coords.len; j++)
+            free(coords[j].frames);
+        vec_free(&animation->tex_coords);
+        free(animation->frame_ends);
+
+        if (animation->owned)
+        {
+            const AnimationDef *def = animation->def;
+            for (u32 j = 0; j < def->frame_count; j++)
+                free((char *)def->frames[j].sound);
+            free((char *)def->name);
+            free((AnimationDef *)def);
+        }
+        free(animation);
+    }
+    vec_free(&compiled);
+}
+
+u32 animation_defs_count(void) { return compiled.len; }
+
+CompiledAnimation *animation_get(AnimationType type)
+{
+    if (type >= compiled.len)
+        FATAL("Animation type %u out of range\n", type);
+    return *(CompiledAnimation **)vec_get(&compiled, type);
+}
+
+AnimationType anim_type_for(const char *name)
+{
+    for (AnimationType type = 0; type < compiled.len; type++)
     {
-        const AnimationDef *def = ANIMATIONS[type];
+        const AnimationDef *def = animation_get(type)->def;
         if (!strcmp(def->name, name))
         {
             return type;
@@ -67,3 +147,69 @@ Rect tex_coords_for(const AnimationDef *def, u32 frame, u32 texture_width,
                  .max = glms_vec2_div(max, tex_size)};
     return rect;
 }
+
+const Rect *animation_tex_coords(CompiledAnimation *animation,
+                                 u32 texture_width, u32 texture_height)
+{
+    AnimationTexCoords *coords =
+        (AnimationTexCoords *)animation->tex_coords.data;
+    for (u32 i = 0; i < animation->tex_coords.len; i++)
+        if (coords[i].texture_width == texture_width &&
+            coords[i].texture_height == texture_height)
+            return coords[i].frames;
+
+    const AnimationDef *def = animation->def;
+    AnimationTexCoords new = {
+        .texture_width = texture_width,
+        .texture_height = texture_height,
+        .frames = malloc(sizeof(Rect) * def->frame_count),
+    };
+    for (u32 i = 0; i < def->frame_count; i++)
+        new.frames[i] = tex_coords_for(def, i, texture_width, texture_height);
+    vec_push(&animation->tex_coords, &new);
+    return new.frames;
+}
+
+// everything's added up in seconds first, the same way for every frame, so
+// frame ends always agree with each other
+static u32 to_millis(f32 seconds) { return (u32)lroundf(seconds * 1000.0f); }
+
+u32 animation_frame_end(const AnimationDef *def, u32 frame)
+{
+    f32 total = 0.0;
+    for (u32 i = 0; i <= frame && i < def->frame_count; i++)
+        total += def->frames[i].frame_time;
+    return to_millis(total);
+}
+
+u32 animation_frame_at(const CompiledAnimation *animation, u32 time)
+{
+    if (animation->def->looping && animation->duration > 0)
+        time %= animation->duration;
+
+    // the first frame that ends after `time`
+    u32 low = 0, high = animation->def->frame_count - 1;
+    while (low < high)
+    {
+        u32 middle = low + (high - low) / 2;
+        if (time < animation->frame_ends[middle])
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low;
+}
+
+u32 animation_frame_remaining(const CompiledAnimation *animation, u32 time,
+                              u32 frame)
+{
+    const AnimationDef *def = animation->def;
+    if (!def->looping && frame == def->frame_count - 1)
+        return UINT32_MAX;
+    if (def->looping && animation->duration > 0)
+        time %= animation->duration;
+    // a looping animation that doesn't take any time
+    if (time >= animation->frame_ends[frame])
+        return UINT32_MAX;
+    return animation->frame_ends[frame] - time;
+}
@@ -3,7 +3,10 @@
 #include "core_types.h"
 #include "sensible_nums.h"
 #include "utility/macros.h"
+#include "utility/vec.h"
 
+// animations added with animation_defs_add (or loaded from a file, see
+// animation/loader.h) get types after Anim_Max, in the order they were added
 typedef enum
 {
     Anim_Test = 0,
@@ -33,9 +36,61 @@ typedef struct
     Frame frames[];
 } AnimationDef;
 
+typedef struct
+{
+    u32 texture_width, texture_height;
+    // one per frame
+    Rect *frames;
+} AnimationTexCoords;
+
+// an AnimationDef with everything that would otherwise be worked out every
+// frame done ahead of time
+typedef struct
+{
+    const AnimationDef *def;
+    // freed along with the name and sounds by animation_defs_free
+    bool owned;
+    bool has_sounds;
+
+    // when each frame ends, in milliseconds from the start (see
+    // animation_frame_end). sorted, so frames can be binary searched
+    u32 *frame_ends;
+    u32 duration;
+
+    // vec<AnimationTexCoords>, one for each texture size it's been used with
+    vec tex_coords;
+} CompiledAnimation;
+
 extern const AnimationDef *ANIMATIONS[Anim_Max];
 
+// compiles everything in ANIMATIONS. call this before adding any others, and
+// before graphics_init (sprite.wgsl gets a copy of every animation)
+void animation_defs_init(void);
+// `def` needs to last until animation_defs_free, which frees it if `owned`.
+// FATAL if there's already an animation with the same name
+AnimationType animation_defs_add(const AnimationDef *def, bool owned);
+void animation_defs_free(void);
+u32 animation_defs_count(void);
+
+// these don't move when more animations are added
+CompiledAnimation *animation_get(AnimationType type);
 AnimationType anim_type_for(const char *name);
 
 Rect tex_coords_for(const AnimationDef *def, u32 frame, u32 texture_width,
                     u32 texture_height);
+// every frame's tex coords for a texture this size. only worked out the
+// first time a size is asked for
+const Rect *animation_tex_coords(CompiledAnimation *animation,
+                                 u32 texture_width, u32 texture_height);
+
+// when `frame` ends, in milliseconds from the start of the animation
+u32 animation_frame_end(const AnimationDef *def, u32 frame);
+// which frame is showing `time` milliseconds in. looping animations wrap
+// around, others stay on their last frame. sprite.wgsl does the same thing
+// (see sprite_animations.h), so sounds played from this line up with what's
+// on screen
+u32 animation_frame_at(const CompiledAnimation *animation, u32 time);
+// how many milliseconds are left of `frame` at `time`, or UINT32_MAX if it's
+// the last frame of an animation that doesn't loop
+u32 animation_frame_remaining(const CompiledAnimation *animation, u32 time,
+                              u32 frame);
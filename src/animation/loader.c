@@ -0,0 +1,160 @@
+#include "loader.h"
+#include "parsers/ini.h"
+#include "utility/vec.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the ini parser keeps the spaces around the =
+static char *trim(char *string)
+{
+    while (isspace((unsigned char)*string))
+        string++;
+    char *end = string + strlen(string);
+    while (end > string && isspace((unsigned char)end[-1]))
+        end--;
+    *end = '\0';
+    return string;
+}
+
+static void free_def(AnimationDef *def)
+{
+    for (u32 i = 0; i < def->frame_count; i++)
+        free((char *)def->frames[i].sound);
+    free((char *)def->name);
+    free(def);
+}
+
+static AnimationDef *parse_section(IniSection *section, char out_err_msg[256])
+{
+    const char *name = trim(section->name);
+    u32 frame_count = 0;
+    for (int i = 0; i < section->pairs->len; i++)
+    {
+        IniPair *pair = linked_list_at(section->pairs, i);
+        if (!strcmp(trim(pair->key), "frame"))
+            frame_count++;
+    }
+    if (frame_count == 0)
+    {
+        snprintf(out_err_msg, 256, "animation %s has no frames", name);
+        return NULL;
+    }
+
+    AnimationDef *def =
+        calloc(1, sizeof(AnimationDef) + sizeof(Frame) * frame_count);
+    def->name = strdup(name);
+
+    for (int i = 0; i < section->pairs->len; i++)
+    {
+        IniPair *pair = linked_list_at(section->pairs, i);
+        char *key = trim(pair->key);
+        char *value = trim(pair->value);
+
+        if (!strcmp(key, "cell_width"))
+            def->cell_width = atol(value);
+        else if (!strcmp(key, "cell_height"))
+            def->cell_height = atol(value);
+        else if (!strcmp(key, "looping"))
+            def->looping = atol(value) != 0;
+        else if (!strcmp(key, "frame"))
+        {
+            Frame *frame = &def->frames[def->frame_count++];
+            char sound[256];
+            int read = sscanf(value, "%f %u %255s", &frame->frame_time,
+                              &frame->cell, sound);
+            if (read < 2 || frame->frame_time < 0.0)
+            {
+                snprintf(out_err_msg, 256,
+                         "animation %s has a bad frame `%s` (expected "
+                         "`seconds cell [sound]`)",
+                         name, value);
+                free_def(def);
+                return NULL;
+            }
+            if (read == 3)
+                frame->sound = strdup(sound);
+        }
+        else
+        {
+            snprintf(out_err_msg, 256, "animation %s has an unknown key %s",
+                     name, key);
+            free_def(def);
+            return NULL;
+        }
+    }
+
+    if (def->cell_width == 0 || def->cell_height == 0)
+    {
+        snprintf(out_err_msg, 256,
+                 "animation %s needs a cell_width and cell_height", name);
+        free_def(def);
+        return NULL;
+    }
+    return def;
+}
+
+static bool load(Ini *ini, char out_err_msg[256])
+{
+    if (!ini)
+        return false;
+
+    // everything's checked before anything gets added, so a bad file can't
+    // leave half its animations behind
+    vec defs;
+    vec_init(&defs, sizeof(AnimationDef *));
+    bool ok = true;
+    for (int i = 0; i < ini->sections->len && ok; i++)
+    {
+        IniSection *section = linked_list_at(ini->sections, i);
+        AnimationDef *def = parse_section(section, out_err_msg);
+        if (!def)
+        {
+            ok = false;
+            break;
+        }
+        vec_push(&defs, &def);
+
+        for (u32 type = 0; type < animation_defs_count(); type++)
+            if (!strcmp(animation_get(type)->def->name, def->name))
+            {
+                snprintf(out_err_msg, 256, "animation %s is already defined",
+                         def->name);
+                ok = false;
+            }
+        for (u32 j = 0; j + 1 < defs.len; j++)
+            if (!strcmp((*(AnimationDef **)vec_get(&defs, j))->name,
+                        def->name))
+            {
+                snprintf(out_err_msg, 256, "animation %s is defined twice",
+                         def->name);
+                ok = false;
+            }
+    }
+
+    for (u32 i = 0; i < defs.len; i++)
+    {
+        AnimationDef *def = *(AnimationDef **)vec_get(&defs, i);
+        if (ok)
+        {
+            def->type = animation_defs_count();
+            animation_defs_add(def, true);
+        }
+        else
+            free_def(def);
+    }
+    vec_free(&defs);
+    ini_free(ini);
+    return ok;
+}
+
+bool animation_defs_load_string(const char *string, char out_err_msg[256])
+{
+    return load(ini_parse_string(string, out_err_msg), out_err_msg);
+}
+
+bool animation_defs_load_file(const char *path, char out_err_msg[256])
+{
+    return load(ini_parse_file(path, out_err_msg), out_err_msg);
+}
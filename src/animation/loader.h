@@ -0,0 +1,21 @@
+#pragma once
+
+#include "animation/definition.h"
+#include <stdbool.h>
+
+// loads animations from an ini file, on top of the ones in ANIMATIONS. each
+// section is one animation, named after the section:
+//
+//   [walk]
+//   cell_width = 16
+//   cell_height = 16
+//   looping = 1
+//   frame = 0.1 4
+//   frame = 0.2 5 event:/sfx/step
+//
+// every `frame` is its length in seconds, its cell, and optionally a sound to
+// play when it starts, in order. looping defaults to 0.
+// returns false with the reason in out_err_msg if anything's wrong, in which
+// case nothing from the file is added
+bool animation_defs_load_string(const char *string, char out_err_msg[256]);
+bool animation_defs_load_file(const char *path, char out_err_msg[256]);
@@ -15,47 +15,22 @@ void *autorun_char_init(Resources *resources, struct MapScene *map_scene,
         FATAL("Autorun characters do nothing without an attached event\n");
     }
 
-    for (u32 i = 0; i < resources->event_count; i++)
+    Event event;
+    if (!event_index_get(&resources->events, event_name, &event))
     {
-        Event event = resources->events[i];
-        if (!strcmp(event.name, event_name))
-        {
-            VM *vm = malloc(sizeof(VM));
-            vm_init(vm, event);
-            return vm;
-        }
+        FATAL("Can't run event `%s`\n", event_name);
     }
-    FATAL("No such event `%s`\n", event_name);
-}
-
-void autorun_char_fixed_update(void **self, Resources *resources,
-                               MapScene *map_scene)
-{
-    (void)map_scene;
 
-    VM *vm = *self;
-    if (vm)
-    {
-        bool finished = vm_execute(vm, resources);
-        if (finished)
-        {
-            vm_free(vm);
-            free(vm);
-            *self = NULL;
-        }
-    }
+    ScriptHandle *script = malloc(sizeof(ScriptHandle));
+    *script = scheduler_spawn(&resources->scheduler, event, NULL);
+    return script;
 }
 
 void autorun_char_free(void *self, Resources *resources, MapScene *map_scene)
 {
-    (void)self;
-    (void)resources;
     (void)map_scene;
 
-    if (self)
-    {
-        VM *vm = self;
-        vm_free(vm);
-        free(vm);
-    }
+    ScriptHandle *script = self;
+    scheduler_kill(&resources->scheduler, *script);
+    free(script);
 }
@@ -13,12 +13,13 @@ void *basic_char_init(Resources *resources, struct MapScene *map_scene,
 
     BasicCharState *state = calloc(1, sizeof(BasicCharState));
     state->rect = args->rect;
+    state->animation = ANIMATION_NONE;
 
+    const AnimationDef *animation = NULL;
     if (hashmap_get(args->metadata, "animation"))
     {
         const char *animation_name = hashmap_get(args->metadata, "animation");
-        AnimationType type = anim_type_for(animation_name);
-        animation_init(&state->animation, type);
+        animation = animation_get(anim_type_for(animation_name))->def;
     }
 
     if (hashmap_get(args->metadata, "sprite"))
@@ -31,23 +32,28 @@ void *basic_char_init(Resources *resources, struct MapScene *map_scene,
         char sprite_name[256] = {0};
         strncpy(sprite_name, hashmap_get(args->metadata, "sprite"),
                 sizeof(sprite_name) - 1);
-        TextureEntry *texture =
-            texture_manager_load(&resources->graphics.texture_manager,
-                                 sprite_name, &resources->graphics.wgpu);
-        WGPUTexture wgpu_tex = texture_manager_get_texture(
-            &resources->graphics.texture_manager, texture);
-        u32 width = wgpuTextureGetWidth(wgpu_tex),
-            height = wgpuTextureGetHeight(wgpu_tex);
-
-        if (state->animation.def)
+        // sprite.wgsl works out animation frames from the whole texture, so
+        // only sprites that don't animate can go in the atlas
+        TextureEntry *texture;
+        if (animation)
+            texture = texture_manager_load_async(
+                &resources->graphics.texture_manager, sprite_name,
+                &resources->graphics.wgpu);
+        else
+            texture = texture_manager_load_packed(
+                &resources->graphics.texture_manager, sprite_name,
+                &resources->graphics.wgpu);
+        u32 width = texture->width, height = texture->height;
+
+        if (animation)
         {
-            width = state->animation.def->cell_width;
-            height = state->animation.def->cell_height;
+            width = animation->cell_width;
+            height = animation->cell_height;
         }
 
         state->quad =
             quad_init(rect_from_size((vec2s){.x = width, .y = height}),
-                      RECT_UNIT_TEX_COORDS);
+                      texture->sub_rect);
 
         sprite_init(
             &state->sprite, texture, transform,
@@ -62,10 +68,11 @@ void *basic_char_init(Resources *resources, struct MapScene *map_scene,
                 sizeof(state->event_name) - 1);
     }
 
-    if (state->animation.def)
+    // the quad keeps its 0 to 1 tex coords, and the shader picks the cell
+    if (animation && state->sprite.texture)
     {
-        animation_apply(&state->animation, &resources->graphics, &state->quad,
-                        &state->sprite);
+        state->animation = animation_play_on_sprite(resources, &state->sprite,
+                                                    animation->type, 1.0);
     }
 
     return state;
@@ -75,13 +82,6 @@ void basic_char_update(void **self, Resources *resources, MapScene *map_scene)
 {
     BasicCharState *state = *self;
 
-    if (state->animation.def)
-    {
-        animation_update(&state->animation, resources);
-        animation_apply(&state->animation, &resources->graphics, &state->quad,
-                        &state->sprite);
-    }
-
     Rect player_rect =
         rect_from_min_size((vec2s){.x = map_scene->player.transform.position.x,
                                    .y = map_scene->player.transform.position.y},
@@ -91,38 +91,18 @@ void basic_char_update(void **self, Resources *resources, MapScene *map_scene)
     bool interact_pressed = input_did_press(&resources->input, Button_Interact);
     bool has_event = (*state->event_name) != '\0';
 
-    if (player_inside && interact_pressed && !state->vm && has_event)
-    {
-        for (u32 i = 0; i < resources->event_count; i++)
-        {
-            Event event = resources->events[i];
-            if (!strcmp(event.name, state->event_name))
-            {
-                state->vm = malloc(sizeof(VM));
-                vm_init(state->vm, event);
-                state->vm->vm_ctx = state;
-                return;
-            }
-        }
-        log_warn("No such event `%s`", state->event_name);
-    }
-}
-
-void basic_char_fixed_update(void **self, Resources *resources,
-                             MapScene *map_scene)
-{
-    (void)map_scene;
+    bool running =
+        scheduler_is_running(&resources->scheduler, state->script);
 
-    BasicCharState *state = *self;
-    if (state->vm)
+    if (player_inside && interact_pressed && !running && has_event)
     {
-        bool finished = vm_execute(state->vm, resources);
-        if (finished)
+        Event event;
+        if (!event_index_get(&resources->events, state->event_name, &event))
         {
-            vm_free(state->vm);
-            free(state->vm);
-            state->vm = NULL;
+            log_warn("Can't run event `%s`", state->event_name);
+            return;
         }
+        state->script = scheduler_spawn(&resources->scheduler, event, state);
     }
 }
 
@@ -137,15 +117,12 @@ void basic_char_free(void *self, Resources *resources, MapScene *map_scene)
                      state->layer_entry);
     }
 
-    if (state->vm)
-    {
-        vm_free(state->vm);
-        free(state->vm);
-    }
+    // the vm points back at us, so it can't outlive us
+    scheduler_kill(&resources->scheduler, state->script);
 
-    if (state->animation.def)
+    if (state->animation != ANIMATION_NONE)
     {
-        animation_free(&state->animation);
+        animations_stop(&resources->animations, state->animation);
     }
 
     free(state);
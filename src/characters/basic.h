@@ -7,9 +7,8 @@
 typedef struct
 {
     char event_name[256];
-    // VMs take a lot of space (~2kb) so it's better to eat the heap
-    // allocation when running an event than it is to store a VM 24/7
-    VM *vm;
+    // the event we're currently running, if any
+    ScriptHandle script;
 
     Transform transform;
     Quad quad;
@@ -17,7 +16,8 @@ typedef struct
     Sprite sprite;
     LayerEntry layer_entry;
 
-    Animation animation;
+    // in Resources.animations, or ANIMATION_NONE
+    AnimationHandle animation;
 
     Rect rect;
 } BasicCharState;
@@ -28,8 +28,5 @@ void *basic_char_init(Resources *resources, struct MapScene *map_scene,
 void basic_char_update(void **self, Resources *resources,
                        struct MapScene *map_scene);
 
-void basic_char_fixed_update(void **self, Resources *resources,
-                             struct MapScene *map_scene);
-
 void basic_char_free(void *self, Resources *resources,
                      struct MapScene *map_scene);
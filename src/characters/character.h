@@ -30,7 +30,6 @@ typedef void *(*character_init_fn)(Resources *resources,
                                    CharacterInitArgs *args);
 
 // characters can update the self pointer if they so choose
-// (this is used by the autorun character to use less resources)
 typedef void (*character_update_fn)(void **self, Resources *resources,
                                     struct MapScene *map_scene);
 
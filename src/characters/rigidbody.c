@@ -68,14 +68,11 @@ void *rigidbody_char_init(Resources *resources, struct MapScene *map_scene,
         char sprite_name[256] = {0};
         strncpy(sprite_name, hashmap_get(args->metadata, "sprite"),
                 sizeof(sprite_name) - 1);
-        TextureEntry *texture_entry =
-            texture_manager_load(&resources->graphics.texture_manager,
-                                 sprite_name, &resources->graphics.wgpu);
-
-        WGPUTexture texture = texture_manager_get_texture(
-            &resources->graphics.texture_manager, texture_entry);
-        u32 w = wgpuTextureGetWidth(texture);
-        u32 h = wgpuTextureGetHeight(texture);
+        TextureEntry *texture_entry = texture_manager_load_packed(
+            &resources->graphics.texture_manager, sprite_name,
+            &resources->graphics.wgpu);
+        u32 w = texture_entry->width;
+        u32 h = texture_entry->height;
 
         state->transform = transform_from_position_scale(
             (vec3s){.x = args->rect.min.x, .y = args->rect.min.y},
@@ -85,7 +82,7 @@ void *rigidbody_char_init(Resources *resources, struct MapScene *map_scene,
 
         Rect quad_rect = rect_from_center_radius(
             GLMS_VEC2_ZERO, (vec2s){.x = w / 2.0, .y = h / 2.0});
-        state->quad = quad_init(quad_rect, RECT_UNIT_TEX_COORDS);
+        state->quad = quad_init(quad_rect, texture_entry->sub_rect);
 
         sprite_init(
             &state->sprite, texture_entry, transform,
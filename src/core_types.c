@@ -204,6 +204,12 @@ bool rect_contains_other(Rect rect, Rect other)
     return rect_contains(rect, other.min) || rect_contains(rect, other.max);
 }
 
+bool rect_intersects(Rect rect, Rect other)
+{
+    return rect.min.x <= other.max.x && rect.max.x >= other.min.x &&
+           rect.min.y <= other.max.y && rect.max.y >= other.min.y;
+}
+
 vec2s rect_clamp(Rect rect, vec2s point)
 {
     return (vec2s){.x = fclamp(point.x, rect.min.x, rect.max.x),
@@ -268,7 +274,8 @@ void quad_into_corners(Quad quad, Vertex corners[4])
 
 Quad quad_from_corners(Vertex vertices[CORNERS_PER_QUAD])
 {
-    Rect rect = rect_init(vertices[0].position, vertices[5].position);
-    Rect tex_coords = rect_init(vertices[0].tex_coords, vertices[5].tex_coords);
+    // top left and bottom right (see quad_into_corners)
+    Rect rect = rect_init(vertices[0].position, vertices[2].position);
+    Rect tex_coords = rect_init(vertices[0].tex_coords, vertices[2].tex_coords);
     return quad_init(rect, tex_coords);
 }
@@ -75,6 +75,8 @@ vec2s rect_bottom_right(Rect rect);
 
 bool rect_contains(Rect rect, vec2s point);
 bool rect_contains_other(Rect rect, Rect other);
+// true if the rects overlap at all (touching counts)
+bool rect_intersects(Rect rect, Rect other);
 
 vec2s rect_clamp(Rect rect, vec2s point);
 Rect rect_clip(Rect rect, Rect other);
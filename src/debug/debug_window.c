@@ -1,5 +1,8 @@
 #include "debug_window.h"
+#include "events/globals.h"
+#include "events/profiler.h"
 #include "scenes/map.h"
+#include "utility/log.h"
 
 static int new_map_input_callback(ImGuiInputTextCallbackData *data)
 {
@@ -42,6 +45,215 @@ static int new_map_input_callback(ImGuiInputTextCallbackData *data)
     return 1;
 }
 
+static bool begin_table(const char *id, const char *const *columns,
+                        u32 column_count)
+{
+    if (!igBeginTable(id, column_count,
+                      ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg,
+                      (ImVec2){0, 0}, 0))
+        return false;
+    for (u32 i = 0; i < column_count; i++)
+        igTableSetupColumn(columns[i], 0, 0, 0);
+    igTableHeadersRow();
+    return true;
+}
+
+static f64 millis(Duration duration)
+{
+    return duration_as_secs_f64(duration) * 1000.0;
+}
+
+static int compare_event_time(const void *a, const void *b)
+{
+    const EventProfile *x = *(EventProfile *const *)a;
+    const EventProfile *y = *(EventProfile *const *)b;
+    if (x->runs.time.inner == y->runs.time.inner)
+        return 0;
+    return x->runs.time.inner < y->runs.time.inner ? 1 : -1;
+}
+
+static void call_row(const char *name, CallProfile *profile)
+{
+    igTableNextRow(0, 0);
+    igTableNextColumn();
+    igText("%s", name);
+    igTableNextColumn();
+    igText("%llu", (unsigned long long)profile->calls);
+    igTableNextColumn();
+    igText("%.3f", millis(profile->time));
+    igTableNextColumn();
+    igText("%.1f", millis(profile->time) * 1000.0 / profile->calls);
+}
+
+static void show_globals(Globals *globals)
+{
+    for (u32 i = 0; i < GLOBAL_MAX; i++)
+    {
+        Value value = globals->values[i];
+        if (VAL_IS_NONE(value))
+            continue;
+
+        const char *name = global_name(i);
+        switch (value.type)
+        {
+        case Val_None:
+            break;
+        case Val_Int:
+            igText("$%s = %d", name, value.data._int);
+            break;
+        case Val_Float:
+            igText("$%s = %f", name, value.data._float);
+            break;
+        case Val_String:
+            igText("$%s = \"%s\"", name, value.data.string);
+            break;
+        case Val_True:
+            igText("$%s = true", name);
+            break;
+        case Val_False:
+            igText("$%s = false", name);
+            break;
+        }
+    }
+}
+
+#define HOT_LINES 10
+
+static void show_profiler(Resources *resources)
+{
+    VMProfiler *profiler = &resources->profiler;
+
+    bool profiling = vm_profiler != NULL;
+    igCheckbox("Profile Scripts", &profiling);
+    vm_profiler = profiling ? profiler : NULL;
+
+    igSameLine(0, -1);
+    if (igSmallButton("Reset"))
+        vm_profiler_reset(profiler);
+    igSameLine(0, -1);
+    if (igSmallButton("Export CSV"))
+    {
+        const char *path = "script_profile.csv";
+        if (vm_profiler_export_csv(profiler, path))
+            log_info("Wrote script profile to %s", path);
+        else
+            log_warn("Failed to write script profile to %s", path);
+    }
+
+    // slowest events first
+    u32 event_count = profiler->events.len;
+    EventProfile **events = malloc(event_count * sizeof(EventProfile *));
+    if (event_count)
+        memcpy(events, profiler->events.data,
+               event_count * sizeof(EventProfile *));
+    qsort(events, event_count, sizeof(EventProfile *), compare_event_time);
+
+    const char *const event_columns[] = {"Event",  "Runs",  "Instructions",
+                                         "ms",     "Yields", "Wakes",
+                                         "Paused"};
+    if (begin_table("events", event_columns, 7))
+    {
+        for (u32 i = 0; i < event_count; i++)
+        {
+            EventProfile *event = events[i];
+            igTableNextRow(0, 0);
+            igTableNextColumn();
+            igText("%s", event->name);
+            igTableNextColumn();
+            igText("%llu", (unsigned long long)event->runs.calls);
+            igTableNextColumn();
+            igText("%llu", (unsigned long long)event->instructions);
+            igTableNextColumn();
+            igText("%.3f", millis(event->runs.time));
+            igTableNextColumn();
+            igText("%llu", (unsigned long long)event->yields);
+            igTableNextColumn();
+            igText("%llu", (unsigned long long)event->wakes);
+            igTableNextColumn();
+            igText("%llu", (unsigned long long)event->preemptions);
+        }
+        igEndTable();
+    }
+
+    // the busiest lines out of every event
+    struct
+    {
+        EventProfile *event;
+        u32 line;
+        u64 count;
+    } hot[HOT_LINES] = {0};
+    for (u32 i = 0; i < event_count; i++)
+    {
+        vec *counts = &events[i]->line_counts;
+        for (u32 line = 0; line < counts->len; line++)
+        {
+            u64 count = *(u64 *)vec_get(counts, line);
+            if (count <= hot[HOT_LINES - 1].count)
+                continue;
+
+            u32 at = HOT_LINES - 1;
+            for (; at > 0 && hot[at - 1].count < count; at--)
+                hot[at] = hot[at - 1];
+            hot[at].event = events[i];
+            hot[at].line = events[i]->first_line + line;
+            hot[at].count = count;
+        }
+    }
+    const char *const line_columns[] = {"Event", "Line", "Instructions"};
+    if (begin_table("lines", line_columns, 3))
+    {
+        for (u32 i = 0; i < HOT_LINES && hot[i].count; i++)
+        {
+            igTableNextRow(0, 0);
+            igTableNextColumn();
+            igText("%s", hot[i].event->name);
+            igTableNextColumn();
+            igText("%u", hot[i].line);
+            igTableNextColumn();
+            igText("%llu", (unsigned long long)hot[i].count);
+        }
+        igEndTable();
+    }
+    free(events);
+
+    u64 total = 0;
+    for (u32 op = 0; op < CODE_COUNT; op++)
+        total += profiler->opcodes[op];
+    const char *const opcode_columns[] = {"Instruction", "Count", "%"};
+    if (begin_table("opcodes", opcode_columns, 3))
+    {
+        for (u32 op = 0; op < CODE_COUNT; op++)
+        {
+            if (!profiler->opcodes[op])
+                continue;
+            igTableNextRow(0, 0);
+            igTableNextColumn();
+            igText("%s", INSTRUCTION_NAMES[op]);
+            igTableNextColumn();
+            igText("%llu", (unsigned long long)profiler->opcodes[op]);
+            igTableNextColumn();
+            igText("%.1f", 100.0 * profiler->opcodes[op] / total);
+        }
+        igEndTable();
+    }
+
+    const char *const call_columns[] = {"Command", "Calls", "ms", "us each"};
+    if (begin_table("commands", call_columns, 4))
+    {
+        for (u32 command = 0; command < Command_Max_Val; command++)
+        {
+            if (profiler->commands[command].calls)
+                call_row(COMMAND_NAMES[command], &profiler->commands[command]);
+        }
+        for (u32 i = 0; i < profiler->scopes.len; i++)
+        {
+            ScopeProfile *scope = vec_get(&profiler->scopes, i);
+            call_row(scope->name, &scope->profile);
+        }
+        igEndTable();
+    }
+}
+
 void debug_wnd_show(DebugWindowState *state)
 {
     if (igBegin("Debug", NULL, 0))
@@ -52,6 +264,24 @@ void debug_wnd_show(DebugWindowState *state)
         {
             MapScene *map = (MapScene *)(state->resources->scene);
             igCheckbox("Freecam", &map->freecam);
+
+            TilemapStream *stream = map->tilemap.stream;
+            if (stream)
+            {
+                igLabelText(
+                    "Tilemap Pool", "%u/%u chunks (%llu bytes)",
+                    stream->resident, stream->settings.pool_chunks,
+                    (unsigned long long)tilemap_stream_pool_bytes(stream));
+                igLabelText(
+                    "Tilemap Uploads",
+                    "%u chunks, %llu bytes (%llu peak), %u evicted",
+                    stream->stats.uploads,
+                    (unsigned long long)stream->stats.uploaded_bytes,
+                    (unsigned long long)stream->stats.peak_uploaded_bytes,
+                    stream->stats.evictions);
+                igLabelText("Tilemap Missing", "%u chunks",
+                            stream->stats.missing);
+            }
         }
         igSeparator();
         igInputText("New Map", state->new_map, sizeof(state->new_map),
@@ -81,6 +311,114 @@ void debug_wnd_show(DebugWindowState *state)
 
         f32 delta = time_delta_seconds(state->resources->time.real.time);
         igLabelText("FPS", "%f", 1.0 / delta);
+        igLabelText("Bind Groups", "%u rebuilt",
+                    state->resources->graphics.bind_groups.rebuilds);
+        TextureManager *textures = &state->resources->graphics.texture_manager;
+        igLabelText("Textures", "%u in the binding array, %u packed",
+                    (u32)textures->texture_views.len,
+                    (u32)textures->packed.len);
+        TextureCacheStats *cache = &textures->stats;
+        igLabelText("Texture Cache",
+                    "%u hits, %u misses, %u evicted, %.1fmb resident",
+                    cache->hits, cache->misses, cache->evictions,
+                    cache->resident_bytes / (1024.0 * 1024.0));
+        igLabelText("Cached Textures", "%u, %.1f/%.1fmb", cache->cached,
+                    cache->cached_bytes / (1024.0 * 1024.0),
+                    textures->cache_budget / (1024.0 * 1024.0));
+        TextureLoadStats *loads = &textures->load_stats;
+        igLabelText("Texture Loads", "%u loading, %u uploaded (%.1fkb)",
+                    loads->loading, loads->uploads,
+                    loads->uploaded_bytes / 1024.0);
+        if (igTreeNode_Str("Atlas"))
+        {
+            for (u32 i = 0; i < textures->atlas.pages.len; i++)
+            {
+                AtlasPage *page = vec_get(&textures->atlas.pages, i);
+                igText("page %u: %u textures, %.1f%% full", i, page->regions,
+                       atlas_occupancy(&textures->atlas, i) * 100.0);
+            }
+            igTreePop();
+        }
+        SpriteBatch *batch = &state->resources->graphics.sprite_batch;
+        igLabelText("Sprites", "%u in %u draw calls", batch->last_sprites,
+                    batch->last_draw_calls);
+        Graphics *graphics = &state->resources->graphics;
+        igLabelText("Culling", "%u/%u sprites, %u/%u ui, %u/%u shapes",
+                    graphics->cull_stats.sprites.visible,
+                    graphics->cull_stats.sprites.submitted,
+                    graphics->cull_stats.ui.visible,
+                    graphics->cull_stats.ui.submitted,
+                    graphics->cull_stats.debug_shapes.visible,
+                    graphics->cull_stats.debug_shapes.submitted);
+        igLabelText("Tilemaps", "%u/%u chunks, %u/%u tiles",
+                    graphics->cull_stats.tile_chunks.visible,
+                    graphics->cull_stats.tile_chunks.submitted,
+                    graphics->cull_stats.tiles.visible,
+                    graphics->cull_stats.tiles.submitted);
+        RenderStats *render_stats = &state->resources->graphics.render_stats;
+        if (igTreeNode_Str("Render State"))
+        {
+            igText("%u draws", render_stats->draws);
+            igText("pipelines: %u set, %u skipped", render_stats->pipelines,
+                   render_stats->pipelines_skipped);
+            igText("bind groups: %u set, %u skipped", render_stats->bind_groups,
+                   render_stats->bind_groups_skipped);
+            igText("vertex buffers: %u set, %u skipped",
+                   render_stats->vertex_buffers,
+                   render_stats->vertex_buffers_skipped);
+            igText("index buffers: %u set, %u skipped",
+                   render_stats->index_buffers,
+                   render_stats->index_buffers_skipped);
+            igTreePop();
+        }
+
+        Scheduler *scheduler = &state->resources->scheduler;
+        igLabelText("Scripts", "%u running, %u sleeping, %u waiting",
+                    scheduler_running_count(scheduler),
+                    scheduler_sleeping_count(scheduler),
+                    scheduler_waiting_count(scheduler));
+        igLabelText("VMs", "%u live, %u pooled, %zu bytes",
+                    scheduler->vms.live, vm_pool_pooled_count(&scheduler->vms),
+                    scheduler->vms.bytes);
+        igLabelText("Script Time", "%.3fms, %u paused, %u put off",
+                    duration_as_secs_f64(scheduler->ran_for_last_tick) * 1000.0,
+                    scheduler->preempted_last_tick,
+                    scheduler->deferred_last_tick);
+        if (igTreeNode_Str("Budget Overruns"))
+        {
+            u32 shown = scheduler->overrun_count < OVERRUN_HISTORY
+                            ? scheduler->overrun_count
+                            : OVERRUN_HISTORY;
+            igText("%u total", scheduler->overrun_count);
+            for (u32 i = 0; i < shown; i++)
+            {
+                BudgetOverrun *overrun = scheduler_overrun(scheduler, i);
+                igText("tick %llu: %s at ip %u (%s)",
+                       (unsigned long long)overrun->tick, overrun->event,
+                       overrun->ip,
+                       overrun->type == Overrun_Instructions ? "instructions"
+                                                              : "time");
+            }
+            igTreePop();
+        }
+        if (igTreeNode_Str("Script Profiler"))
+        {
+            show_profiler(state->resources);
+            igTreePop();
+        }
+        if (igTreeNode_Str("Script Globals"))
+        {
+            show_globals(&state->resources->globals);
+            igTreePop();
+        }
+
+        EventIndex *events = &state->resources->events;
+        igLabelText("Events", "%u/%u compiled, %u prefetched",
+                    events->compiled_count, event_index_count(events),
+                    events->prefetched_count);
+        igLabelText("Hot Reload", "%s, %u events reloaded, %u old versions",
+                    events->hot_reload ? "on" : "off", events->reloaded_count,
+                    (u32)events->retired.len);
     }
     igEnd();
 }
@@ -0,0 +1,32 @@
+#include "aot.h"
+#include "utility/log.h"
+#include "utility/macros.h"
+
+u32 aot_find_source(const char *path, const char *source)
+{
+    for (u32 i = 0; i < AOT_SOURCE_COUNT; i++)
+    {
+        if (STRNEQ(AOT_SOURCES[i].path, path))
+            continue;
+
+        if (AOT_SOURCES[i].hash != aot_source_hash(source))
+        {
+            log_info("%s has changed since it was translated, interpreting it",
+                     path);
+            return AOT_NO_SOURCE;
+        }
+        return i;
+    }
+    return AOT_NO_SOURCE;
+}
+
+event_aot_fn aot_find_event(u32 source, const char *name)
+{
+    for (u32 i = 0; i < AOT_EVENT_COUNT; i++)
+    {
+        const AotEvent *aot = &AOT_EVENTS[i];
+        if (aot->source == source && STREQ(aot->name, name))
+            return aot->fn;
+    }
+    return NULL;
+}
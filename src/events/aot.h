@@ -0,0 +1,55 @@
+#pragma once
+
+// ahead-of-time compiled events.
+//
+// at build time, the event_aot tool (see tools/event_aot.c) runs our compiler
+// over the shipped scripts and translates every event into a C function. those
+// functions run the exact same ops as the vm (see vm_ops.h) and call the exact
+// same COMMANDS, but skip decoding and dispatching instructions.
+//
+// each translated function is a resumable coroutine- it switches on the vm's
+// ip to jump back to whichever command yielded last time it was run.
+//
+// because the scripts can be edited without rebuilding the game, every
+// translated file records a hash of the source it was translated from. the
+// translated functions are only used if the source on disk still matches.
+
+#include "events/event.h"
+#include "sensible_nums.h"
+#include "utility/hashmap.h"
+#include <string.h>
+
+typedef struct
+{
+    const char *path;
+    u64 hash;
+} AotSource;
+
+typedef struct
+{
+    const char *name;
+    // index into AOT_SOURCES
+    u32 source;
+    event_aot_fn fn;
+} AotEvent;
+
+// these are all defined by the generated file
+extern const AotSource AOT_SOURCES[];
+extern const u32 AOT_SOURCE_COUNT;
+extern const AotEvent AOT_EVENTS[];
+extern const u32 AOT_EVENT_COUNT;
+
+// inline so the translator can use this without linking the tables above
+static inline u64 aot_source_hash(const char *source)
+{
+    return fnv_hash_function((void *)source, strlen(source));
+}
+
+#define AOT_NO_SOURCE UINT32_MAX
+
+// returns the index of `path` in AOT_SOURCES, as long as `source` is the same
+// as what was translated. otherwise returns AOT_NO_SOURCE
+u32 aot_find_source(const char *path, const char *source);
+// returns the translated function for the event called `name`, or NULL if it
+// wasn't translated
+event_aot_fn aot_find_event(u32 source, const char *name);
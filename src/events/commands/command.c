@@ -0,0 +1,22 @@
+#include "command.h"
+
+const char *const COMMAND_NAMES[Command_Max_Val] = {
+    [CMD_Printf] = "printf",
+    [CMD_Text] = "text",
+    [CMD_Wait] = "wait",
+    [CMD_Yield] = "yield",
+    [CMD_Rand] = "rand",
+
+    [CMD_MoveL] = "move_l",
+    [CMD_MoveR] = "move_r",
+    [CMD_Move] = "move",
+
+    [CMD_ChangeMap] = "change_map",
+    [CMD_Exit] = "exit",
+
+    [CMD_SetItem] = "set_item",
+
+    [CMD_Call] = "call",
+
+    [CMD_Unimplemented] = "unimplemented",
+};
@@ -19,3 +19,9 @@ typedef enum
 
     Command_Max_Val,
 } Command;
+
+// the names scripts use to call each command.
+// these live apart from COMMANDS so that tools which only need to compile
+// scripts (like the aot translator) don't have to link every command, and
+// everything those commands depend on
+extern const char *const COMMAND_NAMES[Command_Max_Val];
@@ -0,0 +1,38 @@
+#pragma once
+
+// kept apart from command.h, because instructions need to know about commands,
+// and these need to know about the scheduler
+#include "events/scheduler.h"
+#include <stdbool.h>
+
+// state that commands need to hang onto while they're yielding
+typedef struct
+{
+    bool started;
+} WaitCtx;
+
+typedef struct
+{
+    bool has_started;
+} TextCtx;
+
+typedef struct
+{
+    bool did_yield;
+} YieldCtx;
+
+typedef struct
+{
+    bool started;
+    ScriptHandle script;
+} CallCtx;
+
+// only one command can be running on a vm at a time, so they all share the
+// same space. commands should zero it once they're done (see CLEAR_CTX)
+typedef union
+{
+    WaitCtx wait;
+    TextCtx text;
+    YieldCtx yield;
+    CallCtx call;
+} CommandCtx;
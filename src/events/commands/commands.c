@@ -1,11 +1,13 @@
 #include "commands.h"
 #include "characters/basic.h"
 #include "events/commands/command.h"
+#include "events/profiler.h"
 #include "events/value.h"
 #include "events/vm.h"
 #include "scenes/map.h"
 #include "utility/macros.h"
 #include "resources.h"
+#include <math.h>
 
 #define ARG_ERROR(name, expected)                                              \
     if (arg_count != expected)                                                 \
@@ -13,7 +15,7 @@
         FATAL("wrong arity (%d) for " #name "\n", arg_count)                   \
     }
 
-#define CLEAR_CTX(vm) memset(vm->command_ctx, 0, sizeof(vm->command_ctx));
+#define CLEAR_CTX(vm) vm->command_ctx = (CommandCtx){0};
 
 // FIXME: argument type validation
 
@@ -50,43 +52,36 @@ static bool cmd_printf(VM *vm, Value *out, u32 arg_count, Resources *resources)
 
 static bool cmd_wait(VM *vm, Value *out, u32 arg_count, Resources *resources)
 {
-    struct WaitCtx
-    {
-        f32 waited;
-    };
-
     (void)out;
-    (void)resources;
     ARG_ERROR("wait", 1);
 
     Value wait_val = vm_peek(vm, vm->top - 1);
     f32 wait_time = wait_val.data._float;
 
-    struct WaitCtx *ctx = (struct WaitCtx *)vm->command_ctx;
+    WaitCtx *ctx = &vm->command_ctx.wait;
 
     // we're done waiting, stop yielding
-    if (ctx->waited >= wait_time)
+    if (ctx->started || wait_time <= 0.0f)
     {
         CLEAR_CTX(vm);
         vm_pop(vm);
         return false;
     }
 
-    ctx->waited += time_delta_seconds(resources->time.current);
+    // rather than checking every tick, have the scheduler put us to sleep for
+    // however many ticks that is
+    f32 timestep = duration_as_secs(resources->time.fixed.timestep);
+    vm_wait_ticks(vm, (u32)ceilf(wait_time / timestep));
+    ctx->started = true;
     return true;
 }
 
 static bool cmd_text(VM *vm, Value *out, u32 arg_count, Resources *resources)
 {
-    struct TextCtx
-    {
-        bool has_started;
-    };
-
     (void)out;
     ARG_ERROR("text", 1);
 
-    struct TextCtx *ctx = (struct TextCtx *)vm->command_ctx;
+    TextCtx *ctx = &vm->command_ctx.text;
     MapScene *scene = (MapScene *)resources->scene;
 
     if (ctx->has_started)
@@ -94,7 +89,10 @@ static bool cmd_text(VM *vm, Value *out, u32 arg_count, Resources *resources)
         // we've already displayed the text, and are waiting for the textbox to
         // finish.
         if (scene->textbox.open)
+        {
+            vm_wait_signal(vm, Signal_TextboxClosed);
             return true;
+        }
 
         // we're done waiting, stop yielding, and pop the argument off the stack
         CLEAR_CTX(vm);
@@ -105,26 +103,36 @@ static bool cmd_text(VM *vm, Value *out, u32 arg_count, Resources *resources)
     // indicate that we are waiting for the textbox to finish
     Value text_val = vm_peek(vm, vm->top - 1);
     char *text = text_val.data.string;
-    textbox_display_text(&scene->textbox, resources, text);
+    // string literals were already split up when the event was compiled
+    const TextRuns *runs = event_text(&vm->event, text);
+    TextRuns parsed;
+    if (!runs)
+    {
+        text_runs_parse(&parsed, text);
+        runs = &parsed;
+    }
+
+    Instant display_start = vm_profiler_scope_begin();
+    textbox_display_text(&scene->textbox, resources, runs);
+    vm_profiler_scope_end(display_start, "textbox_display_text");
+    if (runs == &parsed)
+        text_runs_free(&parsed);
     ctx->has_started = true;
 
+    // the textbox will wake us up once it's closed
+    vm_wait_signal(vm, Signal_TextboxClosed);
     return true;
 }
 
 static bool cmd_yield(VM *vm, Value *out, u32 arg_count, Resources *resources)
 {
-    struct YieldCtx
-    {
-        bool did_yield;
-    };
-
     (void)vm;
     (void)arg_count;
     (void)resources;
     (void)out;
     ARG_ERROR("yield", 0);
 
-    struct YieldCtx *ctx = (struct YieldCtx *)vm->command_ctx;
+    YieldCtx *ctx = &vm->command_ctx.yield;
 
     if (ctx->did_yield)
     {
@@ -224,7 +232,7 @@ static bool cmd_change_map(VM *vm, Value *out, u32 arg_count,
 
     // set the instruction pointer to the
     // end of the event to exit execution
-    vm->ip = vm->event.instructions_len;
+    vm->ip = vm->event.code_len;
 
     return false;
 }
@@ -238,7 +246,7 @@ static bool cmd_exit(VM *vm, Value *out, u32 arg_count, Resources *resources)
 
     // set the instruction pointer to the
     // end of the event to exit execution
-    vm->ip = vm->event.instructions_len;
+    vm->ip = vm->event.code_len;
 
     return false;
 }
@@ -264,40 +272,30 @@ static bool cmd_call(VM *vm, Value *out, u32 arg_count, Resources *resources)
 
     ARG_ERROR("call", 1);
 
-    // because we're treating the command_ctx as a pointer to a VM, and we need
-    // to take a pointer to the command context (so it becomes a VM**)
-    VM **ctx = (VM **)vm->command_ctx;
+    CallCtx *ctx = &vm->command_ctx.call;
 
-    if (!*ctx)
+    if (!ctx->started)
     {
         const char *event_name = vm_pop(vm).data.string;
-        Event event = {0};
-
-        for (u32 i = 0; i < resources->event_count; i++)
+        Event event;
+        if (!event_index_get(&resources->events, event_name, &event))
         {
-            if (!strcmp(event_name, resources->events[i].name))
-            {
-                event = resources->events[i];
-                break;
-            }
+            FATAL("Can't call event `%s`\n", event_name);
         }
 
-        PTR_ERRCHK(event.name, "Event does not exist\n");
-
-        *ctx = malloc(sizeof(VM));
-
-        vm_init(*ctx, event);
-        (*ctx)->vm_ctx = vm->vm_ctx;
+        // the callee runs on its own, and wakes us up when it's done
+        ctx->script =
+            scheduler_spawn(&resources->scheduler, event, vm->vm_ctx);
+        ctx->started = true;
     }
 
-    if (vm_execute(*ctx, resources))
+    if (!scheduler_is_running(&resources->scheduler, ctx->script))
     {
-        free(*ctx);
         CLEAR_CTX(vm);
-
         return false;
     }
 
+    vm_wait_script(vm, ctx->script);
     return true;
 }
 
@@ -312,22 +310,22 @@ static bool unimplemented(VM *vm, Value *out, u32 arg_count,
 }
 
 const CommandData COMMANDS[] = {
-    [CMD_Printf] = {"printf", cmd_printf},
-    [CMD_Text] = {"text", cmd_text},
-    [CMD_Wait] = {"wait", cmd_wait},
-    [CMD_Yield] = {"yield", cmd_yield},
-    [CMD_Rand] = {"rand", cmd_rand},
+    [CMD_Printf] = {cmd_printf},
+    [CMD_Text] = {cmd_text},
+    [CMD_Wait] = {cmd_wait},
+    [CMD_Yield] = {cmd_yield},
+    [CMD_Rand] = {cmd_rand},
 
-    [CMD_MoveL] = {"move_l", cmd_move_l},
-    [CMD_MoveR] = {"move_r", cmd_move_r},
-    [CMD_Move] = {"move", cmd_move},
+    [CMD_MoveL] = {cmd_move_l},
+    [CMD_MoveR] = {cmd_move_r},
+    [CMD_Move] = {cmd_move},
 
-    [CMD_ChangeMap] = {"change_map", cmd_change_map},
-    [CMD_Exit] = {"exit", cmd_exit},
+    [CMD_ChangeMap] = {cmd_change_map},
+    [CMD_Exit] = {cmd_exit},
 
-    [CMD_SetItem] = {"set_item", cmd_set_item},
+    [CMD_SetItem] = {cmd_set_item},
 
-    [CMD_Call] = {"call", cmd_call},
+    [CMD_Call] = {cmd_call},
 
-    [CMD_Unimplemented] = {"unimplemented", unimplemented},
+    [CMD_Unimplemented] = {unimplemented},
 };
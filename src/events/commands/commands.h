@@ -18,9 +18,9 @@
 typedef bool (*command_fn)(VM *vm, Value *out, u32 arg_count,
                            Resources *resources);
 
+// see COMMAND_NAMES for the name of each command
 typedef struct
 {
-    char *name;
     command_fn fn;
 } CommandData;
 
@@ -1,15 +1,29 @@
 #include "compiler.h"
-#include "events/commands/commands.h"
+#include "events/commands/command.h"
+#include "events/globals.h"
 #include "events/lexer.h"
 #include "events/instruction.h"
-#include "utility/macros.h"
+#include "events/keywords.h"
+#include "events/typecheck.h"
+#include "utility/intern.h"
 #include "utility/vec.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 void compiler_init(Compiler *compiler, const char *source)
 {
     lexer_init(&compiler->lexer, source);
     compiler->is_primed = false;
+
+    compiler->line = 1;
+    compiler->counted_to = source;
+    compiler->previous_end = source;
+
+    compiler->failed = false;
+    compiler->error[0] = '\0';
+    compiler->error_line = 0;
 }
 
 typedef enum
@@ -48,18 +62,91 @@ typedef struct
 {
     // either the name of the label, or the label a goto is expecting
     char *label;
-    // the instruction the goto/label is at
+    // the offset of the goto/label in the code
     u32 instruction;
+    // where the goto is, in case the label doesn't exist
+    u32 line;
 } LabelDef;
 
 // quite a lot of this is copied from
 // https://craftinginterpreters.com/compiling-expressions.html#a-pratt-parser
 
-// TODO handle EOF
+// the line `at` is on. it can't be before anything that's been counted
+static u32 line_at(Compiler *compiler, const char *at)
+{
+    u32 line = compiler->line;
+    const char *p = compiler->counted_to;
+    while (p < at && (p = memchr(p, '\n', at - p)))
+    {
+        line++;
+        p++;
+    }
+    return line;
+}
+
+// only the first error is kept. anything after it is usually just the parser
+// being confused by the first one
+static void verror_at(Compiler *compiler, u32 line, const char *format,
+                      va_list args)
+{
+    if (compiler->failed)
+        return;
+    compiler->failed = true;
+    compiler->error_line = line;
+    vsnprintf(compiler->error, sizeof(compiler->error), format, args);
+}
+
+static void error_at(Compiler *compiler, u32 line, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    verror_at(compiler, line, format, args);
+    va_end(args);
+}
+
+// an error at the current token
+static void error(Compiler *compiler, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    verror_at(compiler, line_at(compiler, compiler->lexer.start), format,
+              args);
+    va_end(args);
+}
+
+// an error at the previous token
+static void error_previous(Compiler *compiler, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    verror_at(compiler, line_at(compiler, compiler->previous_end), format,
+              args);
+    va_end(args);
+}
+
+// for tokens that never got used, because of an error
+static void free_token(Token *token)
+{
+    switch (token->type)
+    {
+    case Token_String:
+    case Token_Ident:
+    case Token_Label:
+    case Token_Global:
+        free(token->data.string);
+        break;
+    default:
+        break;
+    }
+}
+
 static void advance(Compiler *compiler)
 {
     compiler->previous = compiler->current;
+    compiler->previous_end = compiler->lexer.current;
     lexer_next(&compiler->lexer, &compiler->current);
+    if (compiler->current.type == Token_Error)
+        error(compiler, "%s", compiler->current.data.error);
 }
 
 static bool check(Compiler *compiler, TokenType type)
@@ -75,25 +162,50 @@ static bool match(Compiler *compiler, TokenType type)
     return true;
 }
 
-// advances the compiler, and throws an error if the next token did not match
-// the expected token type.
-static void consume(Compiler *compiler, TokenType expected, const char *err)
+// advances the compiler if the next token is the expected token type.
+// otherwise records an error and returns false
+static bool consume(Compiler *compiler, TokenType expected, const char *err)
 {
     if (compiler->current.type == expected)
     {
         advance(compiler);
-        return;
+        return true;
+    }
+
+    if (compiler->current.type == Token_Eof)
+        error(compiler, "%s, got the end of the file", err);
+    else
+        error(compiler, "%s, got '%.*s'", err,
+              (int)(compiler->lexer.current - compiler->lexer.start),
+              compiler->lexer.start);
+    return false;
+}
+
+// instructions are attributed to whatever line the token that finished them is
+// on. tokens only ever move forwards, so lines only need counting once
+static void mark_line(Compiler *compiler)
+{
+    const char *p = compiler->counted_to;
+    const char *end = compiler->previous_end;
+    while (p < end && (p = memchr(p, '\n', end - p)))
+    {
+        compiler->line++;
+        p++;
     }
+    if (end > compiler->counted_to)
+        compiler->counted_to = end;
 
-    FATAL_ERR_MSG("%s, got ", err);
-    token_debug_printf(compiler->current);
-    printf("\n");
-    exit(1);
+    LineStart *last = vec_get(&compiler->lines, compiler->lines.len - 1);
+    if (last && last->line == compiler->line)
+        return;
+    LineStart start = {.ip = compiler->code.len, .line = compiler->line};
+    vec_push(&compiler->lines, &start);
 }
 
 static void emit(Compiler *compiler, Instruction instruction)
 {
-    vec_push(&compiler->instructions, &instruction);
+    mark_line(compiler);
+    instruction_encode(&compiler->code, instruction);
 }
 
 static void emit_basic(Compiler *compiler, InstructionCode code)
@@ -102,21 +214,32 @@ static void emit_basic(Compiler *compiler, InstructionCode code)
     emit(compiler, instruction);
 }
 
+// the offset the next instruction will be emitted at
+static u32 code_position(Compiler *compiler)
+{
+    if (compiler->code.len > CODE_MAX_LEN)
+        error(compiler, "Event is too long (more than %d bytes of code)",
+              CODE_MAX_LEN);
+    return compiler->code.len;
+}
+
 // will emit a jump. callee will need to fill in the position!
 static u32 emit_unknown_jump(Compiler *compiler, InstructionCode code)
 {
-    u32 current_instruction = compiler->instructions.len;
-    Instruction instruction = {.code = code, .data.position = UINT32_MAX};
+    u32 current_instruction = code_position(compiler);
+    Instruction instruction = {.code = code, .data.position = UINT16_MAX};
     emit(compiler, instruction);
     return current_instruction;
 }
 
 static void patch_jump(Compiler *compiler, u32 offset)
 {
-    u32 jump_pos = compiler->instructions.len;
+    u32 jump_pos = code_position(compiler);
 
-    Instruction *instruction = vec_get(&compiler->instructions, offset);
-    instruction->data.position = jump_pos;
+    // skip over the opcode
+    u8 *position = vec_get(&compiler->code, offset + 1);
+    position[0] = jump_pos & 0xFF;
+    position[1] = (jump_pos >> 8) & 0xFF;
 }
 
 static void emit_jump(Compiler *compiler, InstructionCode code, u32 position)
@@ -137,12 +260,37 @@ static void emit_int(Compiler *compiler, bool can_assign)
     emit(compiler, instruction);
 }
 
+// returns the index of `value` in the event's constants, adding it if it isn't
+// there already
+static u32 add_constant(Compiler *compiler, Value value)
+{
+    for (u32 i = 0; i < compiler->constants.len; i++)
+    {
+        Value *constant = vec_get(&compiler->constants, i);
+        if (constant->type != value.type)
+            continue;
+
+        // compare floats bitwise, so -0.0 and 0.0 stay different
+        if (value.type == Val_Float &&
+            !memcmp(&constant->data._float, &value.data._float, sizeof(f32)))
+            return i;
+        // strings are interned
+        if (value.type == Val_String &&
+            constant->data.string == value.data.string)
+            return i;
+    }
+
+    vec_push(&compiler->constants, &value);
+    return compiler->constants.len - 1;
+}
+
 static void emit_float(Compiler *compiler, bool can_assign)
 {
     (void)can_assign;
+    Value value = FLOAT_VAL(compiler->previous.data._float);
     Instruction instruction = {
         .code = Code_Float,
-        .data._float = compiler->previous.data._float,
+        .data.constant = add_constant(compiler, value),
     };
     emit(compiler, instruction);
 }
@@ -150,9 +298,13 @@ static void emit_float(Compiler *compiler, bool can_assign)
 static void emit_string(Compiler *compiler, bool can_assign)
 {
     (void)can_assign;
+    char *string = compiler->previous.data.string;
+    Value value = STRING_VAL(intern_string(string));
+    free(string);
+
     Instruction instruction = {
         .code = Code_String,
-        .data.string = compiler->previous.data.string,
+        .data.constant = add_constant(compiler, value),
     };
     emit(compiler, instruction);
 }
@@ -202,81 +354,131 @@ static void grouping(Compiler *compiler, bool can_assign)
     consume(compiler, Token_ParenR, "Expected '')' after grouping");
 }
 
-static void call(Compiler *compiler, char *command_name)
+// if the only thing text() is given is a string literal, split it into runs
+// now so the textbox doesn't have to
+static void preparse_text(Compiler *compiler, u32 args_start)
 {
-    Command command = 0;
-    for (; command < Command_Max_Val; command++)
+    Instruction insn;
+    u32 args_end =
+        instruction_decode((u8 *)compiler->code.data, args_start, &insn);
+    if (insn.code != Code_String || args_end != code_position(compiler))
+        return;
+
+    Value *constant = vec_get(&compiler->constants, insn.data.constant);
+    const char *string = constant->data.string;
+    for (u32 i = 0; i < compiler->texts.len; i++)
     {
-        CommandData data = COMMANDS[command];
-        if (!strcmp(data.name, command_name))
-            break;
+        TextRuns *existing = vec_get(&compiler->texts, i);
+        if (existing->source == string)
+            return;
     }
-    if (command == Command_Max_Val)
+
+    TextRuns runs;
+    text_runs_parse(&runs, string);
+    vec_push(&compiler->texts, &runs);
+}
+
+static void call(Compiler *compiler, char *command_name)
+{
+    const Keyword *keyword =
+        keyword_lookup(command_name, strlen(command_name));
+    if (!keyword || !keyword->is_command)
     {
-        FATAL("Unrecognized command '%s'\n", command_name);
+        error_previous(compiler, "Unrecognized command '%s'", command_name);
+        free(command_name);
+        return;
     }
+    Command command = keyword->data.command;
 
+    u32 args_start = code_position(compiler);
     u32 arg_count = argument_list(compiler);
+    if (arg_count > UINT8_MAX)
+    {
+        error_previous(compiler, "Too many arguments to '%s'", command_name);
+        free(command_name);
+        return;
+    }
+    if (command == CMD_Text && arg_count == 1)
+        preparse_text(compiler, args_start);
     Instruction instruction = {
         .code = Code_Call,
         .data.call = {command, arg_count},
     };
     emit(compiler, instruction);
+    free(command_name);
+}
+
+// hashmap values aren't aligned, so they have to be copied out
+static u32 read_u32(void *value)
+{
+    u32 out;
+    memcpy(&out, value, sizeof(u32));
+    return out;
 }
 
 // will free the variable name if it is already present!
 static u32 get_or_insert_variable(Compiler *compiler, char *name)
 {
-    for (u32 i = 0; i < compiler->variables.len; i++)
+    void *existing = hashmap_get(&compiler->variable_slots, &name);
+    if (existing)
     {
-        char *var = *(char **)vec_get(&compiler->variables, i);
-        if (!strcmp(name, var))
-        {
-            free(name);
-            return i;
-        }
+        free(name);
+        return read_u32(existing);
     }
 
     // looks like this variable hasn't been used yet.
     // push it to the array and return the slot
     u32 slot = compiler->variables.len;
+    if (slot >= SLOT_MAX)
+    {
+        error_previous(compiler,
+                       "Too many variables (an event can have at most %d)",
+                       SLOT_MAX);
+        free(name);
+        return 0;
+    }
     vec_push(&compiler->variables, &name);
+    hashmap_insert(&compiler->variable_slots, &name, &slot);
     return slot;
 }
 
-static void identifier(Compiler *compiler, bool can_assign)
+// records that the event uses a global, so translated events can find it
+static void use_global(Compiler *compiler, u32 global)
 {
-    char *ident = compiler->previous.data.ident;
-    if (match(compiler, Token_ParenL))
+    // events only ever use a handful of globals
+    for (u32 i = 0; i < compiler->globals.len; i++)
     {
-        // turns out this was a command call. handle that and return immediately
-        call(compiler, ident);
-        return;
+        if (*(u32 *)vec_get(&compiler->globals, i) == global)
+            return;
     }
+    vec_push(&compiler->globals, &global);
+}
 
-    u32 slot = get_or_insert_variable(compiler, ident);
-    Instruction instruction = {.data.slot = slot};
-    instruction.code = Code_Fetch;
+// fetches or sets a variable. `fetch` and `set` are the instructions that do
+// that for this particular variable
+static void variable(Compiler *compiler, bool can_assign, Instruction fetch,
+                     Instruction set)
+{
     // if we can't assign, then this has to be a fetch op.
     if (!can_assign)
     {
-        emit(compiler, instruction);
+        emit(compiler, fetch);
         return;
     }
 
     // otherwise, check if it's a set op
     if (match(compiler, Token_Set))
     {
-        instruction.code = Code_Set;
         expression(compiler);
-        emit(compiler, instruction);
+        emit(compiler, set);
         return;
     }
 
+    Instruction instruction = {0};
     // all of these start with fetching a value, so we emit that here.
     // if none of these cases apply, then we're just fetching the variable, so
     // this works anyway.
-    emit(compiler, instruction);
+    emit(compiler, fetch);
     if (match(compiler, Token_Inc))
     {
         // emit number
@@ -336,9 +538,35 @@ static void identifier(Compiler *compiler, bool can_assign)
     // emit the math op
     emit(compiler, instruction);
     // ..and emit set
-    instruction.code = Code_Set;
-    instruction.data.slot = slot;
-    emit(compiler, instruction);
+    emit(compiler, set);
+}
+
+static void identifier(Compiler *compiler, bool can_assign)
+{
+    char *ident = compiler->previous.data.ident;
+    if (match(compiler, Token_ParenL))
+    {
+        // turns out this was a command call. handle that and return immediately
+        call(compiler, ident);
+        return;
+    }
+
+    u32 slot = get_or_insert_variable(compiler, ident);
+    Instruction fetch = {.code = Code_Fetch, .data.slot = slot};
+    Instruction set = {.code = Code_Set, .data.slot = slot};
+    variable(compiler, can_assign, fetch, set);
+}
+
+static void global(Compiler *compiler, bool can_assign)
+{
+    char *name = compiler->previous.data.ident;
+    u32 index = global_index(name);
+    free(name);
+    use_global(compiler, index);
+
+    Instruction fetch = {.code = Code_FetchGlobal, .data.global = index};
+    Instruction set = {.code = Code_SetGlobal, .data.global = index};
+    variable(compiler, can_assign, fetch, set);
 }
 
 // we don't actually have instructions for boolean logic. instead we
@@ -472,6 +700,7 @@ const ParseRule rules[] = {
     // special
     [Token_Ident] = {identifier, NULL, Prec_None},
     [Token_Label] = NULL_RULE,
+    [Token_Global] = {global, NULL, Prec_None},
 
     // braces
     [Token_BraceL] = NULL_RULE,
@@ -509,6 +738,9 @@ const ParseRule rules[] = {
     [Token_Mult] = {NULL, binary, Prec_Factor},
     [Token_Div] = {NULL, binary, Prec_Factor},
     [Token_Mod] = {NULL, binary, Prec_Factor},
+
+    [Token_Eof] = NULL_RULE,
+    [Token_Error] = NULL_RULE,
 };
 
 static const ParseRule *get_rule(TokenType type) { return &rules[type]; }
@@ -518,7 +750,11 @@ static void parse_precedence(Compiler *compiler, Precendence precedence)
     advance(compiler);
     const ParseRule *rule = get_rule(compiler->previous.type);
     if (rule->prefix == NULL)
-        FATAL("Expected expression\n");
+    {
+        error_previous(compiler, "Expected expression");
+        free_token(&compiler->previous);
+        return;
+    }
 
     bool can_assign = precedence <= Prec_Set;
     rule->prefix(compiler, can_assign);
@@ -531,9 +767,7 @@ static void parse_precedence(Compiler *compiler, Precendence precedence)
     }
 
     if (can_assign && match(compiler, Token_Set))
-    {
-        FATAL("Invalid assignment target");
-    }
+        error_previous(compiler, "Invalid assignment target");
 }
 
 static void expression(Compiler *compiler)
@@ -543,7 +777,8 @@ static void expression(Compiler *compiler)
 
 static void block(Compiler *compiler)
 {
-    while (!check(compiler, Token_BraceR) && !lexer_eof(&compiler->lexer))
+    while (!check(compiler, Token_BraceR) && !check(compiler, Token_Eof) &&
+           !compiler->failed)
     {
         statement(compiler);
     }
@@ -595,14 +830,14 @@ static void loop_statement(Compiler *compiler)
 {
     consume(compiler, Token_BraceL, "Expected '{' after loop");
 
-    u32 loop_start = compiler->instructions.len;
+    u32 loop_start = code_position(compiler);
     block(compiler);
     emit_jump(compiler, Code_Goto, loop_start);
 }
 
 static void while_statement(Compiler *compiler)
 {
-    u32 loop_start = compiler->instructions.len;
+    u32 loop_start = code_position(compiler);
     // condition
     expression(compiler);
     consume(compiler, Token_BraceL, "Expected '{' after while condition");
@@ -629,7 +864,7 @@ static void for_statement(Compiler *compiler)
         expression_statement(compiler);
     }
 
-    u32 loop_start = compiler->instructions.len;
+    u32 loop_start = code_position(compiler);
     u32 exit_jump = UINT32_MAX;
     if (!match(compiler, Token_Semicolon))
     {
@@ -647,7 +882,7 @@ static void for_statement(Compiler *compiler)
         // need to do shenanigans because we want to execute this after the body
         // but we have to emit the instructions *now*
         u32 body_jump = emit_unknown_jump(compiler, Code_Goto);
-        u32 increment_start = compiler->instructions.len;
+        u32 increment_start = code_position(compiler);
         expression(compiler);
         emit_basic(compiler, Code_Pop); // pop increment result
         consume(compiler, Token_BraceL, "Expected '{' after for clauses");
@@ -673,24 +908,24 @@ static void for_statement(Compiler *compiler)
 // fills out the location if a label was found.
 static bool find_label(Compiler *compiler, char *wanted, u32 *location)
 {
-    for (u32 i = 0; i < compiler->labels.len; i++)
-    {
-        LabelDef *label = vec_get(&compiler->labels, i);
-        if (!strcmp(label->label, wanted))
-        {
-            *location = label->instruction;
-            return true;
-        }
-    }
+    void *label = hashmap_get(&compiler->labels, &wanted);
+    if (!label)
+        return false;
 
-    return false;
+    *location = read_u32(label);
+    return true;
 }
 
 static void goto_statement(Compiler *compiler)
 {
-    consume(compiler, Token_Ident, "Expected label after goto");
+    if (!consume(compiler, Token_Ident, "Expected label after goto"))
+        return;
     char *label = compiler->previous.data.ident;
-    consume(compiler, Token_Semicolon, "Expected ';' after goto label");
+    if (!consume(compiler, Token_Semicolon, "Expected ';' after goto label"))
+    {
+        free(label);
+        return;
+    }
 
     u32 jump_position;
     if (find_label(compiler, label, &jump_position))
@@ -704,7 +939,11 @@ static void goto_statement(Compiler *compiler)
     {
         // we'll need to find it later...
         u32 goto_position = emit_unknown_jump(compiler, Code_Goto);
-        LabelDef to_backfill = {.label = label, .instruction = goto_position};
+        LabelDef to_backfill = {
+            .label = label,
+            .instruction = goto_position,
+            .line = compiler->line,
+        };
         vec_push(&compiler->unresolved_gotos, &to_backfill);
     }
 }
@@ -712,20 +951,28 @@ static void goto_statement(Compiler *compiler)
 static void label_statement(Compiler *compiler)
 {
     char *label = compiler->previous.data.label;
-    u32 label_position = compiler->instructions.len;
+    u32 label_position = code_position(compiler);
     if (find_label(compiler, label, &label_position))
     {
-        FATAL("Label %s already defined\n", label);
+        error_previous(compiler, "Label %s already defined", label);
+        free(label);
+        return;
     }
-    LabelDef definition = {.label = label, .instruction = label_position};
-    vec_push(&compiler->labels, &definition);
+    hashmap_insert(&compiler->labels, &label, &label_position);
 }
 
-static void free_label_def(usize i, void *arg)
+static void free_labels(HashMap *labels)
 {
-    (void)i;
-    LabelDef *def = arg;
-    free(def->label);
+    HashMapIter iter;
+    hashmap_iter_init(labels, &iter);
+    void *key;
+    while (hashmap_iter_next(&iter, &key, NULL))
+    {
+        char *label;
+        memcpy(&label, key, sizeof(char *));
+        free(label);
+    }
+    hashmap_free(labels);
 }
 
 // we could probably remove statements and make them behave like rust does...
@@ -733,7 +980,9 @@ static void statement(Compiler *compiler)
 {
     if (match(compiler, Token_Event))
     {
-        FATAL("Event definition is not allowed inside events\n");
+        error_previous(compiler,
+                       "Event definition is not allowed inside events");
+        return;
     }
 
     // we don't do scopes, so blocks don't do much aside reduce visual clutter
@@ -771,15 +1020,42 @@ static void statement(Compiler *compiler)
     }
 }
 
+// throws away everything compiled so far, after an error
+static void discard(Compiler *compiler, char *name)
+{
+    free(name);
+    free_token(&compiler->current);
+    compiler->current.type = Token_Eof;
+
+    for (u32 i = 0; i < compiler->variables.len; i++)
+        free(*(char **)vec_get(&compiler->variables, i));
+    vec_free(&compiler->variables);
+    for (u32 i = 0; i < compiler->texts.len; i++)
+        text_runs_free(vec_get(&compiler->texts, i));
+    vec_free(&compiler->texts);
+
+    vec_free(&compiler->code);
+    vec_free(&compiler->constants);
+    vec_free(&compiler->lines);
+    vec_free(&compiler->globals);
+}
+
 bool compiler_compile(Compiler *compiler, Event *event)
 {
-    if (lexer_eof(&compiler->lexer))
+    if (compiler->failed || lexer_eof(&compiler->lexer))
         return false;
 
-    vec_init(&compiler->instructions, sizeof(Instruction));
+    vec_init(&compiler->code, sizeof(u8));
+    vec_init(&compiler->constants, sizeof(Value));
+    vec_init(&compiler->lines, sizeof(LineStart));
     vec_init(&compiler->variables, sizeof(char *));
+    hashmap_init(&compiler->variable_slots, fnv_cstr_ptr_hash_function,
+                 cstr_ptr_eq_function, sizeof(char *), sizeof(u32));
+    vec_init(&compiler->globals, sizeof(u32));
+    vec_init(&compiler->texts, sizeof(TextRuns));
 
-    vec_init(&compiler->labels, sizeof(LabelDef));
+    hashmap_init(&compiler->labels, fnv_cstr_ptr_hash_function,
+                 cstr_ptr_eq_function, sizeof(char *), sizeof(u32));
     vec_init(&compiler->unresolved_gotos, sizeof(LabelDef));
 
     // when the compiler is first initialized, current and previous are
@@ -789,12 +1065,14 @@ bool compiler_compile(Compiler *compiler, Event *event)
         advance(compiler);
         compiler->is_primed = true;
     }
-    consume(compiler, Token_Event, "Expected event definition");
-    consume(compiler, Token_String, "Expected event name");
-    event->name = compiler->previous.data.string;
-    consume(compiler, Token_BraceL, "Expected block after event name");
-
-    block(compiler);
+    char *name = NULL;
+    if (consume(compiler, Token_Event, "Expected event definition") &&
+        consume(compiler, Token_String, "Expected event name"))
+    {
+        name = compiler->previous.data.string;
+        if (consume(compiler, Token_BraceL, "Expected block after event name"))
+            block(compiler);
+    }
 
     // resolve any unresolved gotos
     for (u32 i = 0; i < compiler->unresolved_gotos.len; i++)
@@ -802,25 +1080,63 @@ bool compiler_compile(Compiler *compiler, Event *event)
         LabelDef *to_backfill = vec_get(&compiler->unresolved_gotos, i);
 
         u32 label_position;
-        if (!find_label(compiler, to_backfill->label, &label_position))
+        if (find_label(compiler, to_backfill->label, &label_position))
         {
-            FATAL("Undefined label %s", to_backfill->label);
+            u8 *position =
+                vec_get(&compiler->code, to_backfill->instruction + 1);
+            position[0] = label_position & 0xFF;
+            position[1] = (label_position >> 8) & 0xFF;
         }
-
-        Instruction *instruction =
-            vec_get(&compiler->instructions, to_backfill->instruction);
-        instruction->data.position = label_position;
+        else
+            error_at(compiler, to_backfill->line, "Undefined label %s",
+                     to_backfill->label);
         free(to_backfill->label);
     }
     vec_free(&compiler->unresolved_gotos);
 
-    vec_free_with(&compiler->labels, free_label_def);
+    free_labels(&compiler->labels);
+    // the names are owned by the event now
+    hashmap_free(&compiler->variable_slots);
+
+    if (compiler->failed)
+    {
+        discard(compiler, name);
+        return false;
+    }
+    event->name = name;
+
+    // makes sure that jumps to the end of the event fit
+    event->code_len = code_position(compiler);
+    event->code = (u8 *)compiler->code.data;
 
-    event->instructions_len = compiler->instructions.len;
-    event->instructions = (Instruction *)compiler->instructions.data;
+    event->constants = (Value *)compiler->constants.data;
+    event->constant_count = compiler->constants.len;
 
     event->slots = (char **)compiler->variables.data;
     event->slot_count = compiler->variables.len;
 
+    event->globals = (u32 *)compiler->globals.data;
+    event->global_count = compiler->globals.len;
+
+    event->texts = (TextRuns *)compiler->texts.data;
+    event->text_count = compiler->texts.len;
+
+    event->lines = (LineStart *)compiler->lines.data;
+    event->line_count = compiler->lines.len;
+
+    event->aot = NULL;
+
+    char error[128];
+    u32 error_ip;
+    if (!typecheck_event(event, error, sizeof(error), &error_ip))
+    {
+        compiler->failed = true;
+        compiler->error_line = event_line(event, error_ip);
+        snprintf(compiler->error, sizeof(compiler->error),
+                 "Type error in event '%s': %s", event->name, error);
+        event_free(event);
+        return false;
+    }
+
     return true;
 }
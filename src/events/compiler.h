@@ -6,6 +6,7 @@
 
 #include "events/event.h"
 #include "events/lexer.h"
+#include "utility/hashmap.h"
 #include "utility/vec.h"
 
 typedef struct
@@ -16,22 +17,48 @@ typedef struct
     Token current;
     Token previous;
 
-    vec instructions; // vec<Instruction>
+    vec code;      // vec<u8> (see instruction.h)
+    vec constants; // vec<Value>
+    vec lines;     // vec<LineStart>
 
-    vec unresolved_gotos; // vec<(char*, u32)> (indexes into instructions)
-    vec labels; // vec<(char*, u32)> (label name and instruction index)
+    // the line the end of the previous token is on. starts at 1, but can be
+    // set after compiler_init if the source doesn't start at the top of a file
+    u32 line;
+    // how far into the source lines have been counted
+    const char *counted_to;
+    // the end of the previous token
+    const char *previous_end;
+
+    vec unresolved_gotos; // vec<(char*, u32)> (offsets into code)
+    HashMap labels; // HashMap<char*, u32> (label name to offset into code)
 
     // list of variables. whenever the compiler finds a mention of a variable,
     // it adds it to this list. the compiler never emits variable names though-
     // only "slots" that variables are stored in.
     // the interpreter is expected to reserve these slots for variables
     vec variables; // vec<char*>
+    // index into variables, so looking a variable up doesn't mean checking
+    // every variable that came before it
+    HashMap variable_slots; // HashMap<char*, u32>
+
+    // every global the event mentions (see globals.h). globals already have
+    // their index by the time the compiler sees them, so these are only kept
+    // for translated events
+    vec globals; // vec<u32>
+
+    // strings passed to text() (see text_runs.h)
+    vec texts; // vec<TextRuns>
+
+    // set once an event fails to compile, along with what went wrong and the
+    // line it went wrong on
+    bool failed;
+    char error[256];
+    u32 error_line;
 } Compiler;
 
 void compiler_init(Compiler *compiler, const char *source);
 // compiles the next event.
-// returns true until there are no events left.
-// will exit the program if it fails to compile
-// (we do not bother handling errors gracefully lol)
-// instructions can be retrieved from the instructions field.
+// returns true until there are no events left, or an event fails to compile.
+// `failed` tells those apart. the compiler can't be used again after a
+// failure, and nothing in the event needs freeing
 bool compiler_compile(Compiler *compiler, Event *event);
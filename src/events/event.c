@@ -1,5 +1,6 @@
 #include "event.h"
-#include "events/commands/commands.h"
+#include "events/commands/command.h"
+#include "events/globals.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -10,6 +11,11 @@ static void slot_instruction(const char *name, u32 slot)
     printf("%s %d\n", name, slot);
 }
 
+static void global_instruction(const char *name, u32 global)
+{
+    printf("%s %d ($%s)\n", name, global, global_name(global));
+}
+
 static void goto_instruction(const char *name, u32 from, u32 to)
 {
     printf("%s %d -> %d\n", name, from, to);
@@ -17,14 +23,15 @@ static void goto_instruction(const char *name, u32 from, u32 to)
 
 static void call_instruction(const char *name, Command command, u32 args)
 {
-    CommandData data = COMMANDS[command];
-    printf("%s %s (%d args)\n", name, data.name, args);
+    printf("%s %s (%d args)\n", name, COMMAND_NAMES[command], args);
 }
 
-static void disassemble_instruction(Event *event, u32 pos)
+// returns the position of the next instruction
+static u32 disassemble_instruction(Event *event, u32 pos)
 {
     printf("%04d | ", pos);
-    Instruction insn = event->instructions[pos];
+    Instruction insn;
+    u32 next = instruction_decode(event->code, pos, &insn);
     switch (insn.code)
     {
     case Code_Goto:
@@ -49,6 +56,12 @@ static void disassemble_instruction(Event *event, u32 pos)
     case Code_Set:
         slot_instruction("Code_Set", insn.data.slot);
         break;
+    case Code_FetchGlobal:
+        global_instruction("Code_FetchGlobal", insn.data.global);
+        break;
+    case Code_SetGlobal:
+        global_instruction("Code_SetGlobal", insn.data.global);
+        break;
     case Code_Negate:
         simple_instruction("Code_Negate");
         break;
@@ -74,10 +87,12 @@ static void disassemble_instruction(Event *event, u32 pos)
         printf("Code_Int %d\n", insn.data._int);
         break;
     case Code_Float:
-        printf("Code_Float %f\n", insn.data._float);
+        printf("Code_Float #%d (%f)\n", insn.data.constant,
+               event->constants[insn.data.constant].data._float);
         break;
     case Code_String:
-        printf("Code_String %s\n", insn.data.string);
+        printf("Code_String #%d (%s)\n", insn.data.constant,
+               event->constants[insn.data.constant].data.string);
         break;
     case Code_True:
         simple_instruction("Code_True");
@@ -106,15 +121,69 @@ static void disassemble_instruction(Event *event, u32 pos)
     case Code_LessEq:
         simple_instruction("Code_LessEq");
         break;
+    case Code_AddInt:
+        simple_instruction("Code_AddInt");
+        break;
+    case Code_SubInt:
+        simple_instruction("Code_SubInt");
+        break;
+    case Code_MulInt:
+        simple_instruction("Code_MulInt");
+        break;
+    case Code_DivInt:
+        simple_instruction("Code_DivInt");
+        break;
+    case Code_ModInt:
+        simple_instruction("Code_ModInt");
+        break;
+    case Code_AddFloat:
+        simple_instruction("Code_AddFloat");
+        break;
+    case Code_SubFloat:
+        simple_instruction("Code_SubFloat");
+        break;
+    case Code_MulFloat:
+        simple_instruction("Code_MulFloat");
+        break;
+    case Code_DivFloat:
+        simple_instruction("Code_DivFloat");
+        break;
+    case Code_GreaterIntInt:
+        simple_instruction("Code_GreaterIntInt");
+        break;
+    case Code_GreaterEqIntInt:
+        simple_instruction("Code_GreaterEqIntInt");
+        break;
+    case Code_LessIntInt:
+        simple_instruction("Code_LessIntInt");
+        break;
+    case Code_LessEqIntInt:
+        simple_instruction("Code_LessEqIntInt");
+        break;
+    case Code_GreaterFloatFloat:
+        simple_instruction("Code_GreaterFloatFloat");
+        break;
+    case Code_GreaterEqFloatFloat:
+        simple_instruction("Code_GreaterEqFloatFloat");
+        break;
+    case Code_LessFloatFloat:
+        simple_instruction("Code_LessFloatFloat");
+        break;
+    case Code_LessEqFloatFloat:
+        simple_instruction("Code_LessEqFloatFloat");
+        break;
     }
+    return next;
 }
 
 void event_disassemble(Event *event)
 {
-    printf("== %s ==\n", event->name);
-    for (u32 pos = 0; pos < event->instructions_len; pos++)
+    printf("== %s (%d bytes, %d constants) ==\n", event->name, event->code_len,
+           event->constant_count);
+    u32 pos = 0;
+    while (pos < event->code_len)
     {
-        disassemble_instruction(event, pos);
+        pos = disassemble_instruction(event, pos);
     }
 }
 
@@ -127,18 +196,53 @@ void event_free(Event *event)
         free(event->slots[i]);
     }
     free(event->slots);
+    free(event->globals);
+
+    for (u32 i = 0; i < event->text_count; i++)
+        text_runs_free(&event->texts[i]);
+    free(event->texts);
+
+    // strings in here are interned, so they're not ours to free
+    free(event->constants);
+    free(event->code);
+    free(event->lines);
+}
+
+u32 event_line_index(const Event *event, u32 ip)
+{
+    // find the last run that starts at or before ip
+    u32 low = 0, high = event->line_count;
+    while (high - low > 1)
+    {
+        u32 mid = (low + high) / 2;
+        if (event->lines[mid].ip <= ip)
+            low = mid;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+u32 event_line(const Event *event, u32 ip)
+{
+    if (!event->line_count)
+        return 0;
+    return event->lines[event_line_index(event, ip)].line;
+}
 
-    for (u32 i = 0; i < event->instructions_len; i++)
+void event_shift_lines(Event *event, i32 by)
+{
+    for (u32 i = 0; i < event->line_count; i++)
+        event->lines[i].line += by;
+}
+
+const TextRuns *event_text(const Event *event, const char *string)
+{
+    // strings are interned, and events don't say much each
+    for (u32 i = 0; i < event->text_count; i++)
     {
-        Instruction instruction = event->instructions[i];
-        switch (instruction.code)
-        {
-        case Code_String:
-            free(instruction.data.string);
-            break;
-        default:
-            break;
-        }
+        if (event->texts[i].source == string)
+            return &event->texts[i];
     }
-    free(event->instructions);
+    return NULL;
 }
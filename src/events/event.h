@@ -1,18 +1,73 @@
 #pragma once
 
 #include "events/instruction.h"
+#include "events/text_runs.h"
+#include "events/value.h"
+#include <stdbool.h>
+
+struct VM;
+struct Resources;
+
+// an event that's been translated to C ahead of time (see aot.h).
+// has the same contract as vm_execute: returns true once the event finishes,
+// and false if it yielded or ran out of budget. the vm's ip is used as the
+// resume point.
+typedef bool (*event_aot_fn)(struct VM *vm, struct Resources *resources);
+
+// every instruction from `ip` up until the next LineStart came from `line` of
+// the script file
+typedef struct
+{
+    u32 ip;
+    u32 line;
+} LineStart;
 
 typedef struct
 {
     char *name;
 
-    Instruction *instructions;
-    u32 instructions_len;
+    // see instruction.h for the format
+    u8 *code;
+    u32 code_len;
+
+    // deduplicated floats and strings used by the event.
+    // strings are interned (see utility/intern.h), and not owned by the event
+    Value *constants;
+    u32 constant_count;
 
     // used for debug information
     char **slots;
     u32 slot_count;
+    // the index of every global the event uses (see globals.h), in the order
+    // it first mentions them. the bytecode has the indices in it already, but
+    // translated events look them up in here, since they can be different in
+    // every run of the game
+    u32 *globals;
+    u32 global_count;
+
+    // every string passed straight to text(), already split into runs
+    TextRuns *texts;
+    u32 text_count;
+    // the deepest the stack ever gets while running this event.
+    // worked out by typecheck_event
+    u32 stack_max;
+
+    // sorted by ip (and by line, since the compiler only ever moves forwards)
+    LineStart *lines;
+    u32 line_count;
+
+    // if this is set, the vm runs this instead of interpreting instructions
+    event_aot_fn aot;
 } Event;
 
 void event_disassemble(Event *event);
 void event_free(Event *event);
+
+// the index of the LineStart `ip` falls under. the event must have lines
+u32 event_line_index(const Event *event, u32 ip);
+// the line `ip` came from, or 0 if the event doesn't know
+u32 event_line(const Event *event, u32 ip);
+// moves the event `by` lines down the file
+void event_shift_lines(Event *event, i32 by);
+// the runs for a string passed to text(), or NULL if it wasn't a string literal
+const TextRuns *event_text(const Event *event, const char *string);
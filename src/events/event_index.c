@@ -0,0 +1,717 @@
+#include "event_index.h"
+#include "events/aot.h"
+#include "events/compiler.h"
+#include "utility/files.h"
+#include "utility/log.h"
+#include "utility/macros.h"
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_timer.h>
+#include <string.h>
+
+void event_index_init(EventIndex *index, bool use_aot)
+{
+    vec_init(&index->files, sizeof(EventFile));
+    vec_init(&index->entries, sizeof(EventEntry));
+    hashmap_init(&index->by_name, fnv_cstr_ptr_hash_function,
+                 cstr_ptr_eq_function, sizeof(char *), sizeof(u32));
+
+    index->use_aot = use_aot;
+
+    index->lock = SDL_CreateMutex();
+    index->compiled = SDL_CreateCondition();
+    index->compile_lock = SDL_CreateMutex();
+    PTR_ERRCHK(index->lock, "Failed to create event index lock");
+    PTR_ERRCHK(index->compiled, "Failed to create event index condition");
+    PTR_ERRCHK(index->compile_lock, "Failed to create event compile lock");
+
+    // the worker is only started once something gets prefetched
+    index->worker = NULL;
+    index->queued = SDL_CreateCondition();
+    PTR_ERRCHK(index->queued, "Failed to create event queue condition");
+    vec_init(&index->queue, sizeof(u32));
+    index->quit = false;
+
+    index->hot_reload = false;
+    vec_init(&index->retired, sizeof(Event));
+
+    index->event_count = 0;
+    index->compiled_count = 0;
+    index->prefetched_count = 0;
+    index->reloaded_count = 0;
+}
+
+void event_index_free(EventIndex *index)
+{
+    if (index->worker)
+    {
+        SDL_LockMutex(index->lock);
+        index->quit = true;
+        SDL_SignalCondition(index->queued);
+        SDL_UnlockMutex(index->lock);
+        SDL_WaitThread(index->worker, NULL);
+    }
+
+    for (u32 i = 0; i < index->entries.len; i++)
+    {
+        EventEntry *entry = vec_get(&index->entries, i);
+        if (entry->state == EventState_Compiled)
+            event_free(&entry->event);
+        free(entry->error);
+        free(entry->name);
+    }
+    for (u32 i = 0; i < index->files.len; i++)
+    {
+        EventFile *file = vec_get(&index->files, i);
+        free(file->path);
+        free(file->source);
+    }
+
+    for (u32 i = 0; i < index->retired.len; i++)
+        event_free(vec_get(&index->retired, i));
+
+    vec_free(&index->retired);
+    vec_free(&index->entries);
+    vec_free(&index->files);
+    vec_free(&index->queue);
+    hashmap_free(&index->by_name);
+
+    SDL_DestroyCondition(index->queued);
+    SDL_DestroyCondition(index->compiled);
+    SDL_DestroyMutex(index->compile_lock);
+    SDL_DestroyMutex(index->lock);
+}
+
+// the pre-scan only has to understand enough of the language to match braces:
+// comments and strings can contain braces, nothing else can
+
+static const char *skip_whitespace(const char *p)
+{
+    for (;;)
+    {
+        while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+            p++;
+        if (*p != '#')
+            return p;
+        p += strcspn(p, "\n");
+    }
+}
+
+static bool is_ident_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_' || c == ':';
+}
+
+// only fatal in release builds, and never while reloading. the events before
+// the problem are still fine, so we can carry on without the rest of the file
+static void scan_error(EventFile *file, const char *at, const char *message,
+                       bool fatal)
+{
+    u32 line = 1;
+    for (const char *p = file->source; p < at; p++)
+        line += *p == '\n';
+
+#ifdef DEBUG
+    fatal = false;
+#endif
+    if (fatal)
+    {
+        FATAL("%s:%u: %s\n", file->path, line, message);
+    }
+    log_warn("%s:%u: %s, skipping the rest of the file", file->path, line,
+             message);
+}
+
+// returns the end of the event, or NULL if it's malformed
+static const char *scan_event(EventFile *file, const char *p, char **name,
+                              bool fatal)
+{
+    if (strncmp(p, "event", 5) || is_ident_char(p[5]))
+    {
+        scan_error(file, p, "Expected event definition", fatal);
+        return NULL;
+    }
+    p = skip_whitespace(p + 5);
+
+    if (*p != '"')
+    {
+        scan_error(file, p, "Expected event name", fatal);
+        return NULL;
+    }
+    const char *name_end = strchr(p + 1, '"');
+    if (!name_end)
+    {
+        scan_error(file, p, "Unterminated event name", fatal);
+        return NULL;
+    }
+    *name = strndup(p + 1, name_end - p - 1);
+    p = skip_whitespace(name_end + 1);
+
+    if (*p != '{')
+    {
+        scan_error(file, p, "Expected block after event name", fatal);
+        free(*name);
+        return NULL;
+    }
+
+    const char *body = p;
+    u32 depth = 0;
+    for (;;)
+    {
+        p += strcspn(p, "{}\"#");
+        switch (*p)
+        {
+        case '{':
+            depth++;
+            p++;
+            break;
+        case '}':
+            p++;
+            if (--depth == 0)
+                return p;
+            break;
+        case '"':
+            p = strchr(p + 1, '"');
+            if (!p)
+            {
+                scan_error(file, body, "Unterminated string in event", fatal);
+                free(*name);
+                return NULL;
+            }
+            p++;
+            break;
+        case '#':
+            p += strcspn(p, "\n");
+            break;
+        case '\0':
+            scan_error(file, body, "Unterminated event block", fatal);
+            free(*name);
+            return NULL;
+        }
+    }
+}
+
+typedef struct
+{
+    char *name;
+    u32 start, end;
+    u32 line;
+} ScannedEvent;
+
+// scans every event in the file into `events`.
+// returns false if the file is malformed (in which case `events` has every
+// event up until the problem)
+static bool scan_file(EventFile *file, vec *events, bool fatal)
+{
+    vec_init(events, sizeof(ScannedEvent));
+
+    const char *p = skip_whitespace(file->source);
+    const char *counted_to = file->source;
+    u32 line = 1;
+    while (*p)
+    {
+        ScannedEvent event;
+        const char *end = scan_event(file, p, &event.name, fatal);
+        if (!end)
+            return false;
+
+        const char *newline;
+        while ((newline = memchr(counted_to, '\n', p - counted_to)))
+        {
+            line++;
+            counted_to = newline + 1;
+        }
+        counted_to = p;
+
+        event.start = p - file->source;
+        event.end = end - file->source;
+        event.line = line;
+        vec_push(events, &event);
+
+        p = skip_whitespace(end);
+    }
+    return true;
+}
+
+static void free_scanned_event(usize i, void *ptr)
+{
+    (void)i;
+    ScannedEvent *event = ptr;
+    free(event->name);
+}
+
+static i64 modified_time(const char *path)
+{
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(path, &info))
+        return 0;
+    return info.modify_time;
+}
+
+// takes ownership of the name. the lock must be held
+static void add_entry(EventIndex *index, u32 file, ScannedEvent *scanned)
+{
+    EventFile *event_file = vec_get(&index->files, file);
+
+    u32 entry_index = index->entries.len;
+    if (!hashmap_insert(&index->by_name, &scanned->name, &entry_index))
+    {
+        // the first one wins, like it always has
+        log_warn("%s: event `%s` is defined more than once", event_file->path,
+                 scanned->name);
+        free(scanned->name);
+        return;
+    }
+
+    EventEntry entry = {
+        .name = scanned->name,
+        .file = file,
+        .start = scanned->start,
+        .end = scanned->end,
+        .line = scanned->line,
+        .state = EventState_Unloaded,
+        .error = NULL,
+    };
+    vec_push(&index->entries, &entry);
+    index->event_count++;
+}
+
+void event_index_add_file(EventIndex *index, const char *path)
+{
+    EventFile file = {.path = strdup(path)};
+    file.modified = modified_time(path);
+    read_entire_file(path, &file.source, NULL);
+
+    file.aot_source = AOT_NO_SOURCE;
+    if (index->use_aot)
+        file.aot_source = aot_find_source(path, file.source);
+
+    // whatever scanned fine is still usable
+    vec scanned;
+    scan_file(&file, &scanned, true);
+
+    SDL_LockMutex(index->lock);
+    u32 file_index = index->files.len;
+    vec_push(&index->files, &file);
+    for (u32 i = 0; i < scanned.len; i++)
+        add_entry(index, file_index, vec_get(&scanned, i));
+    SDL_UnlockMutex(index->lock);
+
+    vec_free(&scanned);
+}
+
+// compiles an entry from its file's current source. on failure, `error` gets
+// the compile error with the file and line it's on. the lock must not be held
+static bool compile_source(EventIndex *index, u32 entry_index, Event *out,
+                           char **error)
+{
+    SDL_LockMutex(index->lock);
+    EventEntry *entry = vec_get(&index->entries, entry_index);
+    EventFile *file = vec_get(&index->files, entry->file);
+    // copy the event out so the compiler can't run off into the next one
+    char *source = strndup(file->source + entry->start,
+                           entry->end - entry->start);
+    char *path = strdup(file->path);
+    u32 aot_source = file->aot_source;
+    u32 line = entry->line;
+    SDL_UnlockMutex(index->lock);
+
+    SDL_LockMutex(index->compile_lock);
+    Compiler compiler;
+    compiler_init(&compiler, source);
+    compiler.line = line;
+    bool compiled = compiler_compile(&compiler, out);
+    SDL_UnlockMutex(index->compile_lock);
+    free(source);
+
+    if (compiled && aot_source != AOT_NO_SOURCE)
+        out->aot = aot_find_event(aot_source, out->name);
+    if (!compiled)
+    {
+        char message[512];
+        snprintf(message, sizeof(message), "%s:%u: %s", path,
+                 compiler.error_line, compiler.error);
+        *error = strdup(message);
+    }
+    free(path);
+    return compiled;
+}
+
+// compiles an entry that's been marked as compiling. the lock must not be held
+static void compile_entry(EventIndex *index, u32 entry_index)
+{
+    Event event;
+    char *error;
+    bool compiled = compile_source(index, entry_index, &event, &error);
+
+    SDL_LockMutex(index->lock);
+    EventEntry *entry = vec_get(&index->entries, entry_index);
+    if (compiled)
+    {
+        entry->event = event;
+        entry->state = EventState_Compiled;
+        index->compiled_count++;
+    }
+    else
+    {
+        entry->error = error;
+        entry->state = EventState_Failed;
+    }
+    SDL_BroadcastCondition(index->compiled);
+    SDL_UnlockMutex(index->lock);
+}
+
+void event_index_compile_all(EventIndex *index)
+{
+    for (u32 i = 0; i < index->entries.len; i++)
+    {
+        EventEntry *entry = vec_get(&index->entries, i);
+        if (entry->state == EventState_Removed)
+            continue;
+        Event event;
+        event_index_get(index, entry->name, &event);
+    }
+}
+
+// the lock must be held
+static bool find_entry(EventIndex *index, const char *name, u32 *entry_index)
+{
+    void *found = hashmap_get(&index->by_name, &name);
+    if (!found)
+        return false;
+    memcpy(entry_index, found, sizeof(u32));
+    return true;
+}
+
+bool event_index_get(EventIndex *index, const char *name, Event *out)
+{
+    SDL_LockMutex(index->lock);
+
+    u32 entry_index;
+    if (!find_entry(index, name, &entry_index))
+    {
+        SDL_UnlockMutex(index->lock);
+        return false;
+    }
+
+    EventEntry *entry = vec_get(&index->entries, entry_index);
+    if (entry->state == EventState_Unloaded)
+    {
+        entry->state = EventState_Compiling;
+        SDL_UnlockMutex(index->lock);
+        compile_entry(index, entry_index);
+        SDL_LockMutex(index->lock);
+    }
+
+    // the worker's already on it
+    for (;;)
+    {
+        entry = vec_get(&index->entries, entry_index);
+        if (entry->state == EventState_Compiled ||
+            entry->state == EventState_Failed)
+            break;
+        SDL_WaitCondition(index->compiled, index->lock);
+    }
+
+    if (entry->state == EventState_Failed)
+    {
+        log_warn("%s", entry->error);
+        SDL_UnlockMutex(index->lock);
+        return false;
+    }
+
+    *out = entry->event;
+    SDL_UnlockMutex(index->lock);
+    return true;
+}
+
+static int worker_main(void *data)
+{
+    EventIndex *index = data;
+
+    SDL_LockMutex(index->lock);
+    for (;;)
+    {
+        while (!index->queue.len && !index->quit)
+            SDL_WaitCondition(index->queued, index->lock);
+        if (index->quit)
+            break;
+
+        u32 entry_index;
+        vec_remove(&index->queue, 0, &entry_index);
+
+        // someone might have looked it up in the meantime
+        EventEntry *entry = vec_get(&index->entries, entry_index);
+        if (entry->state != EventState_Unloaded)
+            continue;
+        entry->state = EventState_Compiling;
+
+        SDL_UnlockMutex(index->lock);
+        compile_entry(index, entry_index);
+        SDL_LockMutex(index->lock);
+    }
+    SDL_UnlockMutex(index->lock);
+
+    return 0;
+}
+
+void event_index_prefetch(EventIndex *index, const char *name)
+{
+    SDL_LockMutex(index->lock);
+
+    u32 entry_index;
+    if (!find_entry(index, name, &entry_index))
+    {
+        SDL_UnlockMutex(index->lock);
+        return;
+    }
+
+    EventEntry *entry = vec_get(&index->entries, entry_index);
+    if (entry->state == EventState_Unloaded)
+    {
+        if (!index->worker)
+        {
+            index->worker =
+                SDL_CreateThread(worker_main, "event compiler", index);
+            PTR_ERRCHK(index->worker, "Failed to start event compiler");
+        }
+
+        vec_push(&index->queue, &entry_index);
+        index->prefetched_count++;
+        SDL_SignalCondition(index->queued);
+    }
+
+    SDL_UnlockMutex(index->lock);
+}
+
+// throws out the compiled version of an entry (or why it didn't compile), if
+// it has one. the lock must be held
+static void retire(EventIndex *index, EventEntry *entry)
+{
+    // it might compile now
+    if (entry->state == EventState_Failed)
+    {
+        free(entry->error);
+        entry->error = NULL;
+        entry->state = EventState_Unloaded;
+        return;
+    }
+    if (entry->state != EventState_Compiled)
+        return;
+
+    // running scripts have their own copy of the event, but they still point
+    // at its code. it's freed once they've all finished (see event_index_poll)
+    vec_push(&index->retired, &entry->event);
+    entry->state = EventState_Unloaded;
+    index->compiled_count--;
+}
+
+void event_index_reload_file(EventIndex *index, const char *path)
+{
+    u64 start = SDL_GetPerformanceCounter();
+
+    char *source;
+    read_entire_file(path, &source, NULL);
+
+    SDL_LockMutex(index->lock);
+
+    u32 file_index = 0;
+    for (; file_index < index->files.len; file_index++)
+    {
+        EventFile *file = vec_get(&index->files, file_index);
+        if (STREQ(file->path, path))
+            break;
+    }
+    if (file_index == index->files.len)
+    {
+        SDL_UnlockMutex(index->lock);
+        log_warn("Can't reload %s, it was never loaded", path);
+        free(source);
+        return;
+    }
+
+    EventFile *file = vec_get(&index->files, file_index);
+    file->modified = modified_time(path);
+    if (STREQ(file->source, source))
+    {
+        SDL_UnlockMutex(index->lock);
+        free(source);
+        return;
+    }
+
+    // if the file is halfway through being edited, keep the old version until
+    // it's fixed
+    EventFile new_file = *file;
+    new_file.source = source;
+    vec scanned;
+    if (!scan_file(&new_file, &scanned, false))
+    {
+        SDL_UnlockMutex(index->lock);
+        log_warn("Keeping the old version of %s until it's fixed", path);
+        vec_free_with(&scanned, free_scanned_event);
+        free(source);
+        return;
+    }
+
+    // anything the worker is compiling from this file is about to be out of
+    // date. let it finish, so we can throw it out
+    for (u32 i = 0; i < index->entries.len; i++)
+    {
+        EventEntry *entry = vec_get(&index->entries, i);
+        while (entry->file == file_index &&
+               entry->state == EventState_Compiling)
+        {
+            SDL_WaitCondition(index->compiled, index->lock);
+            entry = vec_get(&index->entries, i);
+        }
+    }
+
+    u32 old_len = index->entries.len;
+    bool *seen = calloc(old_len, sizeof(bool));
+    vec recompile;
+    vec_init(&recompile, sizeof(u32));
+    u32 changed = 0, added = 0, removed = 0;
+
+    for (u32 i = 0; i < scanned.len; i++)
+    {
+        ScannedEvent *event = vec_get(&scanned, i);
+
+        u32 entry_index;
+        if (!find_entry(index, event->name, &entry_index))
+        {
+            add_entry(index, file_index, event);
+            added++;
+            continue;
+        }
+
+        EventEntry *entry = vec_get(&index->entries, entry_index);
+        if (entry->file != file_index || entry_index >= old_len ||
+            seen[entry_index])
+        {
+            log_warn("%s: event `%s` is defined more than once", path,
+                     event->name);
+            free(event->name);
+            continue;
+        }
+        seen[entry_index] = true;
+        free(event->name);
+
+        u32 old_size = entry->end - entry->start;
+        u32 new_size = event->end - event->start;
+        bool same = old_size == new_size &&
+                    !memcmp(file->source + entry->start,
+                            source + event->start, old_size);
+        entry->start = event->start;
+        entry->end = event->end;
+        if (same)
+        {
+            // something above it changed size. the code's the same, but the
+            // line table needs to follow it
+            if (entry->state == EventState_Compiled)
+                event_shift_lines(&entry->event, event->line - entry->line);
+            entry->line = event->line;
+            continue;
+        }
+        entry->line = event->line;
+
+        changed++;
+        // whoever was using this will probably want it again soon. it stays
+        // live until the new version compiles (below)
+        if (entry->state == EventState_Compiled)
+            vec_push(&recompile, &entry_index);
+        else
+            retire(index, entry);
+    }
+
+    for (u32 i = 0; i < old_len; i++)
+    {
+        EventEntry *entry = vec_get(&index->entries, i);
+        if (entry->file != file_index || entry->state == EventState_Removed ||
+            seen[i])
+            continue;
+
+        retire(index, entry);
+        hashmap_remove(&index->by_name, &entry->name, NULL);
+        entry->state = EventState_Removed;
+        index->event_count--;
+        removed++;
+    }
+
+    // the translated functions only match the file they were translated from.
+    // events that didn't change keep theirs
+    file = vec_get(&index->files, file_index);
+    free(file->source);
+    file->source = source;
+    file->aot_source = AOT_NO_SOURCE;
+    index->reloaded_count += changed + added + removed;
+
+    SDL_UnlockMutex(index->lock);
+
+    // a typo shouldn't break an event that was working, so the old version
+    // only goes once the new one compiles
+    u32 broken = 0;
+    for (u32 i = 0; i < recompile.len; i++)
+    {
+        u32 entry_index = *(u32 *)vec_get(&recompile, i);
+        Event event;
+        char *error;
+        if (!compile_source(index, entry_index, &event, &error))
+        {
+            log_warn("%s (keeping the old version until it's fixed)", error);
+            free(error);
+            broken++;
+            continue;
+        }
+
+        SDL_LockMutex(index->lock);
+        EventEntry *entry = vec_get(&index->entries, entry_index);
+        // running scripts might still be using the old version
+        vec_push(&index->retired, &entry->event);
+        entry->event = event;
+        SDL_UnlockMutex(index->lock);
+    }
+
+    f64 ms = (f64)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+             SDL_GetPerformanceFrequency();
+    log_info("Reloaded %s in %.2fms (%u changed, %u added, %u removed, %u "
+             "broken)",
+             path, ms, changed, added, removed, broken);
+
+    vec_free(&recompile);
+    vec_free(&scanned);
+    free(seen);
+}
+
+void event_index_poll(EventIndex *index, Scheduler *scheduler)
+{
+    if (index->hot_reload)
+    {
+        for (u32 i = 0; i < index->files.len; i++)
+        {
+            EventFile *file = vec_get(&index->files, i);
+            if (modified_time(file->path) != file->modified)
+                event_index_reload_file(index, file->path);
+        }
+    }
+
+    // only the main thread touches retired events, so no need to lock
+    for (u32 i = index->retired.len; i-- > 0;)
+    {
+        Event *event = vec_get(&index->retired, i);
+        if (scheduler_is_running_code(scheduler, event->code))
+            continue;
+        event_free(event);
+        vec_swap_remove(&index->retired, i, NULL);
+    }
+}
+
+u32 event_index_count(EventIndex *index) { return index->event_count; }
+
+bool event_index_load_globals(EventIndex *index, Globals *globals,
+                              const u8 *data, usize len)
+{
+    SDL_LockMutex(index->compile_lock);
+    bool loaded = globals_deserialize(globals, data, len);
+    SDL_UnlockMutex(index->compile_lock);
+    return loaded;
+}
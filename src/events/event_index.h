@@ -0,0 +1,136 @@
+#pragma once
+
+// every event in every script file, compiled on demand.
+//
+// adding a file doesn't compile anything- it only skims the file to find where
+// each `event "name" { ... }` starts and ends. an event gets compiled the first
+// time something looks it up, or ahead of time on a worker thread if something
+// asks for it with event_index_prefetch (maps do this for the events their
+// characters use while the rest of the map loads).
+//
+// this means a broken event only stops the game when something tries to run
+// it, rather than at startup. even then, the compile error is logged and the
+// lookup fails, so it's up to whoever wanted it.
+//
+// files can also be reloaded while the game is running. only the events that
+// actually changed get recompiled, and one that doesn't compile any more keeps
+// its old version until it's fixed. any scripts that were already running keep
+// going with the old version until they finish.
+
+#include "events/event.h"
+#include "events/globals.h"
+#include "events/scheduler.h"
+#include "sensible_nums.h"
+#include "utility/hashmap.h"
+#include "utility/vec.h"
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+
+typedef enum
+{
+    EventState_Unloaded,
+    EventState_Compiling,
+    EventState_Compiled,
+    // the event doesn't compile. `error` says why
+    EventState_Failed,
+    // the event was deleted from its file. removed entries stay around so
+    // entry indices never change
+    EventState_Removed,
+} EventState;
+
+typedef struct
+{
+    char *name;
+    // index into files
+    u32 file;
+    // byte range of the event (from `event` to the closing brace) in the
+    // file's source
+    u32 start, end;
+    // the line the event starts on
+    u32 line;
+
+    EventState state;
+    Event event;
+    // the compile error, with the file and line it's on. only set if the
+    // event failed
+    char *error;
+} EventEntry;
+
+typedef struct
+{
+    char *path;
+    char *source;
+    // index into AOT_SOURCES, or AOT_NO_SOURCE if this file can't use
+    // translated events
+    u32 aot_source;
+    // when the file was last modified, as of the last time we read it
+    i64 modified;
+} EventFile;
+
+typedef struct
+{
+    vec files;   // vec<EventFile>
+    vec entries; // vec<EventEntry>
+    HashMap by_name; // HashMap<char*, u32> (index into entries)
+
+    bool use_aot;
+
+    // guards the state of every entry and the queue
+    SDL_Mutex *lock;
+    // broadcast whenever an entry finishes compiling
+    SDL_Condition *compiled;
+
+    // the compiler isn't thread safe (it interns strings into one big table),
+    // so only one event can compile at a time
+    SDL_Mutex *compile_lock;
+
+    SDL_Thread *worker;
+    SDL_Condition *queued;
+    vec queue; // vec<u32> (index into entries)
+    bool quit;
+
+    // whether event_index_poll should check for files changing
+    bool hot_reload;
+    // old versions of events that changed, which running scripts might still
+    // be using
+    vec retired; // vec<Event>
+
+    u32 event_count;
+    u32 compiled_count;
+    u32 prefetched_count;
+    u32 reloaded_count;
+} EventIndex;
+
+void event_index_init(EventIndex *index, bool use_aot);
+void event_index_free(EventIndex *index);
+
+// reads `path` and indexes every event in it
+void event_index_add_file(EventIndex *index, const char *path);
+// compiles every event right now, the way the game used to at startup. useful
+// for checking that every script still compiles
+void event_index_compile_all(EventIndex *index);
+
+// finds an event by name, compiling it if nobody has yet.
+// returns false if there's no such event, or if it doesn't compile (in which
+// case the compile error is logged)
+bool event_index_get(EventIndex *index, const char *name, Event *out);
+// queues an event to be compiled on the worker thread.
+// does nothing if it's already compiled, or doesn't exist
+void event_index_prefetch(EventIndex *index, const char *name);
+
+// rereads `path`, and recompiles any events in it that have changed (if they
+// were compiled already). the new version of an event only replaces the old one
+// if it compiles. if the file doesn't scan properly, nothing changes
+void event_index_reload_file(EventIndex *index, const char *path);
+// reloads any files that have changed on disk (if hot_reload is set), and frees
+// old versions of events once no running scripts are using them
+void event_index_poll(EventIndex *index, Scheduler *scheduler);
+
+// the number of events (not counting removed ones)
+u32 event_index_count(EventIndex *index);
+
+// globals_deserialize, but safe to call while events are compiling on the
+// worker thread (loading a save gives globals indices and interns strings,
+// which the compiler does too)
+bool event_index_load_globals(EventIndex *index, Globals *globals,
+                              const u8 *data, usize len);
@@ -0,0 +1,272 @@
+#include "globals.h"
+#include "utility/hashmap.h"
+#include "utility/intern.h"
+#include "utility/macros.h"
+#include <stdlib.h>
+#include <string.h>
+
+// the names are owned by this table
+static char *names[GLOBAL_MAX];
+static u32 name_count = 0;
+static HashMap indices; // HashMap<char*, u32>
+static bool indices_init = false;
+
+u32 global_index(const char *name)
+{
+    if (!indices_init)
+    {
+        hashmap_init(&indices, fnv_cstr_ptr_hash_function,
+                     cstr_ptr_eq_function, sizeof(char *), sizeof(u32));
+        indices_init = true;
+    }
+
+    void *existing = hashmap_get(&indices, &name);
+    if (existing)
+    {
+        // hashmap values aren't aligned
+        u32 index;
+        memcpy(&index, existing, sizeof(u32));
+        return index;
+    }
+
+    if (name_count >= GLOBAL_MAX)
+    {
+        FATAL("Too many globals (there can be at most %d)\n", GLOBAL_MAX);
+    }
+
+    u32 index = name_count++;
+    names[index] = strdup(name);
+    hashmap_insert(&indices, &names[index], &index);
+    return index;
+}
+
+static bool global_exists(const char *name)
+{
+    return indices_init && hashmap_get(&indices, &name) != NULL;
+}
+
+const char *global_name(u32 index) { return names[index]; }
+
+void global_names_free(void)
+{
+    if (!indices_init)
+        return;
+
+    for (u32 i = 0; i < name_count; i++)
+        free(names[i]);
+    name_count = 0;
+    hashmap_free(&indices);
+    indices_init = false;
+}
+
+void globals_clear(Globals *globals)
+{
+    // Val_None is 0
+    memset(globals->values, 0, sizeof(globals->values));
+}
+
+// the format is:
+//   "GLBL", then the u32 version and u32 number of globals
+//   for each global: the u16 length of its name, the name, the u8 value type,
+//   then the value (a i32 or f32, or a u32 length and the string)
+// everything is little endian
+#define MAGIC "GLBL"
+#define VERSION 1
+
+static void write_u8(vec *out, u8 value) { vec_push(out, &value); }
+
+static void write_bytes(vec *out, const void *bytes, usize len)
+{
+    const u8 *p = bytes;
+    for (usize i = 0; i < len; i++)
+        write_u8(out, p[i]);
+}
+
+static void write_u16(vec *out, u16 value)
+{
+    write_u8(out, value & 0xFF);
+    write_u8(out, value >> 8);
+}
+
+static void write_u32(vec *out, u32 value)
+{
+    for (u32 i = 0; i < 4; i++)
+        write_u8(out, (value >> (i * 8)) & 0xFF);
+}
+
+void globals_serialize(Globals *globals, vec *out)
+{
+    u32 count = 0;
+    for (u32 i = 0; i < GLOBAL_MAX; i++)
+        count += !VAL_IS_NONE(globals->values[i]);
+
+    write_bytes(out, MAGIC, 4);
+    write_u32(out, VERSION);
+    write_u32(out, count);
+
+    for (u32 i = 0; i < GLOBAL_MAX; i++)
+    {
+        Value value = globals->values[i];
+        if (VAL_IS_NONE(value))
+            continue;
+
+        // anything that's been set has been given a name
+        const char *name = global_name(i);
+        u16 name_len = strlen(name);
+        write_u16(out, name_len);
+        write_bytes(out, name, name_len);
+
+        write_u8(out, value.type);
+        switch (value.type)
+        {
+        case Val_Int:
+            write_u32(out, (u32)value.data._int);
+            break;
+        case Val_Float:
+        {
+            u32 bits;
+            memcpy(&bits, &value.data._float, sizeof(u32));
+            write_u32(out, bits);
+            break;
+        }
+        case Val_String:
+        {
+            u32 len = strlen(value.data.string);
+            write_u32(out, len);
+            write_bytes(out, value.data.string, len);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+typedef struct
+{
+    const u8 *data;
+    usize len;
+    usize at;
+    // set as soon as anything reads past the end
+    bool failed;
+} Reader;
+
+static const u8 *read_bytes(Reader *reader, usize len)
+{
+    if (reader->failed || reader->len - reader->at < len)
+    {
+        reader->failed = true;
+        return NULL;
+    }
+    const u8 *bytes = reader->data + reader->at;
+    reader->at += len;
+    return bytes;
+}
+
+static u8 read_u8(Reader *reader)
+{
+    const u8 *p = read_bytes(reader, 1);
+    return p ? p[0] : 0;
+}
+
+static u16 read_u16(Reader *reader)
+{
+    const u8 *p = read_bytes(reader, 2);
+    return p ? (u16)(p[0] | (p[1] << 8)) : 0;
+}
+
+static u32 read_u32(Reader *reader)
+{
+    const u8 *p = read_bytes(reader, 4);
+    if (!p)
+        return 0;
+    return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) |
+           ((u32)p[3] << 24);
+}
+
+// reads every global, and sets them if `globals` isn't NULL. otherwise it
+// just checks they'd all fit
+static bool read_globals(Reader *reader, Globals *globals)
+{
+    const u8 *magic = read_bytes(reader, 4);
+    if (!magic || memcmp(magic, MAGIC, 4))
+        return false;
+    if (read_u32(reader) != VERSION)
+        return false;
+
+    u32 count = read_u32(reader);
+    if (count > GLOBAL_MAX)
+        return false;
+    // names that'll need an index. a name that's in there twice is counted
+    // twice, but saves never do that
+    u32 new_names = 0;
+
+    for (u32 i = 0; i < count && !reader->failed; i++)
+    {
+        u16 name_len = read_u16(reader);
+        const u8 *name = read_bytes(reader, name_len);
+
+        Value value = {.type = read_u8(reader)};
+        const u8 *string = NULL;
+        u32 string_len = 0;
+        switch (value.type)
+        {
+        case Val_Int:
+            value.data._int = (i32)read_u32(reader);
+            break;
+        case Val_Float:
+        {
+            u32 bits = read_u32(reader);
+            memcpy(&value.data._float, &bits, sizeof(u32));
+            break;
+        }
+        case Val_String:
+            string_len = read_u32(reader);
+            string = read_bytes(reader, string_len);
+            break;
+        case Val_True:
+        case Val_False:
+            break;
+        default:
+            return false;
+        }
+
+        if (reader->failed)
+            continue;
+
+        char *name_copy = strndup((const char *)name, name_len);
+        if (!globals)
+        {
+            new_names += !global_exists(name_copy);
+            free(name_copy);
+            continue;
+        }
+        u32 index = global_index(name_copy);
+        free(name_copy);
+
+        if (string)
+        {
+            char *string_copy = strndup((const char *)string, string_len);
+            value.data.string = intern_string(string_copy);
+            free(string_copy);
+        }
+        globals->values[index] = value;
+    }
+
+    if (name_count + new_names > GLOBAL_MAX)
+        return false;
+    return !reader->failed && reader->at == reader->len;
+}
+
+bool globals_deserialize(Globals *globals, const u8 *data, usize len)
+{
+    // check everything first, so a broken save doesn't half load
+    Reader check = {.data = data, .len = len};
+    if (!read_globals(&check, NULL))
+        return false;
+
+    globals_clear(globals);
+    Reader reader = {.data = data, .len = len};
+    read_globals(&reader, globals);
+    return true;
+}
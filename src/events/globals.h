@@ -0,0 +1,50 @@
+#pragma once
+
+// global script variables, written `$name` in scripts. normal variables only
+// last as long as the event that uses them, but globals stick around until the
+// game ends (or gets saved and loaded), so they're where game flags live.
+//
+// every global name gets a fixed index the first time an event mentions it,
+// and the compiler writes that index straight into the bytecode, so reading a
+// global is just indexing into Globals.values. indices are handed out in
+// whatever order events happen to be compiled in though, so they're only good
+// for one run of the game- saves store names instead.
+//
+// the names are kept in one big table, like interned strings are, so
+// global_index has the same rules as the compiler: only one thread can be
+// calling it at a time (see EventIndex.compile_lock).
+
+#include "events/value.h"
+#include "sensible_nums.h"
+#include "utility/vec.h"
+
+// global indices are varints in bytecode, so this is only here to keep the
+// store a fixed size
+#define GLOBAL_MAX 4096
+
+typedef struct
+{
+    // indexed by global_index. globals nothing has set yet are none
+    Value values[GLOBAL_MAX];
+} Globals;
+
+// returns the index of the global called `name`, giving it one if it doesn't
+// have one yet
+u32 global_index(const char *name);
+// the name of a global that's been given an index
+const char *global_name(u32 index);
+void global_names_free(void);
+
+// sets every global back to none (e.g. for a new game)
+void globals_clear(Globals *globals);
+
+// appends every global that's been set to `out` (a vec<u8>), in a flat binary
+// format that doesn't depend on global indices
+void globals_serialize(Globals *globals, vec *out);
+// replaces every global with what was serialized in `data`. returns false (and
+// leaves the globals alone) if the data is broken, or has more new names than
+// there's room for.
+// this gives names indices and interns strings, so the same rules as
+// global_index apply. while events can be compiling on another thread, use
+// event_index_load_globals instead, which holds the compile lock
+bool globals_deserialize(Globals *globals, const u8 *data, usize len);
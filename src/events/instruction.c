@@ -0,0 +1,144 @@
+#include "instruction.h"
+
+const char *const INSTRUCTION_NAMES[CODE_COUNT] = {
+    [Code_Goto] = "Goto",
+    [Code_GotoIfFalse] = "GotoIfFalse",
+    [Code_GotoIfTrue] = "GotoIfTrue",
+    [Code_Call] = "Call",
+    [Code_Pop] = "Pop",
+    [Code_Fetch] = "Fetch",
+    [Code_Set] = "Set",
+    [Code_FetchGlobal] = "FetchGlobal",
+    [Code_SetGlobal] = "SetGlobal",
+    [Code_Negate] = "Negate",
+    [Code_Not] = "Not",
+    [Code_Add] = "Add",
+    [Code_Sub] = "Sub",
+    [Code_Mul] = "Mul",
+    [Code_Div] = "Div",
+    [Code_Mod] = "Mod",
+    [Code_Int] = "Int",
+    [Code_Float] = "Float",
+    [Code_String] = "String",
+    [Code_True] = "True",
+    [Code_False] = "False",
+    [Code_None] = "None",
+    [Code_Eq] = "Eq",
+    [Code_NotEq] = "NotEq",
+    [Code_Greater] = "Greater",
+    [Code_GreaterEq] = "GreaterEq",
+    [Code_Less] = "Less",
+    [Code_LessEq] = "LessEq",
+    [Code_AddInt] = "AddInt",
+    [Code_SubInt] = "SubInt",
+    [Code_MulInt] = "MulInt",
+    [Code_DivInt] = "DivInt",
+    [Code_ModInt] = "ModInt",
+    [Code_AddFloat] = "AddFloat",
+    [Code_SubFloat] = "SubFloat",
+    [Code_MulFloat] = "MulFloat",
+    [Code_DivFloat] = "DivFloat",
+    [Code_GreaterIntInt] = "GreaterIntInt",
+    [Code_GreaterEqIntInt] = "GreaterEqIntInt",
+    [Code_LessIntInt] = "LessIntInt",
+    [Code_LessEqIntInt] = "LessEqIntInt",
+    [Code_GreaterFloatFloat] = "GreaterFloatFloat",
+    [Code_GreaterEqFloatFloat] = "GreaterEqFloatFloat",
+    [Code_LessFloatFloat] = "LessFloatFloat",
+    [Code_LessEqFloatFloat] = "LessEqFloatFloat",
+};
+
+static void push_byte(vec *code, u8 byte) { vec_push(code, &byte); }
+
+static void push_varint(vec *code, u32 value)
+{
+    do
+    {
+        u8 byte = value & 0x7F;
+        value >>= 7;
+        if (value)
+            byte |= 0x80;
+        push_byte(code, byte);
+    } while (value);
+}
+
+void instruction_encode(vec *code, Instruction instruction)
+{
+    push_byte(code, instruction.code);
+
+    switch (instruction.code)
+    {
+    case Code_Goto:
+    case Code_GotoIfFalse:
+    case Code_GotoIfTrue:
+        push_byte(code, instruction.data.position & 0xFF);
+        push_byte(code, (instruction.data.position >> 8) & 0xFF);
+        break;
+    case Code_Call:
+        push_byte(code, instruction.data.call.command);
+        push_byte(code, instruction.data.call.arg_count);
+        break;
+    case Code_Fetch:
+    case Code_Set:
+        push_byte(code, instruction.data.slot);
+        break;
+    case Code_FetchGlobal:
+    case Code_SetGlobal:
+        push_varint(code, instruction.data.global);
+        break;
+    case Code_Int:
+    {
+        // zigzag encode, so small negative numbers stay small
+        i32 value = instruction.data._int;
+        push_varint(code, ((u32)value << 1) ^ (u32)(value >> 31));
+        break;
+    }
+    case Code_Float:
+    case Code_String:
+        push_varint(code, instruction.data.constant);
+        break;
+    default:
+        break;
+    }
+}
+
+u32 instruction_decode(const u8 *code, u32 offset, Instruction *out)
+{
+    out->code = code[offset];
+    offset++;
+
+    switch (out->code)
+    {
+    case Code_Goto:
+    case Code_GotoIfFalse:
+    case Code_GotoIfTrue:
+        out->data.position = code_read_u16(code + offset);
+        offset += 2;
+        break;
+    case Code_Call:
+        out->data.call.command = code[offset];
+        out->data.call.arg_count = code[offset + 1];
+        offset += 2;
+        break;
+    case Code_Fetch:
+    case Code_Set:
+        out->data.slot = code[offset];
+        offset++;
+        break;
+    case Code_FetchGlobal:
+    case Code_SetGlobal:
+        out->data.global = code_read_varint(code, &offset);
+        break;
+    case Code_Int:
+        out->data._int = code_read_int(code, &offset);
+        break;
+    case Code_Float:
+    case Code_String:
+        out->data.constant = code_read_varint(code, &offset);
+        break;
+    default:
+        break;
+    }
+
+    return offset;
+}
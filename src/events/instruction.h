@@ -1,7 +1,28 @@
 #pragma once
 
+// events are stored as a stream of bytes rather than an array of instructions.
+// each instruction is a 1 byte opcode, followed by its operands (if it has any):
+//  - gotos: the u16 byte offset to jump to
+//  - Code_Call: the u8 command, then the u8 argument count
+//  - Code_Fetch, Code_Set: the u8 slot
+//  - Code_FetchGlobal, Code_SetGlobal: the global's index (see globals.h), as
+//    a LEB128 varint
+//  - Code_Int: the value, as a zigzagged LEB128 varint (so small numbers take up
+//    a single byte)
+//  - Code_Float, Code_String: the index of the value in the event's constants,
+//    as a LEB128 varint
+// nothing else has operands.
+//
+// multi-byte operands are little endian, and aren't aligned.
+
 #include "events/commands/command.h"
 #include "sensible_nums.h"
+#include "utility/vec.h"
+
+// gotos can't jump any further than this
+#define CODE_MAX_LEN UINT16_MAX
+// slot operands are a single byte
+#define SLOT_MAX 256
 
 typedef struct
 {
@@ -23,6 +44,9 @@ typedef struct
         Code_Fetch,
         // Set a value in a slot
         Code_Set,
+        // Fetch/set a global (see globals.h)
+        Code_FetchGlobal,
+        Code_SetGlobal,
 
         // unary ops
         Code_Negate,
@@ -50,6 +74,31 @@ typedef struct
         Code_GreaterEq,
         Code_Less,
         Code_LessEq,
+
+        // type specialized ops. these are never emitted directly by the
+        // parser- the type inference pass (see typecheck.h) swaps the generic
+        // ops above out for these when it can prove the operand types, so the
+        // vm can skip checking them at runtime
+        Code_AddInt,
+        Code_SubInt,
+        Code_MulInt,
+        Code_DivInt,
+        Code_ModInt,
+
+        Code_AddFloat,
+        Code_SubFloat,
+        Code_MulFloat,
+        Code_DivFloat,
+
+        Code_GreaterIntInt,
+        Code_GreaterEqIntInt,
+        Code_LessIntInt,
+        Code_LessEqIntInt,
+
+        Code_GreaterFloatFloat,
+        Code_GreaterEqFloatFloat,
+        Code_LessFloatFloat,
+        Code_LessEqFloatFloat,
     } code;
     union
     {
@@ -58,13 +107,13 @@ typedef struct
 
         // the slot to fetch/set to/from
         u32 slot;
+        // the global to fetch/set to/from
+        u32 global;
 
         // the integer value
         i32 _int;
-        // the float value
-        f32 _float;
-        // the string value
-        char *string;
+        // the index of a float/string in the event's constants
+        u32 constant;
         // the command to call
         struct
         {
@@ -75,3 +124,39 @@ typedef struct
 } Instruction;
 
 typedef enum InstructionCode InstructionCode;
+
+#define CODE_COUNT (Code_LessEqFloatFloat + 1)
+// for showing instructions to people (e.g. in the profiler)
+extern const char *const INSTRUCTION_NAMES[CODE_COUNT];
+
+static inline u16 code_read_u16(const u8 *code)
+{
+    return (u16)(code[0] | (code[1] << 8));
+}
+
+// reads a varint at `*offset`, and moves `*offset` past it
+static inline u32 code_read_varint(const u8 *code, u32 *offset)
+{
+    u32 value = 0;
+    u32 shift = 0;
+    u8 byte;
+    do
+    {
+        byte = code[*offset];
+        (*offset)++;
+        value |= (u32)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return value;
+}
+
+static inline i32 code_read_int(const u8 *code, u32 *offset)
+{
+    u32 zigzag = code_read_varint(code, offset);
+    return (i32)((zigzag >> 1) ^ -(zigzag & 1));
+}
+
+// appends an instruction to a vec<u8>
+void instruction_encode(vec *code, Instruction instruction);
+// decodes the instruction at `offset`, and returns the offset of the next one
+u32 instruction_decode(const u8 *code, u32 offset, Instruction *out);
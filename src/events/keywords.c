@@ -0,0 +1,103 @@
+#include "keywords.h"
+#include "utility/macros.h"
+#include <string.h>
+
+// has to be a power of two, and comfortably bigger than the number of words
+// so that a seed is quick to find
+#define TABLE_BITS 6
+#define TABLE_SIZE (1 << TABLE_BITS)
+
+static const Keyword KEYWORDS[] = {
+    {"event", 5, false, {.token = Token_Event}},
+    {"goto", 4, false, {.token = Token_Goto}},
+    {"if", 2, false, {.token = Token_If}},
+    {"else", 4, false, {.token = Token_Else}},
+    {"loop", 4, false, {.token = Token_Loop}},
+    {"while", 5, false, {.token = Token_While}},
+    {"for", 3, false, {.token = Token_For}},
+    {"none", 4, false, {.token = Token_None}},
+    {"true", 4, false, {.token = Token_True}},
+    {"false", 5, false, {.token = Token_False}},
+};
+#define KEYWORD_COUNT (sizeof(KEYWORDS) / sizeof(Keyword))
+
+static Keyword table[TABLE_SIZE];
+static u32 seed;
+static u32 max_len;
+static bool table_built = false;
+
+static u32 hash(u32 seed, const char *text, usize len)
+{
+    // fnv-1a, but starting from the seed
+    u32 hash = 0x811c9dc5u ^ seed;
+    for (usize i = 0; i < len; i++)
+    {
+        hash ^= (u8)text[i];
+        hash *= 0x01000193u;
+    }
+    return hash >> (32 - TABLE_BITS);
+}
+
+static bool try_insert(const Keyword *keyword)
+{
+    Keyword *bucket = &table[hash(seed, keyword->name, keyword->len)];
+    if (bucket->name)
+        return false;
+    *bucket = *keyword;
+    return true;
+}
+
+// keeps trying seeds until every word lands in a different bucket
+static void build_table(void)
+{
+    for (seed = 0; seed < UINT16_MAX; seed++)
+    {
+        memset(table, 0, sizeof(table));
+        max_len = 0;
+        bool collided = false;
+
+        for (u32 i = 0; i < KEYWORD_COUNT && !collided; i++)
+        {
+            collided = !try_insert(&KEYWORDS[i]);
+            if (KEYWORDS[i].len > max_len)
+                max_len = KEYWORDS[i].len;
+        }
+        for (Command command = 0; command < Command_Max_Val && !collided;
+             command++)
+        {
+            Keyword keyword = {
+                .name = COMMAND_NAMES[command],
+                .len = strlen(COMMAND_NAMES[command]),
+                .is_command = true,
+                .data.command = command,
+            };
+            collided = !try_insert(&keyword);
+            if (keyword.len > max_len)
+                max_len = keyword.len;
+        }
+
+        if (!collided)
+        {
+            table_built = true;
+            return;
+        }
+    }
+
+    FATAL("Couldn't build a perfect hash for keywords and commands (try "
+          "increasing TABLE_BITS)\n");
+}
+
+const Keyword *keyword_lookup(const char *text, usize len)
+{
+    if (!table_built)
+        build_table();
+
+    if (len > max_len)
+        return NULL;
+
+    const Keyword *keyword = &table[hash(seed, text, len)];
+    if (!keyword->name || keyword->len != len ||
+        memcmp(keyword->name, text, len))
+        return NULL;
+    return keyword;
+}
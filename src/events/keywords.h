@@ -0,0 +1,28 @@
+#pragma once
+
+// one table for every word that means something to the compiler: keywords,
+// and the names of commands.
+//
+// it's a perfect hash table built from COMMAND_NAMES the first time it's used-
+// every word gets its own bucket, so a lookup is one hash and one compare.
+
+#include "events/commands/command.h"
+#include "events/lexer.h"
+#include "sensible_nums.h"
+
+typedef struct
+{
+    const char *name;
+    u32 len;
+
+    bool is_command;
+    union
+    {
+        TokenType token;
+        Command command;
+    } data;
+} Keyword;
+
+// returns NULL if `text` isn't a keyword or command name.
+// text doesn't need to be null terminated
+const Keyword *keyword_lookup(const char *text, usize len);
@@ -1,8 +1,14 @@
 #include "lexer.h"
-#include "utility/macros.h"
+#include "events/keywords.h"
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 void lexer_init(Lexer *lexer, const char *src)
 {
     lexer->start = src;
@@ -30,6 +36,12 @@ static Token basic_token(TokenType type)
     return token;
 }
 
+static Token error_token(const char *message)
+{
+    Token token = {.type = Token_Error, .data.error = message};
+    return token;
+}
+
 static bool match(Lexer *lexer, char expected)
 {
     if (lexer_eof(lexer))
@@ -40,45 +52,112 @@ static bool match(Lexer *lexer, char expected)
     return true;
 }
 
+// whitespace, comments and strings make up most of a script, so they're
+// scanned 16 bytes at a time where we can.
+//
+// the scans only ever load 16 byte aligned blocks. an aligned block can't
+// cross into another page, so reading past the null terminator is safe (even
+// if address sanitizer disagrees)
+#ifdef __SSE2__
+
+// the loads have to happen directly inside these functions for this to apply
+#define NO_ASAN __attribute__((no_sanitize_address))
+
+// masks off any bits in the first block that come before `p`
+static inline u32 first_block_mask(const char *p, u32 mask)
+{
+    return mask & (0xFFFFu << ((uintptr_t)p & 15));
+}
+
+static inline const char *block_of(const char *p)
+{
+    return p - ((uintptr_t)p & 15);
+}
+
+NO_ASAN static const char *skip_blanks(const char *p)
+{
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+
+    const char *block = block_of(p);
+    for (bool first = true;; first = false, block += 16)
+    {
+        __m128i chunk = _mm_load_si128((const __m128i *)block);
+        __m128i blanks = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                         _mm_cmpeq_epi8(chunk, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, newline),
+                         _mm_cmpeq_epi8(chunk, carriage_return)));
+        // anything that isn't whitespace, including the terminator
+        u32 mask = ~_mm_movemask_epi8(blanks) & 0xFFFF;
+        if (first)
+            mask = first_block_mask(p, mask);
+        if (mask)
+            return block + __builtin_ctz(mask);
+    }
+}
+
+// finds the first `c`, or the null terminator
+NO_ASAN static const char *find_char(const char *p, char c)
+{
+    const __m128i wanted = _mm_set1_epi8(c);
+    const __m128i zero = _mm_setzero_si128();
+
+    const char *block = block_of(p);
+    for (bool first = true;; first = false, block += 16)
+    {
+        __m128i chunk = _mm_load_si128((const __m128i *)block);
+        u32 mask = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(chunk, wanted), _mm_cmpeq_epi8(chunk, zero)));
+        if (first)
+            mask = first_block_mask(p, mask);
+        if (mask)
+            return block + __builtin_ctz(mask);
+    }
+}
+
+#else
+
+static const char *skip_blanks(const char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        p++;
+    return p;
+}
+
+static const char *find_char(const char *p, char c)
+{
+    while (*p != c && *p != '\0')
+        p++;
+    return p;
+}
+
+#endif
+
 static void skip_whitespace(Lexer *lexer)
 {
     for (;;)
     {
-        char c = peek(lexer);
-        switch (c)
-        {
+        lexer->current = skip_blanks(lexer->current);
+
         // comments aren't really whitepace but they're convenient to handle
         // here
-        case '#':
-        {
-            // read until we find a newline
-            while (peek(lexer) != '\n' && !lexer_eof(lexer))
-                read(lexer);
-            break;
-        }
-        case ' ':
-        case '\r':
-        case '\t':
-        case '\n':
-            read(lexer);
-            break;
-        default:
+        if (peek(lexer) != '#')
             return;
-        }
+        // read until we find a newline
+        lexer->current = find_char(lexer->current, '\n');
     }
 }
 
 static Token read_string(Lexer *lexer)
 {
     // read until we hit closing quote or eof
-    while (peek(lexer) != '"' && !lexer_eof(lexer))
-    {
-        read(lexer);
-    }
+    lexer->current = find_char(lexer->current, '"');
 
-    // throw an error if eof
     if (lexer_eof(lexer))
-        FATAL("Unterminated event string!");
+        return error_token("Unterminated string");
 
     // closing quote
     read(lexer);
@@ -126,8 +205,7 @@ static Token read_number(Lexer *lexer)
     usize digits_len = lexer->current - lexer->start;
     // >= because of null terminator
     if (digits_len >= sizeof(digits))
-        FATAL("Numeric literals longer than %lu characters are unsupported",
-              sizeof(digits));
+        return error_token("Numeric literal is too long");
 
     // copy in digits
     memcpy(digits, lexer->start, digits_len);
@@ -162,60 +240,14 @@ static Token read_text(Lexer *lexer)
 
     Token token;
 
-    // while we could do fancy tree shenanigans to figure out what keyword the
-    // identifier is, i really couldn't be bothered
+    // commands are only special when they're called, so they're still
+    // identifiers as far as the lexer cares
     if (!is_label)
     {
-#define TEXT_IS_KW(keyword)                                                    \
-    (text_len >= strlen(keyword) && !strncmp(lexer->start, keyword, text_len))
-        if TEXT_IS_KW ("event")
+        const Keyword *keyword = keyword_lookup(lexer->start, text_len);
+        if (keyword && !keyword->is_command)
         {
-            token.type = Token_Event;
-            return token;
-        }
-        if TEXT_IS_KW ("goto")
-        {
-            token.type = Token_Goto;
-            return token;
-        }
-        if TEXT_IS_KW ("if")
-        {
-            token.type = Token_If;
-            return token;
-        }
-        if TEXT_IS_KW ("else")
-        {
-            token.type = Token_Else;
-            return token;
-        }
-        if TEXT_IS_KW ("loop")
-        {
-            token.type = Token_Loop;
-            return token;
-        }
-        if TEXT_IS_KW ("while")
-        {
-            token.type = Token_While;
-            return token;
-        }
-        if TEXT_IS_KW ("for")
-        {
-            token.type = Token_For;
-            return token;
-        }
-        if TEXT_IS_KW ("true")
-        {
-            token.type = Token_True;
-            return token;
-        }
-        if TEXT_IS_KW ("false")
-        {
-            token.type = Token_False;
-            return token;
-        }
-        if TEXT_IS_KW ("none")
-        {
-            token.type = Token_None;
+            token.type = keyword->data.token;
             return token;
         }
     }
@@ -242,13 +274,35 @@ static Token read_text(Lexer *lexer)
     return token;
 }
 
+// globals can be called anything a variable can, keywords included
+static Token read_global(Lexer *lexer)
+{
+    if (!is_alpha(peek(lexer)))
+        return error_token("Expected a name after '$'");
+
+    while (is_numeric(peek(lexer)) || is_alpha(peek(lexer)))
+        read(lexer);
+
+    // skip the $
+    usize name_len = lexer->current - lexer->start - 1;
+    char *name = malloc(name_len + 1);
+    memcpy(name, lexer->start + 1, name_len);
+    name[name_len] = '\0';
+
+    Token token = {.type = Token_Global, .data.ident = name};
+    return token;
+}
+
 bool lexer_next(Lexer *lexer, Token *token)
 {
     skip_whitespace(lexer);
     lexer->start = lexer->current;
 
     if (lexer_eof(lexer))
+    {
+        *token = basic_token(Token_Eof);
         return false;
+    }
 
     char c = read(lexer);
 
@@ -369,10 +423,15 @@ bool lexer_next(Lexer *lexer, Token *token)
     case '"':
         *token = read_string(lexer);
         return true;
+
+    case '$':
+        *token = read_global(lexer);
+        return true;
     }
 
-    // we couldn't handle this character. throw an error
-    FATAL("Failed to handle character %c", c);
+    // we couldn't handle this character
+    *token = error_token("Unexpected character");
+    return true;
 }
 
 void token_debug_printf(Token token)
@@ -412,6 +471,9 @@ void token_debug_printf(Token token)
     case Token_Label:
         printf("%s", token.data.label);
         break;
+    case Token_Global:
+        printf("$%s", token.data.ident);
+        break;
     case Token_BraceL:
         printf("{");
         break;
@@ -508,5 +570,11 @@ void token_debug_printf(Token token)
     case Token_For:
         printf("for");
         break;
+    case Token_Eof:
+        printf("<eof>");
+        break;
+    case Token_Error:
+        printf("<error: %s>", token.data.error);
+        break;
     }
 }
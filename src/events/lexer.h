@@ -23,6 +23,8 @@ typedef struct
         // special
         Token_Ident,
         Token_Label,
+        // $name
+        Token_Global,
 
         // braces (ifs, event defs, etc)
         Token_BraceL,
@@ -66,6 +68,11 @@ typedef struct
         Token_Mult,
         Token_Div,
         Token_Mod,
+
+        // there's nothing left
+        Token_Eof,
+        // something the lexer couldn't make sense of. data.error says what
+        Token_Error,
     } type;
 
     union TokenData
@@ -75,6 +82,7 @@ typedef struct
         char *label;
         i32 _int;
         f32 _float;
+        const char *error;
     } data;
 } Token;
 
@@ -87,7 +95,8 @@ typedef struct
 } Lexer;
 
 void lexer_init(Lexer *lexer, const char *src);
-// returns true if there are any more tokens
+// returns true if there are any more tokens. otherwise the token is Token_Eof.
+// the text of whatever token it lexed is between `start` and `current`
 bool lexer_next(Lexer *lexer, Token *token);
 bool lexer_eof(Lexer *lexer);
 
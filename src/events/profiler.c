@@ -0,0 +1,249 @@
+#include "profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+VMProfiler *vm_profiler = NULL;
+
+void vm_profiler_init(VMProfiler *profiler)
+{
+    memset(profiler->opcodes, 0, sizeof(profiler->opcodes));
+    memset(profiler->commands, 0, sizeof(profiler->commands));
+
+    vec_init(&profiler->events, sizeof(EventProfile *));
+    hashmap_init(&profiler->event_indices, fnv_cstr_ptr_hash_function,
+                 cstr_ptr_eq_function, sizeof(char *), sizeof(u32));
+    vec_init(&profiler->scopes, sizeof(ScopeProfile));
+}
+
+static void free_event_profile(usize i, void *ptr)
+{
+    (void)i;
+    EventProfile *profile = *(EventProfile **)ptr;
+    free(profile->name);
+    vec_free(&profile->line_counts);
+    free(profile);
+}
+
+void vm_profiler_free(VMProfiler *profiler)
+{
+    if (vm_profiler == profiler)
+        vm_profiler = NULL;
+
+    vec_free_with(&profiler->events, free_event_profile);
+    hashmap_free(&profiler->event_indices);
+    vec_free(&profiler->scopes);
+}
+
+void vm_profiler_reset(VMProfiler *profiler)
+{
+    memset(profiler->opcodes, 0, sizeof(profiler->opcodes));
+    memset(profiler->commands, 0, sizeof(profiler->commands));
+
+    vec_clear_with(&profiler->events, free_event_profile);
+    // the keys are the profiles' names, which are gone now
+    hashmap_clear(&profiler->event_indices);
+    vec_clear(&profiler->scopes);
+}
+
+EventProfile *vm_profiler_event(VMProfiler *profiler, const char *name)
+{
+    void *existing = hashmap_get(&profiler->event_indices, &name);
+    if (existing)
+    {
+        // hashmap values aren't aligned
+        u32 index;
+        memcpy(&index, existing, sizeof(u32));
+        return *(EventProfile **)vec_get(&profiler->events, index);
+    }
+
+    EventProfile *profile = calloc(1, sizeof(EventProfile));
+    profile->name = strdup(name);
+    vec_init(&profile->line_counts, sizeof(u64));
+
+    u32 index = profiler->events.len;
+    vec_push(&profiler->events, &profile);
+    hashmap_insert(&profiler->event_indices, &profile->name, &index);
+    return profile;
+}
+
+// makes sure there's a count for every line from `first` to `last`. a reloaded
+// event can end up covering different lines than it used to
+static void cover_lines(EventProfile *profile, u32 first, u32 last)
+{
+    u64 zero = 0;
+    vec *counts = &profile->line_counts;
+    if (!counts->len)
+        profile->first_line = first;
+
+    for (; profile->first_line > first; profile->first_line--)
+        vec_insert(counts, 0, &zero);
+    while (profile->first_line + counts->len <= last)
+        vec_push(counts, &zero);
+}
+
+void vm_profiler_begin_run(VMProfiler *profiler, ProfileRun *run,
+                           const Event *event)
+{
+    run->event = event;
+    run->profile = vm_profiler_event(profiler, event->name);
+    run->line = 0;
+    run->instructions = 0;
+
+    // lines only ever go forwards, so the first and last are the whole range
+    if (event->line_count)
+        cover_lines(run->profile, event->lines[0].line,
+                    event->lines[event->line_count - 1].line);
+}
+
+void vm_profiler_end_run(VMProfiler *profiler, ProfileRun *run,
+                         Duration time, bool finished, bool preempted)
+{
+    (void)profiler;
+    EventProfile *profile = run->profile;
+    profile->runs.calls++;
+    profile->runs.time = duration_add(profile->runs.time, time);
+    profile->instructions += run->instructions;
+
+    if (preempted)
+        profile->preemptions++;
+    else if (!finished)
+        profile->yields++;
+}
+
+void vm_profiler_command(VMProfiler *profiler, Command command, Duration time)
+{
+    CallProfile *profile = &profiler->commands[command];
+    profile->calls++;
+    profile->time = duration_add(profile->time, time);
+}
+
+void vm_profiler_wake(VMProfiler *profiler, const Event *event)
+{
+    vm_profiler_event(profiler, event->name)->wakes++;
+}
+
+Instant vm_profiler_scope_begin(void)
+{
+    if (!vm_profiler)
+        return (Instant){0};
+    return instant_now();
+}
+
+void vm_profiler_scope_end(Instant start, const char *name)
+{
+    VMProfiler *profiler = vm_profiler;
+    // profiling could have been turned on halfway through the scope
+    if (!profiler || !start.inner)
+        return;
+    Duration time = instant_elapsed(start);
+
+    // there's only ever a handful of these
+    ScopeProfile *scope = NULL;
+    for (u32 i = 0; i < profiler->scopes.len; i++)
+    {
+        ScopeProfile *existing = vec_get(&profiler->scopes, i);
+        if (existing->name == name || !strcmp(existing->name, name))
+        {
+            scope = existing;
+            break;
+        }
+    }
+    if (!scope)
+    {
+        ScopeProfile new_scope = {.name = name};
+        vec_push(&profiler->scopes, &new_scope);
+        scope = vec_get(&profiler->scopes, profiler->scopes.len - 1);
+    }
+
+    scope->profile.calls++;
+    scope->profile.time = duration_add(scope->profile.time, time);
+}
+
+// event names can have anything in them
+static void write_csv_string(FILE *file, const char *string)
+{
+    fputc('"', file);
+    for (const char *c = string; *c; c++)
+    {
+        if (*c == '"')
+            fputc('"', file);
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+static f64 millis(Duration duration)
+{
+    return duration_as_secs_f64(duration) * 1000.0;
+}
+
+static void write_call_row(FILE *file, const char *kind, const char *name,
+                           CallProfile *profile)
+{
+    fprintf(file, "%s,", kind);
+    write_csv_string(file, name);
+    fprintf(file, ",,%llu,,%f,,,\n", (unsigned long long)profile->calls,
+            millis(profile->time));
+}
+
+bool vm_profiler_export_csv(VMProfiler *profiler, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return false;
+
+    fprintf(file, "kind,name,line,calls,instructions,time_ms,yields,"
+                  "preemptions,wakes\n");
+
+    for (u32 op = 0; op < CODE_COUNT; op++)
+    {
+        if (profiler->opcodes[op])
+            fprintf(file, "opcode,%s,,,%llu,,,,\n", INSTRUCTION_NAMES[op],
+                    (unsigned long long)profiler->opcodes[op]);
+    }
+
+    for (u32 i = 0; i < profiler->events.len; i++)
+    {
+        EventProfile *profile = *(EventProfile **)vec_get(&profiler->events, i);
+        fprintf(file, "event,");
+        write_csv_string(file, profile->name);
+        fprintf(file, ",,%llu,%llu,%f,%llu,%llu,%llu\n",
+                (unsigned long long)profile->runs.calls,
+                (unsigned long long)profile->instructions,
+                millis(profile->runs.time),
+                (unsigned long long)profile->yields,
+                (unsigned long long)profile->preemptions,
+                (unsigned long long)profile->wakes);
+    }
+
+    for (u32 i = 0; i < profiler->events.len; i++)
+    {
+        EventProfile *profile = *(EventProfile **)vec_get(&profiler->events, i);
+        for (u32 line = 0; line < profile->line_counts.len; line++)
+        {
+            u64 count = *(u64 *)vec_get(&profile->line_counts, line);
+            if (!count)
+                continue;
+            fprintf(file, "line,");
+            write_csv_string(file, profile->name);
+            fprintf(file, ",%u,,%llu,,,,\n", profile->first_line + line,
+                    (unsigned long long)count);
+        }
+    }
+
+    for (u32 command = 0; command < Command_Max_Val; command++)
+    {
+        if (profiler->commands[command].calls)
+            write_call_row(file, "command", COMMAND_NAMES[command],
+                           &profiler->commands[command]);
+    }
+
+    for (u32 i = 0; i < profiler->scopes.len; i++)
+    {
+        ScopeProfile *scope = vec_get(&profiler->scopes, i);
+        write_call_row(file, "scope", scope->name, &scope->profile);
+    }
+
+    return fclose(file) == 0;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+// counts what the event vm spends its time on: how many of each instruction it
+// runs, how many instructions each event (and each line of each event) runs,
+// how long each command takes, and how often scripts yield and get woken up.
+//
+// it only counts while vm_profiler is set (the debug window has a checkbox, or
+// pass --profile-scripts). the vm has a separate copy of its loop for
+// profiling, so it costs nothing while it's off. while it's on, events that
+// were translated to C get interpreted instead, so they can be counted too.
+
+#include "events/commands/command.h"
+#include "events/event.h"
+#include "events/instruction.h"
+#include "sensible_nums.h"
+#include "utility/hashmap.h"
+#include "utility/time.h"
+#include "utility/vec.h"
+
+typedef struct
+{
+    u64 calls;
+    Duration time;
+} CallProfile;
+
+typedef struct
+{
+    char *name;
+    // how many times the vm ran this event (every time it picks back up after
+    // yielding counts)
+    CallProfile runs;
+    u64 instructions;
+    u64 yields;
+    // how many times it was paused for running out of budget
+    u64 preemptions;
+    u64 wakes;
+
+    // instructions run on each line, starting from first_line
+    u32 first_line;
+    vec line_counts; // vec<u64>
+} EventProfile;
+
+// a bit of code inside a command that's worth timing on its own
+typedef struct
+{
+    // not owned, see vm_profiler_scope_end
+    const char *name;
+    CallProfile profile;
+} ScopeProfile;
+
+typedef struct
+{
+    u64 opcodes[CODE_COUNT];
+    CallProfile commands[Command_Max_Val];
+
+    vec events; // vec<EventProfile*>
+    HashMap event_indices; // HashMap<char*, u32> (index into events)
+
+    vec scopes; // vec<ScopeProfile>
+} VMProfiler;
+
+// where the profiling vm loop keeps track of the event it's running
+typedef struct
+{
+    const Event *event;
+    EventProfile *profile;
+    // the LineStart the last instruction was under
+    u32 line;
+    u64 instructions;
+} ProfileRun;
+
+// NULL unless profiling is on
+extern VMProfiler *vm_profiler;
+
+void vm_profiler_init(VMProfiler *profiler);
+void vm_profiler_free(VMProfiler *profiler);
+// throws away everything counted so far
+void vm_profiler_reset(VMProfiler *profiler);
+
+// finds the profile for an event, adding it if it's new
+EventProfile *vm_profiler_event(VMProfiler *profiler, const char *name);
+
+void vm_profiler_begin_run(VMProfiler *profiler, ProfileRun *run,
+                           const Event *event);
+// `preempted` and `finished` are what vm_execute found out
+void vm_profiler_end_run(VMProfiler *profiler, ProfileRun *run,
+                         Duration time, bool finished, bool preempted);
+
+static inline void vm_profiler_instruction(VMProfiler *profiler,
+                                           ProfileRun *run, u32 ip,
+                                           InstructionCode op)
+{
+    profiler->opcodes[op]++;
+    run->instructions++;
+
+    const Event *event = run->event;
+    if (!event->line_count)
+        return;
+
+    // instructions mostly run one after another, so this is usually still the
+    // same line
+    u32 line = run->line;
+    if (ip < event->lines[line].ip ||
+        (line + 1 < event->line_count && ip >= event->lines[line + 1].ip))
+        line = run->line = event_line_index(event, ip);
+
+    u64 *counts = (u64 *)run->profile->line_counts.data;
+    counts[event->lines[line].line - run->profile->first_line]++;
+}
+
+void vm_profiler_command(VMProfiler *profiler, Command command, Duration time);
+// counts a script being woken up by the scheduler
+void vm_profiler_wake(VMProfiler *profiler, const Event *event);
+
+// times a bit of code inside a command, e.g.
+//   Instant start = vm_profiler_scope_begin();
+//   textbox_display_text(...);
+//   vm_profiler_scope_end(start, "textbox_display_text");
+// does nothing while profiling is off. `name` must outlive the profiler (use a
+// string literal)
+Instant vm_profiler_scope_begin(void);
+void vm_profiler_scope_end(Instant start, const char *name);
+
+// writes everything out as one big csv, with a `kind` column saying what each
+// row is. returns false if the file couldn't be written
+bool vm_profiler_export_csv(VMProfiler *profiler, const char *path);
@@ -0,0 +1,467 @@
+#include "scheduler.h"
+#include "events/profiler.h"
+#include "events/vm.h"
+#include <stdio.h>
+
+#define NO_TASK UINT32_MAX
+
+typedef enum
+{
+    Task_Free,
+    Task_Runnable,
+    Task_Sleeping,
+    Task_Waiting,
+} TaskState;
+
+typedef struct
+{
+    VM *vm;
+
+    u32 generation;
+    TaskState state;
+
+    // the list this task is currently in, and its neighbours in that list.
+    // free tasks use next to link the free list
+    TaskList *list;
+    u32 prev, next;
+
+    // the tick a sleeping task should wake up on
+    u64 deadline;
+    // the script waiting on this one to finish, if any
+    ScriptHandle joined_by;
+} ScriptTask;
+
+static ScriptTask *task_at(Scheduler *scheduler, u32 index)
+{
+    return vec_get(&scheduler->tasks, index);
+}
+
+static ScriptTask *get_task(Scheduler *scheduler, ScriptHandle script)
+{
+    ScriptTask *task = task_at(scheduler, script.index);
+    if (!task || task->state == Task_Free ||
+        task->generation != script.generation)
+        return NULL;
+    return task;
+}
+
+static void list_init(TaskList *list)
+{
+    list->head = NO_TASK;
+    list->tail = NO_TASK;
+    list->len = 0;
+}
+
+static void list_push(Scheduler *scheduler, TaskList *list, u32 index)
+{
+    ScriptTask *task = task_at(scheduler, index);
+    task->list = list;
+    task->prev = list->tail;
+    task->next = NO_TASK;
+
+    if (list->tail != NO_TASK)
+        task_at(scheduler, list->tail)->next = index;
+    else
+        list->head = index;
+    list->tail = index;
+    list->len++;
+}
+
+static void list_remove(Scheduler *scheduler, u32 index)
+{
+    ScriptTask *task = task_at(scheduler, index);
+    TaskList *list = task->list;
+    if (!list)
+        return;
+
+    if (task->prev != NO_TASK)
+        task_at(scheduler, task->prev)->next = task->next;
+    else
+        list->head = task->next;
+
+    if (task->next != NO_TASK)
+        task_at(scheduler, task->next)->prev = task->prev;
+    else
+        list->tail = task->prev;
+
+    list->len--;
+    task->list = NULL;
+    task->prev = NO_TASK;
+    task->next = NO_TASK;
+}
+
+static u32 list_pop(Scheduler *scheduler, TaskList *list)
+{
+    u32 index = list->head;
+    if (index != NO_TASK)
+        list_remove(scheduler, index);
+    return index;
+}
+
+static void make_runnable(Scheduler *scheduler, u32 index)
+{
+    list_remove(scheduler, index);
+    task_at(scheduler, index)->state = Task_Runnable;
+    list_push(scheduler, &scheduler->runnable, index);
+}
+
+// makes a task that was waiting on something runnable again
+static void wake(Scheduler *scheduler, u32 index)
+{
+    if (vm_profiler)
+        vm_profiler_wake(vm_profiler, &task_at(scheduler, index)->vm->event);
+    make_runnable(scheduler, index);
+}
+
+// moves every task in `from` onto the end of the runnable list
+static void wake_all(Scheduler *scheduler, TaskList *from)
+{
+    u32 index;
+    while ((index = from->head) != NO_TASK)
+        wake(scheduler, index);
+}
+
+static void wheel_insert(Scheduler *scheduler, u32 index)
+{
+    ScriptTask *task = task_at(scheduler, index);
+
+    u64 deadline = task->deadline;
+    // we can't represent deadlines that far out. park it as far out as we can
+    // and it'll get pushed further when it cascades down
+    const u64 max_delta = (1ull << (WHEEL_SLOT_BITS * WHEEL_LEVELS)) - 1;
+    if (deadline - scheduler->now > max_delta)
+        deadline = scheduler->now + max_delta;
+
+    // find the lowest level that can hold this deadline
+    u64 delta = deadline - scheduler->now;
+    u32 level = 0;
+    while (level < WHEEL_LEVELS - 1 &&
+           delta >= (1ull << (WHEEL_SLOT_BITS * (level + 1))))
+        level++;
+
+    u32 slot = (deadline >> (WHEEL_SLOT_BITS * level)) & (WHEEL_SLOTS - 1);
+    task->state = Task_Sleeping;
+    list_push(scheduler, &scheduler->wheel[level][slot], index);
+}
+
+// advances the wheel by one tick, waking anything that's due
+static void wheel_advance(Scheduler *scheduler)
+{
+    scheduler->now++;
+
+    // whenever a level wraps around, the next slot of the level above it is
+    // due to be spread out over the levels below
+    for (u32 level = 1; level < WHEEL_LEVELS; level++)
+    {
+        u64 lower_bits = WHEEL_SLOT_BITS * level;
+        if (scheduler->now & ((1ull << lower_bits) - 1))
+            break;
+
+        u32 slot = (scheduler->now >> lower_bits) & (WHEEL_SLOTS - 1);
+        TaskList *list = &scheduler->wheel[level][slot];
+        u32 index;
+        while ((index = list_pop(scheduler, list)) != NO_TASK)
+            wheel_insert(scheduler, index);
+    }
+
+    u32 slot = scheduler->now & (WHEEL_SLOTS - 1);
+    wake_all(scheduler, &scheduler->wheel[0][slot]);
+}
+
+void scheduler_init(Scheduler *scheduler)
+{
+    vec_init(&scheduler->tasks, sizeof(ScriptTask));
+    scheduler->free_tasks = NO_TASK;
+
+    list_init(&scheduler->runnable);
+    list_init(&scheduler->next_runnable);
+    for (u32 level = 0; level < WHEEL_LEVELS; level++)
+        for (u32 slot = 0; slot < WHEEL_SLOTS; slot++)
+            list_init(&scheduler->wheel[level][slot]);
+    for (u32 signal = 0; signal < Signal_Max; signal++)
+        list_init(&scheduler->signals[signal]);
+    list_init(&scheduler->joining);
+
+    scheduler->now = 0;
+    scheduler->ran_last_tick = 0;
+
+    scheduler->instruction_budget = DEFAULT_INSTRUCTION_BUDGET;
+    scheduler->time_budget = duration_from_micros(DEFAULT_TIME_BUDGET_MICROS);
+    scheduler->ran_for_last_tick = (Duration){0};
+    scheduler->preempted_last_tick = 0;
+    scheduler->deferred_last_tick = 0;
+    scheduler->overrun_count = 0;
+
+    vm_pool_init(&scheduler->vms);
+}
+
+void scheduler_free(Scheduler *scheduler)
+{
+    for (u32 i = 0; i < scheduler->tasks.len; i++)
+    {
+        ScriptTask *task = task_at(scheduler, i);
+        ScriptHandle script = {.index = i, .generation = task->generation};
+        scheduler_kill(scheduler, script);
+    }
+    vec_free(&scheduler->tasks);
+    vm_pool_free(&scheduler->vms);
+}
+
+ScriptHandle scheduler_spawn(Scheduler *scheduler, Event event, void *vm_ctx)
+{
+    VM *vm = vm_pool_get(&scheduler->vms, event);
+    vm->vm_ctx = vm_ctx;
+
+    u32 index = scheduler->free_tasks;
+    if (index != NO_TASK)
+    {
+        scheduler->free_tasks = task_at(scheduler, index)->next;
+    }
+    else
+    {
+        ScriptTask task = {.generation = 0, .state = Task_Free};
+        index = scheduler->tasks.len;
+        vec_push(&scheduler->tasks, &task);
+    }
+
+    ScriptTask *task = task_at(scheduler, index);
+    // generations start at 1, so a zeroed handle is never valid
+    task->generation++;
+    task->vm = vm;
+    task->list = NULL;
+    task->joined_by = (ScriptHandle){0};
+    make_runnable(scheduler, index);
+
+    return (ScriptHandle){.index = index, .generation = task->generation};
+}
+
+static void finish_task(Scheduler *scheduler, u32 index)
+{
+    ScriptTask *task = task_at(scheduler, index);
+    list_remove(scheduler, index);
+
+    ScriptTask *joiner = get_task(scheduler, task->joined_by);
+    if (joiner)
+        wake(scheduler, task->joined_by.index);
+
+    vm_free(task->vm);
+    vm_pool_put(&scheduler->vms, task->vm);
+
+    task->vm = NULL;
+    task->state = Task_Free;
+    task->generation++;
+    task->next = scheduler->free_tasks;
+    scheduler->free_tasks = index;
+}
+
+void scheduler_kill(Scheduler *scheduler, ScriptHandle script)
+{
+    if (!get_task(scheduler, script))
+        return;
+
+    // anything this script is waiting on was started by it, and might be
+    // pointing at the same vm_ctx. kill them too
+    for (u32 i = 0; i < scheduler->tasks.len; i++)
+    {
+        ScriptTask *task = task_at(scheduler, i);
+        if (task->state == Task_Free)
+            continue;
+        if (task->joined_by.index == script.index &&
+            task->joined_by.generation == script.generation)
+        {
+            ScriptHandle child = {.index = i, .generation = task->generation};
+            scheduler_kill(scheduler, child);
+        }
+    }
+
+    finish_task(scheduler, script.index);
+}
+
+bool scheduler_is_running(Scheduler *scheduler, ScriptHandle script)
+{
+    return get_task(scheduler, script) != NULL;
+}
+
+bool scheduler_is_running_code(Scheduler *scheduler, const u8 *code)
+{
+    for (u32 i = 0; i < scheduler->tasks.len; i++)
+    {
+        ScriptTask *task = task_at(scheduler, i);
+        if (task->state != Task_Free && task->vm->event.code == code)
+            return true;
+    }
+    return false;
+}
+
+// figures out where a task that just yielded should go
+static void park(Scheduler *scheduler, u32 index)
+{
+    ScriptTask *task = task_at(scheduler, index);
+    VMWait wait = task->vm->wait;
+    task->vm->wait = (VMWait){.type = Wait_Yield};
+
+    switch (wait.type)
+    {
+    case Wait_Yield:
+        list_push(scheduler, &scheduler->next_runnable, index);
+        break;
+    case Wait_Ticks:
+    {
+        u64 ticks = wait.data.ticks ? wait.data.ticks : 1;
+        task->deadline = scheduler->now + ticks;
+        wheel_insert(scheduler, index);
+        break;
+    }
+    case Wait_Signal:
+        task->state = Task_Waiting;
+        list_push(scheduler, &scheduler->signals[wait.data.signal], index);
+        break;
+    case Wait_Script:
+    {
+        ScriptTask *other = get_task(scheduler, wait.data.script);
+        if (!other)
+        {
+            // it's already finished, so there's nothing to wait for
+            list_push(scheduler, &scheduler->runnable, index);
+            break;
+        }
+        other->joined_by = (ScriptHandle){
+            .index = index,
+            .generation = task->generation,
+        };
+        task->state = Task_Waiting;
+        list_push(scheduler, &scheduler->joining, index);
+        break;
+    }
+    }
+}
+
+// moves every task in `from` onto the front of `to`, keeping their order
+static void move_to_front(Scheduler *scheduler, TaskList *from, TaskList *to)
+{
+    while (from->tail != NO_TASK)
+    {
+        u32 index = from->tail;
+        list_remove(scheduler, index);
+
+        ScriptTask *task = task_at(scheduler, index);
+        task->list = to;
+        task->prev = NO_TASK;
+        task->next = to->head;
+        if (to->head != NO_TASK)
+            task_at(scheduler, to->head)->prev = index;
+        else
+            to->tail = index;
+        to->head = index;
+        to->len++;
+    }
+}
+
+static void record_overrun(Scheduler *scheduler, OverrunType type, VM *vm)
+{
+    BudgetOverrun *overrun =
+        &scheduler->overruns[scheduler->overrun_count % OVERRUN_HISTORY];
+    *overrun = (BudgetOverrun){
+        .type = type,
+        .ip = vm->ip,
+        .tick = scheduler->now,
+    };
+    snprintf(overrun->event, sizeof(overrun->event), "%s", vm->event.name);
+    scheduler->overrun_count++;
+}
+
+void scheduler_tick(Scheduler *scheduler, struct Resources *resources)
+{
+    wheel_advance(scheduler);
+
+    // scripts that yielded last tick (or didn't get to run) run before anything
+    // woken this tick
+    move_to_front(scheduler, &scheduler->next_runnable, &scheduler->runnable);
+
+    scheduler->ran_last_tick = 0;
+    scheduler->preempted_last_tick = 0;
+    scheduler->deferred_last_tick = 0;
+    scheduler->ran_for_last_tick = (Duration){0};
+    // don't bother with the clock on ticks where nothing happens
+    if (!scheduler->runnable.len)
+        return;
+
+    u32 instruction_budget = scheduler->instruction_budget;
+    if (!instruction_budget)
+        instruction_budget = UINT32_MAX;
+    bool timed = scheduler->time_budget.inner > 0;
+    Instant start = instant_now();
+
+    // scripts spawned or woken while this runs get appended to the runnable
+    // list, so they run this tick too
+    u32 index;
+    while ((index = list_pop(scheduler, &scheduler->runnable)) != NO_TASK)
+    {
+        // don't hold onto the task pointer, the task array may grow if this
+        // script spawns another one
+        VM *vm = task_at(scheduler, index)->vm;
+        vm->budget = instruction_budget;
+        bool finished = vm_execute(vm, resources);
+        scheduler->ran_last_tick++;
+
+        if (vm->preempted)
+        {
+            scheduler->preempted_last_tick++;
+            record_overrun(scheduler, Overrun_Instructions, vm);
+        }
+
+        bool out_of_time =
+            timed && duration_is_gt(instant_elapsed(start),
+                                    scheduler->time_budget);
+        if (out_of_time && scheduler->runnable.len && !finished)
+            record_overrun(scheduler, Overrun_Time, vm);
+
+        if (finished)
+            finish_task(scheduler, index);
+        else
+            park(scheduler, index);
+
+        if (out_of_time && scheduler->runnable.len)
+        {
+            // everything that didn't get a turn goes first next tick
+            scheduler->deferred_last_tick = scheduler->runnable.len;
+            move_to_front(scheduler, &scheduler->runnable,
+                          &scheduler->next_runnable);
+            break;
+        }
+    }
+    scheduler->ran_for_last_tick = instant_elapsed(start);
+}
+
+void scheduler_signal(Scheduler *scheduler, VMSignal signal)
+{
+    wake_all(scheduler, &scheduler->signals[signal]);
+}
+
+u32 scheduler_running_count(Scheduler *scheduler)
+{
+    return scheduler->runnable.len + scheduler->next_runnable.len;
+}
+
+u32 scheduler_sleeping_count(Scheduler *scheduler)
+{
+    u32 count = 0;
+    for (u32 level = 0; level < WHEEL_LEVELS; level++)
+        for (u32 slot = 0; slot < WHEEL_SLOTS; slot++)
+            count += scheduler->wheel[level][slot].len;
+    return count;
+}
+
+u32 scheduler_waiting_count(Scheduler *scheduler)
+{
+    u32 count = scheduler->joining.len;
+    for (u32 signal = 0; signal < Signal_Max; signal++)
+        count += scheduler->signals[signal].len;
+    return count;
+}
+
+BudgetOverrun *scheduler_overrun(Scheduler *scheduler, u32 i)
+{
+    u32 latest = scheduler->overrun_count - 1;
+    return &scheduler->overruns[(latest - i) % OVERRUN_HISTORY];
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+// the scheduler owns every running script, and decides which ones need to run
+// each fixed update.
+//
+// rather than running every vm every tick, scripts tell the scheduler what
+// they're waiting on before they yield (see vm_wait_ticks and friends):
+//  - scripts that are sleeping for a set amount of time get parked in a
+//    hierarchical timer wheel, keyed by the tick they should wake up on
+//  - scripts that are waiting on something else happening (like the textbox
+//    closing) get parked until someone calls scheduler_signal
+//  - scripts that are waiting on another script get woken when it finishes
+//  - everything else (i.e. plain yield()s) runs again next tick
+//
+// so each tick only costs as much as the scripts that actually need to run,
+// no matter how many are waiting.
+//
+// scripts also can't hog a tick. each one gets an instruction budget per tick,
+// and once it's used that up it gets paused at the next backwards jump (i.e.
+// the end of a loop iteration) as if it had yielded. on top of that, all the
+// scripts in a tick share a time budget- once that runs out, whatever hasn't
+// run yet gets pushed to the front of the queue for next tick.
+
+#include "events/event.h"
+#include "events/vm_pool.h"
+#include "sensible_nums.h"
+#include "utility/time.h"
+#include "utility/vec.h"
+#include <stdbool.h>
+
+struct VM;
+struct Resources;
+
+// a zeroed handle never refers to a script
+typedef struct
+{
+    u32 index;
+    u32 generation;
+} ScriptHandle;
+
+typedef enum
+{
+    // the map textbox was closed
+    Signal_TextboxClosed,
+
+    Signal_Max,
+} VMSignal;
+
+// intrusive list of tasks (linked through indices, not pointers, because the
+// task array can move)
+typedef struct
+{
+    u32 head, tail;
+    u32 len;
+} TaskList;
+
+#define WHEEL_LEVELS 4
+#define WHEEL_SLOT_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_SLOT_BITS)
+
+// roughly a millisecond of bytecode
+#define DEFAULT_INSTRUCTION_BUDGET 100000
+// a quarter of a 60hz frame
+#define DEFAULT_TIME_BUDGET_MICROS 4000
+// how many overruns the debug window gets to show
+#define OVERRUN_HISTORY 8
+
+typedef enum
+{
+    // a script ran out of instructions and got paused
+    Overrun_Instructions,
+    // a script was running when the tick ran out of time
+    Overrun_Time,
+} OverrunType;
+
+typedef struct
+{
+    OverrunType type;
+    // a copy, since the event might be gone (or reloaded) by the time anyone
+    // looks at this
+    char event[64];
+    // where the script was paused, or where it stopped if it ran out of time
+    u32 ip;
+    u64 tick;
+} BudgetOverrun;
+
+typedef struct
+{
+    vec tasks; // vec<ScriptTask>
+    u32 free_tasks;
+
+    // scripts that run this tick, and scripts that yielded this tick
+    TaskList runnable, next_runnable;
+    // level 0 covers the next WHEEL_SLOTS ticks, level 1 the next
+    // WHEEL_SLOTS^2, and so on
+    TaskList wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+    TaskList signals[Signal_Max];
+    // scripts waiting on other scripts to finish
+    TaskList joining;
+
+    // how many ticks have passed
+    u64 now;
+
+    // how many scripts were run last tick
+    u32 ran_last_tick;
+
+    // how many instructions a script can run each tick. 0 means no limit
+    u32 instruction_budget;
+    // how long every script put together can run for each tick. 0 means no
+    // limit
+    Duration time_budget;
+
+    // how long scripts ran for last tick
+    Duration ran_for_last_tick;
+    // scripts that got paused for running out of instructions last tick
+    u32 preempted_last_tick;
+    // scripts that didn't get to run last tick because it ran out of time
+    u32 deferred_last_tick;
+    // every overrun ever, and a ring buffer of the latest ones
+    u32 overrun_count;
+    BudgetOverrun overruns[OVERRUN_HISTORY];
+
+    // where every script's vm comes from
+    VMPool vms;
+} Scheduler;
+
+void scheduler_init(Scheduler *scheduler);
+// kills every script that's still running
+void scheduler_free(Scheduler *scheduler);
+
+// starts running `event` next tick (or this tick, if called while the scheduler
+// is ticking), with its vm_ctx set to `vm_ctx`.
+ScriptHandle scheduler_spawn(Scheduler *scheduler, Event event, void *vm_ctx);
+// stops and frees a script, along with any scripts it's waiting on.
+// does nothing if the script has already finished.
+void scheduler_kill(Scheduler *scheduler, ScriptHandle script);
+bool scheduler_is_running(Scheduler *scheduler, ScriptHandle script);
+// returns true if any script is running the given bytecode
+bool scheduler_is_running_code(Scheduler *scheduler, const u8 *code);
+
+// runs every script that's runnable this tick
+void scheduler_tick(Scheduler *scheduler, struct Resources *resources);
+// wakes up every script waiting on `signal`
+void scheduler_signal(Scheduler *scheduler, VMSignal signal);
+
+u32 scheduler_running_count(Scheduler *scheduler);
+u32 scheduler_sleeping_count(Scheduler *scheduler);
+u32 scheduler_waiting_count(Scheduler *scheduler);
+
+// the `i`th most recent overrun. i must be less than
+// min(overrun_count, OVERRUN_HISTORY)
+BudgetOverrun *scheduler_overrun(Scheduler *scheduler, u32 i);
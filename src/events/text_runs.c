@@ -0,0 +1,55 @@
+#include "text_runs.h"
+#include "utility/vec.h"
+#include <stdlib.h>
+
+static void push_run(vec *runs, TextRunType type, u16 value)
+{
+    TextRun run = {.type = type, .value = value};
+    vec_push(runs, &run);
+}
+
+void text_runs_parse(TextRuns *out, const char *source)
+{
+    vec text; // vec<char>
+    vec runs; // vec<TextRun>
+    vec_init(&text, sizeof(char));
+    vec_init(&runs, sizeof(TextRun));
+
+    const char *p = source;
+    while (*p)
+    {
+        if (*p == '\\')
+        {
+            // a \ right at the end doesn't escape anything, so it's dropped too
+            char code = p[1];
+            p += code ? 2 : 1;
+            if (code == '.')
+                push_run(&runs, TextRun_Pause, TEXT_PAUSE_LENGTH);
+            continue;
+        }
+
+        vec_push(&text, (void *)p);
+        p++;
+
+        // add to the text run we're in the middle of, if there is one
+        TextRun *last = vec_get(&runs, runs.len - 1);
+        if (last && last->type == TextRun_Text && last->value < UINT16_MAX)
+            last->value++;
+        else
+            push_run(&runs, TextRun_Text, 1);
+    }
+
+    out->source = source;
+    out->len = text.len;
+    char terminator = '\0';
+    vec_push(&text, &terminator);
+    out->text = text.data;
+    out->runs = (TextRun *)runs.data;
+    out->run_count = runs.len;
+}
+
+void text_runs_free(TextRuns *runs)
+{
+    free(runs->text);
+    free(runs->runs);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+// text shown in the textbox can have escape codes in it (`\.` pauses for a
+// bit). rather than the textbox picking those out while it types, the
+// compiler splits every text("...") string up ahead of time into the text with
+// the codes taken out, and a list of runs saying what to do as it gets typed.
+
+#include "sensible_nums.h"
+
+typedef enum
+{
+    // `value` characters of text
+    TextRun_Text,
+    // stop typing for `value` hundredths of a second (`\.`)
+    TextRun_Pause,
+} TextRunType;
+
+typedef struct
+{
+    u8 type; // TextRunType
+    u16 value;
+} TextRun;
+
+// how long `\.` pauses for, in hundredths of a second
+#define TEXT_PAUSE_LENGTH 50
+
+typedef struct
+{
+    // the string from the script. interned, so it can be found by pointer
+    const char *source;
+
+    // the text with every escape code taken out
+    char *text;
+    // how long text is (the textbox types a character per byte, so this is
+    // also how many steps typing it takes)
+    u32 len;
+
+    TextRun *runs;
+    u32 run_count;
+} TextRuns;
+
+// splits `source` up. unknown escape codes are dropped
+void text_runs_parse(TextRuns *out, const char *source);
+void text_runs_free(TextRuns *runs);
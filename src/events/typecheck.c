@@ -0,0 +1,507 @@
+#include "typecheck.h"
+#include "events/instruction.h"
+#include "events/vm.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// what we know about a value at some point in an event
+typedef enum
+{
+    Type_None,
+    Type_Int,
+    Type_Float,
+    Type_String,
+    Type_Bool,
+    // could be anything. command results are always this, as are slots that
+    // are assigned different types depending on which branch was taken
+    Type_Any,
+} StaticType;
+
+// the types on the stack and in every slot right *before* an instruction runs.
+// there's one of these for every byte of code (only the ones at the start of
+// an instruction get used)
+typedef struct
+{
+    bool visited;
+    bool queued;
+    u32 depth;
+    // STACK_MAX stack types, followed by slot_count slot types
+    u8 *types;
+} TypeState;
+
+typedef struct
+{
+    Event *event;
+
+    TypeState *states;
+    u8 *type_storage;
+    u32 state_size;
+
+    // instructions that need to be (re)visited
+    u32 *worklist;
+    u32 worklist_len;
+
+    // the deepest the stack has gotten so far
+    u32 max_depth;
+
+    // set if the stack depth doesn't match up between two branches.
+    // the compiler should never emit code like that, but if it does we just
+    // give up on specializing rather than guessing
+    bool failed;
+
+    // errors are only reported once the types have settled, since a state
+    // that's still being widened (like a variable that's none the first time
+    // through a loop) can look wrong when it isn't
+    bool reporting;
+    // set on the first type error, which is the only one that's reported
+    bool type_error;
+    char *error;
+    usize error_size;
+    u32 error_ip;
+} Checker;
+
+static const char *type_name(StaticType type)
+{
+    switch (type)
+    {
+    case Type_None:
+        return "none";
+    case Type_Int:
+        return "int";
+    case Type_Float:
+        return "float";
+    case Type_String:
+        return "string";
+    case Type_Bool:
+        return "bool";
+    case Type_Any:
+        return "any";
+    }
+    return "unknown";
+}
+
+static void type_error(Checker *checker, u32 ip, const char *format, ...)
+{
+    if (!checker->reporting || checker->type_error)
+        return;
+    checker->type_error = true;
+    checker->error_ip = ip;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(checker->error, checker->error_size, format, args);
+    va_end(args);
+}
+
+static bool maybe_numeric(StaticType type)
+{
+    return type == Type_Int || type == Type_Float || type == Type_Any;
+}
+
+static void enqueue(Checker *checker, u32 ip)
+{
+    TypeState *state = &checker->states[ip];
+    if (state->queued)
+        return;
+    state->queued = true;
+    checker->worklist[checker->worklist_len] = ip;
+    checker->worklist_len++;
+}
+
+// merges the types flowing out of one instruction into the state of another
+static void merge_into(Checker *checker, u32 target, u32 depth, u8 *types)
+{
+    // jumping past the end just means the event finished. and once we're
+    // reporting errors the states are final
+    if (target >= checker->event->code_len || checker->reporting)
+        return;
+
+    TypeState *state = &checker->states[target];
+    if (!state->visited)
+    {
+        state->visited = true;
+        state->depth = depth;
+        memcpy(state->types, types, checker->state_size);
+        enqueue(checker, target);
+        return;
+    }
+
+    if (state->depth != depth)
+    {
+        checker->failed = true;
+        return;
+    }
+
+    bool changed = false;
+    for (u32 i = 0; i < checker->state_size; i++)
+    {
+        // skip over the unused part of the stack
+        if (i >= depth && i < STACK_MAX)
+            continue;
+
+        if (state->types[i] != types[i] && state->types[i] != Type_Any)
+        {
+            state->types[i] = Type_Any;
+            changed = true;
+        }
+    }
+
+    if (changed)
+        enqueue(checker, target);
+}
+
+static StaticType arith_result(Checker *checker, u32 ip, const char *op,
+                               StaticType a, StaticType b)
+{
+    if (!maybe_numeric(a) || !maybe_numeric(b))
+    {
+        type_error(checker, ip,
+                   "Operands to %s must be numbers (got %s and %s)", op,
+                   type_name(a), type_name(b));
+    }
+
+    if (a == Type_Int && b == Type_Int)
+        return Type_Int;
+    if (a == Type_Any || b == Type_Any)
+        return Type_Any;
+    // if *any* of the operands are floats, the output value is a float
+    return Type_Float;
+}
+
+static void compare_check(Checker *checker, u32 ip, const char *op,
+                          StaticType a, StaticType b)
+{
+    if (!maybe_numeric(a) || !maybe_numeric(b))
+    {
+        type_error(checker, ip,
+                   "Operands to %s must be numbers (got %s and %s)", op,
+                   type_name(a), type_name(b));
+    }
+}
+
+// runs a single instruction on the types in `types`, and sets `next` to the
+// offset of the instruction after it.
+// returns false if execution can't fall through to the next instruction.
+static bool step(Checker *checker, u32 ip, u32 *next, u32 *depth, u8 *types)
+{
+    Instruction insn;
+    *next = instruction_decode(checker->event->code, ip, &insn);
+    u8 *slots = types + STACK_MAX;
+
+#define POP()                                                                  \
+    (*depth == 0 ? (checker->failed = true, Type_Any) : types[--(*depth)])
+#define PUSH(type)                                                             \
+    {                                                                          \
+        if (*depth >= STACK_MAX)                                               \
+        {                                                                      \
+            type_error(checker, ip, "Needs more than %d stack slots",          \
+                       STACK_MAX);                                             \
+            return false;                                                      \
+        }                                                                      \
+        types[(*depth)++] = (type);                                            \
+    }
+#define ARITH(op)                                                              \
+    {                                                                          \
+        StaticType b = POP();                                                  \
+        StaticType a = POP();                                                  \
+        PUSH(arith_result(checker, ip, op, a, b));                             \
+        break;                                                                 \
+    }
+#define COMPARE(op)                                                            \
+    {                                                                          \
+        StaticType b = POP();                                                  \
+        StaticType a = POP();                                                  \
+        compare_check(checker, ip, op, a, b);                                  \
+        PUSH(Type_Bool);                                                       \
+        break;                                                                 \
+    }
+
+    switch (insn.code)
+    {
+    case Code_Goto:
+        merge_into(checker, insn.data.position, *depth, types);
+        return false;
+    case Code_GotoIfFalse:
+    case Code_GotoIfTrue:
+        merge_into(checker, insn.data.position, *depth, types);
+        break;
+    case Code_Call:
+    {
+        for (u32 i = 0; i < insn.data.call.arg_count; i++)
+            POP();
+        PUSH(Type_Any);
+        break;
+    }
+    case Code_Pop:
+        POP();
+        break;
+    case Code_Fetch:
+        PUSH(slots[insn.data.slot]);
+        break;
+    case Code_Set:
+    {
+        if (*depth == 0)
+        {
+            checker->failed = true;
+            break;
+        }
+        slots[insn.data.slot] = types[*depth - 1];
+        break;
+    }
+    // any event could have set a global to anything
+    case Code_FetchGlobal:
+        PUSH(Type_Any);
+        break;
+    case Code_SetGlobal:
+        if (*depth == 0)
+            checker->failed = true;
+        break;
+    case Code_Negate:
+    {
+        StaticType value = POP();
+        if (!maybe_numeric(value))
+        {
+            type_error(checker, ip, "Negate operand must be a number (got %s)",
+                       type_name(value));
+        }
+        PUSH(value);
+        break;
+    }
+    case Code_Not:
+        POP();
+        PUSH(Type_Bool);
+        break;
+
+    case Code_Add:
+    case Code_AddInt:
+    case Code_AddFloat:
+        ARITH("+");
+    case Code_Sub:
+    case Code_SubInt:
+    case Code_SubFloat:
+        ARITH("-");
+    case Code_Mul:
+    case Code_MulInt:
+    case Code_MulFloat:
+        ARITH("*");
+    case Code_Div:
+    case Code_DivInt:
+    case Code_DivFloat:
+        ARITH("/");
+    case Code_Mod:
+    case Code_ModInt:
+    {
+        StaticType b = POP();
+        StaticType a = POP();
+        bool a_ok = a == Type_Int || a == Type_Any;
+        bool b_ok = b == Type_Int || b == Type_Any;
+        if (!a_ok || !b_ok)
+        {
+            type_error(checker, ip,
+                       "Operands to %% must be integers (got %s and %s)",
+                       type_name(a), type_name(b));
+        }
+        PUSH(Type_Int);
+        break;
+    }
+
+    case Code_Int:
+        PUSH(Type_Int);
+        break;
+    case Code_Float:
+        PUSH(Type_Float);
+        break;
+    case Code_String:
+        PUSH(Type_String);
+        break;
+    case Code_True:
+    case Code_False:
+        PUSH(Type_Bool);
+        break;
+    case Code_None:
+        PUSH(Type_None);
+        break;
+
+    case Code_Eq:
+    case Code_NotEq:
+        POP();
+        POP();
+        PUSH(Type_Bool);
+        break;
+
+    case Code_Greater:
+    case Code_GreaterIntInt:
+    case Code_GreaterFloatFloat:
+        COMPARE(">");
+    case Code_GreaterEq:
+    case Code_GreaterEqIntInt:
+    case Code_GreaterEqFloatFloat:
+        COMPARE(">=");
+    case Code_Less:
+    case Code_LessIntInt:
+    case Code_LessFloatFloat:
+        COMPARE("<");
+    case Code_LessEq:
+    case Code_LessEqIntInt:
+    case Code_LessEqFloatFloat:
+        COMPARE("<=");
+    }
+
+#undef POP
+#undef PUSH
+#undef ARITH
+#undef COMPARE
+
+    return true;
+}
+
+// picks a specialized version of `code` for the given operand types, or
+// returns `code` unchanged if there isn't one.
+static InstructionCode specialize(InstructionCode code, StaticType a,
+                                  StaticType b)
+{
+    bool ints = a == Type_Int && b == Type_Int;
+    bool floats = a == Type_Float && b == Type_Float;
+
+    switch (code)
+    {
+    case Code_Add:
+        return ints ? Code_AddInt : floats ? Code_AddFloat : code;
+    case Code_Sub:
+        return ints ? Code_SubInt : floats ? Code_SubFloat : code;
+    case Code_Mul:
+        return ints ? Code_MulInt : floats ? Code_MulFloat : code;
+    case Code_Div:
+        return ints ? Code_DivInt : floats ? Code_DivFloat : code;
+    case Code_Mod:
+        return ints ? Code_ModInt : code;
+    case Code_Greater:
+        return ints     ? Code_GreaterIntInt
+               : floats ? Code_GreaterFloatFloat
+                        : code;
+    case Code_GreaterEq:
+        return ints     ? Code_GreaterEqIntInt
+               : floats ? Code_GreaterEqFloatFloat
+                        : code;
+    case Code_Less:
+        return ints ? Code_LessIntInt : floats ? Code_LessFloatFloat : code;
+    case Code_LessEq:
+        return ints     ? Code_LessEqIntInt
+               : floats ? Code_LessEqFloatFloat
+                        : code;
+    default:
+        return code;
+    }
+}
+
+bool typecheck_event(Event *event, char *error, usize error_size,
+                     u32 *error_ip)
+{
+    event->stack_max = 0;
+    if (event->code_len == 0)
+        return true;
+
+    Checker checker = {
+        .event = event,
+        .state_size = STACK_MAX + event->slot_count,
+        .worklist_len = 0,
+        .max_depth = 0,
+        .failed = false,
+        .reporting = false,
+        .type_error = false,
+        .error = error,
+        .error_size = error_size,
+    };
+    u32 len = event->code_len;
+    checker.states = calloc(len, sizeof(TypeState));
+    checker.type_storage = calloc(len, checker.state_size);
+    checker.worklist = malloc(len * sizeof(u32));
+    for (u32 i = 0; i < len; i++)
+        checker.states[i].types = checker.type_storage + i * checker.state_size;
+
+    // slots start out zeroed by vm_init, which is Val_None
+    u8 *scratch = calloc(1, checker.state_size);
+    memset(scratch + STACK_MAX, Type_None, event->slot_count);
+    merge_into(&checker, 0, 0, scratch);
+
+    while (checker.worklist_len > 0 && !checker.failed)
+    {
+        checker.worklist_len--;
+        u32 ip = checker.worklist[checker.worklist_len];
+        TypeState *state = &checker.states[ip];
+        state->queued = false;
+
+        u32 depth = state->depth;
+        u32 next;
+        memcpy(scratch, state->types, checker.state_size);
+        if (step(&checker, ip, &next, &depth, scratch))
+            merge_into(&checker, next, depth, scratch);
+
+        // every op pops its operands before pushing, so the stack is always
+        // at its deepest right after an op
+        if (depth > checker.max_depth)
+            checker.max_depth = depth;
+    }
+
+    // if we couldn't follow the stack, play it safe
+    event->stack_max = checker.failed ? STACK_MAX : checker.max_depth;
+
+    // now the types can't change anymore, run every instruction again on its
+    // final state to find any errors. the first one in the code is reported
+    if (!checker.failed)
+    {
+        checker.reporting = true;
+        u32 next = 0;
+        while (next < len && !checker.type_error)
+        {
+            u32 ip = next;
+            TypeState *state = &checker.states[ip];
+            // unreachable code can't go wrong
+            if (!state->visited)
+            {
+                Instruction insn;
+                next = instruction_decode(event->code, ip, &insn);
+                continue;
+            }
+
+            u32 depth = state->depth;
+            memcpy(scratch, state->types, checker.state_size);
+            step(&checker, ip, &next, &depth, scratch);
+        }
+    }
+
+    // only rewrite instructions once we've reached a fixed point, otherwise we
+    // might specialize based on types that a later branch widens
+    if (!checker.failed && !checker.type_error)
+    {
+        u32 next = 0;
+        while (next < len)
+        {
+            u32 ip = next;
+            Instruction insn;
+            next = instruction_decode(event->code, ip, &insn);
+
+            TypeState *state = &checker.states[ip];
+            // unreachable, or doesn't have enough operands to be a binary op
+            if (!state->visited || state->depth < 2)
+                continue;
+
+            // specialized ops don't have operands either, so we can just
+            // swap the opcode out
+            StaticType a = state->types[state->depth - 2];
+            StaticType b = state->types[state->depth - 1];
+            event->code[ip] = specialize(event->code[ip], a, b);
+        }
+    }
+
+    free(scratch);
+    free(checker.worklist);
+    free(checker.type_storage);
+    free(checker.states);
+
+    if (checker.type_error)
+        *error_ip = checker.error_ip;
+    return !checker.type_error;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "events/event.h"
+
+// the type inference pass.
+//
+// our compiler is single pass, so it has no idea what types anything are when
+// it emits instructions. this pass runs over a compiled event afterwards and
+// tracks the type of every stack value and slot through all the branches and
+// loops in the event. wherever both operands of a math or comparison op are
+// known, the generic op is replaced with a type specialized one (Code_AddInt,
+// Code_LessIntInt, etc) that doesn't have to check types at runtime.
+//
+// ops on operands that are *provably* the wrong type (like % on floats) are
+// compile errors. the first one is written to `error`, its instruction to
+// `error_ip`, and false is returned. nothing gets specialized if there's an
+// error.
+//
+// since we're tracking the stack anyway, this also fills in the event's
+// stack_max.
+bool typecheck_event(Event *event, char *error, usize error_size,
+                     u32 *error_ip);
@@ -43,6 +43,7 @@ typedef union ValueData ValueData;
 
 #define INT_VAL(v) ((Value){.type = Val_Int, .data._int = (v)})
 #define FLOAT_VAL(v) ((Value){.type = Val_Float, .data._float = (v)})
+// strings in values must be interned (see utility/intern.h)!
 #define STRING_VAL(v) ((Value){.type = Val_String, .data.string = (v)})
 
 static inline bool value_is_falsey(Value value)
@@ -84,8 +85,9 @@ static inline bool value_is_eq(Value value, Value other)
         else
             return value.data._float == other.data._int;
     }
+    // strings are interned, so equal strings are always the same pointer
     case Val_String:
-        return !strcmp(value.data.string, other.data.string);
+        return value.data.string == other.data.string;
     }
 
     return false;
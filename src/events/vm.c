@@ -1,146 +1,139 @@
 #include "vm.h"
 #include "events/commands/commands.h"
+#include "events/profiler.h"
 #include "events/value.h"
+#include "events/vm_ops.h"
 #include "utility/macros.h"
 #include <stdio.h>
 #include <string.h>
 
 void vm_init(VM *vm, Event event)
 {
-    vm->event = event;
+    if (vm_frame_size(&event) > vm->frame_capacity)
+    {
+        FATAL("VM frame too small for event '%s' (need %d values, have %d)\n",
+              event.name, vm_frame_size(&event), vm->frame_capacity);
+    }
 
-    memset(vm->slots, 0, sizeof(vm->slots));
+    vm->event = event;
 
-    memset(vm->stack, 0, sizeof(vm->stack));
+    // only the slots need clearing, nothing reads the stack before pushing
+    vm->slots = vm->frame + event.stack_max;
+    memset(vm->slots, 0, event.slot_count * sizeof(Value));
     vm->top = 0;
     vm->ip = 0;
 
-    memset(vm->command_ctx, 0, sizeof(vm->command_ctx));
+    // no limit unless the scheduler says otherwise
+    vm->budget = UINT32_MAX;
+    vm->preempted = false;
+
+    vm->command_ctx = (CommandCtx){0};
     vm->vm_ctx = NULL;
+
+    vm->wait = (VMWait){.type = Wait_Yield};
 }
 
-static inline void push(VM *vm, Value value)
+void vm_push(VM *vm, Value value) { push(vm, value); }
+Value vm_pop(VM *vm) { return pop(vm); }
+Value vm_peek(VM *vm, u32 index) { return peek(vm, index); }
+
+void vm_wait_ticks(VM *vm, u32 ticks)
 {
-#ifdef DEBUG
-    if (vm->top >= STACK_MAX)
-    {
-        FATAL("Out of stack space!");
-    }
-#endif
-    vm->stack[vm->top] = value;
-    vm->top++;
+    vm->wait = (VMWait){.type = Wait_Ticks, .data.ticks = ticks};
 }
 
-static inline Value pop(VM *vm)
+void vm_wait_signal(VM *vm, VMSignal signal)
 {
-#ifdef DEBUG
-    if (vm->top == 0)
-    {
-        FATAL("No more values to pop!");
-    }
-#endif
-    vm->top--;
-    Value value = vm->stack[vm->top];
-    return value;
+    vm->wait = (VMWait){.type = Wait_Signal, .data.signal = signal};
 }
 
-static inline Value peek(VM *vm, u32 idx) { return vm->stack[idx]; }
-
-void vm_push(VM *vm, Value value) { push(vm, value); }
-Value vm_pop(VM *vm) { return pop(vm); }
-Value vm_peek(VM *vm, u32 index) { return peek(vm, index); }
-
-// because we're working with a stack, the right operand comes before the left
-// one
-// TODO write macro for to clean up the if VAL_IS_INT(v2) code
-#define BINARY_CMP_OP(op)                                                      \
-    Value v2 = pop(vm);                                                        \
-    Value v1 = pop(vm);                                                        \
-    if (!VAL_IS_NUMERIC(v1) && !VAL_IS_NUMERIC(v2))                            \
-    {                                                                          \
-        FATAL("Operands to " #op " must be numbers")                           \
-    }                                                                          \
-    Value out;                                                                 \
-    if (VAL_IS_INT(v1))                                                        \
-    {                                                                          \
-        if (VAL_IS_INT(v2))                                                    \
-            out = BOOL_VAL(v1.data._int op v2.data._int);                      \
-        else                                                                   \
-            out = BOOL_VAL(v1.data._int op v2.data._float);                    \
-    }                                                                          \
-    else                                                                       \
-    {                                                                          \
-        if (VAL_IS_INT(v2))                                                    \
-            out = BOOL_VAL(v1.data._float op v2.data._int);                    \
-        else                                                                   \
-            out = BOOL_VAL(v1.data._float op v2.data._float);                  \
-    }                                                                          \
-    push(vm, out);
+void vm_wait_script(VM *vm, ScriptHandle script)
+{
+    vm->wait = (VMWait){.type = Wait_Script, .data.script = script};
+}
 
-// if *any* of the operands are floats, the output value is a float
-#define BINARY_OP(op)                                                          \
-    Value v2 = pop(vm);                                                        \
-    Value v1 = pop(vm);                                                        \
-    if (!VAL_IS_NUMERIC(v1) && !VAL_IS_NUMERIC(v2))                            \
+// jumps to `target`. without jumping backwards, an event can only run for as
+// long as it is, so that's the only place the budget needs checking. the jump
+// has already happened when the vm pauses, so it just picks up from there
+#define JUMP(target)                                                           \
+    do                                                                         \
     {                                                                          \
-        FATAL("Operands to " #op " must be numbers")                           \
-    }                                                                          \
-    Value out;                                                                 \
-    if (VAL_IS_INT(v1))                                                        \
-    {                                                                          \
-        if (VAL_IS_INT(v2))                                                    \
-            out = INT_VAL(v1.data._int op v2.data._int);                       \
-        else                                                                   \
-            out = FLOAT_VAL(v1.data._int op v2.data._float);                   \
-    }                                                                          \
-    else                                                                       \
-    {                                                                          \
-        if (VAL_IS_INT(v2))                                                    \
-            out = FLOAT_VAL(v1.data._float op v2.data._int);                   \
-        else                                                                   \
-            out = FLOAT_VAL(v1.data._float op v2.data._float);                 \
-    }                                                                          \
-    push(vm, out);
+        u32 to = (target);                                                     \
+        vm->ip = to;                                                           \
+        if (to <= start && executed >= vm->budget)                             \
+        {                                                                      \
+            vm->preempted = true;                                              \
+            return false;                                                      \
+        }                                                                      \
+    } while (0)
 
-bool vm_execute(VM *vm, Resources *resources)
+// the interpreter loop, shared between the normal vm and the profiling one.
+// it's always inlined with `profiler` either NULL or not, so the normal copy
+// has all the profiling compiled out
+__attribute__((always_inline)) static inline bool
+interpret(VM *vm, Resources *resources, VMProfiler *profiler, ProfileRun *run)
 {
-    while (vm->ip < vm->event.instructions_len)
+    const u8 *code = vm->event.code;
+    u32 executed = 0;
+    while (vm->ip < vm->event.code_len)
     {
-        Instruction insn = vm->event.instructions[vm->ip];
+        u32 start = vm->ip;
+        InstructionCode op = code[vm->ip];
         vm->ip++;
+        executed++;
+        if (profiler)
+            vm_profiler_instruction(profiler, run, start, op);
 
-        switch (insn.code)
+        switch (op)
         {
         case Code_Goto:
         {
-            vm->ip = insn.data.position;
+            JUMP(code_read_u16(code + vm->ip));
             break;
         }
         case Code_GotoIfFalse:
         {
-            Value cond = peek(vm, 0);
+            Value cond = peek(vm, vm->top - 1);
             if (value_is_falsey(cond))
-                vm->ip = insn.data.position;
+                JUMP(code_read_u16(code + vm->ip));
+            else
+                vm->ip += 2;
             break;
         }
         case Code_GotoIfTrue:
         {
-            Value cond = peek(vm, 0);
+            Value cond = peek(vm, vm->top - 1);
             if (value_is_truthy(cond))
-                vm->ip = insn.data.position;
+                JUMP(code_read_u16(code + vm->ip));
+            else
+                vm->ip += 2;
             break;
         }
         case Code_Call:
         {
             Value value = NONE_VAL;
-            command_fn command = COMMANDS[insn.data.call.command].fn;
-            bool yield =
-                command(vm, &value, insn.data.call.arg_count, resources);
+            Command command_id = code[vm->ip];
+            command_fn command = COMMANDS[command_id].fn;
+            u32 arg_count = code[vm->ip + 1];
+            vm->ip += 2;
+
+            bool yield;
+            if (profiler)
+            {
+                Instant called = instant_now();
+                yield = command(vm, &value, arg_count, resources);
+                vm_profiler_command(profiler, command_id,
+                                    instant_elapsed(called));
+            }
+            else
+            {
+                yield = command(vm, &value, arg_count, resources);
+            }
             if (yield)
             {
-                // subtract 1 from the instruction pointer so we can call this
-                // command again
-                vm->ip--;
+                // rewind the instruction pointer so we can call this command
+                // again
+                vm->ip = start;
                 return false;
             }
             push(vm, value);
@@ -153,34 +146,38 @@ bool vm_execute(VM *vm, Resources *resources)
         }
         case Code_Fetch:
         {
-            Value value = vm->slots[insn.data.slot];
+            Value value = vm->slots[code[vm->ip]];
+            vm->ip++;
             push(vm, value);
             break;
         }
         case Code_Set:
         {
-            Value value = peek(vm, 0);
-            vm->slots[insn.data.slot] = value;
+            Value value = peek(vm, vm->top - 1);
+            vm->slots[code[vm->ip]] = value;
+            vm->ip++;
+            break;
+        }
+        case Code_FetchGlobal:
+        {
+            u32 global = code_read_varint(code, &vm->ip);
+            push(vm, resources->globals.values[global]);
+            break;
+        }
+        case Code_SetGlobal:
+        {
+            u32 global = code_read_varint(code, &vm->ip);
+            resources->globals.values[global] = peek(vm, vm->top - 1);
             break;
         }
         case Code_Not:
         {
-            Value value = pop(vm);
-            bool is_falsey = value_is_falsey(value);
-            push(vm, BOOL_VAL(is_falsey));
+            NOT_OP();
             break;
         }
         case Code_Negate:
         {
-            Value value = pop(vm);
-            if (!VAL_IS_NUMERIC(value))
-            {
-                FATAL("Negate operand must be a number");
-            }
-            if (VAL_IS_INT(value))
-                push(vm, INT_VAL(-value.data._int));
-            else
-                push(vm, FLOAT_VAL(-value.data._float));
+            NEGATE_OP();
             break;
         }
         case Code_Add:
@@ -205,24 +202,15 @@ bool vm_execute(VM *vm, Resources *resources)
         }
         case Code_Mod:
         {
-            Value v2 = pop(vm);
-            Value v1 = pop(vm);
-            if (!VAL_IS_INT(v1) || !VAL_IS_INT(v2))
-            {
-                FATAL("Operands to %% must be integers")
-            }
-            Value out = INT_VAL(v1.data._int % v2.data._int);
-            push(vm, out);
+            MOD_OP();
             break;
         }
         case Code_Int:
-            push(vm, INT_VAL(insn.data._int));
+            push(vm, INT_VAL(code_read_int(code, &vm->ip)));
             break;
         case Code_Float:
-            push(vm, FLOAT_VAL(insn.data._float));
-            break;
         case Code_String:
-            push(vm, STRING_VAL(insn.data.string));
+            push(vm, vm->event.constants[code_read_varint(code, &vm->ip)]);
             break;
         case Code_True:
             push(vm, TRUE_VAL);
@@ -235,18 +223,12 @@ bool vm_execute(VM *vm, Resources *resources)
             break;
         case Code_Eq:
         {
-            Value v2 = pop(vm);
-            Value v1 = pop(vm);
-            bool eq = value_is_eq(v1, v2);
-            push(vm, BOOL_VAL(eq));
+            EQ_OP(false);
             break;
         }
         case Code_NotEq:
         {
-            Value v2 = pop(vm);
-            Value v1 = pop(vm);
-            bool eq = value_is_eq(v1, v2);
-            push(vm, BOOL_VAL(!eq));
+            EQ_OP(true);
             break;
         }
         case Code_Greater:
@@ -269,6 +251,91 @@ bool vm_execute(VM *vm, Resources *resources)
             BINARY_CMP_OP(<=);
             break;
         }
+        case Code_AddInt:
+        {
+            INT_OP(+);
+            break;
+        }
+        case Code_SubInt:
+        {
+            INT_OP(-);
+            break;
+        }
+        case Code_MulInt:
+        {
+            INT_OP(*);
+            break;
+        }
+        case Code_DivInt:
+        {
+            INT_OP(/);
+            break;
+        }
+        case Code_ModInt:
+        {
+            INT_OP(%);
+            break;
+        }
+        case Code_AddFloat:
+        {
+            FLOAT_OP(+);
+            break;
+        }
+        case Code_SubFloat:
+        {
+            FLOAT_OP(-);
+            break;
+        }
+        case Code_MulFloat:
+        {
+            FLOAT_OP(*);
+            break;
+        }
+        case Code_DivFloat:
+        {
+            FLOAT_OP(/);
+            break;
+        }
+        case Code_GreaterIntInt:
+        {
+            INT_CMP_OP(>);
+            break;
+        }
+        case Code_GreaterEqIntInt:
+        {
+            INT_CMP_OP(>=);
+            break;
+        }
+        case Code_LessIntInt:
+        {
+            INT_CMP_OP(<);
+            break;
+        }
+        case Code_LessEqIntInt:
+        {
+            INT_CMP_OP(<=);
+            break;
+        }
+        case Code_GreaterFloatFloat:
+        {
+            FLOAT_CMP_OP(>);
+            break;
+        }
+        case Code_GreaterEqFloatFloat:
+        {
+            FLOAT_CMP_OP(>=);
+            break;
+        }
+        case Code_LessFloatFloat:
+        {
+            FLOAT_CMP_OP(<);
+            break;
+        }
+        case Code_LessEqFloatFloat:
+        {
+            FLOAT_CMP_OP(<=);
+            break;
+        }
         }
     }
 
@@ -276,4 +343,30 @@ bool vm_execute(VM *vm, Resources *resources)
     return true;
 }
 
+// translated events resume from the same ips the interpreter does, so they get
+// interpreted while profiling so they can be counted like everything else
+static bool execute_profiled(VM *vm, Resources *resources,
+                             VMProfiler *profiler)
+{
+    ProfileRun run;
+    vm_profiler_begin_run(profiler, &run, &vm->event);
+    Instant start = instant_now();
+
+    bool finished = interpret(vm, resources, profiler, &run);
+
+    vm_profiler_end_run(profiler, &run, instant_elapsed(start), finished,
+                        vm->preempted);
+    return finished;
+}
+
+bool vm_execute(VM *vm, Resources *resources)
+{
+    vm->preempted = false;
+    if (vm_profiler)
+        return execute_profiled(vm, resources, vm_profiler);
+    if (vm->event.aot)
+        return vm->event.aot(vm, resources);
+    return interpret(vm, resources, NULL, NULL);
+}
+
 void vm_free(VM *vm) { (void)vm; }
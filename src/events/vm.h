@@ -1,34 +1,87 @@
 #pragma once
 
+#include "events/commands/command_ctx.h"
 #include "events/event.h"
+#include "events/scheduler.h"
 #include "events/value.h"
 #include "resources.h"
 
+// the most stack space an event is allowed to use
 #define STACK_MAX 32
-#define SLOT_MAX 32
-#define COMMAND_CTX_MAX 64
+
+// what a vm is waiting on when it yields. see scheduler.h
+typedef enum
+{
+    // run again next tick
+    Wait_Yield = 0,
+    Wait_Ticks,
+    Wait_Signal,
+    Wait_Script,
+} VMWaitType;
 
 typedef struct
 {
-    Event event;
+    VMWaitType type;
+    union
+    {
+        u32 ticks;
+        VMSignal signal;
+        ScriptHandle script;
+    } data;
+} VMWait;
 
-    Value stack[STACK_MAX];
-    Value slots[SLOT_MAX];
+// vms are variable sized, so that they only take up as much space as the event
+// they're running needs. get them from a VMPool (see vm_pool.h) rather than
+// allocating them yourself
+typedef struct VM
+{
+    Event event;
 
     // command specific context
-    char command_ctx[COMMAND_CTX_MAX];
+    CommandCtx command_ctx;
     // vm specific context
     void *vm_ctx;
 
     u32 top;
     u32 ip;
+
+    // how many instructions the vm can run before it pauses itself at the end
+    // of a loop. set by the scheduler every tick
+    u32 budget;
+    // set when vm_execute returns because the budget ran out, rather than
+    // because a command yielded
+    bool preempted;
+
+    // reset to Wait_Yield every time the vm yields
+    VMWait wait;
+
+    // how many values fit in frame
+    u32 frame_capacity;
+    // points into frame, right after the stack
+    Value *slots;
+    // event.stack_max stack values, followed by event.slot_count slots
+    Value frame[];
 } VM;
 
+// how many values the frame of a vm running `event` needs to hold
+static inline u32 vm_frame_size(const Event *event)
+{
+    return event->stack_max + event->slot_count;
+}
+
+// the vm's frame must be at least vm_frame_size(&event) values big
 void vm_init(VM *vm, Event event);
-// returns true if execution has finished.
+// returns true if execution has finished. returns false if a command yielded,
+// or if the vm ran out of budget (see vm->preempted)
 bool vm_execute(VM *vm, Resources *resources);
 void vm_free(VM *vm);
 
 void vm_push(VM *vm, Value value);
 Value vm_pop(VM *vm);
 Value vm_peek(VM *vm, u32 index);
+
+// commands call these right before yielding to tell the scheduler when they
+// next need to run. commands that don't will be run again next tick
+void vm_wait_ticks(VM *vm, u32 ticks);
+void vm_wait_signal(VM *vm, VMSignal signal);
+void vm_wait_script(VM *vm, ScriptHandle script);
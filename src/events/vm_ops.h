@@ -0,0 +1,142 @@
+#pragma once
+
+// stack helpers and op implementations shared between the vm and ahead-of-time
+// translated events (see aot.h). everything here expects a `VM *vm` in scope.
+
+#include "events/value.h"
+#include "events/vm.h"
+#include "utility/macros.h"
+
+static inline void push(VM *vm, Value value)
+{
+#ifdef DEBUG
+    if (vm->top >= vm->event.stack_max)
+    {
+        FATAL("Out of stack space!");
+    }
+#endif
+    vm->frame[vm->top] = value;
+    vm->top++;
+}
+
+static inline Value pop(VM *vm)
+{
+#ifdef DEBUG
+    if (vm->top == 0)
+    {
+        FATAL("No more values to pop!");
+    }
+#endif
+    vm->top--;
+    Value value = vm->frame[vm->top];
+    return value;
+}
+
+// NOTE: indexes from the *bottom* of the stack. use vm->top - 1 for the top
+static inline Value peek(VM *vm, u32 idx) { return vm->frame[idx]; }
+
+// because we're working with a stack, the right operand comes before the left
+// one
+// TODO write macro for to clean up the if VAL_IS_INT(v2) code
+#define BINARY_CMP_OP(op)                                                      \
+    Value v2 = pop(vm);                                                        \
+    Value v1 = pop(vm);                                                        \
+    if (!VAL_IS_NUMERIC(v1) && !VAL_IS_NUMERIC(v2))                            \
+    {                                                                          \
+        FATAL("Operands to " #op " must be numbers")                           \
+    }                                                                          \
+    Value out;                                                                 \
+    if (VAL_IS_INT(v1))                                                        \
+    {                                                                          \
+        if (VAL_IS_INT(v2))                                                    \
+            out = BOOL_VAL(v1.data._int op v2.data._int);                      \
+        else                                                                   \
+            out = BOOL_VAL(v1.data._int op v2.data._float);                    \
+    }                                                                          \
+    else                                                                       \
+    {                                                                          \
+        if (VAL_IS_INT(v2))                                                    \
+            out = BOOL_VAL(v1.data._float op v2.data._int);                    \
+        else                                                                   \
+            out = BOOL_VAL(v1.data._float op v2.data._float);                  \
+    }                                                                          \
+    push(vm, out);
+
+// if *any* of the operands are floats, the output value is a float
+#define BINARY_OP(op)                                                          \
+    Value v2 = pop(vm);                                                        \
+    Value v1 = pop(vm);                                                        \
+    if (!VAL_IS_NUMERIC(v1) && !VAL_IS_NUMERIC(v2))                            \
+    {                                                                          \
+        FATAL("Operands to " #op " must be numbers")                           \
+    }                                                                          \
+    Value out;                                                                 \
+    if (VAL_IS_INT(v1))                                                        \
+    {                                                                          \
+        if (VAL_IS_INT(v2))                                                    \
+            out = INT_VAL(v1.data._int op v2.data._int);                       \
+        else                                                                   \
+            out = FLOAT_VAL(v1.data._int op v2.data._float);                   \
+    }                                                                          \
+    else                                                                       \
+    {                                                                          \
+        if (VAL_IS_INT(v2))                                                    \
+            out = FLOAT_VAL(v1.data._float op v2.data._int);                   \
+        else                                                                   \
+            out = FLOAT_VAL(v1.data._float op v2.data._float);                 \
+    }                                                                          \
+    push(vm, out);
+
+// the ops below don't have anything to do with control flow, so they're
+// shared between the interpreter and aot translated events.
+#define NOT_OP()                                                               \
+    Value value = pop(vm);                                                     \
+    push(vm, BOOL_VAL(value_is_falsey(value)));
+
+#define NEGATE_OP()                                                            \
+    Value value = pop(vm);                                                     \
+    if (!VAL_IS_NUMERIC(value))                                                \
+    {                                                                          \
+        FATAL("Negate operand must be a number");                              \
+    }                                                                          \
+    if (VAL_IS_INT(value))                                                     \
+        push(vm, INT_VAL(-value.data._int));                                   \
+    else                                                                       \
+        push(vm, FLOAT_VAL(-value.data._float));
+
+#define MOD_OP()                                                               \
+    Value v2 = pop(vm);                                                        \
+    Value v1 = pop(vm);                                                        \
+    if (!VAL_IS_INT(v1) || !VAL_IS_INT(v2))                                    \
+    {                                                                          \
+        FATAL("Operands to %% must be integers")                               \
+    }                                                                          \
+    push(vm, INT_VAL(v1.data._int % v2.data._int));
+
+#define EQ_OP(negate)                                                          \
+    Value v2 = pop(vm);                                                        \
+    Value v1 = pop(vm);                                                        \
+    bool eq = value_is_eq(v1, v2);                                             \
+    push(vm, BOOL_VAL(eq != (negate)));
+
+// the type specialized ops. the type inference pass has already proven what
+// the operands are, so we don't need to check anything here
+#define INT_OP(op)                                                             \
+    Value v2 = pop(vm);                                                        \
+    Value v1 = pop(vm);                                                        \
+    push(vm, INT_VAL(v1.data._int op v2.data._int));
+
+#define FLOAT_OP(op)                                                           \
+    Value v2 = pop(vm);                                                        \
+    Value v1 = pop(vm);                                                        \
+    push(vm, FLOAT_VAL(v1.data._float op v2.data._float));
+
+#define INT_CMP_OP(op)                                                         \
+    Value v2 = pop(vm);                                                        \
+    Value v1 = pop(vm);                                                        \
+    push(vm, BOOL_VAL(v1.data._int op v2.data._int));
+
+#define FLOAT_CMP_OP(op)                                                       \
+    Value v2 = pop(vm);                                                        \
+    Value v1 = pop(vm);                                                        \
+    push(vm, BOOL_VAL(v1.data._float op v2.data._float));
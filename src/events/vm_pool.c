@@ -0,0 +1,99 @@
+#include "vm_pool.h"
+#include "events/vm.h"
+#include <stdlib.h>
+
+// returns VM_POOL_CLASSES if the frame is too big to pool
+static u32 frame_class(u32 frame_size, u32 *capacity)
+{
+    u32 class = 0;
+    u32 class_capacity = VM_POOL_MIN_FRAME;
+    while (class_capacity < frame_size)
+    {
+        class_capacity *= 2;
+        class++;
+    }
+
+    *capacity = class_capacity;
+    if (class >= VM_POOL_CLASSES)
+    {
+        // not worth rounding up, it's not going to be reused
+        *capacity = frame_size;
+        return VM_POOL_CLASSES;
+    }
+    return class;
+}
+
+static usize vm_bytes(u32 capacity)
+{
+    return sizeof(VM) + capacity * sizeof(Value);
+}
+
+void vm_pool_init(VMPool *pool)
+{
+    for (u32 i = 0; i < VM_POOL_CLASSES; i++)
+        vec_init(&pool->free[i], sizeof(VM *));
+    pool->allocations = 0;
+    pool->live = 0;
+    pool->bytes = 0;
+}
+
+void vm_pool_free(VMPool *pool)
+{
+    for (u32 i = 0; i < VM_POOL_CLASSES; i++)
+    {
+        for (u32 j = 0; j < pool->free[i].len; j++)
+        {
+            VM **vm = vec_get(&pool->free[i], j);
+            pool->bytes -= vm_bytes((*vm)->frame_capacity);
+            free(*vm);
+        }
+        vec_free(&pool->free[i]);
+    }
+}
+
+VM *vm_pool_get(VMPool *pool, Event event)
+{
+    u32 capacity;
+    u32 class = frame_class(vm_frame_size(&event), &capacity);
+
+    VM *vm;
+    if (class < VM_POOL_CLASSES && pool->free[class].len > 0)
+    {
+        vec_pop(&pool->free[class], &vm);
+    }
+    else
+    {
+        vm = malloc(vm_bytes(capacity));
+        vm->frame_capacity = capacity;
+        pool->allocations++;
+        pool->bytes += vm_bytes(capacity);
+    }
+
+    pool->live++;
+    vm_init(vm, event);
+    return vm;
+}
+
+void vm_pool_put(VMPool *pool, VM *vm)
+{
+    pool->live--;
+
+    u32 capacity;
+    u32 class = frame_class(vm->frame_capacity, &capacity);
+    if (class == VM_POOL_CLASSES)
+    {
+        pool->bytes -= vm_bytes(vm->frame_capacity);
+        free(vm);
+        return;
+    }
+
+    vec_push(&pool->free[class], &vm);
+}
+
+u32 vm_pool_pooled_count(VMPool *pool)
+{
+    u32 count = 0;
+    for (u32 i = 0; i < VM_POOL_CLASSES; i++)
+        count += pool->free[i].len;
+    return count;
+}
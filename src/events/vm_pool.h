@@ -0,0 +1,39 @@
+#pragma once
+
+// recycles vms, so starting an event doesn't have to hit malloc.
+//
+// vms are bucketed by how big their frame is (rounded up to a power of two),
+// so a tiny event never ends up holding onto a frame sized for a huge one.
+
+#include "events/event.h"
+#include "utility/vec.h"
+
+// vm.h includes resources.h, which needs this header
+struct VM;
+
+// frames of 4, 8, 16, 32 and 64 values. anything bigger isn't pooled
+#define VM_POOL_CLASSES 5
+#define VM_POOL_MIN_FRAME 4
+
+typedef struct
+{
+    vec free[VM_POOL_CLASSES]; // vec<struct VM *>
+
+    // how many times we've had to call malloc
+    u32 allocations;
+    // vms that have been handed out and not returned yet
+    u32 live;
+    // how many bytes every vm we own (live or not) takes up
+    usize bytes;
+} VMPool;
+
+void vm_pool_init(VMPool *pool);
+// frees every pooled vm. any vms still live are leaked!
+void vm_pool_free(VMPool *pool);
+
+// returns a vm that's been vm_init'd to run `event`
+struct VM *vm_pool_get(VMPool *pool, Event event);
+void vm_pool_put(VMPool *pool, struct VM *vm);
+
+// how many vms are sitting in the pool, waiting to be reused
+u32 vm_pool_pooled_count(VMPool *pool);
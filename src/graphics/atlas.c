@@ -0,0 +1,195 @@
+#include "atlas.h"
+#include "utility/macros.h"
+
+void atlas_init(Atlas *atlas, u32 page_size)
+{
+    atlas->page_size = page_size;
+    vec_init(&atlas->pages, sizeof(AtlasPage));
+}
+
+static void free_page(usize index, void *data)
+{
+    (void)index;
+    AtlasPage *page = data;
+    AtlasShelf *shelves = (AtlasShelf *)page->shelves.data;
+    for (usize i = 0; i < page->shelves.len; i++)
+        vec_free(&shelves[i].gaps);
+    vec_free(&page->shelves);
+}
+
+void atlas_free(Atlas *atlas) { vec_free_with(&atlas->pages, free_page); }
+
+bool atlas_fits(Atlas *atlas, u32 width, u32 height)
+{
+    u32 max = ATLAS_MAX_SIZE;
+    if (max > atlas->page_size - ATLAS_PADDING)
+        max = atlas->page_size - ATLAS_PADDING;
+    return width > 0 && height > 0 && width <= max && height <= max;
+}
+
+// the first gap at least `width` wide, or -1
+static i64 find_gap(AtlasShelf *shelf, u32 width)
+{
+    AtlasGap *gaps = (AtlasGap *)shelf->gaps.data;
+    for (usize i = 0; i < shelf->gaps.len; i++)
+        if (gaps[i].width >= width)
+            return i;
+    return -1;
+}
+
+// the best shelf for something this size, or -1. shelves much taller than it
+// are only used if a new shelf won't fit
+static i64 find_shelf(Atlas *atlas, AtlasPage *page, u32 width, u32 height)
+{
+    AtlasShelf *shelves = (AtlasShelf *)page->shelves.data;
+    i64 best = -1, fallback = -1;
+    for (usize i = 0; i < page->shelves.len; i++)
+    {
+        AtlasShelf *shelf = &shelves[i];
+        if (shelf->height < height || find_gap(shelf, width) < 0)
+            continue;
+        if (shelf->height <= height * 2)
+        {
+            if (best < 0 || shelf->height < shelves[best].height)
+                best = i;
+        }
+        else if (fallback < 0 || shelf->height < shelves[fallback].height)
+            fallback = i;
+    }
+    if (best >= 0 || page->top + height <= atlas->page_size)
+        return best;
+    return fallback;
+}
+
+static AtlasRegion add_to_shelf(AtlasPage *page, u32 page_index,
+                                usize shelf_index, u32 width, u32 height)
+{
+    AtlasShelf *shelf = vec_get(&page->shelves, shelf_index);
+    i64 gap_index = find_gap(shelf, width + ATLAS_PADDING);
+    AtlasGap *gap = vec_get(&shelf->gaps, gap_index);
+
+    AtlasRegion region = {
+        .page = page_index,
+        .x = gap->x,
+        .y = shelf->y,
+        .width = width,
+        .height = height,
+    };
+    gap->x += width + ATLAS_PADDING;
+    gap->width -= width + ATLAS_PADDING;
+    if (gap->width == 0)
+        vec_remove(&shelf->gaps, gap_index, NULL);
+
+    shelf->used += width + ATLAS_PADDING;
+    page->used_pixels += (u64)width * height;
+    page->regions++;
+    return region;
+}
+
+static bool add_to_page(Atlas *atlas, u32 page_index, u32 width, u32 height,
+                        AtlasRegion *region)
+{
+    AtlasPage *page = vec_get(&atlas->pages, page_index);
+    u32 padded_width = width + ATLAS_PADDING;
+    u32 padded_height = height + ATLAS_PADDING;
+
+    i64 shelf = find_shelf(atlas, page, padded_width, padded_height);
+    if (shelf < 0)
+    {
+        if (page->top + padded_height > atlas->page_size)
+            return false;
+
+        AtlasShelf new = {
+            .y = page->top,
+            .height = padded_height,
+            .used = 0,
+        };
+        vec_init(&new.gaps, sizeof(AtlasGap));
+        AtlasGap all = {.x = 0, .width = atlas->page_size};
+        vec_push(&new.gaps, &all);
+        vec_push(&page->shelves, &new);
+        page->top += padded_height;
+        shelf = page->shelves.len - 1;
+    }
+
+    *region = add_to_shelf(page, page_index, shelf, width, height);
+    return true;
+}
+
+AtlasRegion atlas_add(Atlas *atlas, u32 width, u32 height)
+{
+    if (!atlas_fits(atlas, width, height))
+        FATAL("%ux%u is too big for the atlas\n", width, height);
+
+    AtlasRegion region;
+    for (u32 i = 0; i < atlas->pages.len; i++)
+        if (add_to_page(atlas, i, width, height, &region))
+            return region;
+
+    AtlasPage page = {.top = 0, .used_pixels = 0, .regions = 0};
+    vec_init(&page.shelves, sizeof(AtlasShelf));
+    vec_push(&atlas->pages, &page);
+    add_to_page(atlas, atlas->pages.len - 1, width, height, &region);
+    return region;
+}
+
+void atlas_remove(Atlas *atlas, AtlasRegion region)
+{
+    AtlasPage *page = vec_get(&atlas->pages, region.page);
+    if (!page)
+        FATAL("Atlas page %u doesn't exist\n", region.page);
+
+    AtlasShelf *shelves = (AtlasShelf *)page->shelves.data;
+    AtlasShelf *shelf = NULL;
+    usize shelf_index;
+    for (shelf_index = 0; shelf_index < page->shelves.len; shelf_index++)
+        if (shelves[shelf_index].y == region.y)
+        {
+            shelf = &shelves[shelf_index];
+            break;
+        }
+    if (!shelf)
+        FATAL("Atlas region at %u,%u isn't on a shelf\n", region.x, region.y);
+
+    // put the gap back in order, then join it up with the gaps either side
+    AtlasGap freed = {.x = region.x, .width = region.width + ATLAS_PADDING};
+    AtlasGap *gaps = (AtlasGap *)shelf->gaps.data;
+    usize at = 0;
+    while (at < shelf->gaps.len && gaps[at].x < freed.x)
+        at++;
+    vec_insert(&shelf->gaps, at, &freed);
+    gaps = (AtlasGap *)shelf->gaps.data;
+    if (at + 1 < shelf->gaps.len &&
+        gaps[at].x + gaps[at].width == gaps[at + 1].x)
+    {
+        gaps[at].width += gaps[at + 1].width;
+        vec_remove(&shelf->gaps, at + 1, NULL);
+    }
+    if (at > 0 && gaps[at - 1].x + gaps[at - 1].width == gaps[at].x)
+    {
+        gaps[at - 1].width += gaps[at].width;
+        vec_remove(&shelf->gaps, at, NULL);
+    }
+
+    shelf->used -= region.width + ATLAS_PADDING;
+    page->used_pixels -= (u64)region.width * region.height;
+    page->regions--;
+
+    // empty shelves at the bottom can start again at whatever height's needed
+    while (page->shelves.len > 0)
+    {
+        AtlasShelf *last = vec_get(&page->shelves, page->shelves.len - 1);
+        if (last->used > 0)
+            break;
+        page->top = last->y;
+        vec_free(&last->gaps);
+        vec_pop(&page->shelves, NULL);
+    }
+}
+
+f32 atlas_occupancy(Atlas *atlas, u32 page)
+{
+    AtlasPage *atlas_page = vec_get(&atlas->pages, page);
+    return (f64)atlas_page->used_pixels /
+           ((f64)atlas->page_size * atlas->page_size);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "sensible_nums.h"
+#include "utility/vec.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// packs small textures into shared pages, so they don't each need their own
+// spot in the bindless texture array (which means fewer bind group rebuilds,
+// and sprites using them can be batched together).
+//
+// each page is split into shelves: strips across the page as tall as the
+// first thing put on them. things go on the shortest shelf that's tall enough
+// (but not much too tall) and has a wide enough gap, and when none do a new
+// shelf gets started under the last one. removing something gives its gap
+// back to its shelf, and empty shelves at the bottom of a page are given back
+// to the page.
+//
+// this only keeps track of where things go. the textures are in
+// tex_manager.c
+
+#define ATLAS_PAGE_SIZE 1024
+// anything bigger than this either way gets its own texture
+#define ATLAS_MAX_SIZE 512
+// empty pixels right of and below everything, so nothing bleeds into its
+// neighbours when it's sampled
+#define ATLAS_PADDING 1
+#define ATLAS_NONE UINT32_MAX
+
+typedef struct
+{
+    // ATLAS_NONE if it isn't in the atlas
+    u32 page;
+    // in pixels
+    u32 x, y, width, height;
+} AtlasRegion;
+
+typedef struct
+{
+    u32 x, width;
+} AtlasGap;
+
+typedef struct
+{
+    u32 y, height;
+    // how much of the shelf's width is in use
+    u32 used;
+    vec gaps; // vec<AtlasGap>, sorted by x
+} AtlasShelf;
+
+typedef struct
+{
+    vec shelves; // vec<AtlasShelf>, sorted by y
+    // where the next shelf goes
+    u32 top;
+    u64 used_pixels;
+    u32 regions;
+} AtlasPage;
+
+typedef struct
+{
+    u32 page_size;
+    vec pages; // vec<AtlasPage>
+} Atlas;
+
+void atlas_init(Atlas *atlas, u32 page_size);
+void atlas_free(Atlas *atlas);
+
+// whether something this size should go in the atlas at all
+bool atlas_fits(Atlas *atlas, u32 width, u32 height);
+// finds room for something width x height. if there isn't room on any page,
+// a new one is added (so region.page == atlas->pages.len - 1)
+AtlasRegion atlas_add(Atlas *atlas, u32 width, u32 height);
+void atlas_remove(Atlas *atlas, AtlasRegion region);
+
+// how much of `page` is in use, from 0 to 1
+f32 atlas_occupancy(Atlas *atlas, u32 page);
@@ -0,0 +1,54 @@
+#include "bind_group_cache.h"
+#include "utility/macros.h"
+
+void bind_group_cache_init(BindGroupCache *cache, void *userdata)
+{
+    for (u32 i = 0; i < BindGroup_Max; i++)
+    {
+        cache->groups[i] = (CachedBindGroup){
+            .bind_group = NULL,
+            .generation = 0,
+            .build = NULL,
+        };
+    }
+    cache->userdata = userdata;
+    cache->rebuilds = 0;
+}
+
+void bind_group_cache_free(BindGroupCache *cache)
+{
+    for (u32 i = 0; i < BindGroup_Max; i++)
+    {
+        if (cache->groups[i].bind_group)
+            wgpuBindGroupRelease(cache->groups[i].bind_group);
+        cache->groups[i].bind_group = NULL;
+    }
+}
+
+void bind_group_cache_set_builder(BindGroupCache *cache, BindGroupKind kind,
+                                  bind_group_build_fn build)
+{
+    cache->groups[kind].build = build;
+}
+
+WGPUBindGroup bind_group_cache_get(BindGroupCache *cache, BindGroupKind kind,
+                                   u64 generation)
+{
+    CachedBindGroup *group = &cache->groups[kind];
+    if (group->bind_group && group->generation == generation)
+        return group->bind_group;
+
+    if (!group->build)
+    {
+        FATAL("No way to build bind group %d\n", kind);
+    }
+
+    // anything still using the old one (like a frame in flight) keeps its own
+    // reference, so it's fine to let go of it here
+    if (group->bind_group)
+        wgpuBindGroupRelease(group->bind_group);
+    group->bind_group = group->build(cache->userdata);
+    group->generation = generation;
+    cache->rebuilds++;
+    return group->bind_group;
+}
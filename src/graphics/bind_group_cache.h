@@ -0,0 +1,59 @@
+#pragma once
+
+#include <wgpu.h>
+#include "sensible_nums.h"
+
+// bind groups that stick around between frames, instead of being built and
+// thrown away every frame.
+// everything a bind group gets built from has a generation counter that goes
+// up whenever it changes (see TextureManager.generation), and each cached bind
+// group remembers the generation it was built with. it only gets rebuilt when
+// that doesn't match anymore.
+
+// builds a new bind group from whatever `userdata` is
+typedef WGPUBindGroup (*bind_group_build_fn)(void *userdata);
+
+typedef enum
+{
+    // sprites, ui sprites and tilemaps all use this one
+    BindGroup_Sprite,
+    BindGroup_Light,
+    BindGroup_HdrTonemap,
+
+    BindGroup_Max,
+} BindGroupKind;
+
+typedef struct
+{
+    WGPUBindGroup bind_group; // NULL until it's first needed
+    u64 generation;
+    bind_group_build_fn build;
+} CachedBindGroup;
+
+typedef struct
+{
+    CachedBindGroup groups[BindGroup_Max];
+    void *userdata;
+
+    // how many times any bind group has been (re)built. nothing changes on an
+    // idle frame, so this shouldn't go up
+    u32 rebuilds;
+} BindGroupCache;
+
+void bind_group_cache_init(BindGroupCache *cache, void *userdata);
+void bind_group_cache_free(BindGroupCache *cache);
+
+void bind_group_cache_set_builder(BindGroupCache *cache, BindGroupKind kind,
+                                  bind_group_build_fn build);
+
+// returns the bind group, rebuilding it first if it was built with a different
+// generation
+WGPUBindGroup bind_group_cache_get(BindGroupCache *cache, BindGroupKind kind,
+                                   u64 generation);
+
+// combines the generations of the textures and buffers (quads + transforms),
+// which is everything the sprite bind group depends on
+static inline u64 bind_group_generation(u32 textures, u32 buffers)
+{
+    return ((u64)textures << 32) | buffers;
+}
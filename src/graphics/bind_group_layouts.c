@@ -4,6 +4,7 @@
 #include "wgpu.h"
 #include <stdlib.h>
 
+// tilemaps use this too, so they can share a bind group with sprites
 void build_sprite_layout(BindGroupLayouts *layouts, WGPUResources *resources)
 {
     BindGroupLayoutBuilder builder;
@@ -31,7 +32,7 @@ void build_sprite_layout(BindGroupLayouts *layouts, WGPUResources *resources)
     entry = (WGPUBindGroupLayoutEntry){
         .nextInChain = (WGPUChainedStruct *)extras,
         .texture = texture_layout,
-        .visibility = WGPUShaderStage_Fragment,
+        .visibility = WGPUShaderStage_Fragment | WGPUShaderStage_Vertex,
     };
     bind_group_layout_builder_append(&builder, entry);
 
@@ -44,6 +45,17 @@ void build_sprite_layout(BindGroupLayouts *layouts, WGPUResources *resources)
     };
     bind_group_layout_builder_append(&builder, entry);
 
+    // the quad buffer, which batched sprites get their corners from, then
+    // the animation tables (see sprite_animations.h)
+    for (u32 i = 0; i < 3; i++)
+    {
+        entry = (WGPUBindGroupLayoutEntry){
+            .buffer = buffer_layout,
+            .visibility = WGPUShaderStage_Vertex,
+        };
+        bind_group_layout_builder_append(&builder, entry);
+    }
+
     layouts->sprite = bind_group_layout_build(&builder, resources->device,
                                               "Sprite Bind Group Layout");
     bind_group_layout_builder_free(&builder); // free the builder after use
@@ -80,39 +92,24 @@ void build_light_layout(BindGroupLayouts *layouts, WGPUResources *resources)
     bind_group_layout_builder_free(&builder);
 }
 
-void build_tilemap_layout(BindGroupLayouts *layouts, WGPUResources *resources)
+void build_hdr_tonemap_layout(BindGroupLayouts *layouts,
+                              WGPUResources *resources)
 {
     BindGroupLayoutBuilder builder;
     bind_group_layout_builder_init(&builder);
 
-    WGPUBufferBindingLayout buffer_layout = {
-        .type = WGPUBufferBindingType_ReadOnlyStorage,
-    };
-    WGPUBindGroupLayoutEntry entry = {
-        .buffer = buffer_layout,
-        .visibility = WGPUShaderStage_Vertex,
-    };
-    bind_group_layout_builder_append(&builder, entry);
-
-    WGPUBindGroupLayoutEntryExtras *extras =
-        malloc(sizeof(WGPUBindGroupLayoutEntryExtras));
-    *extras = (WGPUBindGroupLayoutEntryExtras){
-        .chain = {.sType = (WGPUSType)WGPUSType_BindGroupLayoutEntryExtras},
-        .count = 2048,
-    };
     WGPUTextureBindingLayout texture_layout = {
         .sampleType = WGPUTextureSampleType_Float,
         .viewDimension = WGPUTextureViewDimension_2D,
     };
-    entry = (WGPUBindGroupLayoutEntry){
-        .nextInChain = (WGPUChainedStruct *)extras,
+    WGPUBindGroupLayoutEntry entry = {
         .texture = texture_layout,
-        .visibility = WGPUShaderStage_Fragment | WGPUShaderStage_Vertex,
+        .visibility = WGPUShaderStage_Fragment,
     };
     bind_group_layout_builder_append(&builder, entry);
 
     WGPUSamplerBindingLayout sampler_layout = {
-        .type = WGPUSamplerBindingType_Filtering,
+        .type = WGPUSamplerBindingType_NonFiltering,
     };
     entry = (WGPUBindGroupLayoutEntry){
         .sampler = sampler_layout,
@@ -120,38 +117,31 @@ void build_tilemap_layout(BindGroupLayouts *layouts, WGPUResources *resources)
     };
     bind_group_layout_builder_append(&builder, entry);
 
-    layouts->tilemap = bind_group_layout_build(&builder, resources->device,
-                                               "Tilemap Bind Group Layout");
-    bind_group_layout_builder_free(&builder); // free the builder after use
+    layouts->hdr_tonemap = bind_group_layout_build(
+        &builder, resources->device, "HDR Tonemap Bind Group Layout");
+    bind_group_layout_builder_free(&builder);
 }
 
-void build_hdr_tonemap_layout(BindGroupLayouts *layouts,
-                              WGPUResources *resources)
+void build_tilemap_layout(BindGroupLayouts *layouts, WGPUResources *resources)
 {
     BindGroupLayoutBuilder builder;
     bind_group_layout_builder_init(&builder);
 
-    WGPUTextureBindingLayout texture_layout = {
-        .sampleType = WGPUTextureSampleType_Float,
-        .viewDimension = WGPUTextureViewDimension_2D,
-    };
-    WGPUBindGroupLayoutEntry entry = {
-        .texture = texture_layout,
-        .visibility = WGPUShaderStage_Fragment,
-    };
-    bind_group_layout_builder_append(&builder, entry);
-
-    WGPUSamplerBindingLayout sampler_layout = {
-        .type = WGPUSamplerBindingType_NonFiltering,
-    };
-    entry = (WGPUBindGroupLayoutEntry){
-        .sampler = sampler_layout,
-        .visibility = WGPUShaderStage_Fragment,
+    WGPUBufferBindingLayout buffer_layout = {
+        .type = WGPUBufferBindingType_ReadOnlyStorage,
     };
-    bind_group_layout_builder_append(&builder, entry);
+    // the uv table, then the animations and their frames
+    for (u32 i = 0; i < 3; i++)
+    {
+        WGPUBindGroupLayoutEntry entry = {
+            .buffer = buffer_layout,
+            .visibility = WGPUShaderStage_Vertex,
+        };
+        bind_group_layout_builder_append(&builder, entry);
+    }
 
-    layouts->hdr_tonemap = bind_group_layout_build(
-        &builder, resources->device, "HDR Tonemap Bind Group Layout");
+    layouts->tilemap = bind_group_layout_build(&builder, resources->device,
+                                               "Tilemap Bind Group Layout");
     bind_group_layout_builder_free(&builder);
 }
 
@@ -160,14 +150,14 @@ void bind_group_layouts_init(BindGroupLayouts *layouts,
 {
     build_sprite_layout(layouts, resources);
     build_light_layout(layouts, resources);
-    build_tilemap_layout(layouts, resources);
     build_hdr_tonemap_layout(layouts, resources);
+    build_tilemap_layout(layouts, resources);
 }
 
 void bind_group_layouts_free(BindGroupLayouts *layouts)
 {
     wgpuBindGroupLayoutRelease(layouts->sprite);
     wgpuBindGroupLayoutRelease(layouts->lighting);
-    wgpuBindGroupLayoutRelease(layouts->tilemap);
     wgpuBindGroupLayoutRelease(layouts->hdr_tonemap);
+    wgpuBindGroupLayoutRelease(layouts->tilemap);
 }
@@ -7,10 +7,12 @@
 
 typedef struct
 {
+    // shared by sprites, ui sprites and tilemaps
     WGPUBindGroupLayout sprite;
     WGPUBindGroupLayout lighting;
-    WGPUBindGroupLayout tilemap;
     WGPUBindGroupLayout hdr_tonemap;
+    // a tilemap's uv and animation tables, which go alongside the sprite one
+    WGPUBindGroupLayout tilemap;
 } BindGroupLayouts;
 
 void bind_group_layouts_init(BindGroupLayouts *layouts,
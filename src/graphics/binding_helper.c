@@ -160,3 +160,20 @@ WGPUBindGroup bind_group_build(BindGroupBuilder *builder, WGPUDevice device,
     };
     return wgpuDeviceCreateBindGroup(device, &desc);
 }
+
+// ---  ---
+
+WGPUBuffer storage_buffer_from_vec(vec *table, WGPUDevice device,
+                                   WGPUQueue queue, const char *label)
+{
+    usize size = table->len * table->ele_size;
+    WGPUBufferDescriptor buffer_desc = {
+        .label = label,
+        .size = size > 0 ? size : table->ele_size,
+        .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage,
+    };
+    WGPUBuffer buffer = wgpuDeviceCreateBuffer(device, &buffer_desc);
+    if (size > 0)
+        wgpuQueueWriteBuffer(queue, buffer, 0, table->data, size);
+    return buffer;
+}
@@ -50,3 +50,10 @@ void bind_group_builder_append_texture_view_array(
 
 WGPUBindGroup bind_group_build(BindGroupBuilder *builder, WGPUDevice device,
                                WGPUBindGroupLayout layout, const char *label);
+
+// a storage buffer with everything in `table` uploaded to it, for lookup
+// tables the shaders index into.
+// wgpu doesn't like empty buffers, so there's always room for at least one
+// element. new buffers are zeroed, so that one is all zeroes
+WGPUBuffer storage_buffer_from_vec(vec *table, WGPUDevice device,
+                                   WGPUQueue queue, const char *label);
@@ -0,0 +1,372 @@
+#include "culling.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+Rect cull_quad_bounds(Rect quad, mat4s transform)
+{
+    vec2s corners[] = {
+        quad.min,
+        {.x = quad.max.x, .y = quad.min.y},
+        quad.max,
+        {.x = quad.min.x, .y = quad.max.y},
+    };
+
+    Rect bounds = {.min = {.x = INFINITY, .y = INFINITY},
+                   .max = {.x = -INFINITY, .y = -INFINITY}};
+    for (u32 i = 0; i < 4; i++)
+    {
+        vec4s point =
+            glms_mat4_mulv(transform, (vec4s){.x = corners[i].x,
+                                              .y = corners[i].y,
+                                              .z = 0.0,
+                                              .w = 1.0});
+        bounds.min.x = fminf(bounds.min.x, point.x);
+        bounds.min.y = fminf(bounds.min.y, point.y);
+        bounds.max.x = fmaxf(bounds.max.x, point.x);
+        bounds.max.y = fmaxf(bounds.max.y, point.y);
+    }
+    return bounds;
+}
+
+// sprite.wgsl moves things by camera_position * (1 - parallax), which is the
+// same as the camera being at camera_position * parallax
+Rect cull_view_rect(CullView view, vec2s parallax)
+{
+    return rect_from_min_size(glms_vec2_mul(view.position, parallax),
+                              view.size);
+}
+
+static bool is_parallaxed(vec2s parallax)
+{
+    return parallax.x != 1.0 || parallax.y != 1.0;
+}
+
+void layer_culling_init(LayerCulling *culling, thing_cull_keys_fn keys,
+                        f32 cell_size)
+{
+    culling->keys = keys;
+    culling->cell_size = cell_size;
+
+    vec_init(&culling->items, sizeof(CullItem));
+    hashmap_init(&culling->cells, fnv_hash_function, memcmp_eq_function,
+                 sizeof(CullCell), sizeof(u32));
+    vec_init(&culling->cell_lists, sizeof(vec));
+    vec_init(&culling->unbinned, sizeof(u32));
+    vec_init(&culling->pending, sizeof(u32));
+    vec_init(&culling->by_transform, sizeof(u32));
+    vec_init(&culling->by_quad, sizeof(u32));
+    vec_init(&culling->visible, sizeof(u32));
+
+    culling->query = 0;
+    culling->live = 0;
+}
+
+void layer_culling_free(LayerCulling *culling)
+{
+    for (usize i = 0; i < culling->cell_lists.len; i++)
+        vec_free(vec_get(&culling->cell_lists, i));
+    vec_free(&culling->cell_lists);
+    hashmap_free(&culling->cells);
+
+    vec_free(&culling->items);
+    vec_free(&culling->unbinned);
+    vec_free(&culling->pending);
+    vec_free(&culling->by_transform);
+    vec_free(&culling->by_quad);
+    vec_free(&culling->visible);
+}
+
+// ---  ---
+
+static CullItem *get_item(LayerCulling *culling, u32 entry)
+{
+    CullItem *item = vec_get(&culling->items, entry);
+    assert(item != NULL);
+    return item;
+}
+
+static u32 *chain_head(vec *by, u32 index)
+{
+    while (by->len <= index)
+    {
+        u32 none = CULL_ENTRY_NONE;
+        vec_push(by, &none);
+    }
+    return vec_get(by, index);
+}
+
+static void remove_from_list(vec *list, u32 entry)
+{
+    u32 *entries = (u32 *)list->data;
+    for (usize i = 0; i < list->len; i++)
+    {
+        if (entries[i] == entry)
+        {
+            vec_swap_remove(list, i, NULL);
+            return;
+        }
+    }
+}
+
+static vec *cell_list(LayerCulling *culling, CullCell cell, bool create)
+{
+    // hashmap values aren't aligned
+    void *value = hashmap_get(&culling->cells, &cell);
+    u32 index;
+    if (value)
+    {
+        memcpy(&index, value, sizeof(u32));
+        return vec_get(&culling->cell_lists, index);
+    }
+    if (!create)
+        return NULL;
+
+    index = culling->cell_lists.len;
+    vec list;
+    vec_init(&list, sizeof(u32));
+    vec_push(&culling->cell_lists, &list);
+    hashmap_insert(&culling->cells, &cell, &index);
+    return vec_get(&culling->cell_lists, index);
+}
+
+static CullCell cell_at(LayerCulling *culling, vec2s point)
+{
+    return (CullCell){.x = (i32)floorf(point.x / culling->cell_size),
+                      .y = (i32)floorf(point.y / culling->cell_size)};
+}
+
+static void unbin(LayerCulling *culling, u32 entry, CullItem *item)
+{
+    if (item->in_grid)
+    {
+        for (i32 y = item->min_cell.y; y <= item->max_cell.y; y++)
+            for (i32 x = item->min_cell.x; x <= item->max_cell.x; x++)
+                remove_from_list(
+                    cell_list(culling, (CullCell){.x = x, .y = y}, false),
+                    entry);
+        item->in_grid = false;
+    }
+    if (item->unbinned)
+    {
+        remove_from_list(&culling->unbinned, entry);
+        item->unbinned = false;
+    }
+}
+
+static void bin(LayerCulling *culling, u32 entry, CullItem *item)
+{
+    CullCell min = cell_at(culling, item->bounds.min);
+    CullCell max = cell_at(culling, item->bounds.max);
+    i64 cells = ((i64)max.x - min.x + 1) * ((i64)max.y - min.y + 1);
+
+    if (is_parallaxed(item->keys.parallax) || cells > CULL_MAX_CELLS)
+    {
+        vec_push(&culling->unbinned, &entry);
+        item->unbinned = true;
+        return;
+    }
+
+    for (i32 y = min.y; y <= max.y; y++)
+        for (i32 x = min.x; x <= max.x; x++)
+            vec_push(cell_list(culling, (CullCell){.x = x, .y = y}, true),
+                     &entry);
+    item->min_cell = min;
+    item->max_cell = max;
+    item->in_grid = true;
+}
+
+// ---  ---
+
+void layer_culling_add(LayerCulling *culling, u32 entry, void *thing)
+{
+    while (culling->items.len <= entry)
+    {
+        CullItem empty = {0};
+        vec_push(&culling->items, &empty);
+    }
+
+    CullItem *item = get_item(culling, entry);
+    assert(!item->live);
+    *item = (CullItem){.live = true, .pending = true};
+    culling->keys(thing, &item->keys);
+
+    u32 *head = chain_head(&culling->by_transform, item->keys.transform);
+    item->next_same_transform = *head;
+    *head = entry;
+
+    head = chain_head(&culling->by_quad, item->keys.quad);
+    item->next_same_quad = *head;
+    *head = entry;
+
+    vec_push(&culling->pending, &entry);
+    culling->live++;
+}
+
+void layer_culling_remove(LayerCulling *culling, u32 entry)
+{
+    CullItem *item = get_item(culling, entry);
+    assert(item->live);
+
+    unbin(culling, entry, item);
+    if (item->pending)
+        remove_from_list(&culling->pending, entry);
+
+    // unlink it from the things sharing its transform and quad
+    u32 *link = vec_get(&culling->by_transform, item->keys.transform);
+    while (*link != entry)
+        link = &get_item(culling, *link)->next_same_transform;
+    *link = item->next_same_transform;
+
+    link = vec_get(&culling->by_quad, item->keys.quad);
+    while (*link != entry)
+        link = &get_item(culling, *link)->next_same_quad;
+    *link = item->next_same_quad;
+
+    item->live = false;
+    culling->live--;
+}
+
+static void recompute(LayerCulling *culling, u32 entry,
+                      TransformManager *transforms, QuadManager *quads)
+{
+    CullItem *item = get_item(culling, entry);
+    Quad quad = quad_manager_get(quads, item->keys.quad);
+    mat4s matrix = transform_manager_get_matrix(transforms,
+                                                item->keys.transform);
+    Rect bounds = cull_quad_bounds(quad.rect, matrix);
+    item->pending = false;
+
+    // the grid only needs touching if it ended up in different cells
+    CullCell min = cell_at(culling, bounds.min);
+    CullCell max = cell_at(culling, bounds.max);
+    if (item->in_grid && min.x == item->min_cell.x &&
+        min.y == item->min_cell.y && max.x == item->max_cell.x &&
+        max.y == item->max_cell.y)
+    {
+        item->bounds = bounds;
+        return;
+    }
+
+    unbin(culling, entry, item);
+    item->bounds = bounds;
+    bin(culling, entry, item);
+}
+
+void layer_culling_refresh(LayerCulling *culling, TransformManager *transforms,
+                           QuadManager *quads)
+{
+    // keys in the dirty sets aren't aligned, so they get copied out
+    HashSetIter iter;
+    hashset_iter_init(&transforms->dirty_entries, &iter);
+    void *key;
+    while ((key = hashset_iter_next(&iter)))
+    {
+        TransformEntry transform;
+        memcpy(&transform, key, sizeof(TransformEntry));
+        u32 *head = vec_get(&culling->by_transform, transform);
+        for (u32 entry = head ? *head : CULL_ENTRY_NONE;
+             entry != CULL_ENTRY_NONE;
+             entry = get_item(culling, entry)->next_same_transform)
+            recompute(culling, entry, transforms, quads);
+    }
+
+    hashset_iter_init(&quads->dirty_entries, &iter);
+    while ((key = hashset_iter_next(&iter)))
+    {
+        QuadEntry quad;
+        memcpy(&quad, key, sizeof(QuadEntry));
+        u32 *head = vec_get(&culling->by_quad, quad);
+        for (u32 entry = head ? *head : CULL_ENTRY_NONE;
+             entry != CULL_ENTRY_NONE;
+             entry = get_item(culling, entry)->next_same_quad)
+            recompute(culling, entry, transforms, quads);
+    }
+
+    // anything that was just added has been dirty since, so it's probably
+    // been done already
+    u32 *pending = (u32 *)culling->pending.data;
+    for (usize i = 0; i < culling->pending.len; i++)
+        if (get_item(culling, pending[i])->pending)
+            recompute(culling, pending[i], transforms, quads);
+    vec_clear(&culling->pending);
+}
+
+static void check(LayerCulling *culling, u32 entry, Rect view)
+{
+    CullItem *item = get_item(culling, entry);
+    if (item->last_query == culling->query)
+        return;
+    item->last_query = culling->query;
+
+    if (rect_intersects(item->bounds, view))
+        vec_push(&culling->visible, &entry);
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    u32 left = *(const u32 *)a, right = *(const u32 *)b;
+    return left < right ? -1 : left > right;
+}
+
+// checks every thing one by one, which keeps them in order already
+static void query_everything(LayerCulling *culling, CullView view)
+{
+    CullItem *items = (CullItem *)culling->items.data;
+    for (u32 entry = 0; entry < culling->items.len; entry++)
+        if (items[entry].live && !items[entry].pending)
+            check(culling, entry,
+                  cull_view_rect(view, items[entry].keys.parallax));
+}
+
+static void query_grid(LayerCulling *culling, CullView view, Rect rect,
+                       CullCell min, CullCell max)
+{
+    for (i32 y = min.y; y <= max.y; y++)
+    {
+        for (i32 x = min.x; x <= max.x; x++)
+        {
+            vec *list = cell_list(culling, (CullCell){.x = x, .y = y}, false);
+            if (!list)
+                continue;
+            u32 *entries = (u32 *)list->data;
+            for (usize i = 0; i < list->len; i++)
+                check(culling, entries[i], rect);
+        }
+    }
+
+    u32 *unbinned = (u32 *)culling->unbinned.data;
+    for (usize i = 0; i < culling->unbinned.len; i++)
+    {
+        CullItem *item = get_item(culling, unbinned[i]);
+        check(culling, unbinned[i], cull_view_rect(view, item->keys.parallax));
+    }
+
+    // the grid doesn't keep things in order, but overlapping things still
+    // need drawing in the order they were added
+    qsort(culling->visible.data, culling->visible.len, sizeof(u32),
+          compare_entries);
+}
+
+void layer_culling_query(LayerCulling *culling, CullView view,
+                         CullStats *stats)
+{
+    vec_clear(&culling->visible);
+    culling->query++;
+
+    Rect rect = cull_view_rect(view, GLMS_VEC2_ONE);
+    CullCell min = cell_at(culling, rect.min);
+    CullCell max = cell_at(culling, rect.max);
+    i64 view_cells = ((i64)max.x - min.x + 1) * ((i64)max.y - min.y + 1);
+
+    // if the camera can see more cells than there are things (zoomed way out,
+    // or there's hardly anything here), it's quicker to just check everything
+    if (view_cells > culling->live)
+        query_everything(culling, view);
+    else
+        query_grid(culling, view, rect, min, max);
+
+    stats->submitted += culling->live;
+    stats->visible += culling->visible.len;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "core_types.h"
+#include "graphics/quad_manager.h"
+#include "graphics/transform_manager.h"
+#include "sensible_nums.h"
+#include "utility/hashmap.h"
+#include "utility/vec.h"
+
+// skipping things that aren't on screen, before they get anywhere near the gpu.
+//
+// each thing in a culled layer has its world space bounds (its quad's rect
+// after being transformed) cached, and only recomputed when its transform or
+// quad changes. we find out about that from the managers' dirty sets, so
+// nothing that moves sprites around needs to know about culling.
+//
+// things are put into a uniform grid by their bounds, so finding what's on
+// screen only looks at the few cells the camera can see, instead of every
+// single thing on a big map. things with parallax (and anything huge) aren't
+// in the grid, since where they are on screen depends on the camera, so they
+// get checked one by one.
+
+#define CULL_CELL_SIZE 256.0f
+// things covering more cells than this get checked one by one instead
+#define CULL_MAX_CELLS 64
+
+// what a thing's bounds get computed from
+typedef struct
+{
+    TransformEntry transform;
+    QuadEntry quad;
+    // see Sprite.parallax_factor. this is only read when the thing is added
+    vec2s parallax;
+} CullKeys;
+
+typedef void (*thing_cull_keys_fn)(void *thing, CullKeys *keys);
+
+// the camera, for culling
+typedef struct
+{
+    vec2s position;
+    vec2s size;
+} CullView;
+
+typedef struct
+{
+    // things that could have been drawn, and things that were
+    u32 submitted, visible;
+} CullStats;
+
+typedef struct
+{
+    i32 x, y;
+} CullCell;
+
+typedef struct
+{
+    CullKeys keys;
+    Rect bounds;
+
+    // the cells this is in (inclusive), if it's in the grid
+    CullCell min_cell, max_cell;
+    bool live, in_grid, unbinned, pending;
+
+    // other things using the same transform/quad, see by_transform/by_quad
+    u32 next_same_transform, next_same_quad;
+    // so things in more than one cell are only checked once per query
+    u32 last_query;
+} CullItem;
+
+typedef struct LayerCulling
+{
+    thing_cull_keys_fn keys;
+    f32 cell_size;
+
+    // everything here is indexed by the thing's LayerEntry
+    vec items; // vec<CullItem>
+
+    HashMap cells;  // CullCell -> u32 index into cell_lists
+    vec cell_lists; // vec<vec<LayerEntry>>
+    vec unbinned;   // vec<LayerEntry>, things that aren't in the grid
+    vec pending;    // vec<LayerEntry>, added but bounds not computed yet
+
+    // the first thing using each transform/quad entry (CULL_ENTRY_NONE if
+    // there isn't one)
+    vec by_transform; // vec<LayerEntry>
+    vec by_quad;      // vec<LayerEntry>
+
+    vec visible; // vec<LayerEntry>, filled by layer_culling_query
+    u32 query;
+    u32 live;
+} LayerCulling;
+
+// layer.h includes this, so LayerEntry isn't defined yet. they're both u32s
+#define CULL_ENTRY_NONE UINT32_MAX
+
+// world space bounds of `quad` after being transformed by `transform`
+Rect cull_quad_bounds(Rect quad, mat4s transform);
+// what part of the world is on screen for something with this parallax factor
+Rect cull_view_rect(CullView view, vec2s parallax);
+
+void layer_culling_init(LayerCulling *culling, thing_cull_keys_fn keys,
+                        f32 cell_size);
+void layer_culling_free(LayerCulling *culling);
+
+// called by layer_add/layer_remove (entry is a LayerEntry)
+void layer_culling_add(LayerCulling *culling, u32 entry, void *thing);
+void layer_culling_remove(LayerCulling *culling, u32 entry);
+
+// recomputes the bounds of anything that was added or has moved since last
+// time. needs calling before the managers upload, since that clears their
+// dirty sets
+void layer_culling_refresh(LayerCulling *culling, TransformManager *transforms,
+                           QuadManager *quads);
+
+// fills culling->visible with everything that's on screen, in layer order
+void layer_culling_query(LayerCulling *culling, CullView view,
+                         CullStats *stats);
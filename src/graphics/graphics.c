@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 #include <wgpu.h>
 
 #include "graphics.h"
@@ -7,6 +8,7 @@
 #include "binding_helper.h"
 #include "graphics/light.h"
 #include "graphics/sprite.h"
+#include "graphics/sprite_batch.h"
 #include "graphics/tilemap.h"
 #include "graphics/ui_sprite.h"
 #include "imgui_wgpu.h"
@@ -21,12 +23,15 @@ QuadEntry graphics_screen_quad_entry(void) { return screen_quad_index; }
 
 struct DeferredContext
 {
+    Graphics *graphics;
     mat4s camera;
     mat4s camera_projection;
     vec2s camera_position;
+    // for culling tilemap chunks
+    CullView view;
 };
 
-void tilemap_layer_draw(void *layer, void *context, WGPURenderPassEncoder pass)
+void tilemap_layer_draw(void *layer, void *context, RenderState *state)
 {
     TilemapLayer *tilemap_layer = layer;
     struct DeferredContext *def_context = context;
@@ -45,51 +50,168 @@ void tilemap_layer_draw(void *layer, void *context, WGPURenderPassEncoder pass)
             glms_mat4_mul(def_context->camera_projection, camera_transform);
     }
 
-    tilemap_render(tilemap_layer->tilemap, camera, tilemap_layer->layer, pass);
+    Rect view =
+        cull_view_rect(def_context->view, tilemap_layer->parallax_factor);
+    tilemap_render(tilemap_layer->tilemap, def_context->graphics, camera, view,
+                   tilemap_layer->layer, state);
 }
 
-void sprite_draw(void *thing, void *context, WGPURenderPassEncoder pass)
+// what tilemap layers get submitted to the render queue with
+struct TilemapSubmit
 {
-    struct DeferredContext *def_context = context;
-    Sprite *sprite = thing;
+    RenderQueue *queue;
+    struct DeferredContext *def_context;
+    WGPURenderPipeline pipeline;
+    WGPUBindGroup bind_group;
+
+    u8 layer;
+    // tilemap layers can overlap each other, so they need drawing in the
+    // order they were added. this goes up for each one
+    u32 depth;
+};
 
-    mat4s camera = def_context->camera;
-    if (sprite->parallax_factor.x != 1.0 || sprite->parallax_factor.y != 1.0)
-    {
-        vec2s camera_position = glms_vec2_mul(def_context->camera_position,
-                                              sprite->parallax_factor);
-        mat4s camera_transform = glms_look(
-            (vec3s){.x = camera_position.x, .y = camera_position.y, .z = 0.0},
-            (vec3s){.x = 0.0, .y = 0.0, .z = -1.0},
-            (vec3s){.x = 0.0, .y = 1.0, .z = 0.0});
-        camera =
-            glms_mat4_mul(def_context->camera_projection, camera_transform);
-    }
+void tilemap_layer_submit(void *layer, void *batch)
+{
+    struct TilemapSubmit *submit = batch;
+    TilemapLayer *tilemap_layer = layer;
+
+    // streaming tilemaps need to know what's going to be drawn before any of
+    // it is
+    struct DeferredContext *def_context = submit->def_context;
+    Rect view =
+        cull_view_rect(def_context->view, tilemap_layer->parallax_factor);
+    tilemap_request(tilemap_layer->tilemap, def_context->graphics, view,
+                    tilemap_layer->layer);
+
+    RenderKey key = {
+        .pass = RenderPass_Deferred,
+        .layer = submit->layer,
+        .pipeline = RenderPipeline_Tilemap,
+        .depth = submit->depth++,
+    };
+    RenderItem item = {
+        .key = render_key_pack(key),
+        .pipeline = submit->pipeline,
+        .bind_group = submit->bind_group,
+        .draw = tilemap_layer_draw,
+        .thing = layer,
+        .ctx = submit->def_context,
+    };
+    render_queue_push(submit->queue, &item);
+}
+
+// a whole layer of sprites, which gets drawn with one draw call (see
+// sprite_batch.h)
+struct SpriteLayerDraw
+{
+    SpriteBatch *batch;
+    SpriteBatchRange range;
+    SpritePushConstants *constants;
+};
 
-    sprite_render(sprite, camera, pass);
+static void sprite_layer_draw(void *thing, void *context, RenderState *state)
+{
+    (void)context;
+    struct SpriteLayerDraw *draw = thing;
+    render_state_set_push_constants(state, sizeof(SpritePushConstants),
+                                    draw->constants);
+    sprite_batch_draw(draw->batch, draw->range, state);
 }
 
-void ui_sprite_draw(void *thing, void *context, WGPURenderPassEncoder pass)
+static void submit_sprite_layer(RenderQueue *queue,
+                                struct SpriteLayerDraw *draw, RenderKey key,
+                                WGPURenderPipeline pipeline,
+                                WGPUBindGroup bind_group)
 {
-    UiSprite *sprite = thing;
-    ui_sprite_render(sprite, *(mat4s *)context, pass);
+    if (draw->range.count == 0)
+        return;
+
+    RenderItem item = {
+        .key = render_key_pack(key),
+        .pipeline = pipeline,
+        .bind_group = bind_group,
+        .draw = sprite_layer_draw,
+        .thing = draw,
+    };
+    render_queue_push(queue, &item);
 }
 
-void point_light_draw(void *thing, void *context, WGPURenderPassEncoder pass)
+void point_light_draw(void *thing, void *context, RenderState *state)
 {
     Light *light = thing;
     if (light->type != Light_Point)
         return;
-    light_render(light, pass, *(Camera *)context);
+    light_render(light, state, *(Camera *)context);
 }
 
-void directional_light_draw(void *thing, void *context,
-                            WGPURenderPassEncoder pass)
+void directional_light_draw(void *thing, void *context, RenderState *state)
 {
     Light *light = thing;
     if (light->type != Light_Direct)
         return;
-    light_render(light, pass, *(Camera *)context);
+    light_render(light, state, *(Camera *)context);
+}
+
+static WGPUBindGroup build_sprite_bind_group(void *userdata)
+{
+    Graphics *graphics = userdata;
+    BindGroupBuilder builder;
+    bind_group_builder_init(&builder);
+
+    bind_group_builder_append_buffer(&builder,
+                                     graphics->transform_manager.buffer);
+    bind_group_builder_append_texture_view_array(
+        &builder,
+        (WGPUTextureView *)graphics->texture_manager.texture_views.data,
+        graphics->texture_manager.texture_views.len);
+    bind_group_builder_append_sampler(&builder, graphics->sampler);
+    bind_group_builder_append_buffer(&builder, graphics->quad_manager.buffer);
+    bind_group_builder_append_buffer(&builder,
+                                     graphics->sprite_animations.animations);
+    bind_group_builder_append_buffer(&builder,
+                                     graphics->sprite_animations.frames);
+
+    WGPUBindGroup bind_group = bind_group_build(
+        &builder, graphics->wgpu.device, graphics->bind_group_layouts.sprite,
+        "Sprite Bind Group");
+
+    bind_group_builder_free(&builder);
+    return bind_group;
+}
+
+static WGPUBindGroup build_light_bind_group(void *userdata)
+{
+    Graphics *graphics = userdata;
+    BindGroupBuilder builder;
+    bind_group_builder_init(&builder);
+
+    bind_group_builder_append_texture_view(&builder, graphics->color_view);
+    bind_group_builder_append_sampler(&builder, graphics->sampler);
+
+    WGPUBindGroup bind_group = bind_group_build(
+        &builder, graphics->wgpu.device, graphics->bind_group_layouts.lighting,
+        "Light Bind Group");
+
+    bind_group_builder_free(&builder);
+    return bind_group;
+}
+
+static WGPUBindGroup build_hdr_tonemap_bind_group(void *userdata)
+{
+    Graphics *graphics = userdata;
+    BindGroupBuilder builder;
+    bind_group_builder_init(&builder);
+
+    bind_group_builder_append_texture_view(&builder, graphics->lit_view);
+    bind_group_builder_append_sampler(&builder, graphics->sampler);
+
+    WGPUBindGroup bind_group =
+        bind_group_build(&builder, graphics->wgpu.device,
+                         graphics->bind_group_layouts.hdr_tonemap,
+                         "Screen Blit Bind Group");
+
+    bind_group_builder_free(&builder);
+    return bind_group;
 }
 
 void graphics_init(Graphics *graphics, SDL_Window *window, Settings *settings)
@@ -104,28 +226,49 @@ void graphics_init(Graphics *graphics, SDL_Window *window, Settings *settings)
     // texture manager has no gpu side resources allocated initially so no need
     // to pass wgpu
     texture_manager_init(&graphics->texture_manager);
-
-    layer_init(&graphics->tilemap_layers.background, tilemap_layer_draw);
-    layer_init(&graphics->tilemap_layers.middle, tilemap_layer_draw);
-    layer_init(&graphics->tilemap_layers.foreground, tilemap_layer_draw);
-
-    layer_init(&graphics->sprite_layers.background, sprite_draw);
-    layer_init(&graphics->sprite_layers.middle, sprite_draw);
-    layer_init(&graphics->sprite_layers.foreground, sprite_draw);
+    graphics->buffer_generation = 0;
+    graphics->frame = 0;
+    graphics->animation_time = 0;
+    sprite_batch_init(&graphics->sprite_batch, &graphics->wgpu);
+    sprite_animations_init(&graphics->sprite_animations, &graphics->wgpu);
+    render_queue_init(&graphics->render_queue);
+    memset(&graphics->render_stats, 0, sizeof(RenderStats));
+    memset(&graphics->cull_stats, 0, sizeof(graphics->cull_stats));
+
+    layer_init_batched(&graphics->tilemap_layers.background,
+                       tilemap_layer_submit);
+    layer_init_batched(&graphics->tilemap_layers.middle, tilemap_layer_submit);
+    layer_init_batched(&graphics->tilemap_layers.foreground,
+                       tilemap_layer_submit);
+
+    layer_init_batched(&graphics->sprite_layers.background,
+                       sprite_batch_thing);
+    layer_init_batched(&graphics->sprite_layers.middle, sprite_batch_thing);
+    layer_init_batched(&graphics->sprite_layers.foreground,
+                       sprite_batch_thing);
+    layer_enable_culling(&graphics->sprite_layers.background,
+                         sprite_cull_keys);
+    layer_enable_culling(&graphics->sprite_layers.middle, sprite_cull_keys);
+    layer_enable_culling(&graphics->sprite_layers.foreground,
+                         sprite_cull_keys);
 
     // TODO add free fns
-    layer_init(&graphics->ui_layers.background, ui_sprite_draw);
-    layer_init(&graphics->ui_layers.middle, ui_sprite_draw);
-    layer_init(&graphics->ui_layers.foreground, ui_sprite_draw);
+    layer_init_batched(&graphics->ui_layers.background, ui_sprite_batch_thing);
+    layer_init_batched(&graphics->ui_layers.middle, ui_sprite_batch_thing);
+    layer_init_batched(&graphics->ui_layers.foreground, ui_sprite_batch_thing);
+    layer_enable_culling(&graphics->ui_layers.background, ui_sprite_cull_keys);
+    layer_enable_culling(&graphics->ui_layers.middle, ui_sprite_cull_keys);
+    layer_enable_culling(&graphics->ui_layers.foreground, ui_sprite_cull_keys);
 
     layer_init(&graphics->lights, point_light_draw);
 
     // load bearing molly
     // why do we need this? primarily to make sure that at least one texture is
-    // loaded, because you can't bind an empty texture array
-    texture_manager_load(&graphics->texture_manager,
-                         "assets/textures/load_bearing_molly.png",
-                         &graphics->wgpu);
+    // loaded, because you can't bind an empty texture array. she also stands
+    // in for textures that are still loading
+    graphics->texture_manager.placeholder = texture_manager_load(
+        &graphics->texture_manager, "assets/textures/load_bearing_molly.png",
+        &graphics->wgpu);
 
     {
         WGPUExtent3D extents = {
@@ -190,98 +333,185 @@ void graphics_init(Graphics *graphics, SDL_Window *window, Settings *settings)
         };
         screen_quad_index = quad_manager_add(&graphics->quad_manager, quad);
     }
-}
 
-void build_sprite_bind_group(Graphics *graphics, WGPUBindGroup *bind_group)
-{
-    BindGroupBuilder builder;
-    bind_group_builder_init(&builder);
-
-    bind_group_builder_append_buffer(&builder,
-                                     graphics->transform_manager.buffer);
-    bind_group_builder_append_texture_view_array(
-        &builder,
-        (WGPUTextureView *)graphics->texture_manager.texture_views.data,
-        graphics->texture_manager.texture_views.len);
-    bind_group_builder_append_sampler(&builder, graphics->sampler);
-
-    *bind_group = bind_group_build(&builder, graphics->wgpu.device,
-                                   graphics->bind_group_layouts.sprite,
-                                   "Sprite Bind Group");
-
-    bind_group_builder_free(&builder);
+    // these don't get built until they're first used
+    bind_group_cache_init(&graphics->bind_groups, graphics);
+    bind_group_cache_set_builder(&graphics->bind_groups, BindGroup_Sprite,
+                                 build_sprite_bind_group);
+    bind_group_cache_set_builder(&graphics->bind_groups, BindGroup_Light,
+                                 build_light_bind_group);
+    bind_group_cache_set_builder(&graphics->bind_groups, BindGroup_HdrTonemap,
+                                 build_hdr_tonemap_bind_group);
 }
 
-void build_light_bind_group(Graphics *graphics, WGPUBindGroup *bind_group)
+u32 graphics_animation_time(Duration elapsed)
 {
-    BindGroupBuilder builder;
-    bind_group_builder_init(&builder);
-
-    bind_group_builder_append_texture_view(&builder, graphics->color_view);
-    bind_group_builder_append_sampler(&builder, graphics->sampler);
-
-    *bind_group = bind_group_build(&builder, graphics->wgpu.device,
-                                   graphics->bind_group_layouts.lighting,
-                                   "Light Bind Group");
-
-    bind_group_builder_free(&builder);
+    return (u32)(u64)(duration_as_secs_f64(elapsed) * 1000.0);
 }
 
-void build_tilemap_bind_group(Graphics *graphics, WGPUBindGroup *bind_group)
+void graphics_render(Graphics *graphics, Physics *physics, Camera raw_camera,
+                     Duration elapsed)
 {
-    // FIXME it's a waste to create a new bind group every frame + this has the
-    // same layout as the regular sprite bind group
-    BindGroupBuilder builder;
-    bind_group_builder_init(&builder);
-
-    bind_group_builder_append_buffer(&builder,
-                                     graphics->transform_manager.buffer);
-    bind_group_builder_append_texture_view_array(
-        &builder,
-        (WGPUTextureView *)graphics->texture_manager.texture_views.data,
-        graphics->texture_manager.texture_views.len);
-    bind_group_builder_append_sampler(&builder, graphics->sampler);
+    // the debug window reads these in between frames, so they're always for a
+    // whole frame
+    memset(&graphics->render_stats, 0, sizeof(RenderStats));
+    memset(&graphics->cull_stats, 0, sizeof(graphics->cull_stats));
+    graphics->frame++;
+    graphics->animation_time = graphics_animation_time(elapsed);
+
+    Layer *sprite_layers[] = {
+        &graphics->sprite_layers.background,
+        &graphics->sprite_layers.middle,
+        &graphics->sprite_layers.foreground,
+    };
+    Layer *tilemap_layers[] = {
+        &graphics->tilemap_layers.background,
+        &graphics->tilemap_layers.middle,
+        &graphics->tilemap_layers.foreground,
+    };
+    Layer *ui_layers[] = {
+        &graphics->ui_layers.background,
+        &graphics->ui_layers.middle,
+        &graphics->ui_layers.foreground,
+    };
 
-    *bind_group = bind_group_build(&builder, graphics->wgpu.device,
-                                   graphics->bind_group_layouts.tilemap,
-                                   "Tilemap Bind Group");
+    // this has to happen before uploading, since that's when the managers
+    // forget what changed
+    for (u32 i = 0; i < 3; i++)
+    {
+        layer_culling_refresh(sprite_layers[i]->culling,
+                              &graphics->transform_manager,
+                              &graphics->quad_manager);
+        layer_culling_refresh(ui_layers[i]->culling,
+                              &graphics->transform_manager,
+                              &graphics->quad_manager);
+    }
 
-    bind_group_builder_free(&builder);
-}
+    // before the bind groups, since this adds textures
+    texture_manager_upload_loaded(&graphics->texture_manager, &graphics->wgpu);
+
+    if (quad_manager_upload_dirty(&graphics->quad_manager, &graphics->wgpu))
+        graphics->buffer_generation++;
+    if (transform_manager_upload_dirty(&graphics->transform_manager,
+                                       &graphics->wgpu))
+        graphics->buffer_generation++;
+
+    // the sprite bind group has every texture + the quad and transform buffers
+    // in it, so it needs rebuilding when any of them change. tilemaps use it
+    // too
+    u64 sprite_generation =
+        bind_group_generation(graphics->texture_manager.generation,
+                              graphics->buffer_generation);
+    WGPUBindGroup sprite_bind_group = bind_group_cache_get(
+        &graphics->bind_groups, BindGroup_Sprite, sprite_generation);
+
+    // the color and lit textures live as long as graphics does, so these only
+    // ever get built once
+    WGPUBindGroup light_bind_group =
+        bind_group_cache_get(&graphics->bind_groups, BindGroup_Light, 0);
+    WGPUBindGroup hdr_tonemap_bind_group =
+        bind_group_cache_get(&graphics->bind_groups, BindGroup_HdrTonemap, 0);
 
-void build_hdr_tonemap_bind_group(Graphics *graphics, WGPUBindGroup *bind_group)
-{
-    BindGroupBuilder builder;
-    bind_group_builder_init(&builder);
+    mat4s camera_projection =
+        glms_ortho(0.0, GAME_VIEW_WIDTH, GAME_VIEW_HEIGHT, 0.0, -1.0f, 1.0f);
+    mat4s camera_transform = glms_look(
+        (vec3s){.x = raw_camera.x, .y = raw_camera.y, .z = raw_camera.z},
+        (vec3s){.x = 0.0, .y = 0.0, .z = -1.0},
+        (vec3s){.x = 0.0, .y = 1.0, .z = 0.0});
+    mat4s camera = glms_mat4_mul(camera_projection, camera_transform);
 
-    bind_group_builder_append_texture_view(&builder, graphics->lit_view);
-    bind_group_builder_append_sampler(&builder, graphics->sampler);
+    CullView sprite_view = {
+        .position = (vec2s){.x = raw_camera.x, .y = raw_camera.y},
+        .size = {.x = GAME_VIEW_WIDTH, .y = GAME_VIEW_HEIGHT},
+    };
+    struct DeferredContext def_context = {
+        .graphics = graphics,
+        .camera = camera,
+        .camera_position = sprite_view.position,
+        .camera_projection = camera_projection,
+        .view = sprite_view,
+    };
 
-    *bind_group = bind_group_build(&builder, graphics->wgpu.device,
-                                   graphics->bind_group_layouts.hdr_tonemap,
-                                   "Screen Blit Bind Group");
+    SpritePushConstants sprite_constants = {
+        .camera = camera,
+        .camera_position = def_context.camera_position,
+        .time = graphics->animation_time,
+    };
 
-    bind_group_builder_free(&builder);
-}
+    mat4s ui_camera_projection =
+        glms_ortho(0.0, UI_VIEW_WIDTH, UI_VIEW_HEIGHT, 0.0, -1.0f, 1.0f);
+    mat4s ui_camera_transform =
+        glms_look(GLMS_VEC3_ZERO, (vec3s){.x = 0.0, .y = 0.0, .z = -1.0},
+                  (vec3s){.x = 0.0, .y = 1.0, .z = 0.0});
+    SpritePushConstants ui_constants = {
+        .camera = glms_mat4_mul(ui_camera_projection, ui_camera_transform),
+        .camera_position = GLMS_VEC2_ZERO,
+        .time = graphics->animation_time,
+    };
 
-void graphics_render(Graphics *graphics, Physics *physics, Camera raw_camera)
-{
-    quad_manager_upload_dirty(&graphics->quad_manager, &graphics->wgpu);
-    transform_manager_upload_dirty(&graphics->transform_manager,
-                                   &graphics->wgpu);
+    CullView ui_view = {
+        .position = GLMS_VEC2_ZERO,
+        .size = {.x = UI_VIEW_WIDTH, .y = UI_VIEW_HEIGHT},
+    };
 
-    // FIXME we really should not be creating a new bind group every frame
-    WGPUBindGroup sprite_bind_group;
-    build_sprite_bind_group(graphics, &sprite_bind_group);
+    // every sprite on screen gets uploaded in one go before anything is drawn
+    SpriteBatch *batch = &graphics->sprite_batch;
+    sprite_batch_begin(batch);
 
-    WGPUBindGroup light_bind_group;
-    build_light_bind_group(graphics, &light_bind_group);
+    // everything gets submitted to the render queue up front, and then each
+    // pass just draws its part of it. within a layer, tilemaps are drawn
+    // before sprites (see RenderPipelineId)
+    RenderQueue *queue = &graphics->render_queue;
+    render_queue_clear(queue);
 
-    WGPUBindGroup tilemap_bind_group;
-    build_tilemap_bind_group(graphics, &tilemap_bind_group);
+    struct SpriteLayerDraw sprite_draws[3], ui_draws[3];
+    for (u8 i = 0; i < 3; i++)
+    {
+        struct TilemapSubmit tilemap_submit = {
+            .queue = queue,
+            .def_context = &def_context,
+            .pipeline = graphics->shaders.defferred.tilemap,
+            .bind_group = sprite_bind_group,
+            .layer = i,
+        };
+        layer_batch(tilemap_layers[i], &tilemap_submit);
+
+        sprite_draws[i] = (struct SpriteLayerDraw){
+            .batch = batch,
+            .range = sprite_batch_add_layer(batch, sprite_layers[i],
+                                            sprite_view,
+                                            &graphics->cull_stats.sprites),
+            .constants = &sprite_constants,
+        };
+        RenderKey key = {
+            .pass = RenderPass_Deferred,
+            .layer = i,
+            .pipeline = RenderPipeline_Sprite,
+        };
+        submit_sprite_layer(queue, &sprite_draws[i], key,
+                            graphics->shaders.defferred.sprite,
+                            sprite_bind_group);
+    }
+    for (u8 i = 0; i < 3; i++)
+    {
+        ui_draws[i] = (struct SpriteLayerDraw){
+            .batch = batch,
+            .range = sprite_batch_add_layer(batch, ui_layers[i], ui_view,
+                                            &graphics->cull_stats.ui),
+            .constants = &ui_constants,
+        };
+        RenderKey key = {
+            .pass = RenderPass_Screen,
+            .layer = i,
+            .pipeline = RenderPipeline_UiSprite,
+        };
+        submit_sprite_layer(queue, &ui_draws[i], key,
+                            graphics->shaders.forward.ui_sprite,
+                            sprite_bind_group);
+    }
 
-    WGPUBindGroup hdr_tonemap_bind_group;
-    build_hdr_tonemap_bind_group(graphics, &hdr_tonemap_bind_group);
+    sprite_batch_upload(batch, &graphics->wgpu);
+    render_queue_sort(queue);
 
     WGPUSurfaceTexture surface_texture;
     wgpuSurfaceGetCurrentTexture(graphics->wgpu.surface, &surface_texture);
@@ -316,20 +546,6 @@ void graphics_render(Graphics *graphics, Physics *physics, Camera raw_camera)
     WGPUCommandEncoder command_encoder =
         wgpuDeviceCreateCommandEncoder(graphics->wgpu.device, NULL);
 
-    mat4s camera_projection =
-        glms_ortho(0.0, GAME_VIEW_WIDTH, GAME_VIEW_HEIGHT, 0.0, -1.0f, 1.0f);
-    mat4s camera_transform = glms_look(
-        (vec3s){.x = raw_camera.x, .y = raw_camera.y, .z = raw_camera.z},
-        (vec3s){.x = 0.0, .y = 0.0, .z = -1.0},
-        (vec3s){.x = 0.0, .y = 1.0, .z = 0.0});
-    mat4s camera = glms_mat4_mul(camera_projection, camera_transform);
-
-    struct DeferredContext def_context = {
-        .camera = camera,
-        .camera_position = (vec2s){.x = raw_camera.x, .y = raw_camera.y},
-        .camera_projection = camera_projection};
-
-    u64 quad_buffer_size = wgpuBufferGetSize(graphics->quad_manager.buffer);
     {
         WGPURenderPassColorAttachment defferred_attachments[] = {{
             .view = graphics->color_view,
@@ -346,60 +562,9 @@ void graphics_render(Graphics *graphics, Physics *physics, Camera raw_camera)
         WGPURenderPassEncoder render_pass = wgpuCommandEncoderBeginRenderPass(
             command_encoder, &deferred_render_pass_desc);
 
-        wgpuRenderPassEncoderSetPipeline(render_pass,
-                                         graphics->shaders.defferred.tilemap);
-        wgpuRenderPassEncoderSetBindGroup(render_pass, 0, tilemap_bind_group, 0,
-                                          NULL);
-        layer_draw(&graphics->tilemap_layers.background, &def_context,
-                   render_pass);
-
-        wgpuRenderPassEncoderSetPipeline(render_pass,
-                                         graphics->shaders.defferred.sprite);
-        wgpuRenderPassEncoderSetBindGroup(render_pass, 0, sprite_bind_group, 0,
-                                          NULL);
-        wgpuRenderPassEncoderSetVertexBuffer(
-            render_pass, 0, graphics->quad_manager.buffer, 0, quad_buffer_size);
-        wgpuRenderPassEncoderSetIndexBuffer(render_pass,
-                                            graphics->quad_manager.index_buffer,
-                                            WGPUIndexFormat_Uint16, 0, 12);
-        layer_draw(&graphics->sprite_layers.background, &def_context,
-                   render_pass);
-
-        wgpuRenderPassEncoderSetPipeline(render_pass,
-                                         graphics->shaders.defferred.tilemap);
-        wgpuRenderPassEncoderSetBindGroup(render_pass, 0, tilemap_bind_group, 0,
-                                          NULL);
-        layer_draw(&graphics->tilemap_layers.middle, &def_context, render_pass);
-
-        wgpuRenderPassEncoderSetPipeline(render_pass,
-                                         graphics->shaders.defferred.sprite);
-        wgpuRenderPassEncoderSetBindGroup(render_pass, 0, sprite_bind_group, 0,
-                                          NULL);
-        wgpuRenderPassEncoderSetVertexBuffer(
-            render_pass, 0, graphics->quad_manager.buffer, 0, quad_buffer_size);
-        wgpuRenderPassEncoderSetIndexBuffer(render_pass,
-                                            graphics->quad_manager.index_buffer,
-                                            WGPUIndexFormat_Uint16, 0, 12);
-        layer_draw(&graphics->sprite_layers.middle, &def_context, render_pass);
-
-        wgpuRenderPassEncoderSetPipeline(render_pass,
-                                         graphics->shaders.defferred.tilemap);
-        wgpuRenderPassEncoderSetBindGroup(render_pass, 0, tilemap_bind_group, 0,
-                                          NULL);
-        layer_draw(&graphics->tilemap_layers.foreground, &def_context,
-                   render_pass);
-
-        wgpuRenderPassEncoderSetPipeline(render_pass,
-                                         graphics->shaders.defferred.sprite);
-        wgpuRenderPassEncoderSetBindGroup(render_pass, 0, sprite_bind_group, 0,
-                                          NULL);
-        wgpuRenderPassEncoderSetVertexBuffer(
-            render_pass, 0, graphics->quad_manager.buffer, 0, quad_buffer_size);
-        wgpuRenderPassEncoderSetIndexBuffer(render_pass,
-                                            graphics->quad_manager.index_buffer,
-                                            WGPUIndexFormat_Uint16, 0, 12);
-        layer_draw(&graphics->sprite_layers.foreground, &def_context,
-                   render_pass);
+        RenderState state;
+        render_state_begin(&state, render_pass, &graphics->render_stats);
+        render_queue_execute(queue, RenderPass_Deferred, &state);
 
         wgpuRenderPassEncoderEnd(render_pass);
         wgpuRenderPassEncoderRelease(render_pass);
@@ -421,20 +586,20 @@ void graphics_render(Graphics *graphics, Physics *physics, Camera raw_camera)
         };
         WGPURenderPassEncoder render_pass = wgpuCommandEncoderBeginRenderPass(
             command_encoder, &lit_render_pass_desc);
-        wgpuRenderPassEncoderSetBindGroup(render_pass, 0, light_bind_group, 0,
-                                          0);
 
-        wgpuRenderPassEncoderSetPipeline(render_pass,
-                                         graphics->shaders.lights.direct);
+        RenderState state;
+        render_state_begin(&state, render_pass, &graphics->render_stats);
+        render_state_set_bind_group(&state, 0, light_bind_group);
+
+        render_state_set_pipeline(&state, graphics->shaders.lights.direct);
 
         graphics->lights.draw = directional_light_draw;
-        layer_draw(&graphics->lights, &raw_camera, render_pass);
+        layer_draw(&graphics->lights, &raw_camera, &state);
 
-        wgpuRenderPassEncoderSetPipeline(render_pass,
-                                         graphics->shaders.lights.point);
+        render_state_set_pipeline(&state, graphics->shaders.lights.point);
 
         graphics->lights.draw = point_light_draw;
-        layer_draw(&graphics->lights, &raw_camera, render_pass);
+        layer_draw(&graphics->lights, &raw_camera, &state);
 
         wgpuRenderPassEncoderEnd(render_pass);
         wgpuRenderPassEncoderRelease(render_pass);
@@ -462,47 +627,29 @@ void graphics_render(Graphics *graphics, Physics *physics, Camera raw_camera)
         WGPURenderPassEncoder render_pass = wgpuCommandEncoderBeginRenderPass(
             command_encoder, &screen_render_pass_desc);
 
+        RenderState state;
+        render_state_begin(&state, render_pass, &graphics->render_stats);
+
         // copy the lit texture to the screen
         // we unfortunately can't use wgpuCommandEncoderCopyTextureToTexture
         // because the lit texture is not the same size as the screen texture
         // i wish there was some kind of blit function :( we could prooooobably
         // do this with a compute shader but i honestly could not be bothered
         // right now
-        wgpuRenderPassEncoderSetPipeline(render_pass,
-                                         graphics->shaders.forward.hdr_tonemap);
-        wgpuRenderPassEncoderSetBindGroup(render_pass, 0,
-                                          hdr_tonemap_bind_group, 0, NULL);
+        render_state_set_pipeline(&state,
+                                  graphics->shaders.forward.hdr_tonemap);
+        render_state_set_bind_group(&state, 0, hdr_tonemap_bind_group);
         // no vertex buffer, just plain drawing
-        wgpuRenderPassEncoderDraw(render_pass, 6, 1, 0, 0);
+        render_state_draw(&state, 6, 1, 0);
 
         if (physics->debug_draw)
-            physics_debug_draw(&debug_ctx, physics, render_pass);
-
-        mat4s camera_projection =
-            glms_ortho(0.0, UI_VIEW_WIDTH, UI_VIEW_HEIGHT, 0.0, -1.0f, 1.0f);
-        mat4s camera_transform =
-            glms_look(GLMS_VEC3_ZERO, (vec3s){.x = 0.0, .y = 0.0, .z = -1.0},
-                      (vec3s){.x = 0.0, .y = 1.0, .z = 0.0});
-        mat4s camera = glms_mat4_mul(camera_projection, camera_transform);
+            physics_debug_draw(&debug_ctx, physics, &state);
 
-        wgpuRenderPassEncoderSetPipeline(render_pass,
-                                         graphics->shaders.forward.ui_sprite);
-        wgpuRenderPassEncoderSetBindGroup(render_pass, 0, sprite_bind_group, 0,
-                                          NULL);
-        wgpuRenderPassEncoderSetVertexBuffer(
-            render_pass, 0, graphics->quad_manager.buffer, 0, quad_buffer_size);
-        wgpuRenderPassEncoderSetIndexBuffer(render_pass,
-                                            graphics->quad_manager.index_buffer,
-                                            WGPUIndexFormat_Uint16, 0, 12);
-
-        layer_draw(&graphics->ui_layers.background, &camera, render_pass);
-
-        layer_draw(&graphics->ui_layers.middle, &camera, render_pass);
-
-        layer_draw(&graphics->ui_layers.foreground, &camera, render_pass);
+        render_queue_execute(queue, RenderPass_Screen, &state);
 
         // imgui is used for debug tools, so we want that to be on top of most
-        // of the game's ui
+        // of the game's ui. it sets its own state, so nothing can be drawn
+        // through `state` after this
         ImGui_ImplWGPU_RenderDrawData(igGetDrawData(), render_pass);
 
         wgpuRenderPassEncoderEnd(render_pass);
@@ -517,11 +664,6 @@ void graphics_render(Graphics *graphics, Physics *physics, Camera raw_camera)
     if (physics->debug_draw)
         physics_debug_draw_free(&debug_ctx);
 
-    wgpuBindGroupRelease(sprite_bind_group);
-    wgpuBindGroupRelease(light_bind_group);
-    wgpuBindGroupRelease(tilemap_bind_group);
-    wgpuBindGroupRelease(hdr_tonemap_bind_group);
-
     wgpuCommandBufferRelease(command_buffer);
     wgpuCommandEncoderRelease(command_encoder);
     wgpuTextureViewRelease(frame);
@@ -530,9 +672,13 @@ void graphics_render(Graphics *graphics, Physics *physics, Camera raw_camera)
 
 void graphics_free(Graphics *graphics)
 {
+    bind_group_cache_free(&graphics->bind_groups);
     quad_manager_free(&graphics->quad_manager);
     transform_manager_free(&graphics->transform_manager);
     texture_manager_free(&graphics->texture_manager);
+    sprite_batch_free(&graphics->sprite_batch);
+    sprite_animations_free(&graphics->sprite_animations);
+    render_queue_free(&graphics->render_queue);
 
     layer_free(&graphics->tilemap_layers.background);
     layer_free(&graphics->tilemap_layers.middle);
@@ -1,10 +1,16 @@
 #pragma once
 
+#include "graphics/bind_group_cache.h"
 #include "graphics/layer.h"
+#include "graphics/render_queue.h"
+#include "graphics/render_state.h"
+#include "graphics/sprite_animations.h"
+#include "graphics/sprite_batch.h"
 #include "graphics/tex_manager.h"
 #include "physics/physics.h"
 #include "settings.h"
 #include "transform_manager.h"
+#include "utility/time.h"
 #include "wgpu_resources.h"
 #include "quad_manager.h"
 #include "shaders.h"
@@ -27,6 +33,15 @@ typedef struct Graphics
     QuadManager quad_manager;
     TransformManager transform_manager;
     TextureManager texture_manager;
+    // goes up whenever the quad or transform manager's buffer gets remade
+    u32 buffer_generation;
+    // goes up every graphics_render
+    u64 frame;
+    // the `elapsed` passed to graphics_render in milliseconds, which animated
+    // tiles go by. it wraps around after about 50 days
+    u32 animation_time;
+
+    BindGroupCache bind_groups;
 
     WGPUSampler sampler;
     WGPUTexture color;
@@ -38,6 +53,9 @@ typedef struct Graphics
     WGPUTexture lit;
     WGPUTextureView lit_view;
 
+    // sprites and ui sprites get drawn a whole layer at a time
+    SpriteBatch sprite_batch;
+    SpriteAnimations sprite_animations;
     StandardLayers sprite_layers;
 
     // why is this separate from the sprite layers? well, layers are set up to
@@ -45,6 +63,19 @@ typedef struct Graphics
     // of pipeline + bind group changes we have to do.
     StandardLayers tilemap_layers;
 
+    // tilemaps and sprite layers get submitted here every frame, then sorted
+    // so the same pipelines and bind groups are drawn together
+    RenderQueue render_queue;
+    // how many state changes the last frame made (and skipped)
+    RenderStats render_stats;
+    // how many things were on screen last frame, out of how many there were
+    struct
+    {
+        CullStats sprites, ui, debug_shapes;
+        // see tilemap_render
+        CullStats tile_chunks, tiles;
+    } cull_stats;
+
     StandardLayers ui_layers;
 
     Layer lights;
@@ -56,7 +87,13 @@ typedef struct
 } Camera;
 
 void graphics_init(Graphics *graphics, SDL_Window *window, Settings *settings);
-void graphics_render(Graphics *graphics, Physics *physics, Camera camera);
+// `elapsed` is how long the game's been running, for anything animated on the
+// gpu
+void graphics_render(Graphics *graphics, Physics *physics, Camera camera,
+                     Duration elapsed);
+// what Graphics.animation_time will be for `elapsed`, so things timed on the
+// cpu can match what the gpu's doing
+u32 graphics_animation_time(Duration elapsed);
 void graphics_free(Graphics *graphics);
 void graphics_resize(Graphics *graphics, int width, int height);
 QuadEntry graphics_screen_quad_entry(void);
@@ -2,6 +2,7 @@
 #include "sensible_nums.h"
 #include "utility/vec.h"
 #include <assert.h>
+#include <stdlib.h>
 
 typedef struct
 {
@@ -19,9 +20,32 @@ void layer_init(Layer *layer, thing_draw_fn draw)
     layer->next = 0;
 
     layer->draw = draw;
+    layer->batch = NULL;
+    layer->culling = NULL;
 }
 
-void layer_free(Layer *layer) { vec_free(&layer->entries); }
+void layer_init_batched(Layer *layer, thing_batch_fn batch)
+{
+    layer_init(layer, NULL);
+    layer->batch = batch;
+}
+
+void layer_enable_culling(Layer *layer, thing_cull_keys_fn keys)
+{
+    assert(layer->entries.len == 0);
+    layer->culling = malloc(sizeof(LayerCulling));
+    layer_culling_init(layer->culling, keys, CULL_CELL_SIZE);
+}
+
+void layer_free(Layer *layer)
+{
+    vec_free(&layer->entries);
+    if (layer->culling)
+    {
+        layer_culling_free(layer->culling);
+        free(layer->culling);
+    }
+}
 
 LayerEntry layer_add(Layer *layer, void *thing)
 {
@@ -49,6 +73,9 @@ LayerEntry layer_add(Layer *layer, void *thing)
         entry->entry = thing;
     }
 
+    if (layer->culling)
+        layer_culling_add(layer->culling, key, thing);
+
     return key;
 }
 
@@ -61,9 +88,12 @@ void layer_remove(Layer *layer, LayerEntry entry)
     data->entry = (void *)LAYER_ENTRY_FREE;
     data->next = layer->next;
     layer->next = entry;
+
+    if (layer->culling)
+        layer_culling_remove(layer->culling, entry);
 }
 
-void layer_draw(Layer *layer, void *context, WGPURenderPassEncoder pass)
+void layer_draw(Layer *layer, void *context, RenderState *state)
 {
     for (usize i = 0; i < layer->entries.len; i++)
     {
@@ -71,6 +101,37 @@ void layer_draw(Layer *layer, void *context, WGPURenderPassEncoder pass)
         if ((usize)data->entry == LAYER_ENTRY_FREE)
             continue;
         if (layer->draw)
-            layer->draw(data->entry, context, pass);
+            layer->draw(data->entry, context, state);
+    }
+}
+
+void layer_batch(Layer *layer, void *batch)
+{
+    for (usize i = 0; i < layer->entries.len; i++)
+    {
+        LayerEntryData *data = vec_get(&layer->entries, i);
+        if ((usize)data->entry == LAYER_ENTRY_FREE)
+            continue;
+        if (layer->batch)
+            layer->batch(data->entry, batch);
+    }
+}
+
+void layer_batch_visible(Layer *layer, void *batch, CullView view,
+                         CullStats *stats)
+{
+    // not culled, so it doesn't count towards the stats
+    if (!layer->culling)
+    {
+        layer_batch(layer, batch);
+        return;
+    }
+
+    layer_culling_query(layer->culling, view, stats);
+    LayerEntry *visible = (LayerEntry *)layer->culling->visible.data;
+    for (usize i = 0; i < layer->culling->visible.len; i++)
+    {
+        LayerEntryData *data = vec_get(&layer->entries, visible[i]);
+        layer->batch(data->entry, batch);
     }
 }
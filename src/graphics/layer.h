@@ -1,14 +1,18 @@
 #pragma once
 
 #include <wgpu.h>
+#include "graphics/culling.h"
+#include "graphics/render_state.h"
 #include "sensible_nums.h"
 #include "utility/vec.h"
 
 typedef struct Graphics Graphics;
 
 // called to render one thing.
-typedef void (*thing_draw_fn)(void *this, void *ctx,
-                              WGPURenderPassEncoder pass);
+typedef void (*thing_draw_fn)(void *this, void *ctx, RenderState *state);
+// called to add one thing to a batch that gets drawn all at once (e.g. a
+// SpriteBatch), instead of drawing it straight away.
+typedef void (*thing_batch_fn)(void *this, void *batch);
 
 // holds a bundle of one type of thing.
 // this is so we can minimize the amount of pipeline + bind group changes we
@@ -19,6 +23,10 @@ typedef struct
     u32 next;
 
     thing_draw_fn draw;
+    thing_batch_fn batch;
+
+    // NULL unless layer_enable_culling was called
+    LayerCulling *culling;
 } Layer;
 
 // we store pointers to things in the layer so a u32 for ENTRY_FREE won't cut
@@ -27,9 +35,22 @@ typedef struct
 typedef u32 LayerEntry;
 
 void layer_init(Layer *layer, thing_draw_fn draw);
+// for layers where everything gets batched rather than drawn one at a time
+void layer_init_batched(Layer *layer, thing_batch_fn batch);
+// lets layer_batch_visible skip things that aren't on screen (see culling.h).
+// call before adding anything
+void layer_enable_culling(Layer *layer, thing_cull_keys_fn keys);
 void layer_free(Layer *layer);
 
 LayerEntry layer_add(Layer *layer, void *thing);
 void layer_remove(Layer *layer, LayerEntry entry);
 
-void layer_draw(Layer *layer, void *ctx, WGPURenderPassEncoder pass);
+void layer_draw(Layer *layer, void *ctx, RenderState *state);
+// adds everything in the layer to `batch`, in the same order layer_draw would
+// draw them
+void layer_batch(Layer *layer, void *batch);
+// same as layer_batch, but only adds what's on screen if the layer is culled.
+// layer_culling_refresh needs to have been called this frame, and `stats` only
+// counts culled layers
+void layer_batch_visible(Layer *layer, void *batch, CullView view,
+                         CullStats *stats);
@@ -4,7 +4,7 @@
 #include "graphics/shaders.h"
 #include "utility/common_defines.h"
 
-void light_render(Light *light, WGPURenderPassEncoder pass, Camera camera)
+void light_render(Light *light, RenderState *state, Camera camera)
 {
     switch (light->type)
     {
@@ -33,10 +33,9 @@ void light_render(Light *light, WGPURenderPassEncoder pass, Camera camera)
         if (rect_width(clipped_rect) == 0 || rect_height(clipped_rect) == 0)
             return;
 
-        wgpuRenderPassEncoderSetPushConstants(
-            pass, WGPUShaderStage_Fragment | WGPUShaderStage_Vertex, 0,
-            sizeof(PointLightPushConstants), &push_constants);
-        wgpuRenderPassEncoderDraw(pass, VERTICES_PER_QUAD, 1, 0, 0);
+        render_state_set_push_constants(state, sizeof(PointLightPushConstants),
+                                        &push_constants);
+        render_state_draw(state, VERTICES_PER_QUAD, 1, 0);
 
         break;
     }
@@ -48,10 +47,9 @@ void light_render(Light *light, WGPURenderPassEncoder pass, Camera camera)
             .volumetric_intensity = light->volumetric_intensity,
         };
 
-        wgpuRenderPassEncoderSetPushConstants(
-            pass, WGPUShaderStage_Fragment | WGPUShaderStage_Vertex, 0,
-            sizeof(DirectLightPushConstants), &push_constants);
-        wgpuRenderPassEncoderDraw(pass, VERTICES_PER_QUAD, 1, 0, 0);
+        render_state_set_push_constants(state, sizeof(DirectLightPushConstants),
+                                        &push_constants);
+        render_state_draw(state, VERTICES_PER_QUAD, 1, 0);
 
         break;
     }
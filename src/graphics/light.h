@@ -28,4 +28,4 @@ typedef struct
     f32 volumetric_intensity;
 } Light;
 
-void light_render(Light *light, WGPURenderPassEncoder pass, Camera camera);
+void light_render(Light *light, RenderState *state, Camera camera);
@@ -30,7 +30,10 @@ void quad_manager_init(QuadManager *manager, WGPUResources *resources)
 {
     WGPUBufferDescriptor buffer_desc = {
         .size = INITIAL_BUFFER_SIZE,
-        .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
+        // sprites read it as a storage buffer, debug drawing uses it as a
+        // vertex buffer
+        .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex |
+                 WGPUBufferUsage_Storage,
         .label = "quad manager buffer",
     };
     manager->buffer = wgpuDeviceCreateBuffer(resources->device, &buffer_desc);
@@ -129,10 +132,10 @@ Quad quad_manager_get(QuadManager *manager, QuadEntry entry)
 
 // ---  ---
 
-void quad_manager_upload_dirty(QuadManager *manager, WGPUResources *resources)
+bool quad_manager_upload_dirty(QuadManager *manager, WGPUResources *resources)
 {
     if (manager->dirty_entries.len == 0)
-        return;
+        return false;
 
     u32 buffer_size = wgpuBufferGetSize(manager->buffer);
     bool needs_regen =
@@ -148,7 +151,8 @@ void quad_manager_upload_dirty(QuadManager *manager, WGPUResources *resources)
             // length, which would work
             // but would require more resizing operations.
             .size = manager->entries.cap * sizeof(QuadEntryData),
-            .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
+            .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex |
+                     WGPUBufferUsage_Storage,
             .label = "quad manager buffer",
         };
         manager->buffer =
@@ -160,7 +164,7 @@ void quad_manager_upload_dirty(QuadManager *manager, WGPUResources *resources)
                              manager->entries.len * sizeof(QuadEntryData));
         hashset_clear(&manager->dirty_entries);
 
-        return;
+        return true;
     }
 
     // write all the dirty entries to the buffer
@@ -183,4 +187,6 @@ void quad_manager_upload_dirty(QuadManager *manager, WGPUResources *resources)
 
     // clear the dirty set
     hashset_clear(&manager->dirty_entries);
+
+    return false;
 }
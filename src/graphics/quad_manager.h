@@ -34,4 +34,5 @@ void quad_manager_update(QuadManager *manager, QuadEntry entry, Quad quad);
 Quad quad_manager_get(QuadManager *manager, QuadEntry entry);
 
 // call before using for rendering
-void quad_manager_upload_dirty(QuadManager *manager, WGPUResources *resources);
+// returns true if the buffer was regenerated
+bool quad_manager_upload_dirty(QuadManager *manager, WGPUResources *resources);
@@ -0,0 +1,99 @@
+#include "render_queue.h"
+#include <string.h>
+
+void render_queue_init(RenderQueue *queue)
+{
+    vec_init(&queue->items, sizeof(RenderItem));
+    vec_init(&queue->sorted, sizeof(RenderSortEntry));
+    vec_init(&queue->scratch, sizeof(RenderSortEntry));
+}
+
+void render_queue_free(RenderQueue *queue)
+{
+    vec_free(&queue->items);
+    vec_free(&queue->sorted);
+    vec_free(&queue->scratch);
+}
+
+void render_queue_clear(RenderQueue *queue)
+{
+    vec_clear(&queue->items);
+    vec_clear(&queue->sorted);
+}
+
+void render_queue_push(RenderQueue *queue, RenderItem *item)
+{
+    RenderSortEntry entry = {.key = item->key, .item = queue->items.len};
+    vec_push(&queue->items, item);
+    vec_push(&queue->sorted, &entry);
+}
+
+// lsd radix sort, a byte at a time. bytes that are the same in every key
+// (most of them, since there's only a couple passes and layers) get skipped
+void render_sort_entries(RenderSortEntry *entries, RenderSortEntry *scratch,
+                         u32 count)
+{
+    RenderSortEntry *from = entries;
+    RenderSortEntry *to = scratch;
+
+    for (u32 shift = 0; shift < 64; shift += 8)
+    {
+        u32 counts[256] = {0};
+        for (u32 i = 0; i < count; i++)
+            counts[(from[i].key >> shift) & 0xFF]++;
+
+        // everything's in the same bucket, so this byte wouldn't move anything
+        if (count == 0 || counts[(from[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        u32 offset = 0;
+        for (u32 i = 0; i < 256; i++)
+        {
+            u32 bucket = counts[i];
+            counts[i] = offset;
+            offset += bucket;
+        }
+
+        for (u32 i = 0; i < count; i++)
+            to[counts[(from[i].key >> shift) & 0xFF]++] = from[i];
+
+        RenderSortEntry *swap = from;
+        from = to;
+        to = swap;
+    }
+
+    if (from != entries)
+        memcpy(entries, from, count * sizeof(RenderSortEntry));
+}
+
+void render_queue_sort(RenderQueue *queue)
+{
+    if (queue->scratch.cap < queue->sorted.len)
+        vec_resize(&queue->scratch, queue->sorted.len);
+
+    render_sort_entries((RenderSortEntry *)queue->sorted.data,
+                        (RenderSortEntry *)queue->scratch.data,
+                        queue->sorted.len);
+}
+
+void render_queue_execute(RenderQueue *queue, RenderPassId pass,
+                          RenderState *state)
+{
+    RenderSortEntry *sorted = (RenderSortEntry *)queue->sorted.data;
+    RenderItem *items = (RenderItem *)queue->items.data;
+
+    for (u32 i = 0; i < queue->sorted.len; i++)
+    {
+        // passes are the top bits, so each pass is one run of the queue
+        u64 item_pass = sorted[i].key >> 60;
+        if (item_pass < pass)
+            continue;
+        if (item_pass > pass)
+            break;
+
+        RenderItem *item = &items[sorted[i].item];
+        render_state_set_pipeline(state, item->pipeline);
+        render_state_set_bind_group(state, 0, item->bind_group);
+        item->draw(item->thing, item->ctx, state);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <wgpu.h>
+#include "graphics/render_state.h"
+#include "sensible_nums.h"
+#include "utility/vec.h"
+
+// instead of drawing things as soon as we get to them, things that need
+// drawing get put in a queue with a sort key, the queue gets sorted, and then
+// everything gets drawn in key order. things that need the same pipeline and
+// bind group end up next to each other, so the RenderState can skip setting
+// them again.
+//
+// keys are (from most to least significant):
+//   pass (4 bits) | layer (4) | pipeline (8) | bind group (8) | texture (16) |
+//   depth (24)
+// the sort is stable, so things with the same key are drawn in the order they
+// were submitted.
+
+typedef enum
+{
+    RenderPass_Deferred,
+    RenderPass_Screen,
+} RenderPassId;
+
+// what order pipelines get drawn in on the same layer
+typedef enum
+{
+    RenderPipeline_Tilemap,
+    RenderPipeline_Sprite,
+    RenderPipeline_UiSprite,
+} RenderPipelineId;
+
+typedef struct
+{
+    u8 pass;       // RenderPassId
+    u8 layer;      // e.g. background/middle/foreground
+    u8 pipeline;   // RenderPipelineId
+    u8 bind_group; // only matters when there's more than one per pipeline
+    // things that overlap need drawing in a set order, so only use this for
+    // things where order doesn't matter. depth is below it
+    u16 texture;
+    u32 depth; // only 24 bits are used
+} RenderKey;
+
+static inline u64 render_key_pack(RenderKey key)
+{
+    return ((u64)(key.pass & 0xF) << 60) | ((u64)(key.layer & 0xF) << 56) |
+           ((u64)key.pipeline << 48) | ((u64)key.bind_group << 40) |
+           ((u64)key.texture << 24) | (key.depth & 0xFFFFFF);
+}
+
+// sets push constants and draws. pipeline and bind group 0 are already set
+typedef void (*render_item_fn)(void *thing, void *ctx, RenderState *state);
+
+typedef struct
+{
+    u64 key;
+    WGPURenderPipeline pipeline;
+    WGPUBindGroup bind_group;
+
+    render_item_fn draw;
+    void *thing;
+    void *ctx;
+} RenderItem;
+
+typedef struct
+{
+    u64 key;
+    u32 item;
+} RenderSortEntry;
+
+typedef struct
+{
+    vec items;   // vec<RenderItem>, in submission order
+    vec sorted;  // vec<RenderSortEntry>, in key order after render_queue_sort
+    vec scratch; // vec<RenderSortEntry>, for the radix sort
+} RenderQueue;
+
+void render_queue_init(RenderQueue *queue);
+void render_queue_free(RenderQueue *queue);
+
+// throws away every item
+void render_queue_clear(RenderQueue *queue);
+void render_queue_push(RenderQueue *queue, RenderItem *item);
+
+void render_queue_sort(RenderQueue *queue);
+// draws every item in `pass` (the queue needs to be sorted first)
+void render_queue_execute(RenderQueue *queue, RenderPassId pass,
+                          RenderState *state);
+
+// sorts `count` entries by key with a radix sort. `scratch` needs room for
+// `count` entries too. entries with the same key stay in the same order
+void render_sort_entries(RenderSortEntry *entries, RenderSortEntry *scratch,
+                         u32 count);
@@ -0,0 +1,108 @@
+#include "render_state.h"
+#include "webgpu.h"
+#include <assert.h>
+#include <string.h>
+
+void render_state_begin(RenderState *state, WGPURenderPassEncoder pass,
+                        RenderStats *stats)
+{
+    memset(state, 0, sizeof(RenderState));
+    state->pass = pass;
+    state->stats = stats;
+}
+
+void render_state_set_pipeline(RenderState *state, WGPURenderPipeline pipeline)
+{
+    if (state->pipeline == pipeline)
+    {
+        state->stats->pipelines_skipped++;
+        return;
+    }
+
+    wgpuRenderPassEncoderSetPipeline(state->pass, pipeline);
+    state->pipeline = pipeline;
+    state->stats->pipelines++;
+}
+
+void render_state_set_bind_group(RenderState *state, u32 index,
+                                 WGPUBindGroup bind_group)
+{
+    assert(index < RENDER_STATE_BIND_GROUPS);
+    if (state->bind_groups[index] == bind_group)
+    {
+        state->stats->bind_groups_skipped++;
+        return;
+    }
+
+    wgpuRenderPassEncoderSetBindGroup(state->pass, index, bind_group, 0, NULL);
+    state->bind_groups[index] = bind_group;
+    state->stats->bind_groups++;
+}
+
+static bool same_buffer(BoundBuffer *bound, WGPUBuffer buffer, u64 offset,
+                        u64 size)
+{
+    return bound->buffer == buffer && bound->offset == offset &&
+           bound->size == size;
+}
+
+void render_state_set_vertex_buffer(RenderState *state, u32 slot,
+                                    WGPUBuffer buffer, u64 offset, u64 size)
+{
+    assert(slot < RENDER_STATE_VERTEX_BUFFERS);
+    BoundBuffer *bound = &state->vertex_buffers[slot];
+    if (same_buffer(bound, buffer, offset, size))
+    {
+        state->stats->vertex_buffers_skipped++;
+        return;
+    }
+
+    wgpuRenderPassEncoderSetVertexBuffer(state->pass, slot, buffer, offset,
+                                         size);
+    *bound = (BoundBuffer){.buffer = buffer, .offset = offset, .size = size};
+    state->stats->vertex_buffers++;
+}
+
+void render_state_set_index_buffer(RenderState *state, WGPUBuffer buffer,
+                                   WGPUIndexFormat format, u64 offset,
+                                   u64 size)
+{
+    if (same_buffer(&state->index_buffer, buffer, offset, size) &&
+        state->index_format == format)
+    {
+        state->stats->index_buffers_skipped++;
+        return;
+    }
+
+    wgpuRenderPassEncoderSetIndexBuffer(state->pass, buffer, format, offset,
+                                        size);
+    state->index_buffer =
+        (BoundBuffer){.buffer = buffer, .offset = offset, .size = size};
+    state->index_format = format;
+    state->stats->index_buffers++;
+}
+
+void render_state_set_push_constants(RenderState *state, u32 size,
+                                     const void *data)
+{
+    wgpuRenderPassEncoderSetPushConstants(
+        state->pass, WGPUShaderStage_Vertex | WGPUShaderStage_Fragment, 0, size,
+        data);
+}
+
+void render_state_draw(RenderState *state, u32 vertex_count,
+                       u32 instance_count, u32 first_instance)
+{
+    wgpuRenderPassEncoderDraw(state->pass, vertex_count, instance_count, 0,
+                              first_instance);
+    state->stats->draws++;
+}
+
+void render_state_draw_indexed(RenderState *state, u32 index_count,
+                               u32 instance_count, u32 first_index,
+                               i32 base_vertex)
+{
+    wgpuRenderPassEncoderDrawIndexed(state->pass, index_count, instance_count,
+                                     first_index, base_vertex, 0);
+    state->stats->draws++;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <wgpu.h>
+#include <stdbool.h>
+#include "sensible_nums.h"
+
+// wraps a render pass and remembers what's bound, so setting something that's
+// already set doesn't reach wgpu. everything that draws should go through
+// this rather than calling wgpuRenderPassEncoderSet* itself, otherwise the
+// tracker won't know things changed.
+//
+// bind groups stay bound across pipeline changes (they only need to be
+// compatible with the pipeline when drawing), so changing pipeline doesn't
+// forget them.
+
+#define RENDER_STATE_BIND_GROUPS 4
+#define RENDER_STATE_VERTEX_BUFFERS 2
+
+typedef struct
+{
+    // how many of each set call went through to wgpu
+    u32 pipelines, bind_groups, vertex_buffers, index_buffers;
+    // and how many were skipped, since it was already set
+    u32 pipelines_skipped, bind_groups_skipped, vertex_buffers_skipped,
+        index_buffers_skipped;
+    u32 draws;
+} RenderStats;
+
+typedef struct
+{
+    WGPUBuffer buffer;
+    u64 offset, size;
+} BoundBuffer;
+
+typedef struct
+{
+    WGPURenderPassEncoder pass;
+    RenderStats *stats;
+
+    WGPURenderPipeline pipeline;
+    WGPUBindGroup bind_groups[RENDER_STATE_BIND_GROUPS];
+    BoundBuffer vertex_buffers[RENDER_STATE_VERTEX_BUFFERS];
+    BoundBuffer index_buffer;
+    WGPUIndexFormat index_format;
+} RenderState;
+
+// nothing is bound at the start of a pass. `stats` is added to as things get
+// set and drawn
+void render_state_begin(RenderState *state, WGPURenderPassEncoder pass,
+                        RenderStats *stats);
+
+void render_state_set_pipeline(RenderState *state,
+                               WGPURenderPipeline pipeline);
+void render_state_set_bind_group(RenderState *state, u32 index,
+                                 WGPUBindGroup bind_group);
+void render_state_set_vertex_buffer(RenderState *state, u32 slot,
+                                    WGPUBuffer buffer, u64 offset, u64 size);
+void render_state_set_index_buffer(RenderState *state, WGPUBuffer buffer,
+                                   WGPUIndexFormat format, u64 offset,
+                                   u64 size);
+
+// push constants aren't tracked, since they're different for nearly every draw
+void render_state_set_push_constants(RenderState *state, u32 size,
+                                     const void *data);
+
+void render_state_draw(RenderState *state, u32 vertex_count,
+                       u32 instance_count, u32 first_instance);
+void render_state_draw_indexed(RenderState *state, u32 index_count,
+                               u32 instance_count, u32 first_index,
+                               i32 base_vertex);
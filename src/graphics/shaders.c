@@ -1,6 +1,8 @@
 #include "shaders.h"
 #include "core_types.h"
 #include "graphics/bind_group_layouts.h"
+#include "graphics/sprite_batch.h"
+#include "graphics/tilemap_chunks.h"
 #include "graphics/wgpu_resources.h"
 #include "sensible_nums.h"
 #include "utility/macros.h"
@@ -8,6 +10,7 @@
 #include "webgpu.h"
 
 #include <wgpu.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <libgen.h>
 
@@ -130,6 +133,42 @@ void shaders_init(Shaders *shaders, BindGroupLayouts *layouts,
         .attributeCount = 2,
         .attributes = quad_vertex_attributes};
 
+    // vertex layout for batched sprites. the quad itself comes from the quad
+    // buffer, this is just what's different for each sprite
+    WGPUVertexAttribute sprite_instance_attributes[] = {
+        (WGPUVertexAttribute){
+            // transform, texture and quad index
+            .format = WGPUVertexFormat_Uint32x3,
+            .offset = offsetof(SpriteInstance, transform_index),
+            .shaderLocation = 0,
+        },
+        (WGPUVertexAttribute){
+            .format = WGPUVertexFormat_Float32,
+            .offset = offsetof(SpriteInstance, opacity),
+            .shaderLocation = 1,
+        },
+        (WGPUVertexAttribute){
+            .format = WGPUVertexFormat_Float32x2,
+            .offset = offsetof(SpriteInstance, parallax),
+            .shaderLocation = 2,
+        },
+        (WGPUVertexAttribute){
+            // animation and when it started
+            .format = WGPUVertexFormat_Uint32x2,
+            .offset = offsetof(SpriteInstance, animation),
+            .shaderLocation = 3,
+        },
+        (WGPUVertexAttribute){
+            .format = WGPUVertexFormat_Float32,
+            .offset = offsetof(SpriteInstance, animation_speed),
+            .shaderLocation = 4,
+        }};
+    WGPUVertexBufferLayout sprite_instance_buffer_layout = {
+        .arrayStride = sizeof(SpriteInstance),
+        .stepMode = WGPUVertexStepMode_Instance,
+        .attributeCount = 5,
+        .attributes = sprite_instance_attributes};
+
     // color targets used for defferred rendering
     WGPUColorTargetState defferred_targets[] = {(WGPUColorTargetState){
         .format = WGPUTextureFormat_RGBA8Unorm,
@@ -183,32 +222,35 @@ void shaders_init(Shaders *shaders, BindGroupLayouts *layouts,
         PUSH_CONSTANTS_FOR(SpritePushConstants);
     shaders->defferred.sprite =
         create_shader("assets/shaders/sprite.wgsl", "sprite", &layouts->sprite,
-                      1, sprite_constants, 1, &quad_vertex_buffer_layout, 1,
-                      defferred_targets, 1, NULL, NULL, resources);
+                      1, sprite_constants, 1, &sprite_instance_buffer_layout,
+                      1, defferred_targets, 1, NULL, NULL, resources);
 
-    WGPUPushConstantRange ui_sprite_constants[] =
-        PUSH_CONSTANTS_FOR(UiSpritePushConstants);
     shaders->forward.ui_sprite = create_shader(
         "assets/shaders/ui_sprite.wgsl", "ui_sprite", &layouts->sprite, 1,
-        ui_sprite_constants, 1, &quad_vertex_buffer_layout, 1,
+        sprite_constants, 1, &sprite_instance_buffer_layout, 1,
         alpha_surface_targets, 1, NULL, NULL, resources);
 
-    WGPUVertexAttribute tilemap_vertex_attributes[] = {(WGPUVertexAttribute){
-        .format = WGPUVertexFormat_Sint32,
-        .offset = 0,
-        .shaderLocation = 0,
-    }};
+    // the whole tile is packed into one u32 (see tilemap_chunks.h)
+    WGPUVertexAttribute tilemap_vertex_attributes[] = {
+        (WGPUVertexAttribute){
+            .format = WGPUVertexFormat_Uint32,
+            .offset = 0,
+            .shaderLocation = 0,
+        },
+    };
     WGPUVertexBufferLayout tilemap_vertex_buffer_layout = {
-        .arrayStride = sizeof(u32),
+        .arrayStride = sizeof(TilemapTile),
         .stepMode = WGPUVertexStepMode_Instance,
         .attributeCount = 1,
         .attributes = tilemap_vertex_attributes,
     };
     WGPUPushConstantRange tilemap_constants[] =
         PUSH_CONSTANTS_FOR(TilemapPushConstants);
+    WGPUBindGroupLayout tilemap_layouts[] = {layouts->sprite,
+                                             layouts->tilemap};
 
     shaders->defferred.tilemap = create_shader(
-        "assets/shaders/tilemap.wgsl", "tilemap", &layouts->tilemap, 1,
+        "assets/shaders/tilemap.wgsl", "tilemap", tilemap_layouts, 2,
         tilemap_constants, 1, &tilemap_vertex_buffer_layout, 1,
         defferred_targets, 1, NULL, NULL, resources);
 
@@ -61,11 +61,15 @@ typedef struct
     u32 solid;
 } B2DDrawPolygonPushConstants;
 
+// used by both sprites and ui sprites. everything per sprite is in a
+// SpriteInstance
 typedef struct
 {
     mat4s camera;
-    u32 transform_index;
-    u32 texture_index;
+    // sprites with parallax get moved by part of this
+    vec2s camera_position;
+    // see Graphics.animation_time
+    u32 time;
 } SpritePushConstants;
 
 typedef struct
@@ -73,15 +77,10 @@ typedef struct
     mat4s camera;
     u32 transform_index;
     u32 texture_index;
-    f32 opacity;
-} UiSpritePushConstants;
-
-typedef struct
-{
-    mat4s camera;
-    u32 transform_index;
-    u32 texture_index;
-    u32 map_width;
+    // the chunk being drawn, in tiles
+    u32 chunk_x, chunk_y;
+    // see Graphics.animation_time
+    u32 time;
 } TilemapPushConstants;
 
 typedef struct
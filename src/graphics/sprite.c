@@ -1,6 +1,7 @@
 #include "sprite.h"
 #include "core_types.h"
 #include "graphics/quad_manager.h"
+#include "graphics/sprite_batch.h"
 
 void sprite_init(Sprite *sprite, TextureEntry *texture,
                  TransformEntry transform, QuadEntry quad)
@@ -10,6 +11,7 @@ void sprite_init(Sprite *sprite, TextureEntry *texture,
     sprite->quad = quad;
 
     sprite->parallax_factor = (vec2s){.x = 1.0, .y = 1.0};
+    sprite_stop_animation(sprite);
 }
 
 void sprite_free(Sprite *sprite, Graphics *graphics)
@@ -19,19 +21,41 @@ void sprite_free(Sprite *sprite, Graphics *graphics)
     texture_manager_unload(&graphics->texture_manager, sprite->texture);
 }
 
-void sprite_render(Sprite *sprite, mat4s camera, WGPURenderPassEncoder pass)
+void sprite_play_animation(Sprite *sprite, AnimationType type, u32 start,
+                           f32 speed)
 {
+    sprite->animation = type + 1;
+    sprite->animation_start = start;
+    sprite->animation_speed = speed;
+}
 
-    SpritePushConstants push_constants = {
-        .camera = camera,
-        .texture_index = sprite->texture->index,
+void sprite_stop_animation(Sprite *sprite)
+{
+    sprite->animation = 0;
+    sprite->animation_start = 0;
+    sprite->animation_speed = 1.0;
+}
+
+void sprite_batch_thing(void *thing, void *batch)
+{
+    Sprite *sprite = thing;
+    SpriteInstance instance = {
         .transform_index = sprite->transform,
+        .texture_index = sprite->texture->index,
+        .quad_index = sprite->quad,
+        .opacity = 1.0,
+        .parallax = sprite->parallax_factor,
+        .animation = sprite->animation,
+        .animation_start = sprite->animation_start,
+        .animation_speed = sprite->animation_speed,
     };
+    vec_push(batch, &instance);
+}
 
-    wgpuRenderPassEncoderSetPushConstants(
-        pass, WGPUShaderStage_Fragment | WGPUShaderStage_Vertex, 0,
-        sizeof(SpritePushConstants), &push_constants);
-    wgpuRenderPassEncoderDrawIndexed(pass, VERTICES_PER_QUAD, 1, 0,
-                                     QUAD_ENTRY_TO_VERTEX_INDEX(sprite->quad),
-                                     0);
+void sprite_cull_keys(void *thing, CullKeys *keys)
+{
+    Sprite *sprite = thing;
+    keys->transform = sprite->transform;
+    keys->quad = sprite->quad;
+    keys->parallax = sprite->parallax_factor;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "animation/definition.h"
 #include "graphics.h"
 
 typedef struct
@@ -9,10 +10,25 @@ typedef struct
     QuadEntry quad;
 
     vec2s parallax_factor;
+
+    // see SpriteInstance.animation
+    u32 animation;
+    u32 animation_start;
+    f32 animation_speed;
 } Sprite;
 
 void sprite_init(Sprite *sprite, TextureEntry *texture,
                  TransformEntry transform, QuadEntry quad);
 void sprite_free(Sprite *sprite, Graphics *graphics);
 
-void sprite_render(Sprite *sprite, mat4s camera, WGPURenderPassEncoder pass);
+// plays an animation entirely on the gpu, from `start` (in
+// Graphics.animation_time). the quad's tex coords should be 0 to 1, and they
+// get mapped onto the animation's cells
+void sprite_play_animation(Sprite *sprite, AnimationType type, u32 start,
+                           f32 speed);
+void sprite_stop_animation(Sprite *sprite);
+
+// adds a sprite to a vec<SpriteInstance> (see layer_init_batched)
+void sprite_batch_thing(void *thing, void *batch);
+// for culling sprite layers (see layer_enable_culling)
+void sprite_cull_keys(void *thing, CullKeys *keys);
@@ -0,0 +1,58 @@
+#include "sprite_animations.h"
+#include "animation/definition.h"
+#include "graphics/binding_helper.h"
+#include "webgpu.h"
+
+void sprite_animations_build(vec *animations, vec *frames)
+{
+    vec_clear(animations);
+    vec_clear(frames);
+    for (AnimationType type = 0; type < animation_defs_count(); type++)
+    {
+        CompiledAnimation *compiled = animation_get(type);
+        const AnimationDef *def = compiled->def;
+        SpriteAnimation animation = {
+            .first = frames->len,
+            .count = def->frame_count,
+            .cell_width = def->cell_width,
+            .cell_height = def->cell_height,
+            .duration = compiled->duration,
+            .looping = def->looping,
+        };
+        vec_push(animations, &animation);
+
+        for (u32 i = 0; i < def->frame_count; i++)
+        {
+            SpriteAnimationFrame frame = {
+                .cell = def->frames[i].cell,
+                .end = compiled->frame_ends[i],
+            };
+            vec_push(frames, &frame);
+        }
+    }
+}
+
+void sprite_animations_init(SpriteAnimations *animations,
+                            WGPUResources *resources)
+{
+    vec table, frames;
+    vec_init(&table, sizeof(SpriteAnimation));
+    vec_init(&frames, sizeof(SpriteAnimationFrame));
+    sprite_animations_build(&table, &frames);
+
+    animations->animations =
+        storage_buffer_from_vec(&table, resources->device, resources->queue,
+                                "sprite animation table");
+    animations->frames =
+        storage_buffer_from_vec(&frames, resources->device, resources->queue,
+                                "sprite animation frames");
+
+    vec_free(&table);
+    vec_free(&frames);
+}
+
+void sprite_animations_free(SpriteAnimations *animations)
+{
+    wgpuBufferRelease(animations->animations);
+    wgpuBufferRelease(animations->frames);
+}
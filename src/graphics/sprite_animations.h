@@ -0,0 +1,43 @@
+#pragma once
+
+#include <wgpu.h>
+#include "graphics/wgpu_resources.h"
+#include "sensible_nums.h"
+#include "utility/vec.h"
+
+// every AnimationDef, uploaded once so sprite.wgsl can work out which frame an
+// animated sprite is on by itself. sprites only need to say which animation
+// they're playing and when it started (see SpriteInstance), so nothing gets
+// uploaded as they play.
+
+// laid out like SpriteAnimation in sprite.wgsl
+typedef struct
+{
+    // the frames are [first, first + count) in the frame table
+    u32 first, count;
+    u32 cell_width, cell_height;
+    // in milliseconds
+    u32 duration;
+    u32 looping;
+} SpriteAnimation;
+
+typedef struct
+{
+    u32 cell;
+    // see animation_frame_end
+    u32 end;
+} SpriteAnimationFrame;
+
+typedef struct
+{
+    WGPUBuffer animations; // one SpriteAnimation per AnimationType
+    WGPUBuffer frames;     // SpriteAnimationFrames
+} SpriteAnimations;
+
+void sprite_animations_init(SpriteAnimations *animations,
+                            WGPUResources *resources);
+void sprite_animations_free(SpriteAnimations *animations);
+
+// fills `animations` (a vec<SpriteAnimation>) and `frames` (a
+// vec<SpriteAnimationFrame>) from every compiled animation, indexed by type
+void sprite_animations_build(vec *animations, vec *frames);
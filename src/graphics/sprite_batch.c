@@ -0,0 +1,86 @@
+#include "sprite_batch.h"
+#include "core_types.h"
+#include "webgpu.h"
+
+#define INITIAL_INSTANCE_CAP 256
+
+static WGPUBuffer create_buffer(WGPUResources *resources, usize cap)
+{
+    WGPUBufferDescriptor buffer_desc = {
+        .size = cap * sizeof(SpriteInstance),
+        .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
+        .label = "sprite instance buffer",
+    };
+    return wgpuDeviceCreateBuffer(resources->device, &buffer_desc);
+}
+
+void sprite_batch_init(SpriteBatch *batch, WGPUResources *resources)
+{
+    vec_init_with_capacity(&batch->instances, sizeof(SpriteInstance),
+                           INITIAL_INSTANCE_CAP);
+    batch->buffer = create_buffer(resources, INITIAL_INSTANCE_CAP);
+
+    batch->sprites = 0;
+    batch->draw_calls = 0;
+    batch->last_sprites = 0;
+    batch->last_draw_calls = 0;
+}
+
+void sprite_batch_free(SpriteBatch *batch)
+{
+    wgpuBufferRelease(batch->buffer);
+    vec_free(&batch->instances);
+}
+
+void sprite_batch_begin(SpriteBatch *batch)
+{
+    batch->last_sprites = batch->sprites;
+    batch->last_draw_calls = batch->draw_calls;
+    batch->sprites = 0;
+    batch->draw_calls = 0;
+
+    vec_clear(&batch->instances);
+}
+
+SpriteBatchRange sprite_batch_add_layer(SpriteBatch *batch, Layer *layer,
+                                        CullView view, CullStats *stats)
+{
+    SpriteBatchRange range = {.first = batch->instances.len};
+    layer_batch_visible(layer, &batch->instances, view, stats);
+    range.count = batch->instances.len - range.first;
+    batch->sprites += range.count;
+    return range;
+}
+
+void sprite_batch_upload(SpriteBatch *batch, WGPUResources *resources)
+{
+    if (batch->instances.len == 0)
+        return;
+
+    // same as the other managers, keep the buffer as big as the vec's capacity
+    // so it only gets remade when the vec grows
+    u64 buffer_size = wgpuBufferGetSize(batch->buffer);
+    if (batch->instances.cap * sizeof(SpriteInstance) > buffer_size)
+    {
+        wgpuBufferRelease(batch->buffer);
+        batch->buffer = create_buffer(resources, batch->instances.cap);
+    }
+
+    wgpuQueueWriteBuffer(resources->queue, batch->buffer, 0,
+                         batch->instances.data,
+                         batch->instances.len * sizeof(SpriteInstance));
+}
+
+void sprite_batch_draw(SpriteBatch *batch, SpriteBatchRange range,
+                       RenderState *state)
+{
+    if (range.count == 0)
+        return;
+
+    // every layer uses the same binding, so it's only set for the first one
+    render_state_set_vertex_buffer(
+        state, 0, batch->buffer, 0,
+        batch->instances.len * sizeof(SpriteInstance));
+    render_state_draw(state, VERTICES_PER_QUAD, range.count, range.first);
+    batch->draw_calls++;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <wgpu.h>
+#include <cglm/types-struct.h>
+#include "graphics/layer.h"
+#include "graphics/render_state.h"
+#include "graphics/wgpu_resources.h"
+#include "sensible_nums.h"
+#include "utility/vec.h"
+
+// sprites aren't drawn one at a time. instead, every frame each sprite layer
+// gets turned into a list of instances, all of them get uploaded at once, and
+// then each layer is drawn with a single instanced draw call. the shaders pull
+// the quad's corners out of the quad manager's buffer using quad_index.
+
+// what the gpu gets for each sprite (an instance vertex buffer)
+typedef struct
+{
+    u32 transform_index;
+    u32 texture_index;
+    u32 quad_index;
+    f32 opacity;
+    // how much the sprite moves with the camera (1 is normal)
+    vec2s parallax;
+    // 0 if the sprite isn't animated, otherwise its AnimationType + 1. the
+    // shader picks the frame (see sprite_animations.h), and the quad's tex
+    // coords go from 0 to 1 across the cell
+    u32 animation;
+    // when the animation started and how fast it's going. see
+    // Graphics.animation_time
+    u32 animation_start;
+    f32 animation_speed;
+} SpriteInstance;
+
+// where a layer's instances ended up, so it can be drawn later
+typedef struct
+{
+    u32 first;
+    u32 count;
+} SpriteBatchRange;
+
+typedef struct
+{
+    vec instances; // vec<SpriteInstance>, refilled every frame
+    WGPUBuffer buffer;
+
+    // for the debug window. draw calls are counted as they happen, so
+    // draw_calls is only complete once the frame is done
+    u32 sprites, draw_calls;
+    u32 last_sprites, last_draw_calls;
+} SpriteBatch;
+
+void sprite_batch_init(SpriteBatch *batch, WGPUResources *resources);
+void sprite_batch_free(SpriteBatch *batch);
+
+// throws away last frame's instances
+void sprite_batch_begin(SpriteBatch *batch);
+// adds every sprite in `layer` (which needs to be made with layer_init_batched)
+// that's on screen, if the layer is culled
+SpriteBatchRange sprite_batch_add_layer(SpriteBatch *batch, Layer *layer,
+                                        CullView view, CullStats *stats);
+// sends every instance to the gpu. call once everything's been added, and
+// before drawing anything
+void sprite_batch_upload(SpriteBatch *batch, WGPUResources *resources);
+// draws a layer's sprites with one draw call, using whatever pipeline and bind
+// group is set
+void sprite_batch_draw(SpriteBatch *batch, SpriteBatchRange range,
+                       RenderState *state);
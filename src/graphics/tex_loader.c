@@ -0,0 +1,213 @@
+#include "tex_loader.h"
+#include "utility/log.h"
+#include "utility/macros.h"
+#include <SDL3_image/SDL_image.h>
+#include <stdio.h>
+#include <string.h>
+
+void texture_loader_init(TextureLoader *loader)
+{
+    loader->lock = SDL_CreateMutex();
+    loader->queued = SDL_CreateCondition();
+    loader->finished = SDL_CreateCondition();
+    PTR_ERRCHK(loader->lock, "Failed to create texture loader lock");
+    PTR_ERRCHK(loader->queued, "Failed to create texture queue condition");
+    PTR_ERRCHK(loader->finished, "Failed to create texture decode condition");
+
+    vec_init(&loader->threads, sizeof(SDL_Thread *));
+    vec_init(&loader->queue, sizeof(TextureJob *));
+    vec_init(&loader->decoded, sizeof(TextureJob *));
+    loader->decoding = 0;
+    loader->quit = false;
+}
+
+void texture_job_free(TextureJob *job)
+{
+    if (job->surface)
+        SDL_DestroySurface(job->surface);
+    free(job->path);
+    free(job);
+}
+
+static void free_job(usize index, void *data)
+{
+    (void)index;
+    texture_job_free(*(TextureJob **)data);
+}
+
+void texture_loader_free(TextureLoader *loader)
+{
+    SDL_LockMutex(loader->lock);
+    loader->quit = true;
+    SDL_BroadcastCondition(loader->queued);
+    SDL_UnlockMutex(loader->lock);
+    for (usize i = 0; i < loader->threads.len; i++)
+        SDL_WaitThread(*(SDL_Thread **)vec_get(&loader->threads, i), NULL);
+
+    vec_free(&loader->threads);
+    vec_free_with(&loader->queue, free_job);
+    vec_free_with(&loader->decoded, free_job);
+    SDL_DestroyCondition(loader->finished);
+    SDL_DestroyCondition(loader->queued);
+    SDL_DestroyMutex(loader->lock);
+}
+
+static void decode(TextureJob *job)
+{
+    SDL_Surface *surface = IMG_Load(job->path);
+    if (!surface)
+    {
+        snprintf(job->error, sizeof(job->error), "%s", SDL_GetError());
+        return;
+    }
+
+    if (surface->format != SDL_PIXELFORMAT_RGBA32)
+    {
+        SDL_Surface *converted =
+            SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
+        SDL_DestroySurface(surface);
+        surface = converted;
+        if (!surface)
+        {
+            snprintf(job->error, sizeof(job->error), "%s", SDL_GetError());
+            return;
+        }
+    }
+    job->surface = surface;
+}
+
+static int worker_main(void *data)
+{
+    TextureLoader *loader = data;
+
+    SDL_LockMutex(loader->lock);
+    for (;;)
+    {
+        while (!loader->queue.len && !loader->quit)
+            SDL_WaitCondition(loader->queued, loader->lock);
+        if (loader->quit)
+            break;
+
+        TextureJob *job;
+        vec_remove(&loader->queue, 0, &job);
+        loader->decoding++;
+
+        SDL_UnlockMutex(loader->lock);
+        decode(job);
+        SDL_LockMutex(loader->lock);
+
+        loader->decoding--;
+        vec_push(&loader->decoded, &job);
+        SDL_BroadcastCondition(loader->finished);
+    }
+    SDL_UnlockMutex(loader->lock);
+
+    return 0;
+}
+
+// the lock must be held
+static void start_workers(TextureLoader *loader)
+{
+    // leave a core for the main thread
+    int threads = SDL_GetNumLogicalCPUCores() - 1;
+    if (threads < 1)
+        threads = 1;
+    if (threads > TEXTURE_LOADER_MAX_THREADS)
+        threads = TEXTURE_LOADER_MAX_THREADS;
+
+    for (int i = 0; i < threads; i++)
+    {
+        SDL_Thread *thread =
+            SDL_CreateThread(worker_main, "texture decoder", loader);
+        PTR_ERRCHK(thread, "Failed to start texture decoder");
+        vec_push(&loader->threads, &thread);
+    }
+    log_info("Decoding textures on %d threads", threads);
+}
+
+TextureJob *texture_loader_queue(TextureLoader *loader, const char *path,
+                                 void *user)
+{
+    TextureJob *job = malloc(sizeof(TextureJob));
+    *job = (TextureJob){
+        .path = strdup(path),
+        .user = user,
+        .surface = NULL,
+        .error = {0},
+    };
+
+    SDL_LockMutex(loader->lock);
+    if (!loader->threads.len)
+        start_workers(loader);
+    vec_push(&loader->queue, &job);
+    SDL_SignalCondition(loader->queued);
+    SDL_UnlockMutex(loader->lock);
+
+    return job;
+}
+
+void texture_loader_cancel(TextureLoader *loader, TextureJob *job)
+{
+    SDL_LockMutex(loader->lock);
+    // no one's started on it yet, so it can go now. otherwise it's freed once
+    // it's decoded
+    for (usize i = 0; i < loader->queue.len; i++)
+        if (*(TextureJob **)vec_get(&loader->queue, i) == job)
+        {
+            vec_remove(&loader->queue, i, NULL);
+            texture_job_free(job);
+            SDL_UnlockMutex(loader->lock);
+            return;
+        }
+    job->user = NULL;
+    SDL_UnlockMutex(loader->lock);
+}
+
+TextureJob *texture_loader_pop(TextureLoader *loader, bool wait)
+{
+    SDL_LockMutex(loader->lock);
+    for (;;)
+    {
+        while (loader->decoded.len)
+        {
+            TextureJob *job;
+            vec_remove(&loader->decoded, 0, &job);
+            if (job->user)
+            {
+                SDL_UnlockMutex(loader->lock);
+                return job;
+            }
+            texture_job_free(job);
+        }
+
+        if (!wait || (!loader->queue.len && !loader->decoding))
+            break;
+        SDL_WaitCondition(loader->finished, loader->lock);
+    }
+    SDL_UnlockMutex(loader->lock);
+    return NULL;
+}
+
+bool texture_loader_png_size(const char *path, u32 *width, u32 *height)
+{
+    static const char signature[] = "\x89PNG\r\n\x1A\n";
+
+    // the signature, then the IHDR chunk's length and type, then its width and
+    // height (big endian)
+    u8 header[24];
+    SDL_IOStream *io = SDL_IOFromFile(path, "rb");
+    if (!io)
+        return false;
+    usize read = SDL_ReadIO(io, header, sizeof(header));
+    SDL_CloseIO(io);
+
+    if (read != sizeof(header) || memcmp(header, signature, 8) != 0 ||
+        memcmp(header + 12, "IHDR", 4) != 0)
+        return false;
+
+    *width = (u32)header[16] << 24 | (u32)header[17] << 16 |
+             (u32)header[18] << 8 | header[19];
+    *height = (u32)header[20] << 24 | (u32)header[21] << 16 |
+              (u32)header[22] << 8 | header[23];
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+#include "sensible_nums.h"
+#include "utility/vec.h"
+
+// decodes images on worker threads, so loading a map doesn't wait on every png
+// it uses. the workers convert them to rgba too, so all that's left for the
+// main thread is uploading them.
+//
+// the workers are only started once something gets queued.
+
+#define TEXTURE_LOADER_MAX_THREADS 4
+
+typedef struct
+{
+    char *path;
+    // whatever it was queued with. NULL once it's cancelled
+    void *user;
+    // rgba32. NULL until it's decoded, or if decoding failed
+    SDL_Surface *surface;
+    char error[128];
+} TextureJob;
+
+typedef struct
+{
+    SDL_Mutex *lock;
+    SDL_Condition *queued;
+    SDL_Condition *finished;
+
+    vec threads; // vec<SDL_Thread *>
+    vec queue;   // vec<TextureJob *>, oldest first
+    vec decoded; // vec<TextureJob *>, in the order they were finished
+    // how many jobs the workers are in the middle of
+    u32 decoding;
+    bool quit;
+} TextureLoader;
+
+void texture_loader_init(TextureLoader *loader);
+// waits for the workers to finish what they're decoding, and throws away
+// everything that's left
+void texture_loader_free(TextureLoader *loader);
+
+// the path is copied
+TextureJob *texture_loader_queue(TextureLoader *loader, const char *path,
+                                 void *user);
+// the job gets freed once no worker is using it, so it mustn't be used after
+// this
+void texture_loader_cancel(TextureLoader *loader, TextureJob *job);
+// the oldest decoded job, or NULL if there isn't one. with `wait`, it waits for
+// one unless there's nothing left to decode.
+// the job is the caller's to free with texture_job_free
+TextureJob *texture_loader_pop(TextureLoader *loader, bool wait);
+void texture_job_free(TextureJob *job);
+
+// reads a png's size from its header, without decoding it. false if it isn't a
+// png (or can't be read)
+bool texture_loader_png_size(const char *path, u32 *width, u32 *height);
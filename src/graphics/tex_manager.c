@@ -1,6 +1,7 @@
 #include "tex_manager.h"
 #include "sensible_nums.h"
 #include "utility/graphics.h"
+#include "utility/log.h"
 #include "utility/macros.h"
 #include "webgpu.h"
 #include <SDL3_image/SDL_image.h>
@@ -15,6 +16,23 @@ void texture_manager_init(TextureManager *manager)
     vec_init(&manager->texture_views, sizeof(WGPUTextureView));
     vec_init(&manager->textures, sizeof(WGPUTexture));
     vec_init(&manager->entries, sizeof(TextureEntry *));
+    atlas_init(&manager->atlas, ATLAS_PAGE_SIZE);
+    vec_init(&manager->atlas_pages, sizeof(TextureEntry *));
+    vec_init(&manager->packed, sizeof(TextureEntry *));
+    hashmap_init(&manager->by_path, fnv_cstr_ptr_hash_function,
+                 cstr_ptr_eq_function, sizeof(char *), sizeof(TextureEntry *));
+    hashmap_init(&manager->packed_by_path, fnv_cstr_ptr_hash_function,
+                 cstr_ptr_eq_function, sizeof(char *), sizeof(TextureEntry *));
+    manager->newest = NULL;
+    manager->oldest = NULL;
+    manager->cache_budget = TEXTURE_CACHE_BUDGET;
+    manager->stats = (TextureCacheStats){0};
+    manager->placeholder = NULL;
+    texture_loader_init(&manager->loader);
+    vec_init(&manager->loading, sizeof(TextureEntry *));
+    manager->upload_budget = TEXTURE_UPLOAD_BUDGET;
+    manager->load_stats = (TextureLoadStats){0};
+    manager->generation = 0;
 }
 
 static void free_texture_view(usize index, void *data)
@@ -32,33 +50,90 @@ static void free_texture(usize index, void *data)
 static void free_entry(usize index, void *data)
 {
     (void)index;
+    // cached entries have a ref count of 0, but still own their path
     TextureEntry *entry = *(TextureEntry **)data;
-    if (entry->ref_count > 0)
-        free((void *)entry->path);
+    free((void *)entry->path);
     free(entry);
 }
 void texture_manager_free(TextureManager *manager)
 {
+    // the workers have to stop before anything they might be decoding for is
+    // freed
+    texture_loader_free(&manager->loader);
+    vec_free_with(&manager->loading, free_entry);
     vec_free_with(&manager->texture_views, free_texture_view);
     vec_free_with(&manager->textures, free_texture);
     vec_free_with(&manager->entries, free_entry);
+    vec_free_with(&manager->packed, free_entry);
+    vec_free(&manager->atlas_pages);
+    atlas_free(&manager->atlas);
+    hashmap_free(&manager->by_path);
+    hashmap_free(&manager->packed_by_path);
+}
+
+static void cache(TextureManager *manager, TextureEntry *entry)
+{
+    entry->newer = NULL;
+    entry->older = manager->newest;
+    if (manager->newest)
+        manager->newest->newer = entry;
+    else
+        manager->oldest = entry;
+    manager->newest = entry;
+
+    manager->stats.cached++;
+    manager->stats.cached_bytes += entry->bytes;
+}
+
+static void uncache(TextureManager *manager, TextureEntry *entry)
+{
+    if (entry->newer)
+        entry->newer->older = entry->older;
+    else
+        manager->newest = entry->older;
+    if (entry->older)
+        entry->older->newer = entry->newer;
+    else
+        manager->oldest = entry->newer;
+    entry->newer = NULL;
+    entry->older = NULL;
+
+    manager->stats.cached--;
+    manager->stats.cached_bytes -= entry->bytes;
+}
+
+static TextureEntry *find_loaded(TextureManager *manager, HashMap *map,
+                                 const char *path)
+{
+    void *found = hashmap_get(map, &path);
+    if (!found)
+        return NULL;
+
+    TextureEntry *entry;
+    memcpy(&entry, found, sizeof(TextureEntry *));
+    if (entry->ref_count == 0)
+        uncache(manager, entry);
+    entry->ref_count++;
+    manager->stats.hits++;
+    return entry;
+}
+
+static void add_to_index(TextureManager *manager, TextureEntry *entry)
+{
+    entry->from_file = true;
+    HashMap *map = entry->region.page == ATLAS_NONE ? &manager->by_path
+                                                    : &manager->packed_by_path;
+    hashmap_insert(map, &entry->path, &entry);
 }
 
 TextureEntry *texture_manager_load(TextureManager *manager, const char *path,
                                    WGPUResources *resources)
 {
     // check if the texture is already loaded
-    for (usize i = 0; i < manager->entries.len; i++)
-    {
-        TextureEntry *entry = *(TextureEntry **)vec_get(&manager->entries, i);
-        if (entry->ref_count == 0)
-            continue;
-        if (strcmp(entry->path, path) == 0)
-        {
-            entry->ref_count++;
-            return entry;
-        }
-    }
+    TextureEntry *loaded = find_loaded(manager, &manager->by_path, path);
+    if (loaded)
+        return loaded;
+    manager->stats.misses++;
 
     // load texture
     SDL_Surface *surface = IMG_Load(path);
@@ -68,7 +143,9 @@ TextureEntry *texture_manager_load(TextureManager *manager, const char *path,
         resources);
     SDL_DestroySurface(surface);
 
-    return texture_manager_register(manager, texture, path);
+    TextureEntry *entry = texture_manager_register(manager, texture, path);
+    add_to_index(manager, entry);
+    return entry;
 }
 
 TextureEntry *texture_manager_register(TextureManager *manager,
@@ -81,7 +158,19 @@ TextureEntry *texture_manager_register(TextureManager *manager,
         .ref_count = 1,
         .index = manager->entries.len,
         .path = new_path,
+        .width = wgpuTextureGetWidth(texture),
+        .height = wgpuTextureGetHeight(texture),
+        .sub_rect = RECT_UNIT_TEX_COORDS,
+        .region = {.page = ATLAS_NONE},
+        .from_file = false,
+        // textures are always rgba8
+        .bytes = (u64)wgpuTextureGetWidth(texture) *
+                 wgpuTextureGetHeight(texture) * 4,
+        .newer = NULL,
+        .older = NULL,
+        .loading = NULL,
     };
+    manager->stats.resident_bytes += entry.bytes;
 
     TextureEntry *new_entry = malloc(sizeof(TextureEntry));
     *new_entry = entry;
@@ -89,45 +178,227 @@ TextureEntry *texture_manager_register(TextureManager *manager,
     vec_push(&manager->entries, &new_entry);
     vec_push(&manager->textures, &texture);
     vec_push(&manager->texture_views, &view);
+    manager->generation++;
 
     return new_entry;
 }
 
-void texture_manager_unload(TextureManager *manager, TextureEntry *entry)
+TextureEntry *texture_manager_load_packed(TextureManager *manager,
+                                          const char *path,
+                                          WGPUResources *resources)
 {
-    assert(entry->ref_count > 0);
-    entry->ref_count--;
+    TextureEntry *loaded = find_loaded(manager, &manager->packed_by_path, path);
+    if (!loaded)
+        loaded = find_loaded(manager, &manager->by_path, path);
+    if (loaded)
+        return loaded;
+    manager->stats.misses++;
 
-    if (entry->ref_count == 0)
+    SDL_Surface *surface = IMG_Load(path);
+    SDL_PTR_ERRCHK(surface, "failed to load image");
+    TextureEntry *entry =
+        texture_manager_register_surface(manager, surface, path, resources);
+    SDL_DestroySurface(surface);
+    add_to_index(manager, entry);
+    return entry;
+}
+
+TextureEntry *texture_manager_register_surface(TextureManager *manager,
+                                               SDL_Surface *surface,
+                                               const char *path,
+                                               WGPUResources *resources)
+{
+    if (!atlas_fits(&manager->atlas, surface->w, surface->h))
+    {
+        WGPUTexture texture = texture_from_surface(
+            surface, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst,
+            resources);
+        return texture_manager_register(manager, texture, path);
+    }
+
+    AtlasRegion region = atlas_add(&manager->atlas, surface->w, surface->h);
+    // a new page. it gets a spot in the binding array like any other texture
+    if (region.page == manager->atlas_pages.len)
     {
-        WGPUTexture texture;
-        WGPUTextureView view;
-
-        // swap remove avoids shifting elements around by swapping in the last
-        // element and decrementing the length of the array
-        // this is important to
-        // 1) keep the arrays contiguous
-        // 2) make sure everything has the correct index
-        vec_swap_remove(&manager->textures, entry->index, &texture);
-        vec_swap_remove(&manager->texture_views, entry->index, &view);
-        vec_swap_remove(&manager->entries, entry->index, NULL);
-
-        // if this happens to be the last element, we don't need to update
-        // anything!
-        if (entry->index < manager->entries.len)
+        WGPUTexture texture =
+            blank_texture(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE,
+                          WGPUTextureUsage_TextureBinding, resources);
+        TextureEntry *page =
+            texture_manager_register(manager, texture, "atlas page");
+        vec_push(&manager->atlas_pages, &page);
+    }
+    TextureEntry *page =
+        *(TextureEntry **)vec_get(&manager->atlas_pages, region.page);
+    write_surface_to_texture_at(region.x, region.y, surface,
+                                texture_manager_get_texture(manager, page),
+                                resources);
+
+    vec2s page_size = {.x = ATLAS_PAGE_SIZE, .y = ATLAS_PAGE_SIZE};
+    vec2s min = {.x = region.x, .y = region.y};
+    vec2s max = {.x = region.x + region.width, .y = region.y + region.height};
+    TextureEntry entry = {
+        .ref_count = 1,
+        .index = page->index,
+        .path = strdup(path),
+        .width = region.width,
+        .height = region.height,
+        .sub_rect = {.min = glms_vec2_div(min, page_size),
+                     .max = glms_vec2_div(max, page_size)},
+        .region = region,
+        .from_file = false,
+        .bytes = (u64)region.width * region.height * 4,
+        .newer = NULL,
+        .older = NULL,
+        .loading = NULL,
+    };
+    TextureEntry *new_entry = malloc(sizeof(TextureEntry));
+    *new_entry = entry;
+    vec_push(&manager->packed, &new_entry);
+    return new_entry;
+}
+
+Rect texture_entry_tex_coords(TextureEntry *entry, Rect tex_coords)
+{
+    vec2s size = glms_vec2_sub(entry->sub_rect.max, entry->sub_rect.min);
+    return (Rect){
+        .min = glms_vec2_add(entry->sub_rect.min,
+                             glms_vec2_mul(tex_coords.min, size)),
+        .max = glms_vec2_add(entry->sub_rect.min,
+                             glms_vec2_mul(tex_coords.max, size)),
+    };
+}
+
+// the old pixels are left on the page, and get written over by whatever goes
+// there next
+static void unload_packed(TextureManager *manager, TextureEntry *entry)
+{
+    atlas_remove(&manager->atlas, entry->region);
+    for (usize i = 0; i < manager->packed.len; i++)
+        if (*(TextureEntry **)vec_get(&manager->packed, i) == entry)
         {
-            TextureEntry *moved_entry =
-                *(TextureEntry **)vec_get(&manager->entries, entry->index);
-            // update the moved entry's index to where it is now
-            moved_entry->index = entry->index;
+            vec_swap_remove(&manager->packed, i, NULL);
+            break;
         }
+    if (entry->from_file)
+        hashmap_remove(&manager->packed_by_path, &entry->path, NULL);
+    free((void *)entry->path);
+    free(entry);
+}
 
-        wgpuTextureRelease(texture);
-        wgpuTextureViewRelease(view);
-        free((void *)entry->path);
+static void remove_loading(TextureManager *manager, TextureEntry *entry)
+{
+    for (usize i = 0; i < manager->loading.len; i++)
+        if (*(TextureEntry **)vec_get(&manager->loading, i) == entry)
+        {
+            vec_swap_remove(&manager->loading, i, NULL);
+            break;
+        }
+}
+
+// everything in `entries` that was using the texture at `from` uses the one at
+// `to` now
+static void move_references(vec *entries, u32 from, u32 to)
+{
+    for (usize i = 0; i < entries->len; i++)
+    {
+        TextureEntry *entry = *(TextureEntry **)vec_get(entries, i);
+        if (entry->index == from)
+            entry->index = to;
+    }
+}
 
+static void release(TextureManager *manager, TextureEntry *entry)
+{
+    if (entry->region.page != ATLAS_NONE)
+    {
+        unload_packed(manager, entry);
+        return;
+    }
+
+    // it's not on the gpu yet, so there's nothing else to release
+    if (entry->loading)
+    {
+        texture_loader_cancel(&manager->loader, entry->loading);
+        remove_loading(manager, entry);
+        hashmap_remove(&manager->by_path, &entry->path, NULL);
+        free((void *)entry->path);
         free(entry);
+        return;
+    }
+
+    WGPUTexture texture;
+    WGPUTextureView view;
+
+    // swap remove avoids shifting elements around by swapping in the last
+    // element and decrementing the length of the array
+    // this is important to
+    // 1) keep the arrays contiguous
+    // 2) make sure everything has the correct index
+    vec_swap_remove(&manager->textures, entry->index, &texture);
+    vec_swap_remove(&manager->texture_views, entry->index, &view);
+    vec_swap_remove(&manager->entries, entry->index, NULL);
+    manager->generation++;
+
+    // if this happens to be the last element, we don't need to update
+    // anything!
+    if (entry->index < manager->entries.len)
+    {
+        TextureEntry *moved_entry =
+            *(TextureEntry **)vec_get(&manager->entries, entry->index);
+        // update the moved entry's index to where it is now
+        u32 old_index = moved_entry->index;
+        moved_entry->index = entry->index;
+
+        // if it's an atlas page, everything on it moved too. same for the
+        // placeholder and everything still loading
+        move_references(&manager->packed, old_index, entry->index);
+        move_references(&manager->loading, old_index, entry->index);
     }
+
+    wgpuTextureRelease(texture);
+    wgpuTextureViewRelease(view);
+    manager->stats.resident_bytes -= entry->bytes;
+    if (entry->from_file)
+        hashmap_remove(&manager->by_path, &entry->path, NULL);
+    free((void *)entry->path);
+
+    free(entry);
+}
+
+// releases the least recently used cached textures until they fit the budget
+static void evict(TextureManager *manager)
+{
+    while (manager->oldest &&
+           manager->stats.cached_bytes > manager->cache_budget)
+    {
+        TextureEntry *oldest = manager->oldest;
+        uncache(manager, oldest);
+        release(manager, oldest);
+        manager->stats.evictions++;
+    }
+}
+
+void texture_manager_unload(TextureManager *manager, TextureEntry *entry)
+{
+    assert(entry->ref_count > 0);
+    entry->ref_count--;
+    if (entry->ref_count > 0)
+        return;
+
+    // nothing else can load it again, so there's no point keeping it
+    if (!entry->from_file)
+    {
+        release(manager, entry);
+        return;
+    }
+    cache(manager, entry);
+    evict(manager);
+}
+
+void texture_manager_set_cache_budget(TextureManager *manager, u64 bytes)
+{
+    manager->cache_budget = bytes;
+    evict(manager);
 }
 
 WGPUTexture texture_manager_get_texture(TextureManager *manager,
@@ -145,3 +416,101 @@ WGPUTextureView texture_manager_get_texture_view(TextureManager *manager,
     assert(view != NULL);
     return *view;
 }
+
+TextureEntry *texture_manager_load_async(TextureManager *manager,
+                                         const char *path,
+                                         WGPUResources *resources)
+{
+    TextureEntry *loaded = find_loaded(manager, &manager->by_path, path);
+    if (loaded)
+        return loaded;
+
+    // without a size, nothing can make a quad for it yet
+    u32 width, height;
+    if (!manager->placeholder ||
+        !texture_loader_png_size(path, &width, &height))
+        return texture_manager_load(manager, path, resources);
+    manager->stats.misses++;
+
+    TextureEntry entry = {
+        .ref_count = 1,
+        .index = manager->placeholder->index,
+        .path = strdup(path),
+        .width = width,
+        .height = height,
+        .sub_rect = RECT_UNIT_TEX_COORDS,
+        .region = {.page = ATLAS_NONE},
+        .from_file = false,
+        // what it will take up. it's only resident once it's uploaded
+        .bytes = (u64)width * height * 4,
+        .newer = NULL,
+        .older = NULL,
+    };
+    TextureEntry *new_entry = malloc(sizeof(TextureEntry));
+    *new_entry = entry;
+    new_entry->loading =
+        texture_loader_queue(&manager->loader, new_entry->path, new_entry);
+    vec_push(&manager->loading, &new_entry);
+    add_to_index(manager, new_entry);
+    return new_entry;
+}
+
+// like texture_manager_register, but into the entry that's been out there
+// with the placeholder. returns how many bytes were uploaded
+static u64 finish_load(TextureManager *manager, TextureJob *job,
+                       WGPUResources *resources)
+{
+    TextureEntry *entry = job->user;
+    if (!job->surface)
+        FATAL("SDL error:failed to load image %s: %s\n", job->path,
+              job->error);
+    if (job->surface->w != (int)entry->width ||
+        job->surface->h != (int)entry->height)
+        log_warn("%s is %dx%d, but its header said %ux%u", job->path,
+                 job->surface->w, job->surface->h, entry->width,
+                 entry->height);
+
+    // it's already rgba, so this is just the upload
+    WGPUTexture texture = texture_from_surface(
+        job->surface,
+        WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, resources);
+    WGPUTextureView view = wgpuTextureCreateView(texture, NULL);
+    texture_job_free(job);
+
+    entry->index = manager->entries.len;
+    entry->loading = NULL;
+    vec_push(&manager->entries, &entry);
+    vec_push(&manager->textures, &texture);
+    vec_push(&manager->texture_views, &view);
+    manager->generation++;
+    manager->stats.resident_bytes += entry->bytes;
+    remove_loading(manager, entry);
+    return entry->bytes;
+}
+
+void texture_manager_upload_loaded(TextureManager *manager,
+                                   WGPUResources *resources)
+{
+    manager->load_stats.uploads = 0;
+    manager->load_stats.uploaded_bytes = 0;
+    while (manager->load_stats.uploads == 0 ||
+           manager->load_stats.uploaded_bytes < manager->upload_budget)
+    {
+        TextureJob *job = texture_loader_pop(&manager->loader, false);
+        if (!job)
+            break;
+        manager->load_stats.uploaded_bytes +=
+            finish_load(manager, job, resources);
+        manager->load_stats.uploads++;
+    }
+    manager->load_stats.loading = manager->loading.len;
+}
+
+void texture_manager_finish_loading(TextureManager *manager,
+                                    WGPUResources *resources)
+{
+    TextureJob *job;
+    while ((job = texture_loader_pop(&manager->loader, true)))
+        finish_load(manager, job, resources);
+    manager->load_stats.loading = manager->loading.len;
+}
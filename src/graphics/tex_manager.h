@@ -1,43 +1,167 @@
 #pragma once
 
+#include <SDL3/SDL.h>
 #include <wgpu.h>
+#include "graphics/atlas.h"
+#include "graphics/tex_loader.h"
 #include "graphics/wgpu_resources.h"
 #include "core_types.h"
 #include "sensible_nums.h"
+#include "utility/hashmap.h"
 #include "utility/vec.h"
 
+// how many bytes of textures nothing's using get kept around, so going back
+// and forth between maps doesn't decode the same pngs every time
+#define TEXTURE_CACHE_BUDGET (64 * 1024 * 1024)
+// how many bytes of textures loaded with texture_manager_load_async get
+// uploaded each frame. at least one always is, however big it is
+#define TEXTURE_UPLOAD_BUDGET (4 * 1024 * 1024)
+
 // reference counted!
-typedef struct
+typedef struct TextureEntry
 {
     u32 ref_count;
+    // into texture_views. textures packed into the atlas have their page's
     u32 index;
     const char *path; // DO NOT MODIFY!
+
+    // the texture's own size, even if it's packed
+    u32 width, height;
+    // where the texture is in the one at `index`, as tex coords.
+    // RECT_UNIT_TEX_COORDS unless it's packed
+    Rect sub_rect;
+    // region.page is ATLAS_NONE unless it's packed
+    AtlasRegion region;
+
+    // loaded from `path`, so it can be found again and cached
+    bool from_file;
+    // what it takes up on the gpu (or in its atlas page), or will once it's
+    // loaded
+    u64 bytes;
+    // the cache's lru list, most recently unloaded first. only used while
+    // ref_count is 0
+    struct TextureEntry *newer, *older;
+
+    // the decode it's waiting on, if it was loaded with
+    // texture_manager_load_async. until it's done, index is the placeholder's
+    TextureJob *loading;
 } TextureEntry;
 
+typedef struct
+{
+    // loads that found the texture already there (used or cached), and ones
+    // that had to decode it
+    u32 hits, misses;
+    // cached textures released to stay under the budget
+    u32 evictions;
+    // everything in the binding array, atlas pages included
+    u64 resident_bytes;
+    // textures with no references that haven't been evicted yet
+    u64 cached_bytes;
+    u32 cached;
+} TextureCacheStats;
+
+typedef struct
+{
+    // textures still being decoded or waiting to be uploaded
+    u32 loading;
+    // for the last frame
+    u32 uploads;
+    u64 uploaded_bytes;
+} TextureLoadStats;
+
 typedef struct
 {
     vec texture_views; // vec<WGPUTextureView>
     vec textures;      // vec<WGPUTexture>
     vec entries;       // a list of TextureEntry
+
+    // small textures loaded with texture_manager_load_packed or
+    // texture_manager_register_surface. each page is a normal entry above
+    Atlas atlas;
+    vec atlas_pages; // vec<TextureEntry *>, indexed by AtlasRegion.page
+    vec packed;      // vec<TextureEntry *>
+
+    // textures loaded from files, including cached ones
+    HashMap by_path;        // HashMap<char *, TextureEntry *>
+    HashMap packed_by_path; // HashMap<char *, TextureEntry *>
+
+    // textures from files aren't released when their ref count hits 0, they
+    // go on this list instead. the oldest get released once there's more
+    // than cache_budget bytes of them
+    TextureEntry *newest, *oldest;
+    u64 cache_budget;
+    TextureCacheStats stats;
+
+    // what async loads are drawn with until they're ready. nothing's loaded
+    // async without one
+    TextureEntry *placeholder;
+    TextureLoader loader;
+    vec loading; // vec<TextureEntry *>
+    u64 upload_budget;
+    TextureLoadStats load_stats;
+
+    // goes up every time texture_views changes, so bind groups with every
+    // texture in them know when to rebuild
+    u32 generation;
 } TextureManager;
 
 void texture_manager_init(TextureManager *manager);
 void texture_manager_free(TextureManager *manager);
 
 // returns a reference to the texture at the given path
-// O(n) time complexity. Will increment the reference count of the texture if it
-// already exists
+// Will increment the reference count of the texture if it already exists (or
+// is still cached)
 // if the texture does not exist, it will be loaded
 // NOTE: the path IS copied!
 TextureEntry *texture_manager_load(TextureManager *manager, const char *path,
                                    WGPUResources *resources);
-// will decrement the reference count of the texture, and unload it if it
-// reaches 0
+// will decrement the reference count of the texture. if it reaches 0, textures
+// from files get cached, and everything else is unloaded
 void texture_manager_unload(TextureManager *manager, TextureEntry *entry);
 
+// 0 turns the cache off. releases cached textures until they fit
+void texture_manager_set_cache_budget(TextureManager *manager, u64 bytes);
+
+// like texture_manager_load, but the png is decoded on another thread. the
+// entry's size is right straight away (it's read from the png's header), but
+// it's drawn with the placeholder until texture_manager_upload_loaded has
+// uploaded it. anything else falls back to texture_manager_load.
+// loading something that's still loading gives you the same entry
+TextureEntry *texture_manager_load_async(TextureManager *manager,
+                                         const char *path,
+                                         WGPUResources *resources);
+// uploads textures that have finished decoding, up to upload_budget bytes.
+// call once a frame
+void texture_manager_upload_loaded(TextureManager *manager,
+                                   WGPUResources *resources);
+// waits for every async load and uploads them all, however long that takes
+void texture_manager_finish_loading(TextureManager *manager,
+                                    WGPUResources *resources);
+
 TextureEntry *texture_manager_register(TextureManager *manager,
                                        WGPUTexture texture, const char *path);
 
+// like texture_manager_load, but small textures get packed into a shared
+// atlas page instead of getting their own texture. what's drawn with them has
+// to use texture_entry_tex_coords, so this isn't for tilesets or sprites
+// animated on the gpu (they work out tex coords from the whole texture)
+TextureEntry *texture_manager_load_packed(TextureManager *manager,
+                                          const char *path,
+                                          WGPUResources *resources);
+// packs `surface` into the atlas if it's small enough, otherwise makes a
+// texture for it. the surface isn't freed, or kept. paths don't need to be
+// unique, as nothing looks these up
+TextureEntry *texture_manager_register_surface(TextureManager *manager,
+                                               SDL_Surface *surface,
+                                               const char *path,
+                                               WGPUResources *resources);
+
+// maps `tex_coords` (0 to 1 over the texture) onto the part of the texture at
+// entry->index that it's in
+Rect texture_entry_tex_coords(TextureEntry *entry, Rect tex_coords);
+
+// for packed textures, this is the whole atlas page
 WGPUTexture texture_manager_get_texture(TextureManager *manager,
                                         TextureEntry *entry);
 WGPUTextureView texture_manager_get_texture_view(TextureManager *manager,
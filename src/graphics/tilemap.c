@@ -7,54 +7,224 @@
 #include "utility/log.h"
 #include "webgpu.h"
 
+// empty tables get one zeroed element, so an empty animation table has nothing
+// animating
+static WGPUBuffer create_table(Graphics *graphics, vec *table,
+                               const char *label)
+{
+    return storage_buffer_from_vec(table, graphics->wgpu.device,
+                                   graphics->wgpu.queue, label);
+}
+
+static void create_animation_tables(Tilemap *tilemap, Graphics *graphics,
+                                    TilemapAnimations *animations)
+{
+    tilemap->tile_animations = create_table(
+        graphics, &animations->animations, "tilemap animation table");
+    tilemap->animation_frames = create_table(graphics, &animations->frames,
+                                             "tilemap animation frames");
+
+    BindGroupBuilder builder;
+    bind_group_builder_init(&builder);
+    bind_group_builder_append_buffer(&builder, tilemap->tile_uvs);
+    bind_group_builder_append_buffer(&builder, tilemap->tile_animations);
+    bind_group_builder_append_buffer(&builder, tilemap->animation_frames);
+    tilemap->tables_bind_group = bind_group_build(
+        &builder, graphics->wgpu.device, graphics->bind_group_layouts.tilemap,
+        "tilemap tables bind group");
+    bind_group_builder_free(&builder);
+}
+
+static void create_tables(Tilemap *tilemap, Graphics *graphics)
+{
+    // not the texture's size, since it might still be loading
+    vec uvs;
+    vec_init(&uvs, sizeof(TilemapUv));
+    tilemap_uv_table(&uvs, tilemap->tileset->width, tilemap->tileset->height);
+    tilemap->tile_uvs = create_table(graphics, &uvs, "tilemap uv table");
+    vec_free(&uvs);
+
+    // nothing animates until tilemap_set_animations
+    TilemapAnimations none;
+    tilemap_animations_init(&none);
+    create_animation_tables(tilemap, graphics, &none);
+    tilemap_animations_free(&none);
+}
+
+static void release_animation_tables(Tilemap *tilemap)
+{
+    wgpuBindGroupRelease(tilemap->tables_bind_group);
+    wgpuBufferRelease(tilemap->tile_animations);
+    wgpuBufferRelease(tilemap->animation_frames);
+}
+
+void tilemap_set_animations(Tilemap *tilemap, Graphics *graphics,
+                            TilemapAnimations *animations)
+{
+    release_animation_tables(tilemap);
+    create_animation_tables(tilemap, graphics, animations);
+}
+
 void tilemap_init(Tilemap *tilemap, Graphics *graphics, TextureEntry *tileset,
                   TransformEntry transform, int map_w, int map_h, int layers,
-                  i32 *map_data)
+                  u32 *map_data)
 {
+    if ((u64)map_w * map_h * layers > TILEMAP_STREAM_THRESHOLD)
+    {
+        tilemap_init_streaming(tilemap, graphics, tileset, transform, map_w,
+                               map_h, layers, map_data,
+                               TILEMAP_STREAM_DEFAULTS);
+        return;
+    }
+
     tilemap->tileset = tileset;
     tilemap->transform = transform;
     tilemap->map_w = map_w;
     tilemap->map_h = map_h;
     tilemap->layers = layers;
+    tilemap->stream = NULL;
+    vec_init(&tilemap->draws, sizeof(TilemapDraw));
+    create_tables(tilemap, graphics);
 
-    usize map_data_size = map_w * map_h * layers * sizeof(i32);
-    log_info("map data size: %lu", map_data_size);
+    vec tiles;
+    vec_init(&tiles, sizeof(TilemapTile));
+    tilemap_chunks_build(&tilemap->chunks, map_w, map_h, layers, map_data,
+                         &tiles);
 
+    usize map_data_size = tiles.len * sizeof(TilemapTile);
+    log_info("map data size: %lu (%lu of %d tiles aren't empty)",
+             map_data_size, tiles.len, map_w * map_h * layers);
+
+    // wgpu doesn't like empty buffers
     WGPUBufferDescriptor buffer_desc = {
         .label = "tilemap instance buffer",
-        .size = map_data_size,
+        .size = map_data_size > 0 ? map_data_size : sizeof(TilemapTile),
         .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
     };
     tilemap->instances =
         wgpuDeviceCreateBuffer(graphics->wgpu.device, &buffer_desc);
-    wgpuQueueWriteBuffer(graphics->wgpu.queue, tilemap->instances, 0, map_data,
-                         map_data_size);
+    if (map_data_size > 0)
+        wgpuQueueWriteBuffer(graphics->wgpu.queue, tilemap->instances, 0,
+                             tiles.data, map_data_size);
+    vec_free(&tiles);
+}
+
+void tilemap_init_streaming(Tilemap *tilemap, Graphics *graphics,
+                            TextureEntry *tileset, TransformEntry transform,
+                            int map_w, int map_h, int layers, u32 *map_data,
+                            TilemapStreamSettings settings)
+{
+    tilemap->tileset = tileset;
+    tilemap->transform = transform;
+    tilemap->map_w = map_w;
+    tilemap->map_h = map_h;
+    tilemap->layers = layers;
+    vec_init(&tilemap->draws, sizeof(TilemapDraw));
+    create_tables(tilemap, graphics);
+
+    tilemap->stream = malloc(sizeof(TilemapStream));
+    TilemapStream *stream = tilemap->stream;
+    tilemap_stream_init(stream, &graphics->wgpu, map_w, map_h, layers,
+                        settings);
+    for (int layer = 0; layer < layers; layer++)
+    {
+        u32 *layer_data = map_data + (usize)map_w * map_h * layer;
+        for (int chunk_y = 0; chunk_y < stream->chunks_h; chunk_y++)
+            tilemap_stream_add_rows(
+                stream, layer, chunk_y,
+                layer_data + (usize)chunk_y * TILEMAP_CHUNK_SIZE * map_w);
+    }
+
+    log_info("streaming map: %lu bytes compressed, %llu byte chunk pool",
+             stream->compressed.len,
+             (unsigned long long)tilemap_stream_pool_bytes(stream));
 }
 
 void tilemap_free(Tilemap *tilemap, Graphics *graphics)
 {
-    wgpuBufferRelease(tilemap->instances);
+    if (tilemap->stream)
+    {
+        tilemap_stream_free(tilemap->stream);
+        free(tilemap->stream);
+    }
+    else
+    {
+        wgpuBufferRelease(tilemap->instances);
+        tilemap_chunks_free(&tilemap->chunks);
+    }
+    release_animation_tables(tilemap);
+    wgpuBufferRelease(tilemap->tile_uvs);
+    vec_free(&tilemap->draws);
     texture_manager_unload(&graphics->texture_manager, tilemap->tileset);
     transform_manager_remove(&graphics->transform_manager, tilemap->transform);
 }
 
-void tilemap_render(Tilemap *tilemap, mat4s camera, int layer,
-                    WGPURenderPassEncoder pass)
+// the view gets moved into the tilemap's space, rather than moving every
+// chunk into world space
+static Rect local_view(Tilemap *tilemap, Graphics *graphics, Rect view)
+{
+    mat4s transform = transform_manager_get_matrix(
+        &graphics->transform_manager, tilemap->transform);
+    return cull_quad_bounds(view, glms_mat4_inv(transform));
+}
+
+void tilemap_request(Tilemap *tilemap, Graphics *graphics, Rect view,
+                     int layer)
 {
-    u64 layer_size = tilemap->map_w * tilemap->map_h * sizeof(u32);
-    wgpuRenderPassEncoderSetVertexBuffer(pass, 0, tilemap->instances,
-                                         layer_size * layer, layer_size);
+    // everything's already on the gpu
+    if (!tilemap->stream)
+        return;
+    tilemap_stream_request(tilemap->stream, layer,
+                           local_view(tilemap, graphics, view),
+                           graphics->frame);
+}
+
+void tilemap_render(Tilemap *tilemap, Graphics *graphics, mat4s camera,
+                    Rect view, int layer, RenderState *state)
+{
+    Rect local = local_view(tilemap, graphics, view);
+    CullStats *chunk_stats = &graphics->cull_stats.tile_chunks;
+    CullStats *tile_stats = &graphics->cull_stats.tiles;
+
+    WGPUBuffer instances;
+    if (tilemap->stream)
+    {
+        // uploads for every layer happen when the first one is drawn, so the
+        // closest chunks get the budget no matter which layer they're in
+        tilemap_stream_flush(tilemap->stream, &graphics->wgpu);
+        tilemap_stream_visible(tilemap->stream, layer, local, &tilemap->draws,
+                               chunk_stats, tile_stats);
+        instances = tilemap->stream->pool;
+    }
+    else
+    {
+        tilemap_chunks_visible(&tilemap->chunks, layer, local,
+                               &tilemap->draws, chunk_stats, tile_stats);
+        instances = tilemap->instances;
+    }
+    if (tilemap->draws.len == 0)
+        return;
 
+    render_state_set_bind_group(state, 1, tilemap->tables_bind_group);
     TilemapPushConstants constants = {
         .camera = camera,
         .transform_index = tilemap->transform,
         .texture_index = tilemap->tileset->index,
-        .map_width = tilemap->map_w,
+        .time = graphics->animation_time,
     };
 
-    wgpuRenderPassEncoderSetPushConstants(
-        pass, WGPUShaderStage_Vertex | WGPUShaderStage_Fragment, 0,
-        sizeof(TilemapPushConstants), &constants);
-    wgpuRenderPassEncoderDraw(pass, VERTICES_PER_QUAD,
-                              tilemap->map_w * tilemap->map_h, 0, 0);
+    // tile positions are in their chunk, so each chunk is its own draw. they
+    // all share the one binding, and pick their tiles with first_instance
+    render_state_set_vertex_buffer(state, 0, instances, 0,
+                                   wgpuBufferGetSize(instances));
+    TilemapDraw *draws = (TilemapDraw *)tilemap->draws.data;
+    for (usize i = 0; i < tilemap->draws.len; i++)
+    {
+        constants.chunk_x = draws[i].x;
+        constants.chunk_y = draws[i].y;
+        render_state_set_push_constants(state, sizeof(TilemapPushConstants),
+                                        &constants);
+        render_state_draw(state, VERTICES_PER_QUAD, draws[i].count,
+                          draws[i].first);
+    }
 }
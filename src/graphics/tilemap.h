@@ -1,6 +1,20 @@
 #pragma once
 
 #include "graphics.h"
+#include "graphics/tilemap_animations.h"
+#include "graphics/tilemap_chunks.h"
+#include "graphics/tilemap_stream.h"
+
+// maps with more tiles than this (across every layer) are streamed in around
+// the camera instead of all being uploaded up front (see tilemap_stream.h)
+#define TILEMAP_STREAM_THRESHOLD (2048 * 2048)
+// 4mb of chunks, 64kb uploaded a frame at most
+#define TILEMAP_STREAM_DEFAULTS                                                \
+    ((TilemapStreamSettings){                                                  \
+        .pool_chunks = 1024,                                                   \
+        .margin = 2,                                                           \
+        .upload_budget = 64 * 1024,                                            \
+    })
 
 typedef struct
 {
@@ -8,8 +22,18 @@ typedef struct
     TextureEntry *tileset;
     TransformEntry transform;
     int map_w, map_h, layers;
-    // 1 instance per tile. instances have just the tile ID
+    // only the non-empty tiles, chunk by chunk (see tilemap_chunks.h)
     WGPUBuffer instances;
+    TilemapChunks chunks;
+    // NULL unless the map's too big to upload all at once. if it's not NULL,
+    // instances and chunks aren't used
+    TilemapStream *stream;
+    // where each tile is in the tileset (see tilemap_uv_table) and how they
+    // animate (see tilemap_animations.h). these are all in group 1
+    WGPUBuffer tile_uvs, tile_animations, animation_frames;
+    WGPUBindGroup tables_bind_group;
+    // vec<TilemapDraw>, reused every time a layer gets drawn
+    vec draws;
 } Tilemap;
 
 typedef struct
@@ -20,10 +44,26 @@ typedef struct
     vec2s parallax_factor;
 } TilemapLayer;
 
+// `map_data` is Tiled's gids, flip flags and all. picks whether to stream the
+// map based on how big it is
 void tilemap_init(Tilemap *tilemap, Graphics *graphics, TextureEntry *tileset,
                   TransformEntry transform, int map_w, int map_h, int layers,
-                  i32 *map_data);
+                  u32 *map_data);
+void tilemap_init_streaming(Tilemap *tilemap, Graphics *graphics,
+                            TextureEntry *tileset, TransformEntry transform,
+                            int map_w, int map_h, int layers, u32 *map_data,
+                            TilemapStreamSettings settings);
 void tilemap_free(Tilemap *tilemap, Graphics *graphics);
+// replaces which tiles animate. they're copied to the gpu, so `animations`
+// can be freed after
+void tilemap_set_animations(Tilemap *tilemap, Graphics *graphics,
+                            TilemapAnimations *animations);
 
-void tilemap_render(Tilemap *tilemap, mat4s camera, int layer,
-                    WGPURenderPassEncoder pass);
+// needs calling for every layer that's going to be drawn this frame, before
+// any of them are drawn. `view` is the same as for tilemap_render
+void tilemap_request(Tilemap *tilemap, Graphics *graphics, Rect view,
+                     int layer);
+// only draws the chunks in `view` (the part of the world that's on screen,
+// see cull_view_rect). how many were drawn goes in graphics->cull_stats
+void tilemap_render(Tilemap *tilemap, Graphics *graphics, mat4s camera,
+                    Rect view, int layer, RenderState *state);
@@ -0,0 +1,63 @@
+#include "tilemap_animations.h"
+#include "utility/log.h"
+
+void tilemap_animations_init(TilemapAnimations *animations)
+{
+    vec_init(&animations->animations, sizeof(TilemapAnimation));
+    vec_init(&animations->frames, sizeof(TilemapAnimationFrame));
+}
+
+void tilemap_animations_free(TilemapAnimations *animations)
+{
+    vec_free(&animations->animations);
+    vec_free(&animations->frames);
+}
+
+void tilemap_animations_add(TilemapAnimations *animations, u32 tile,
+                            TilemapAnimationFrame *frames, u32 count)
+{
+    TilemapAnimation animation = {
+        .first = animations->frames.len,
+        .count = count,
+    };
+    for (u32 i = 0; i < count; i++)
+        animation.duration += frames[i].duration;
+    // the shader does time % duration
+    if (count == 0 || animation.duration == 0)
+    {
+        log_warn("tile %u's animation doesn't take any time, so it won't "
+                 "animate",
+                 tile);
+        return;
+    }
+
+    for (u32 i = 0; i < count; i++)
+        vec_push(&animations->frames, &frames[i]);
+    while (animations->animations.len <= tile)
+    {
+        TilemapAnimation none = {0};
+        vec_push(&animations->animations, &none);
+    }
+    *(TilemapAnimation *)vec_get(&animations->animations, tile) = animation;
+}
+
+u32 tilemap_animations_frame(TilemapAnimations *animations, u32 tile,
+                             u32 time)
+{
+    if (tile >= animations->animations.len)
+        return tile;
+    TilemapAnimation *animation = vec_get(&animations->animations, tile);
+    if (animation->count == 0)
+        return tile;
+
+    u32 into = time % animation->duration;
+    TilemapAnimationFrame *frames = vec_get(&animations->frames, 0);
+    for (u32 i = 0; i < animation->count; i++)
+    {
+        TilemapAnimationFrame *frame = &frames[animation->first + i];
+        if (into < frame->duration)
+            return frame->tile;
+        into -= frame->duration;
+    }
+    return tile;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "sensible_nums.h"
+#include "utility/vec.h"
+
+// animated tiles from the tileset (water, torches...). the tables get
+// uploaded once and tilemap.wgsl picks the frame from the time, so animated
+// tiles don't cost anything on the cpu each frame
+
+// one per tile in the tileset. laid out like a vec4u in tilemap.wgsl
+typedef struct
+{
+    // the frames are [first, first + count) in TilemapAnimations.frames.
+    // count is 0 if the tile doesn't animate
+    u32 first, count;
+    // every frame added up, in milliseconds
+    u32 duration;
+    u32 padding;
+} TilemapAnimation;
+
+typedef struct
+{
+    u32 tile;
+    // in milliseconds
+    u32 duration;
+} TilemapAnimationFrame;
+
+typedef struct
+{
+    // vec<TilemapAnimation>, indexed by tile. only goes up to the last tile
+    // that animates, anything after that doesn't
+    vec animations;
+    // vec<TilemapAnimationFrame>
+    vec frames;
+} TilemapAnimations;
+
+void tilemap_animations_init(TilemapAnimations *animations);
+void tilemap_animations_free(TilemapAnimations *animations);
+
+// makes `tile` go through `frames`, looping
+void tilemap_animations_add(TilemapAnimations *animations, u32 tile,
+                            TilemapAnimationFrame *frames, u32 count);
+
+// which tile `tile` shows `time` milliseconds in. this is what tilemap.wgsl
+// does, so it needs to match
+u32 tilemap_animations_frame(TilemapAnimations *animations, u32 tile,
+                             u32 time);
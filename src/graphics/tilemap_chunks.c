@@ -0,0 +1,168 @@
+#include "tilemap_chunks.h"
+#include "utility/macros.h"
+#include <math.h>
+
+TilemapTile tilemap_tile_pack(u32 gid, u32 x, u32 y)
+{
+    u32 tile = (gid & TILEMAP_GID_MASK) - 1;
+    if (tile >= TILEMAP_MAX_TILES)
+    {
+        FATAL("Tile %u doesn't fit in 16 bits\n", tile);
+    }
+
+    u32 flips = (gid & TILEMAP_FLIP_HORIZONTAL ? 1 : 0) |
+                (gid & TILEMAP_FLIP_VERTICAL ? 2 : 0) |
+                (gid & TILEMAP_FLIP_DIAGONAL ? 4 : 0);
+    return tile | flips << 16 | x << 19 | y << 24;
+}
+
+static void build_chunk(TilemapChunks *chunks, u32 *layer_data, int chunk_x,
+                        int chunk_y, vec *tiles)
+{
+    TilemapChunk chunk = {
+        .first = tiles->len,
+        .bounds = {.min = {.x = INFINITY, .y = INFINITY},
+                   .max = {.x = -INFINITY, .y = -INFINITY}},
+    };
+
+    int start_x = chunk_x * TILEMAP_CHUNK_SIZE;
+    int start_y = chunk_y * TILEMAP_CHUNK_SIZE;
+    int end_x = fmin(start_x + TILEMAP_CHUNK_SIZE, chunks->map_w);
+    int end_y = fmin(start_y + TILEMAP_CHUNK_SIZE, chunks->map_h);
+    for (int y = start_y; y < end_y; y++)
+    {
+        for (int x = start_x; x < end_x; x++)
+        {
+            u32 gid = layer_data[y * chunks->map_w + x];
+            if ((gid & TILEMAP_GID_MASK) == 0)
+                continue;
+
+            TilemapTile tile =
+                tilemap_tile_pack(gid, x - start_x, y - start_y);
+            vec_push(tiles, &tile);
+
+            chunk.bounds.min.x =
+                fminf(chunk.bounds.min.x, x * TILEMAP_TILE_SIZE);
+            chunk.bounds.min.y =
+                fminf(chunk.bounds.min.y, y * TILEMAP_TILE_SIZE);
+            chunk.bounds.max.x =
+                fmaxf(chunk.bounds.max.x, (x + 1) * TILEMAP_TILE_SIZE);
+            chunk.bounds.max.y =
+                fmaxf(chunk.bounds.max.y, (y + 1) * TILEMAP_TILE_SIZE);
+        }
+    }
+    chunk.count = tiles->len - chunk.first;
+    vec_push(&chunks->chunks, &chunk);
+}
+
+void tilemap_chunks_build(TilemapChunks *chunks, int map_w, int map_h,
+                          int layers, u32 *map_data, vec *tiles)
+{
+    chunks->map_w = map_w;
+    chunks->map_h = map_h;
+    chunks->layers = layers;
+    chunks->chunks_w = (map_w + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+    chunks->chunks_h = (map_h + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+
+    vec_init_with_capacity(&chunks->chunks, sizeof(TilemapChunk),
+                           chunks->chunks_w * chunks->chunks_h * layers);
+    vec_init(&chunks->layer_tiles, sizeof(u32));
+    vec_init(&chunks->layer_chunks, sizeof(u32));
+
+    for (int layer = 0; layer < layers; layer++)
+    {
+        u32 *layer_data = map_data + (usize)map_w * map_h * layer;
+        u32 first_tile = tiles->len;
+        u32 non_empty_chunks = 0;
+        for (int chunk_y = 0; chunk_y < chunks->chunks_h; chunk_y++)
+        {
+            for (int chunk_x = 0; chunk_x < chunks->chunks_w; chunk_x++)
+            {
+                build_chunk(chunks, layer_data, chunk_x, chunk_y, tiles);
+                TilemapChunk *chunk =
+                    vec_get(&chunks->chunks, chunks->chunks.len - 1);
+                if (chunk->count > 0)
+                    non_empty_chunks++;
+            }
+        }
+        u32 layer_tiles = tiles->len - first_tile;
+        vec_push(&chunks->layer_tiles, &layer_tiles);
+        vec_push(&chunks->layer_chunks, &non_empty_chunks);
+    }
+}
+
+void tilemap_chunks_free(TilemapChunks *chunks)
+{
+    vec_free(&chunks->chunks);
+    vec_free(&chunks->layer_tiles);
+    vec_free(&chunks->layer_chunks);
+}
+
+TilemapChunkRange tilemap_chunk_range(int chunks_w, int chunks_h, Rect view,
+                                      int margin)
+{
+    f32 chunk_pixels = TILEMAP_CHUNK_SIZE * TILEMAP_TILE_SIZE;
+    return (TilemapChunkRange){
+        .min_x = fmaxf(floorf(view.min.x / chunk_pixels) - margin, 0),
+        .min_y = fmaxf(floorf(view.min.y / chunk_pixels) - margin, 0),
+        .max_x = fminf(floorf(view.max.x / chunk_pixels) + margin,
+                       chunks_w - 1),
+        .max_y = fminf(floorf(view.max.y / chunk_pixels) + margin,
+                       chunks_h - 1),
+    };
+}
+
+void tilemap_chunks_visible(TilemapChunks *chunks, int layer, Rect view,
+                            vec *draws, CullStats *chunk_stats,
+                            CullStats *tile_stats)
+{
+    vec_clear(draws);
+    chunk_stats->submitted += *(u32 *)vec_get(&chunks->layer_chunks, layer);
+    tile_stats->submitted += chunks->map_w * chunks->map_h;
+
+    TilemapChunkRange range =
+        tilemap_chunk_range(chunks->chunks_w, chunks->chunks_h, view, 0);
+    TilemapChunk *layer_chunks = vec_get(
+        &chunks->chunks, (usize)layer * chunks->chunks_w * chunks->chunks_h);
+    for (int y = range.min_y; y <= range.max_y; y++)
+    {
+        for (int x = range.min_x; x <= range.max_x; x++)
+        {
+            TilemapChunk *chunk = &layer_chunks[y * chunks->chunks_w + x];
+            if (chunk->count == 0 || !rect_intersects(chunk->bounds, view))
+                continue;
+
+            chunk_stats->visible++;
+            tile_stats->visible += chunk->count;
+            TilemapDraw draw = {
+                .first = chunk->first,
+                .count = chunk->count,
+                .x = x * TILEMAP_CHUNK_SIZE,
+                .y = y * TILEMAP_CHUNK_SIZE,
+            };
+            vec_push(draws, &draw);
+        }
+    }
+}
+
+void tilemap_uv_table(vec *uvs, u32 tileset_w, u32 tileset_h)
+{
+    vec_clear(uvs);
+    u32 columns = tileset_w / TILEMAP_TILE_SIZE;
+    u32 rows = tileset_h / TILEMAP_TILE_SIZE;
+    for (u32 y = 0; y < rows; y++)
+    {
+        for (u32 x = 0; x < columns; x++)
+        {
+            // slightly smaller than 8x8 to reduce bleeding from adjacent
+            // pixels
+            TilemapUv uv = {
+                .min = {.x = (x * TILEMAP_TILE_SIZE + 0.01f) / tileset_w,
+                        .y = (y * TILEMAP_TILE_SIZE + 0.01f) / tileset_h},
+                .max = {.x = (x * TILEMAP_TILE_SIZE + 7.99f) / tileset_w,
+                        .y = (y * TILEMAP_TILE_SIZE + 7.99f) / tileset_h},
+            };
+            vec_push(uvs, &uv);
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "core_types.h"
+#include "graphics/culling.h"
+#include "sensible_nums.h"
+#include "utility/vec.h"
+
+// tilemaps are split into chunks of this many tiles square. each chunk only
+// has its non-empty tiles in it, and only the chunks that are on screen get
+// drawn
+#define TILEMAP_CHUNK_SIZE 32
+#define TILEMAP_TILE_SIZE 8
+
+// map data is Tiled's gids: 0 is empty, the tile is gid - 1 (there's only
+// ever one tileset), and the top bits say how it's flipped
+#define TILEMAP_FLIP_HORIZONTAL 0x80000000u
+#define TILEMAP_FLIP_VERTICAL 0x40000000u
+#define TILEMAP_FLIP_DIAGONAL 0x20000000u
+// this also gets rid of the hexagonal rotation bit, which we don't use
+#define TILEMAP_GID_MASK 0x0FFFFFFFu
+#define TILEMAP_MAX_TILES 0x10000
+
+// one instance per non-empty tile, packed into 32 bits so there's less to
+// upload and for the vertex shader to read:
+//   0-15  the tile in the tileset
+//  16-18  flipped horizontally, vertically, diagonally (see tilemap.wgsl)
+//  19-23  x in the chunk
+//  24-28  y in the chunk
+// empty tiles aren't in the instance buffer at all, which is why the position
+// has to be here. the chunk's position gets passed in when drawing
+typedef u32 TilemapTile;
+
+// `x` and `y` are in the chunk
+TilemapTile tilemap_tile_pack(u32 gid, u32 x, u32 y);
+
+typedef struct
+{
+    // where this chunk's tiles are in the instance buffer
+    u32 first, count;
+    // around the non-empty tiles, in pixels before the tilemap's transform
+    Rect bounds;
+} TilemapChunk;
+
+// chunks from min to max (inclusive). empty if min > max
+typedef struct
+{
+    int min_x, min_y, max_x, max_y;
+} TilemapChunkRange;
+
+// a chunk to draw
+typedef struct
+{
+    u32 first, count;
+    // in tiles, from the top left of the map
+    u32 x, y;
+} TilemapDraw;
+
+// where a tile is in the tileset texture, with a bit cut off each edge so the
+// tiles next to it don't bleed in
+typedef struct
+{
+    vec2s min, max;
+} TilemapUv;
+
+typedef struct
+{
+    int map_w, map_h, layers;
+    int chunks_w, chunks_h;
+
+    // vec<TilemapChunk>, chunks_w * chunks_h per layer, row by row. empty
+    // chunks are still here (with a count of 0) so finding the chunks on
+    // screen is just indexing
+    vec chunks;
+    // vec<u32>, how many non-empty tiles/chunks are in each layer
+    vec layer_tiles, layer_chunks;
+} TilemapChunks;
+
+// splits `map_data` (map_w * map_h gids per layer) into chunks. the tiles go
+// in `tiles` (a vec<TilemapTile>) chunk by chunk
+void tilemap_chunks_build(TilemapChunks *chunks, int map_w, int map_h,
+                          int layers, u32 *map_data, vec *tiles);
+void tilemap_chunks_free(TilemapChunks *chunks);
+
+// the chunks `view` covers (plus `margin` chunks around it), clamped to the map
+TilemapChunkRange tilemap_chunk_range(int chunks_w, int chunks_h, Rect view,
+                                      int margin);
+
+// fills `draws` (a vec<TilemapDraw>) with the chunks that need drawing for the
+// part of the map in `view` (in pixels before the tilemap's transform). the
+// number of chunks and tiles that are visible gets added to the stats.
+// tiles->submitted counts every tile in the layer, empty or not, since that's
+// how many used to be drawn
+void tilemap_chunks_visible(TilemapChunks *chunks, int layer, Rect view,
+                            vec *draws, CullStats *chunk_stats,
+                            CullStats *tile_stats);
+
+// fills `uvs` (a vec<TilemapUv>) with where each tile is in a tileset of this
+// size, so the shader doesn't have to work it out for every vertex
+void tilemap_uv_table(vec *uvs, u32 tileset_w, u32 tileset_h);
@@ -0,0 +1,412 @@
+#include "tilemap_stream.h"
+#include "utility/log.h"
+#include "utility/macros.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <webgpu.h>
+
+// a run in the compressed data. these aren't aligned, so they're memcpy'd
+#define RUN_SIZE (sizeof(u16) + sizeof(u32))
+
+void tilemap_stream_init(TilemapStream *stream, WGPUResources *resources,
+                         int map_w, int map_h, int layers,
+                         TilemapStreamSettings settings)
+{
+    assert(settings.pool_chunks > 0);
+
+    stream->settings = settings;
+    stream->map_w = map_w;
+    stream->map_h = map_h;
+    stream->layers = layers;
+    stream->chunks_w = (map_w + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+    stream->chunks_h = (map_h + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+
+    usize chunk_count = (usize)stream->chunks_w * stream->chunks_h * layers;
+    vec_init_with_capacity(&stream->chunks, sizeof(StreamedChunk),
+                           chunk_count);
+    for (usize i = 0; i < chunk_count; i++)
+    {
+        StreamedChunk empty = {.slot = TILEMAP_SLOT_NONE};
+        vec_push(&stream->chunks, &empty);
+    }
+    vec_init(&stream->compressed, sizeof(u8));
+    vec_init(&stream->layer_chunks, sizeof(u32));
+    for (int i = 0; i < layers; i++)
+    {
+        u32 none = 0;
+        vec_push(&stream->layer_chunks, &none);
+    }
+
+    WGPUBufferDescriptor buffer_desc = {
+        .label = "tilemap chunk pool",
+        .size = tilemap_stream_pool_bytes(stream),
+        .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex,
+    };
+    stream->pool = wgpuDeviceCreateBuffer(resources->device, &buffer_desc);
+
+    // every slot starts off free, in the lru list in order
+    vec_init_with_capacity(&stream->slots, sizeof(StreamSlot),
+                           settings.pool_chunks);
+    for (u32 i = 0; i < settings.pool_chunks; i++)
+    {
+        StreamSlot slot = {
+            .chunk = TILEMAP_SLOT_NONE,
+            .prev = i == 0 ? TILEMAP_SLOT_NONE : i - 1,
+            .next = i + 1 == settings.pool_chunks ? TILEMAP_SLOT_NONE : i + 1,
+        };
+        vec_push(&stream->slots, &slot);
+    }
+    stream->lru_head = 0;
+    stream->lru_tail = settings.pool_chunks - 1;
+    stream->resident = 0;
+
+    vec_init(&stream->requests, sizeof(StreamRequest));
+    stream->frame = 0;
+    stream->flushed = false;
+    stream->warned_full = false;
+    memset(&stream->stats, 0, sizeof(TilemapStreamStats));
+}
+
+static void push_run(vec *compressed, u16 length, u32 gid)
+{
+    if (compressed->len + RUN_SIZE > compressed->cap)
+        vec_resize(compressed, compressed->cap * 2 + RUN_SIZE);
+    u8 *run = (u8 *)compressed->data + compressed->len;
+    memcpy(run, &length, sizeof(u16));
+    memcpy(run + sizeof(u16), &gid, sizeof(u32));
+    compressed->len += RUN_SIZE;
+}
+
+void tilemap_stream_add_rows(TilemapStream *stream, int layer, int chunk_y,
+                             u32 *rows)
+{
+    int start_y = chunk_y * TILEMAP_CHUNK_SIZE;
+    int end_y = fmin(start_y + TILEMAP_CHUNK_SIZE, stream->map_h);
+    u32 *layer_chunks = vec_get(&stream->layer_chunks, layer);
+
+    for (int chunk_x = 0; chunk_x < stream->chunks_w; chunk_x++)
+    {
+        usize index =
+            ((usize)layer * stream->chunks_h + chunk_y) * stream->chunks_w +
+            chunk_x;
+        StreamedChunk *chunk = vec_get(&stream->chunks, index);
+        *chunk = (StreamedChunk){
+            .offset = stream->compressed.len,
+            .slot = TILEMAP_SLOT_NONE,
+            .bounds = {.min = {.x = INFINITY, .y = INFINITY},
+                       .max = {.x = -INFINITY, .y = -INFINITY}},
+        };
+
+        int start_x = chunk_x * TILEMAP_CHUNK_SIZE;
+        int end_x = fmin(start_x + TILEMAP_CHUNK_SIZE, stream->map_w);
+
+        // runs go row by row through the chunk, and can carry on into the
+        // next row
+        u16 length = 0;
+        u32 current = 0;
+        for (int y = start_y; y < end_y; y++)
+        {
+            for (int x = start_x; x < end_x; x++)
+            {
+                u32 gid = rows[(y - start_y) * stream->map_w + x];
+                if ((gid & TILEMAP_GID_MASK) != 0)
+                {
+                    chunk->count++;
+                    chunk->bounds.min.x =
+                        fminf(chunk->bounds.min.x, x * TILEMAP_TILE_SIZE);
+                    chunk->bounds.min.y =
+                        fminf(chunk->bounds.min.y, y * TILEMAP_TILE_SIZE);
+                    chunk->bounds.max.x = fmaxf(chunk->bounds.max.x,
+                                                (x + 1) * TILEMAP_TILE_SIZE);
+                    chunk->bounds.max.y = fmaxf(chunk->bounds.max.y,
+                                                (y + 1) * TILEMAP_TILE_SIZE);
+                }
+
+                if (length > 0 && gid == current)
+                {
+                    length++;
+                    continue;
+                }
+                if (length > 0)
+                {
+                    push_run(&stream->compressed, length, current);
+                    chunk->runs++;
+                }
+                current = gid;
+                length = 1;
+            }
+        }
+        if (length > 0)
+        {
+            push_run(&stream->compressed, length, current);
+            chunk->runs++;
+        }
+
+        // empty chunks don't need their runs
+        if (chunk->count == 0)
+        {
+            stream->compressed.len = chunk->offset;
+            chunk->runs = 0;
+        }
+        else
+        {
+            (*layer_chunks)++;
+        }
+    }
+}
+
+void tilemap_stream_free(TilemapStream *stream)
+{
+    wgpuBufferRelease(stream->pool);
+    vec_free(&stream->chunks);
+    vec_free(&stream->compressed);
+    vec_free(&stream->layer_chunks);
+    vec_free(&stream->slots);
+    vec_free(&stream->requests);
+}
+
+u64 tilemap_stream_pool_bytes(TilemapStream *stream)
+{
+    return (u64)stream->settings.pool_chunks * TILEMAP_SLOT_SIZE;
+}
+
+// ---  ---
+
+static StreamSlot *get_slot(TilemapStream *stream, u32 slot)
+{
+    return vec_get(&stream->slots, slot);
+}
+
+static void lru_unlink(TilemapStream *stream, u32 index)
+{
+    StreamSlot *slot = get_slot(stream, index);
+    if (slot->prev != TILEMAP_SLOT_NONE)
+        get_slot(stream, slot->prev)->next = slot->next;
+    else
+        stream->lru_head = slot->next;
+    if (slot->next != TILEMAP_SLOT_NONE)
+        get_slot(stream, slot->next)->prev = slot->prev;
+    else
+        stream->lru_tail = slot->prev;
+}
+
+// moves a slot to the front of the lru list
+static void touch(TilemapStream *stream, u32 index)
+{
+    StreamSlot *slot = get_slot(stream, index);
+    slot->last_used = stream->frame;
+    if (stream->lru_head == index)
+        return;
+
+    lru_unlink(stream, index);
+    slot->prev = TILEMAP_SLOT_NONE;
+    slot->next = stream->lru_head;
+    get_slot(stream, stream->lru_head)->prev = index;
+    stream->lru_head = index;
+}
+
+static StreamedChunk *chunk_at(TilemapStream *stream, int layer, int x, int y)
+{
+    usize index =
+        ((usize)layer * stream->chunks_h + y) * stream->chunks_w + x;
+    return vec_get(&stream->chunks, index);
+}
+
+static void decompress(TilemapStream *stream, u32 index)
+{
+    StreamedChunk *chunk = vec_get(&stream->chunks, index);
+    u32 chunk_index = index % (stream->chunks_w * stream->chunks_h);
+    int start_x = (chunk_index % stream->chunks_w) * TILEMAP_CHUNK_SIZE;
+    int width = fmin(TILEMAP_CHUNK_SIZE, stream->map_w - start_x);
+
+    u8 *runs = vec_get(&stream->compressed, chunk->offset);
+    u32 position = 0, tiles = 0;
+    for (u32 i = 0; i < chunk->runs; i++)
+    {
+        u16 length;
+        u32 gid;
+        memcpy(&length, runs + i * RUN_SIZE, sizeof(u16));
+        memcpy(&gid, runs + i * RUN_SIZE + sizeof(u16), sizeof(u32));
+        if ((gid & TILEMAP_GID_MASK) == 0)
+        {
+            position += length;
+            continue;
+        }
+        for (u32 j = 0; j < length; j++, position++)
+        {
+            stream->scratch[tiles++] = tilemap_tile_pack(
+                gid, position % width, position / width);
+        }
+    }
+    assert(tiles == chunk->count);
+}
+
+// a free slot, or whichever was used the longest time ago. slots used this
+// frame are being drawn, so they can't be taken
+static u32 take_slot(TilemapStream *stream)
+{
+    u32 index = stream->lru_tail;
+    StreamSlot *slot = get_slot(stream, index);
+    if (slot->chunk != TILEMAP_SLOT_NONE)
+    {
+        if (slot->last_used == stream->frame)
+            return TILEMAP_SLOT_NONE;
+
+        StreamedChunk *evicted = vec_get(&stream->chunks, slot->chunk);
+        evicted->slot = TILEMAP_SLOT_NONE;
+        slot->chunk = TILEMAP_SLOT_NONE;
+        stream->resident--;
+        stream->stats.evictions++;
+    }
+    return index;
+}
+
+static int compare_requests(const void *a, const void *b)
+{
+    const StreamRequest *left = a, *right = b;
+    if (left->priority != right->priority)
+        return left->priority < right->priority ? -1 : 1;
+    return left->chunk < right->chunk ? -1 : left->chunk > right->chunk;
+}
+
+// ---  ---
+
+void tilemap_stream_request(TilemapStream *stream, int layer, Rect view,
+                            u64 frame)
+{
+    if (frame != stream->frame)
+    {
+        stream->frame = frame;
+        stream->flushed = false;
+        vec_clear(&stream->requests);
+        stream->stats.uploaded_bytes = 0;
+        stream->stats.uploads = 0;
+        stream->stats.evictions = 0;
+        stream->stats.missing = 0;
+    }
+
+    TilemapChunkRange visible =
+        tilemap_chunk_range(stream->chunks_w, stream->chunks_h, view, 0);
+    TilemapChunkRange wanted = tilemap_chunk_range(
+        stream->chunks_w, stream->chunks_h, view, stream->settings.margin);
+    vec2s center = rect_center(view);
+
+    for (int y = wanted.min_y; y <= wanted.max_y; y++)
+    {
+        for (int x = wanted.min_x; x <= wanted.max_x; x++)
+        {
+            StreamedChunk *chunk = chunk_at(stream, layer, x, y);
+            if (chunk->count == 0)
+                continue;
+            if (chunk->slot != TILEMAP_SLOT_NONE)
+            {
+                touch(stream, chunk->slot);
+                continue;
+            }
+
+            // whatever's on screen goes first, then the nearest chunks
+            bool on_screen = x >= visible.min_x && x <= visible.max_x &&
+                             y >= visible.min_y && y <= visible.max_y;
+            vec2s chunk_center = rect_center(chunk->bounds);
+            f32 distance = glms_vec2_distance(center, chunk_center);
+            StreamRequest request = {
+                .chunk = chunk - (StreamedChunk *)stream->chunks.data,
+                .priority = on_screen ? distance - 1e9f : distance,
+            };
+            vec_push(&stream->requests, &request);
+        }
+    }
+}
+
+void tilemap_stream_flush(TilemapStream *stream, WGPUResources *resources)
+{
+    if (stream->flushed)
+        return;
+    stream->flushed = true;
+
+    qsort(stream->requests.data, stream->requests.len, sizeof(StreamRequest),
+          compare_requests);
+
+    StreamRequest *requests = (StreamRequest *)stream->requests.data;
+    for (usize i = 0; i < stream->requests.len; i++)
+    {
+        StreamedChunk *chunk = vec_get(&stream->chunks, requests[i].chunk);
+        // the same layer can be asked for twice in a frame
+        if (chunk->slot != TILEMAP_SLOT_NONE)
+            continue;
+
+        // at least one chunk always gets uploaded, so a tiny budget still
+        // gets there eventually
+        u64 bytes = chunk->count * sizeof(TilemapTile);
+        if (stream->stats.uploads > 0 &&
+            stream->stats.uploaded_bytes + bytes >
+                stream->settings.upload_budget)
+            break;
+
+        u32 slot_index = take_slot(stream);
+        if (slot_index == TILEMAP_SLOT_NONE)
+        {
+            if (stream->warned_full)
+                break;
+            stream->warned_full = true;
+            log_warn("tilemap chunk pool is too small for what's on screen "
+                     "(%u chunks)",
+                     stream->settings.pool_chunks);
+            break;
+        }
+
+        decompress(stream, requests[i].chunk);
+        wgpuQueueWriteBuffer(resources->queue, stream->pool,
+                             (u64)slot_index * TILEMAP_SLOT_SIZE,
+                             stream->scratch, bytes);
+
+        get_slot(stream, slot_index)->chunk = requests[i].chunk;
+        stream->resident++;
+        chunk->slot = slot_index;
+        touch(stream, slot_index);
+
+        stream->stats.uploaded_bytes += bytes;
+        stream->stats.uploads++;
+    }
+
+    if (stream->stats.uploaded_bytes > stream->stats.peak_uploaded_bytes)
+        stream->stats.peak_uploaded_bytes = stream->stats.uploaded_bytes;
+}
+
+void tilemap_stream_visible(TilemapStream *stream, int layer, Rect view,
+                            vec *draws, CullStats *chunk_stats,
+                            CullStats *tile_stats)
+{
+    vec_clear(draws);
+    chunk_stats->submitted += *(u32 *)vec_get(&stream->layer_chunks, layer);
+    tile_stats->submitted += stream->map_w * stream->map_h;
+
+    TilemapChunkRange range =
+        tilemap_chunk_range(stream->chunks_w, stream->chunks_h, view, 0);
+    for (int y = range.min_y; y <= range.max_y; y++)
+    {
+        for (int x = range.min_x; x <= range.max_x; x++)
+        {
+            StreamedChunk *chunk = chunk_at(stream, layer, x, y);
+            if (chunk->count == 0 || !rect_intersects(chunk->bounds, view))
+                continue;
+            if (chunk->slot == TILEMAP_SLOT_NONE)
+            {
+                stream->stats.missing++;
+                continue;
+            }
+
+            chunk_stats->visible++;
+            tile_stats->visible += chunk->count;
+            TilemapDraw draw = {
+                .first = chunk->slot * TILEMAP_CHUNK_TILES,
+                .count = chunk->count,
+                .x = x * TILEMAP_CHUNK_SIZE,
+                .y = y * TILEMAP_CHUNK_SIZE,
+            };
+            vec_push(draws, &draw);
+        }
+    }
+}
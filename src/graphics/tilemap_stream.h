@@ -0,0 +1,129 @@
+#pragma once
+
+#include "core_types.h"
+#include "graphics/culling.h"
+#include "graphics/tilemap_chunks.h"
+#include "graphics/wgpu_resources.h"
+#include "sensible_nums.h"
+#include "utility/vec.h"
+
+// for maps that are too big to keep on the gpu all at once.
+//
+// the tiles are kept on the cpu, run length encoded chunk by chunk, and only
+// the chunks around the camera are on the gpu. the gpu side is a fixed size
+// pool of chunk slots, so how much memory it uses doesn't depend on the map.
+// when the pool is full, the chunk that was used the longest time ago gets
+// replaced.
+//
+// each frame, every layer asks for the chunks it's going to draw (plus a
+// margin around them, so walking around doesn't show chunks popping in), and
+// then the ones that aren't there yet get uploaded, nearest first, up to a
+// per frame budget. anything that didn't fit just gets uploaded next frame.
+
+#define TILEMAP_CHUNK_TILES (TILEMAP_CHUNK_SIZE * TILEMAP_CHUNK_SIZE)
+#define TILEMAP_SLOT_SIZE (TILEMAP_CHUNK_TILES * sizeof(TilemapTile))
+#define TILEMAP_SLOT_NONE UINT32_MAX
+
+typedef struct
+{
+    // how many chunks fit on the gpu at once
+    u32 pool_chunks;
+    // how many chunks around the view get loaded ahead of time
+    u32 margin;
+    // how many bytes can be uploaded each frame
+    u64 upload_budget;
+} TilemapStreamSettings;
+
+typedef struct
+{
+    // where this chunk's runs are in TilemapStream.compressed
+    usize offset;
+    u32 runs;
+    // non-empty tiles
+    u32 count;
+    // see TilemapChunk.bounds
+    Rect bounds;
+    // which slot it's in, or TILEMAP_SLOT_NONE if it's not on the gpu
+    u32 slot;
+} StreamedChunk;
+
+typedef struct
+{
+    // index into TilemapStream.chunks, or TILEMAP_SLOT_NONE if it's free
+    u32 chunk;
+    // the lru list, most recently used first
+    u32 prev, next;
+    u64 last_used;
+} StreamSlot;
+
+typedef struct
+{
+    u32 chunk;
+    // lower gets uploaded first
+    f32 priority;
+} StreamRequest;
+
+typedef struct
+{
+    // for the last frame
+    u64 uploaded_bytes;
+    u32 uploads, evictions;
+    // chunks that were on screen but weren't on the gpu yet
+    u32 missing;
+    // since the stream was made
+    u64 peak_uploaded_bytes;
+} TilemapStreamStats;
+
+typedef struct
+{
+    TilemapStreamSettings settings;
+    int map_w, map_h, layers;
+    int chunks_w, chunks_h;
+
+    vec chunks;     // vec<StreamedChunk>, laid out like TilemapChunks.chunks
+    vec compressed; // vec<u8>, runs of (u16 length, u32 gid)
+    vec layer_chunks; // vec<u32>, how many non-empty chunks are in each layer
+
+    WGPUBuffer pool;
+    vec slots; // vec<StreamSlot>
+    u32 lru_head, lru_tail;
+    u32 resident;
+
+    // chunks asked for this frame that aren't on the gpu yet
+    vec requests; // vec<StreamRequest>
+    u64 frame;
+    bool flushed;
+    // so a pool that's too small doesn't warn every frame
+    bool warned_full;
+
+    TilemapStreamStats stats;
+    // where chunks get decompressed to before uploading
+    TilemapTile scratch[TILEMAP_CHUNK_TILES];
+} TilemapStream;
+
+void tilemap_stream_init(TilemapStream *stream, WGPUResources *resources,
+                         int map_w, int map_h, int layers,
+                         TilemapStreamSettings settings);
+// compresses one row of chunks from `rows`, which is map_w * TILEMAP_CHUNK_SIZE
+// gids (fewer at the bottom of the map). this way the whole map doesn't need
+// to be in memory uncompressed
+void tilemap_stream_add_rows(TilemapStream *stream, int layer, int chunk_y,
+                             u32 *rows);
+void tilemap_stream_free(TilemapStream *stream);
+
+// marks the chunks in and around `view` (in pixels before the tilemap's
+// transform) as needed this frame. the first call with a new `frame` forgets
+// the last frame's requests
+void tilemap_stream_request(TilemapStream *stream, int layer, Rect view,
+                            u64 frame);
+// uploads what was requested, up to the budget. only does anything the first
+// time it's called each frame
+void tilemap_stream_flush(TilemapStream *stream, WGPUResources *resources);
+
+// like tilemap_chunks_visible, but the draws are slots in the pool. chunks
+// that aren't on the gpu yet are skipped
+void tilemap_stream_visible(TilemapStream *stream, int layer, Rect view,
+                            vec *draws, CullStats *chunk_stats,
+                            CullStats *tile_stats);
+
+u64 tilemap_stream_pool_bytes(TilemapStream *stream);
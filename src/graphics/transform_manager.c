@@ -113,6 +113,16 @@ Transform transform_manager_get(TransformManager *manager, TransformEntry entry)
     return transform_from_matrix(data->transform);
 }
 
+mat4s transform_manager_get_matrix(TransformManager *manager,
+                                   TransformEntry entry)
+{
+    TransformEntryData *data = vec_get(&manager->entries, entry);
+    assert(data != NULL);
+    assert(data->next.is_free != TRANSFORM_ENTRY_FREE);
+
+    return data->transform;
+}
+
 // ---  ---
 
 bool transform_manager_upload_dirty(TransformManager *manager,
@@ -31,6 +31,9 @@ void transform_manager_update(TransformManager *manager, TransformEntry entry,
 // to update them!
 Transform transform_manager_get(TransformManager *manager,
                                 TransformEntry entry);
+// this one's fast, since the matrix is what's actually stored
+mat4s transform_manager_get_matrix(TransformManager *manager,
+                                   TransformEntry entry);
 
 // call before using for rendering
 // returns true if the buffer was regenerated
@@ -1,6 +1,7 @@
 #include "ui_sprite.h"
 #include "core_types.h"
 #include "graphics/quad_manager.h"
+#include "graphics/sprite_batch.h"
 #include "graphics/tex_manager.h"
 #include "sensible_nums.h"
 
@@ -20,21 +21,24 @@ void ui_sprite_free(UiSprite *sprite, Graphics *graphics)
     texture_manager_unload(&graphics->texture_manager, sprite->texture);
 }
 
-void ui_sprite_render(UiSprite *sprite, mat4s camera,
-                      WGPURenderPassEncoder pass)
+void ui_sprite_batch_thing(void *thing, void *batch)
 {
-
-    UiSpritePushConstants push_constants = {
-        .camera = camera,
-        .texture_index = sprite->texture->index,
+    UiSprite *sprite = thing;
+    SpriteInstance instance = {
         .transform_index = sprite->transform,
+        .texture_index = sprite->texture->index,
+        .quad_index = sprite->quad,
         .opacity = sprite->opacity,
+        // the ui camera never moves
+        .parallax = GLMS_VEC2_ONE,
     };
+    vec_push(batch, &instance);
+}
 
-    wgpuRenderPassEncoderSetPushConstants(
-        pass, WGPUShaderStage_Fragment | WGPUShaderStage_Vertex, 0,
-        sizeof(SpritePushConstants), &push_constants);
-    wgpuRenderPassEncoderDrawIndexed(pass, VERTICES_PER_QUAD, 1, 0,
-                                     QUAD_ENTRY_TO_VERTEX_INDEX(sprite->quad),
-                                     0);
+void ui_sprite_cull_keys(void *thing, CullKeys *keys)
+{
+    UiSprite *sprite = thing;
+    keys->transform = sprite->transform;
+    keys->quad = sprite->quad;
+    keys->parallax = GLMS_VEC2_ONE;
 }
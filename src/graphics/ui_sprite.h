@@ -15,5 +15,7 @@ void ui_sprite_init(UiSprite *sprite, TextureEntry *texture,
                     TransformEntry transform, QuadEntry quad, f32 opacity);
 void ui_sprite_free(UiSprite *sprite, Graphics *graphics);
 
-void ui_sprite_render(UiSprite *sprite, mat4s camera,
-                      WGPURenderPassEncoder pass);
+// adds a ui sprite to a vec<SpriteInstance> (see layer_init_batched)
+void ui_sprite_batch_thing(void *thing, void *batch);
+// for culling ui layers (see layer_enable_culling)
+void ui_sprite_cull_keys(void *thing, CullKeys *keys);
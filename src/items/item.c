@@ -6,7 +6,10 @@ static void on_use(Resources *resources)
 {
     MapScene *scene = (MapScene *)resources->scene;
 
-    textbox_display_text(&scene->textbox, resources, "i've been used");
+    TextRuns text;
+    text_runs_parse(&text, "i've been used");
+    textbox_display_text(&scene->textbox, resources, &text);
+    text_runs_free(&text);
 }
 
 const Item ITEMS[Item_Max] = {
@@ -15,31 +15,37 @@
 
 #include "utility/macros.h"
 #include "utility/common_defines.h"
+#include "animation/animation.h"
+#include "animation/loader.h"
 #include "debug/debug_window.h"
-#include "events/compiler.h"
+#include "events/event_index.h"
 #include "scenes/fmod_logo.h"
 #include "scenes/title.h"
 #include "settings.h"
 #include "utility/files.h"
+#include "utility/intern.h"
+#include "utility/log.h"
 
 #define WINDOW_NAME "i am the window"
 
-static void event_free_fn(usize i, void *ptr)
-{
-    (void)i;
-    Event *event = ptr;
-    event_free(event);
-}
-
 int main(int argc, char **argv)
 {
     bool imgui_demo = false;
     bool debug = false;
+    // always interpret events, even if they've been translated to C
+    bool no_aot = false;
+    // compile every event at startup instead of when they're first used
+    bool eager_events = false;
+    // count what scripts are doing from the start (see events/profiler.h)
+    bool profile_scripts = false;
 
     for (int i = 0; i < argc; i++)
     {
         imgui_demo |= !strcmp(argv[i], "--imgui-demo");
         debug |= !strcmp(argv[i], "--debug");
+        no_aot |= !strcmp(argv[i], "--no-aot");
+        eager_events |= !strcmp(argv[i], "--eager-events");
+        profile_scripts |= !strcmp(argv[i], "--profile-scripts");
     }
 
     Resources resources;
@@ -85,6 +91,16 @@ int main(int argc, char **argv)
 
     audio_init(&resources.audio, debug, &resources.settings);
     input_init(&resources.input, resources.window);
+
+    // every animation needs to be known before graphics_init, which gives
+    // sprite.wgsl a copy of them
+    animation_defs_init();
+    char animation_err[256];
+    if (SDL_GetPathInfo("assets/animations.ini", NULL) &&
+        !animation_defs_load_file("assets/animations.ini", animation_err))
+        FATAL("Failed to load assets/animations.ini: %s\n", animation_err);
+    animations_init(&resources.animations);
+
     graphics_init(&resources.graphics, resources.window, &resources.settings);
     physics_init(&resources.physics);
     fonts_init(&resources.fonts);
@@ -95,29 +111,31 @@ int main(int argc, char **argv)
     char *files[] = {
         "assets/events.txt",
     };
-    vec events;
-    vec_init(&events, sizeof(Event));
 
+    // events are only compiled once something needs them (see event_index.h)
+    u64 index_start = SDL_GetPerformanceCounter();
+    event_index_init(&resources.events, !no_aot);
+    // pick up script edits without restarting
+#ifdef DEBUG
+    resources.events.hot_reload = true;
+#else
+    resources.events.hot_reload = debug;
+#endif
     for (u32 i = 0; i < 1; i++)
-    {
-        char *out;
-        read_entire_file(files[i], &out, NULL);
-
-        Compiler compiler;
-        compiler_init(&compiler, out);
-
-        Event event;
-        while (compiler_compile(&compiler, &event))
-        {
-            event_disassemble(&event);
-            vec_push(&events, &event);
-        }
-
-        free(out);
-    }
-
-    resources.events = (Event *)events.data;
-    resources.event_count = events.len;
+        event_index_add_file(&resources.events, files[i]);
+    if (eager_events)
+        event_index_compile_all(&resources.events);
+    f64 index_ms = (f64)(SDL_GetPerformanceCounter() - index_start) * 1000.0 /
+                   SDL_GetPerformanceFrequency();
+    log_info("Indexed %u events (%u compiled) in %.2fms",
+             event_index_count(&resources.events),
+             resources.events.compiled_count, index_ms);
+
+    scheduler_init(&resources.scheduler);
+    globals_clear(&resources.globals);
+    vm_profiler_init(&resources.profiler);
+    if (profile_scripts)
+        vm_profiler = &resources.profiler;
 
     WGPUMultisampleState multisample_state = {
         .count = 1,
@@ -181,6 +199,8 @@ int main(int argc, char **argv)
             }
         }
 
+        event_index_poll(&resources.events, &resources.scheduler);
+
         // we have to start the frame after we hand imgui all the events,
         // otherwise imgui will lag 1 frame behind the game logic. this is
         // especially important if the window is resized!
@@ -216,9 +236,19 @@ int main(int argc, char **argv)
         resources.time.current = resources.time.virt.time;
         resources.scene_interface.update(&resources);
 
+        // after the scene, so anything it started gets its first frame before
+        // it's drawn
+        animations_update(
+            &resources.animations,
+            graphics_animation_time(resources.time.virt.time.elapsed));
+        animations_update_quads(&resources.animations,
+                                &resources.graphics.quad_manager);
+        animations_play_sounds(&resources.animations, &resources);
+
         igRender();
+        // virtual time, so animated tiles stop when the game's paused
         graphics_render(&resources.graphics, &resources.physics,
-                        resources.raw_camera);
+                        resources.raw_camera, resources.time.virt.time.elapsed);
 
         if (first_frame)
         {
@@ -250,8 +280,13 @@ int main(int argc, char **argv)
     }
 
     resources.scene_interface.free(&resources);
+    animations_free(&resources.animations);
 
-    vec_free_with(&events, event_free_fn);
+    scheduler_free(&resources.scheduler);
+    vm_profiler_free(&resources.profiler);
+    event_index_free(&resources.events);
+    global_names_free();
+    intern_free();
 
     settings_save_to(&resources.settings, settings_path);
 
@@ -262,6 +297,7 @@ int main(int argc, char **argv)
     fonts_free(&resources.fonts);
     physics_free(&resources.physics);
     graphics_free(&resources.graphics);
+    animation_defs_free();
     audio_free(&resources.audio);
 
     SDL_DestroyWindow(resources.window);
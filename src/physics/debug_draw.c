@@ -4,6 +4,7 @@
 #include "utility/common_defines.h"
 #include "webgpu.h"
 #include "wgpu.h"
+#include <math.h>
 
 vec3s vec3_from_hex(b2HexColor color)
 {
@@ -14,16 +15,39 @@ vec3s vec3_from_hex(b2HexColor color)
     };
 }
 
+// box2d draws everything in the world, so skip what's not on screen.
+// `center` and `radius` are in meters
+static bool shape_visible(Box2DDebugCtx *ctx, b2Vec2 center, f32 radius)
+{
+    CullView view = {
+        .position = {.x = ctx->raw_camera.x, .y = ctx->raw_camera.y},
+        .size = {.x = GAME_VIEW_WIDTH, .y = GAME_VIEW_HEIGHT},
+    };
+    // y is flipped, same as the shaders do
+    Rect bounds = rect_from_center_radius(
+        (vec2s){.x = M_TO_PX(center.x), .y = M_TO_PX(-center.y)},
+        VEC2_SPLAT(M_TO_PX(radius)));
+
+    CullStats *stats = &ctx->graphics->cull_stats.debug_shapes;
+    stats->submitted++;
+    if (!rect_intersects(bounds, cull_view_rect(view, GLMS_VEC2_ONE)))
+        return false;
+    stats->visible++;
+    return true;
+}
+
 void draw_maybe_solid_circle(b2Vec2 center, float radius, b2HexColor color,
                              void *context, bool solid)
 {
     Box2DDebugCtx *ctx = context;
+    if (!shape_visible(ctx, center, radius))
+        return;
 
     u64 quad_buffer_size =
         wgpuBufferGetSize(ctx->graphics->quad_manager.buffer);
 
-    wgpuRenderPassEncoderSetPipeline(ctx->pass,
-                                     ctx->graphics->shaders.box2d_debug.circle);
+    render_state_set_pipeline(ctx->state,
+                              ctx->graphics->shaders.box2d_debug.circle);
 
     float scale =
         (float)ctx->graphics->wgpu.surface_config.width / GAME_VIEW_WIDTH;
@@ -36,18 +60,18 @@ void draw_maybe_solid_circle(b2Vec2 center, float radius, b2HexColor color,
         .internal_scale = scale,
         .solid = solid,
     };
-    wgpuRenderPassEncoderSetPushConstants(
-        ctx->pass, WGPUShaderStage_Fragment | WGPUShaderStage_Vertex, 0,
-        sizeof(B2DCirclePushConstants), &push_constants);
-
-    wgpuRenderPassEncoderSetVertexBuffer(
-        ctx->pass, 0, ctx->graphics->quad_manager.buffer, 0, quad_buffer_size);
-    wgpuRenderPassEncoderSetIndexBuffer(
-        ctx->pass, ctx->graphics->quad_manager.index_buffer,
-        WGPUIndexFormat_Uint16, 0, 16);
-    wgpuRenderPassEncoderDrawIndexed(
-        ctx->pass, VERTICES_PER_QUAD, 1, 0,
-        QUAD_ENTRY_TO_VERTEX_INDEX(graphics_screen_quad_entry()), 0);
+    render_state_set_push_constants(ctx->state, sizeof(B2DCirclePushConstants),
+                                    &push_constants);
+
+    render_state_set_vertex_buffer(ctx->state, 0,
+                                   ctx->graphics->quad_manager.buffer, 0,
+                                   quad_buffer_size);
+    render_state_set_index_buffer(ctx->state,
+                                  ctx->graphics->quad_manager.index_buffer,
+                                  WGPUIndexFormat_Uint16, 0, 16);
+    render_state_draw_indexed(
+        ctx->state, VERTICES_PER_QUAD, 1, 0,
+        QUAD_ENTRY_TO_VERTEX_INDEX(graphics_screen_quad_entry()));
 }
 
 // FIXME we should be drawing a line to indicate the rotation of the circle
@@ -75,6 +99,14 @@ void draw_maybe_solid_polygon(b2Transform transform, const b2Vec2 *vertices,
                               bool solid)
 {
     Box2DDebugCtx *ctx = context;
+
+    // the polygon can be rotated, so use the furthest vertex as a radius
+    f32 radius = 0.0;
+    for (i32 i = 0; i < vertex_count; i++)
+        radius = fmaxf(radius, b2Length(vertices[i]));
+    if (!shape_visible(ctx, transform.p, radius))
+        return;
+
     // this is a bit of a nightmare to do...
     // box2d gives us a CCW list of vertices, but we need to draw them as a
     // triangles!
@@ -99,8 +131,8 @@ void draw_maybe_solid_polygon(b2Transform transform, const b2Vec2 *vertices,
                          sizeof(u32) * (vertex_count - 2) * 3);
     free(indices);
 
-    wgpuRenderPassEncoderSetPipeline(
-        ctx->pass, ctx->graphics->shaders.box2d_debug.polygon);
+    render_state_set_pipeline(ctx->state,
+                              ctx->graphics->shaders.box2d_debug.polygon);
 
     float scale =
         (float)ctx->graphics->wgpu.surface_config.width / GAME_VIEW_WIDTH;
@@ -115,17 +147,16 @@ void draw_maybe_solid_polygon(b2Transform transform, const b2Vec2 *vertices,
         .solid = solid,
     };
 
-    wgpuRenderPassEncoderSetPushConstants(
-        ctx->pass, WGPUShaderStage_Fragment | WGPUShaderStage_Vertex, 0,
-        sizeof(B2DDrawPolygonPushConstants), &push_constants);
+    render_state_set_push_constants(
+        ctx->state, sizeof(B2DDrawPolygonPushConstants), &push_constants);
 
-    wgpuRenderPassEncoderSetVertexBuffer(ctx->pass, 0, ctx->vertex_buffer,
-                                         ctx->vertex_index, vertex_buffer_size);
-    wgpuRenderPassEncoderSetIndexBuffer(ctx->pass, ctx->index_buffer,
-                                        WGPUIndexFormat_Uint32,
-                                        ctx->index_index, index_buffer_size);
+    render_state_set_vertex_buffer(ctx->state, 0, ctx->vertex_buffer,
+                                   ctx->vertex_index, vertex_buffer_size);
+    render_state_set_index_buffer(ctx->state, ctx->index_buffer,
+                                  WGPUIndexFormat_Uint32, ctx->index_index,
+                                  index_buffer_size);
 
-    wgpuRenderPassEncoderDrawIndexed(ctx->pass, index_count, 1, 0, 0, 0);
+    render_state_draw_indexed(ctx->state, index_count, 1, 0, 0);
 
     ctx->vertex_index += vertex_buffer_size;
     ctx->index_index += index_buffer_size;
@@ -191,9 +222,9 @@ void draw_capsule(b2Vec2 c1, b2Vec2 c2, float rad, b2HexColor color, void *ctx)
 }
 
 void physics_debug_draw(Box2DDebugCtx *ctx, Physics *physics,
-                        WGPURenderPassEncoder pass)
+                        RenderState *state)
 {
-    ctx->pass = pass;
+    ctx->state = state;
     b2DebugDraw debug_draw = {.context = ctx,
                               .DrawCircle = draw_circle,
                               .DrawPoint = draw_point,
@@ -10,7 +10,9 @@
 typedef struct
 {
     Graphics *graphics;
-    WGPURenderPassEncoder pass;
+    // every circle uses the same pipeline and buffers, so going through this
+    // means only the first one actually sets them
+    RenderState *state;
     Camera raw_camera;
     WGPUBuffer vertex_buffer;
     WGPUBuffer index_buffer;
@@ -23,6 +25,6 @@ typedef struct
 void physics_debug_draw_init(Box2DDebugCtx *ctx, Graphics *graphics,
                              Camera raw_camera);
 void physics_debug_draw(Box2DDebugCtx *ctx, Physics *physics,
-                        WGPURenderPassEncoder pass);
+                        RenderState *state);
 // call this after finished with the renderpass!
 void physics_debug_draw_free(Box2DDebugCtx *ctx);
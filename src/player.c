@@ -36,7 +36,7 @@ void player_init(Player *player, b2Vec2 initial_pos, Resources *resources)
     QuadEntry quad_entry =
         quad_manager_add(&resources->graphics.quad_manager, player->quad);
 
-    TextureEntry *texture = texture_manager_load(
+    TextureEntry *texture = texture_manager_load_async(
         &resources->graphics.texture_manager, "assets/textures/player.png",
         &resources->graphics.wgpu);
 
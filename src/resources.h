@@ -1,6 +1,10 @@
 #pragma once
 
-#include "events/event.h"
+#include "animation/animations.h"
+#include "events/event_index.h"
+#include "events/globals.h"
+#include "events/profiler.h"
+#include "events/scheduler.h"
 #include "fonts/fonts.h"
 #include "graphics/graphics.h"
 #include "items/item.h"
@@ -26,6 +30,8 @@ typedef struct Resources
     Camera raw_camera;
     Fonts fonts;
     Settings settings;
+    // every playing animation, updated once a frame after the scene
+    Animations animations;
 
     // all scenes are required to start with SceneType as their first field.
     // use that to check what the current scene is rather than checking the
@@ -50,8 +56,15 @@ typedef struct Resources
         Time current;
     } time;
 
-    Event *events;
-    u32 event_count;
+    // every event, compiled as they're needed
+    EventIndex events;
+    // every running event script
+    Scheduler scheduler;
+    // $variables in scripts, which last between events
+    Globals globals;
+    // what those scripts are spending their time on, while vm_profiler points
+    // at it
+    VMProfiler profiler;
 
     ItemType inventory[INVENTORY_SIZE];
 
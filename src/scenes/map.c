@@ -5,6 +5,7 @@
 #include "ui/settings.h"
 #include "ui/textbox.h"
 #include "utility/common_defines.h"
+#include "utility/log.h"
 #include "utility/macros.h"
 #include "map_loader.h"
 #include "characters/character.h"
@@ -47,6 +48,7 @@ static char *tiled_image_path_to_actual(char *path)
 void map_scene_init(Resources *resources, void *extra_args)
 {
     MapInitArgs *args = (MapInitArgs *)extra_args;
+    u64 load_start = SDL_GetPerformanceCounter();
 
     MapScene *map_scene = malloc(sizeof(MapScene));
     resources->scene = (Scene *)map_scene;
@@ -96,9 +98,9 @@ void map_scene_init(Resources *resources, void *extra_args)
 
     char *actual_path =
         tiled_image_path_to_actual(map->ts_head->tileset->image->source);
-    TextureEntry *tileset_texture =
-        texture_manager_load(&resources->graphics.texture_manager, actual_path,
-                             &resources->graphics.wgpu);
+    TextureEntry *tileset_texture = texture_manager_load_async(
+        &resources->graphics.texture_manager, actual_path,
+        &resources->graphics.wgpu);
     free(actual_path);
 
     Transform transform = transform_from_xyz(0, 0, 0);
@@ -111,6 +113,12 @@ void map_scene_init(Resources *resources, void *extra_args)
 
     free(load.tiles);
 
+    TilemapAnimations tile_animations;
+    handle_tile_animations(map->ts_head->tileset, &tile_animations);
+    tilemap_set_animations(&map_scene->tilemap, &resources->graphics,
+                           &tile_animations);
+    tilemap_animations_free(&tile_animations);
+
     player_init(&map_scene->player, player_position, resources);
 
     settings_menu_init(&map_scene->settings, resources);
@@ -139,12 +147,23 @@ void map_scene_init(Resources *resources, void *extra_args)
 
     vec_free(&load_characters);
     tmx_map_free(map);
+
+    // textures loaded async aren't counted, they show up over the next few
+    // frames
+    f64 load_ms = (f64)(SDL_GetPerformanceCounter() - load_start) * 1000.0 /
+                  SDL_GetPerformanceFrequency();
+    log_info("Loaded %s in %.2fms (%u textures still loading)",
+             map_scene->current_map, load_ms,
+             (u32)resources->graphics.texture_manager.loading.len);
 }
 
 void map_scene_fixed_update(Resources *resources)
 {
     MapScene *map_scene = (MapScene *)resources->scene;
 
+    // run any events that need running
+    scheduler_tick(&resources->scheduler, resources);
+
     for (u32 i = 0; i < map_scene->characters.len; i++)
     {
         MapCharacterEntry *chara = vec_get(&map_scene->characters, i);
@@ -5,6 +5,7 @@
 #include "resources.h"
 #include "utility/common_defines.h"
 #include "utility/log.h"
+#include <string.h>
 
 #define COLLISION_CLASS "collision"
 #define LIGHTS_CLASS "lights"
@@ -203,9 +204,9 @@ void handle_image_layer(tmx_layer *layer, Resources *resources,
     tmx_image *image = layer->content.image;
 
     char *actual_path = tiled_image_path_to_actual(image->source);
-    TextureEntry *texture_entry =
-        texture_manager_load(&resources->graphics.texture_manager, actual_path,
-                             &resources->graphics.wgpu);
+    TextureEntry *texture_entry = texture_manager_load_async(
+        &resources->graphics.texture_manager, actual_path,
+        &resources->graphics.wgpu);
     free(actual_path);
 
 #define REPEAT_LAYER_DIM_LEN 100000
@@ -290,13 +291,11 @@ void handle_tile_layer(tmx_layer *layer, Resources *resources,
 {
     load->layers++;
     u32 layer_size = load->width * load->height;
-    load->tiles = realloc(load->tiles, layer_size * load->layers * sizeof(i32));
+    load->tiles = realloc(load->tiles, layer_size * load->layers * sizeof(u32));
 
+    // the gids are kept as they are, so the flip flags make it to the tilemap
     u32 start = (load->layers - 1) * layer_size;
-    for (u32 i = 0; i < layer_size; i++)
-    {
-        load->tiles[start + i] = layer->content.gids[i] - 1;
-    }
+    memcpy(load->tiles + start, layer->content.gids, layer_size * sizeof(u32));
 
     MapRenderable renderable;
     renderable.type = Map_TileLayer;
@@ -322,6 +321,35 @@ void handle_tile_layer(tmx_layer *layer, Resources *resources,
     vec_push(load->renderables, &renderable);
 }
 
+void handle_tile_animations(tmx_tileset *tileset,
+                            TilemapAnimations *animations)
+{
+    tilemap_animations_init(animations);
+
+    vec frames;
+    vec_init(&frames, sizeof(TilemapAnimationFrame));
+    for (u32 i = 0; i < tileset->tilecount; i++)
+    {
+        tmx_tile *tile = &tileset->tiles[i];
+        if (tile->animation_len == 0)
+            continue;
+
+        vec_clear(&frames);
+        for (u32 j = 0; j < tile->animation_len; j++)
+        {
+            TilemapAnimationFrame frame = {
+                .tile = tile->animation[j].tile_id,
+                .duration = tile->animation[j].duration,
+            };
+            vec_push(&frames, &frame);
+        }
+        tilemap_animations_add(animations, tile->id,
+                               (TilemapAnimationFrame *)frames.data,
+                               frames.len);
+    }
+    vec_free(&frames);
+}
+
 static void prop_foreach_func(tmx_property *prop, void *ud)
 {
     if (prop->type != PT_STRING)
@@ -336,7 +364,6 @@ static void prop_foreach_func(tmx_property *prop, void *ud)
 void handle_character_layer(tmx_layer *layer, Resources *resources,
                             MapLoadArgs *load)
 {
-    (void)resources;
     tmx_object *current = layer->content.objgr->head;
     while (current)
     {
@@ -373,6 +400,12 @@ void handle_character_layer(tmx_layer *layer, Resources *resources,
         tmx_property_foreach(current->properties, prop_foreach_func,
                              &obj.properties);
 
+        // start compiling the character's event now, while the rest of the
+        // map loads
+        char *event_name = hashmap_get(&obj.properties, "event");
+        if (event_name)
+            event_index_prefetch(&resources->events, event_name);
+
         vec_push(load->characters, &obj);
 
         current = current->next;
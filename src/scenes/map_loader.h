@@ -12,7 +12,8 @@
 
 typedef struct
 {
-    i32 *tiles;
+    // Tiled gids, see tilemap_init
+    u32 *tiles;
     u32 width, height, layers;
     Tilemap *tilemap;
 
@@ -70,3 +71,6 @@ typedef struct
 
 void handle_map_layers(tmx_layer *head, Resources *resources,
                        MapLoadArgs *map_data);
+// the tiles in `tileset` that animate. `animations` needs freeing after
+void handle_tile_animations(tmx_tileset *tileset,
+                            TilemapAnimations *animations);
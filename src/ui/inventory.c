@@ -23,20 +23,19 @@ static void inventory_init_name(Inventory *inventory, Resources *resources)
         color.b = 200;
     }
 
-    WGPUTexture texture =
-        font_render_text(&resources->fonts.compaq.medium, item.name, color,
-                         &resources->graphics.wgpu);
+    SDL_Surface *surface =
+        font_render_surface(&resources->fonts.compaq.medium, item.name, color);
+    TextureEntry *texture_entry = texture_manager_register_surface(
+        &resources->graphics.texture_manager, surface, "inventory_name_texture",
+        &resources->graphics.wgpu);
+    SDL_DestroySurface(surface);
 
-    u32 width = wgpuTextureGetWidth(texture);
-    u32 height = wgpuTextureGetHeight(texture);
-
-    TextureEntry *texture_entry =
-        texture_manager_register(&resources->graphics.texture_manager, texture,
-                                 "inventory_name_texture");
+    u32 width = texture_entry->width;
+    u32 height = texture_entry->height;
 
     Quad quad = {
         rect_from_size((vec2s){.x = width, .y = height}),
-        RECT_UNIT_TEX_COORDS,
+        texture_entry->sub_rect,
     };
     QuadEntry quad_entry =
         quad_manager_add(&resources->graphics.quad_manager, quad);
@@ -64,20 +63,19 @@ static void inventory_init_description(Inventory *inventory,
     Item item = ITEMS[viewed_item_type];
 
     SDL_Color color = {255, 255, 255, 255};
-    WGPUTexture texture =
-        font_render_text(&resources->fonts.compaq.medium, item.description,
-                         color, &resources->graphics.wgpu);
-
-    u32 width = wgpuTextureGetWidth(texture);
-    u32 height = wgpuTextureGetHeight(texture);
+    SDL_Surface *surface = font_render_surface(
+        &resources->fonts.compaq.medium, item.description, color);
+    TextureEntry *texture_entry = texture_manager_register_surface(
+        &resources->graphics.texture_manager, surface,
+        "inventory_description_texture", &resources->graphics.wgpu);
+    SDL_DestroySurface(surface);
 
-    TextureEntry *texture_entry =
-        texture_manager_register(&resources->graphics.texture_manager, texture,
-                                 "inventory_description_texture");
+    u32 width = texture_entry->width;
+    u32 height = texture_entry->height;
 
     Quad quad = {
         rect_from_size((vec2s){.x = width, .y = height}),
-        RECT_UNIT_TEX_COORDS,
+        texture_entry->sub_rect,
     };
     QuadEntry quad_entry =
         quad_manager_add(&resources->graphics.quad_manager, quad);
@@ -133,9 +131,10 @@ void inventory_init(Inventory *inventory, Resources *resources)
 
         // initialize slot
         {
-            TextureEntry *texture = texture_manager_load(
+            TextureEntry *texture = texture_manager_load_packed(
                 &resources->graphics.texture_manager,
                 "assets/textures/slot.png", &resources->graphics.wgpu);
+            quad.tex_coords = texture->sub_rect;
 
             QuadEntry quad_entry =
                 quad_manager_add(&resources->graphics.quad_manager, quad);
@@ -155,9 +154,10 @@ void inventory_init(Inventory *inventory, Resources *resources)
         {
             Item item = ITEMS[item_type];
 
-            TextureEntry *texture =
-                texture_manager_load(&resources->graphics.texture_manager,
-                                     item.icon, &resources->graphics.wgpu);
+            TextureEntry *texture = texture_manager_load_packed(
+                &resources->graphics.texture_manager, item.icon,
+                &resources->graphics.wgpu);
+            quad.tex_coords = texture->sub_rect;
 
             QuadEntry quad_entry =
                 quad_manager_add(&resources->graphics.quad_manager, quad);
@@ -219,10 +219,18 @@ void inventory_update(Inventory *inventory, Resources *resources)
                                        inventory->icons[i].texture);
 
                 Item item = ITEMS[item_type];
-                TextureEntry *texture =
-                    texture_manager_load(&resources->graphics.texture_manager,
-                                         item.icon, &resources->graphics.wgpu);
+                TextureEntry *texture = texture_manager_load_packed(
+                    &resources->graphics.texture_manager, item.icon,
+                    &resources->graphics.wgpu);
                 inventory->icons[i].texture = texture;
+
+                // it's probably somewhere else in the atlas
+                Quad quad = {
+                    .rect = rect_from_size(VEC2_SPLAT(32.0)),
+                    .tex_coords = texture->sub_rect,
+                };
+                quad_manager_update(&resources->graphics.quad_manager,
+                                    inventory->icons[i].quad, quad);
             }
         }
 
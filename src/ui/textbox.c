@@ -10,8 +10,12 @@
 void textbox_init(Textbox *textbox, Resources *resources)
 {
     memset(textbox->text, 0, sizeof(textbox->text));
+    textbox->text_len = 0;
     textbox->text_idx = 0;
     textbox->text_type_time = 0.0f;
+    vec_init(&textbox->runs, sizeof(TextRun));
+    textbox->run_idx = 0;
+    textbox->run_pos = 0;
     textbox->typing = false;
     textbox->waiting_for_input = false;
     textbox->open = false;
@@ -20,17 +24,14 @@ void textbox_init(Textbox *textbox, Resources *resources)
     textbox->fixed_update_occured = false;
 
     {
-        TextureEntry *texture = texture_manager_load(
+        TextureEntry *texture = texture_manager_load_packed(
             &resources->graphics.texture_manager, TEXTURE_PATH("textbox.png"),
             &resources->graphics.wgpu);
-        WGPUTexture wgpu_texture = texture_manager_get_texture(
-            &resources->graphics.texture_manager, texture);
 
         Quad quad = {
             .rect = rect_from_size(
-                (vec2s){.x = wgpuTextureGetWidth(wgpu_texture),
-                        .y = wgpuTextureGetHeight(wgpu_texture)}),
-            .tex_coords = RECT_UNIT_TEX_COORDS,
+                (vec2s){.x = texture->width, .y = texture->height}),
+            .tex_coords = texture->sub_rect,
         };
         QuadEntry quad_entry =
             quad_manager_add(&resources->graphics.quad_manager, quad);
@@ -57,6 +58,7 @@ void textbox_free(Textbox *textbox, Resources *resources)
 
     ui_sprite_free(&textbox->sprite, &resources->graphics);
     layer_remove(&resources->graphics.ui_layers.middle, textbox->sprite_entry);
+    vec_free(&textbox->runs);
 }
 
 static void update_text(Textbox *textbox, Resources *resources)
@@ -73,21 +75,30 @@ static void update_text(Textbox *textbox, Resources *resources)
         text, color, &resources->graphics.wgpu);
 }
 
-static void process_escape_code(Textbox *textbox, Resources *resources)
+// types the next character
+static void type_character(Textbox *textbox)
 {
-    (void)resources;
+    textbox->text_idx++;
+    TextRun *run = vec_get(&textbox->runs, textbox->run_idx);
+    if (!run)
+        return;
 
-    if (textbox->text[textbox->text_idx] == '\\')
+    if (++textbox->run_pos >= run->value)
     {
-        switch (textbox->text[textbox->text_idx + 1])
-        {
-        case '.':
-            textbox->text_type_time = -0.5f;
-            break;
-        }
-        memmove(textbox->text + textbox->text_idx,
-                textbox->text + textbox->text_idx + 2,
-                strlen(textbox->text) - textbox->text_idx); // teehee
+        textbox->run_idx++;
+        textbox->run_pos = 0;
+    }
+}
+
+// starts any pauses that come before the next character
+static void process_pauses(Textbox *textbox)
+{
+    TextRun *run;
+    while ((run = vec_get(&textbox->runs, textbox->run_idx)) &&
+           run->type == TextRun_Pause)
+    {
+        textbox->text_type_time = -run->value / 100.0f;
+        textbox->run_idx++;
     }
 }
 
@@ -99,6 +110,7 @@ static void remove_text(Textbox *textbox, Resources *resources)
     layer_remove(&resources->graphics.ui_layers.foreground,
                  textbox->text_sprite_entry);
     memset(textbox->text, 0, sizeof(textbox->text));
+    textbox->text_len = 0;
 }
 
 void textbox_fixed_update(Textbox *textbox, Resources *resources)
@@ -120,22 +132,19 @@ void textbox_update(Textbox *textbox, Resources *resources)
         textbox->text_type_time += delta;
         if (textbox->text_type_time >= 0.01f)
         {
-            textbox->text_idx++;
             textbox->text_type_time = 0.0f;
+            type_character(textbox);
             update_text(textbox, resources);
-            process_escape_code(textbox, resources);
+            process_pauses(textbox);
         }
         if (INPUT_BUTTONS_DOWN(resources))
         {
             // skip typing animation
-            while (textbox->text_idx < (int)strlen(textbox->text))
-            {
-                textbox->text_idx++;
-                process_escape_code(textbox, resources);
-            }
+            textbox->text_idx = textbox->text_len;
+            textbox->run_idx = textbox->runs.len;
             update_text(textbox, resources);
         }
-        if (textbox->text_idx >= (int)strlen(textbox->text))
+        if (textbox->text_idx >= textbox->text_len)
         {
             textbox->typing = false;
             textbox->waiting_for_input = true;
@@ -148,16 +157,28 @@ void textbox_update(Textbox *textbox, Resources *resources)
         // next fixed update, prevents flickering when showing new text
         textbox->needs_remove_text = true;
         textbox->open = false;
+        scheduler_signal(&resources->scheduler, Signal_TextboxClosed);
     }
 }
 
-void textbox_display_text(Textbox *textbox, Resources *resources, char *text)
+void textbox_display_text(Textbox *textbox, Resources *resources,
+                          const TextRuns *text)
 {
     if (*textbox->text)
     {
         remove_text(textbox, resources);
     }
-    strncpy(textbox->text, text, sizeof(textbox->text) - 1);
+    // the runs belong to the event, which could be reloaded while this is up
+    textbox->text_len = fmin(text->len, sizeof(textbox->text) - 1);
+    memcpy(textbox->text, text->text, textbox->text_len);
+    textbox->text[textbox->text_len] = '\0';
+    vec_clear(&textbox->runs);
+    for (u32 i = 0; i < text->run_count; i++)
+        vec_push(&textbox->runs, &text->runs[i]);
+    textbox->run_idx = 0;
+    textbox->run_pos = 0;
+    process_pauses(textbox);
+
     textbox->text_idx = 0;
     textbox->typing = true;
     textbox->waiting_for_input = false;
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <stdbool.h>
+#include "events/text_runs.h"
 #include "fmod_studio_common.h"
 #include "graphics/layer.h"
 #include "graphics/ui_sprite.h"
 #include "resources.h"
+#include "utility/vec.h"
 
 typedef struct
 {
@@ -16,10 +18,18 @@ typedef struct
 
     FMOD_STUDIO_EVENTDESCRIPTION *talk_sound;
 
+    // escape codes have already been taken out (see events/text_runs.h)
     char text[512];
-    int text_idx;
+    u32 text_len;
+    // how much of text has been typed
+    u32 text_idx;
     f32 text_type_time;
 
+    // a copy of the text's runs. it keeps its capacity between texts
+    vec runs; // vec<TextRun>
+    // the run being typed, and how far into it typing is
+    u32 run_idx, run_pos;
+
     bool open;
     bool typing, waiting_for_input;
     bool needs_remove_text, fixed_update_occured;
@@ -29,4 +39,5 @@ void textbox_init(Textbox *textbox, Resources *resources);
 void textbox_free(Textbox *textbox, Resources *resources);
 void textbox_fixed_update(Textbox *textbox, Resources *resources);
 void textbox_update(Textbox *textbox, Resources *resources);
-void textbox_display_text(Textbox *textbox, Resources *resources, char *text);
+void textbox_display_text(Textbox *textbox, Resources *resources,
+                          const TextRuns *text);
@@ -35,6 +35,27 @@ bool strlen_eq_function(void *a, void *b, usize key_size)
     return strcmp(a, b) == 0;
 }
 
+// keys aren't aligned inside buckets, so the pointer has to be memcpy'd out
+static char *read_cstr_ptr(void *key)
+{
+    char *string;
+    memcpy(&string, key, sizeof(char *));
+    return string;
+}
+
+u64 fnv_cstr_ptr_hash_function(void *key, usize key_size)
+{
+    (void)key_size;
+    char *string = read_cstr_ptr(key);
+    return fnv_hash_function(string, strlen(string));
+}
+
+bool cstr_ptr_eq_function(void *a, void *b, usize key_size)
+{
+    (void)key_size;
+    return strcmp(read_cstr_ptr(a), read_cstr_ptr(b)) == 0;
+}
+
 #define BUCKET_SIZE(map) (sizeof(Bucket) + (map)->key_size + (map)->value_size)
 #define BUCKET_AT(map, buckets, i)                                             \
     ((Bucket *)(buckets + (i * BUCKET_SIZE(map))))
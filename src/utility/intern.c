@@ -0,0 +1,49 @@
+#include "intern.h"
+#include "utility/hashmap.h"
+#include <stdlib.h>
+#include <string.h>
+
+// keys are char *, and so are the values (the same pointer as the key)
+static HashMap strings;
+static bool strings_init = false;
+
+// the hashmap stores keys and values unaligned
+static char *read_string(void *ptr)
+{
+    char *string;
+    memcpy(&string, ptr, sizeof(char *));
+    return string;
+}
+
+char *intern_string(const char *string)
+{
+    if (!strings_init)
+    {
+        hashmap_init(&strings, fnv_cstr_ptr_hash_function,
+                     cstr_ptr_eq_function, sizeof(char *), sizeof(char *));
+        strings_init = true;
+    }
+
+    void *interned = hashmap_get(&strings, &string);
+    if (interned)
+        return read_string(interned);
+
+    char *copy = strdup(string);
+    hashmap_insert(&strings, &copy, &copy);
+    return copy;
+}
+
+void intern_free(void)
+{
+    if (!strings_init)
+        return;
+
+    HashMapIter iter;
+    hashmap_iter_init(&strings, &iter);
+    void *key;
+    while (hashmap_iter_next(&iter, &key, NULL))
+        free(read_string(key));
+
+    hashmap_free(&strings);
+    strings_init = false;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// string interning. every distinct string gets exactly one copy, so interned
+// strings can be compared by pointer instead of with strcmp.
+//
+// interned strings live until intern_free is called.
+
+// returns the interned copy of `string`, making one if there isn't one yet
+char *intern_string(const char *string);
+void intern_free(void);
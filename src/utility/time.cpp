@@ -113,9 +113,7 @@ extern "C"
 
     Duration instant_elapsed(Instant instant)
     {
-        instant_inner::duration instant_dur(instant.inner);
-        duration_inner duration(instant_dur);
-        return {duration.count()};
+        return instant_duration_since(instant_now(), instant);
     }
 
     Duration instant_duration_since(Instant instant, Instant earlier)
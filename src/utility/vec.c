@@ -113,7 +113,7 @@ void vec_remove(vec *v, usize index, void *elem)
         // shift everything to the left using memmove
         memmove(v->data + index * v->ele_size,
                 v->data + (index + 1) * v->ele_size,
-                (v->len - index) * v->ele_size);
+                (v->len - index - 1) * v->ele_size);
     }
     v->len--;
 }
@@ -0,0 +1,351 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "animation/animations.h"
+#include "animation/definition.h"
+#include "animation/loader.h"
+#include "fake_wgpu.h"
+#include "graphics/quad_manager.h"
+
+// checks compiled animations pick the same frames as adding up frame times
+// does, that everything playing catches up after a hitch instead of lagging
+// behind, and that animations load from ini files. then compares stepping
+// 5000 characters' animations along one at a time against updating them all
+// in one pass.
+// there's no gpu here, so the quad manager's wgpu calls are stubbed out.
+
+#define CHARACTERS 5000
+#define FRAMES 1000
+// 60fps
+#define FRAME_MILLIS 16
+// a 250ms hitch every 100 frames
+#define HITCH_EVERY 100
+#define HITCH_MILLIS 250
+
+#ifdef __clang__
+#pragma clang diagnostic ignored "-Wgnu-flexible-array-initializer"
+#endif
+
+static const AnimationDef WALK = {
+    .name = "walk",
+    .cell_width = 8,
+    .cell_height = 8,
+    .looping = true,
+    .frame_count = 3,
+    .frames =
+        {
+            {0.1, 4, NULL},
+            {0.2, 5, "event:/sfx/step"},
+            {0.1, 6, NULL},
+        },
+};
+
+static const AnimationDef DIE = {
+    .name = "die",
+    .cell_width = 8,
+    .cell_height = 8,
+    .looping = false,
+    .frame_count = 2,
+    .frames =
+        {
+            {0.5, 0, NULL},
+            {0.5, 1, NULL},
+        },
+};
+
+// long enough that the binary search takes a few steps
+static const AnimationDef RUN = {
+    .name = "run",
+    .cell_width = 16,
+    .cell_height = 16,
+    .looping = true,
+    .frame_count = 12,
+    .frames =
+        {
+            {0.05, 0, NULL},
+            {0.05, 1, NULL},
+            {0.1, 2, NULL},
+            {0.033, 3, NULL},
+            {0.033, 4, NULL},
+            {0.034, 5, NULL},
+            {0.2, 6, NULL},
+            {0.0, 7, NULL},
+            {0.1, 8, NULL},
+            {0.1, 9, NULL},
+            {0.05, 10, NULL},
+            {0.25, 11, NULL},
+        },
+};
+
+static AnimationType walk_type, die_type, run_type;
+static CompiledAnimation *walk, *die, *run;
+
+// going through the frames one by one
+static u32 frame_at_slowly(const AnimationDef *def, u32 time)
+{
+    u32 duration = animation_frame_end(def, def->frame_count - 1);
+    if (def->looping && duration > 0)
+        time %= duration;
+    for (u32 i = 0; i < def->frame_count; i++)
+        if (time < animation_frame_end(def, i))
+            return i;
+    return def->frame_count - 1;
+}
+
+static bool rects_equal(Rect a, Rect b)
+{
+    return a.min.x == b.min.x && a.min.y == b.min.y && a.max.x == b.max.x &&
+           a.max.y == b.max.y;
+}
+
+static void test_tables(void)
+{
+    CompiledAnimation *all[] = {walk, die, run};
+    for (u32 i = 0; i < 3; i++)
+    {
+        const AnimationDef *def = all[i]->def;
+        assert(all[i]->duration ==
+               animation_frame_end(def, def->frame_count - 1));
+        for (u32 time = 0; time < 5000; time++)
+            assert(animation_frame_at(all[i], time) ==
+                   frame_at_slowly(def, time));
+    }
+    assert(walk->has_sounds && !die->has_sounds);
+
+    // the 0 length frame is never shown
+    for (u32 time = 0; time < 5000; time++)
+        assert(animation_frame_at(run, time) != 7);
+
+    const Rect *coords = animation_tex_coords(run, 64, 64);
+    for (u32 i = 0; i < RUN.frame_count; i++)
+        assert(rects_equal(coords[i], tex_coords_for(&RUN, i, 64, 64)));
+    // only worked out once per size
+    assert(animation_tex_coords(run, 64, 64) == coords);
+    const Rect *wide = animation_tex_coords(run, 256, 16);
+    assert(wide != coords);
+    assert(rects_equal(wide[11], tex_coords_for(&RUN, 11, 256, 16)));
+    assert(run->tex_coords.len == 2);
+}
+
+static void test_playing(WGPUResources *resources)
+{
+    QuadManager quads;
+    quad_manager_init(&quads, resources);
+    Quad quad = {.rect = rect_from_size((vec2s){.x = 8, .y = 8}),
+                 .tex_coords = RECT_UNIT_TEX_COORDS};
+    QuadEntry entry = quad_manager_add(&quads, quad);
+
+    Animations animations;
+    animations_init(&animations);
+    AnimationHandle walking =
+        animations_play_quad(&animations, walk_type, 1000, 1.0, entry,
+                             quad.rect, 64, 8);
+    AnimationHandle dying = animations_play(&animations, die_type, 1000, 2.0);
+    assert(animations_frame(&animations, walking) == ANIMATION_NONE);
+
+    // starting counts as a change, so the first frame gets applied
+    animations_update(&animations, 1000);
+    assert(animations.changed.len == 2);
+    AnimationChange *change = vec_get(&animations.changed, 0);
+    assert(change->handle == walking && change->from == ANIMATION_NONE);
+    animations_update_quads(&animations, &quads);
+    assert(rects_equal(quad_manager_get(&quads, entry).tex_coords,
+                       tex_coords_for(&WALK, 0, 64, 8)));
+
+    // nothing changes until a frame ends
+    animations_update(&animations, 1050);
+    assert(animations.changed.len == 0);
+
+    // a hitch skips straight to where it should be
+    animations_update(&animations, 1000 + 4000 + 350);
+    assert(animations_frame(&animations, walking) == 2);
+    change = vec_get(&animations.changed, 0);
+    assert(change->handle == walking && change->from == 0);
+    animations_update_quads(&animations, &quads);
+    assert(rects_equal(quad_manager_get(&quads, entry).tex_coords,
+                       tex_coords_for(&WALK, 2, 64, 8)));
+    // going twice as fast, so it's been over for a while
+    assert(animations_frame(&animations, dying) == 1);
+    assert(animations_finished(&animations, dying));
+    assert(!animations_finished(&animations, walking));
+
+    // stopped animations aren't updated, and their handles get reused
+    animations_stop(&animations, walking);
+    animations_update(&animations, 1000 + 4000 + 50);
+    assert(animations.changed.len == 0);
+    AnimationHandle again = animations_play(&animations, run_type, 6000, 1.0);
+    assert(again == walking);
+    animations_update(&animations, 6000 + 160);
+    assert(animations_frame(&animations, again) ==
+           animation_frame_at(run, 160));
+
+    animations_free(&animations);
+    quad_manager_free(&quads);
+}
+
+static void test_loading(void)
+{
+    char err[256];
+    u32 count = animation_defs_count();
+
+    const char *file = "[idle]\n"
+                       "cell_width = 16\n"
+                       "cell_height = 24\n"
+                       "looping = 1\n"
+                       "frame = 0.5 0\n"
+                       "frame = 0.25 1 event:/sfx/blink\n"
+                       "[sit]\n"
+                       "cell_width=16\n"
+                       "cell_height=24\n"
+                       "frame=1 2\n";
+    assert(animation_defs_load_string(file, err));
+    assert(animation_defs_count() == count + 2);
+
+    CompiledAnimation *idle = animation_get(anim_type_for("idle"));
+    assert(idle->def->type == count);
+    assert(idle->def->cell_width == 16 && idle->def->cell_height == 24);
+    assert(idle->def->looping);
+    assert(idle->def->frame_count == 2);
+    assert(idle->def->frames[1].cell == 1);
+    assert(!strcmp(idle->def->frames[1].sound, "event:/sfx/blink"));
+    assert(idle->has_sounds);
+    assert(idle->duration == 750);
+    assert(animation_frame_at(idle, 760) == 0);
+
+    CompiledAnimation *sit = animation_get(anim_type_for("sit"));
+    assert(!sit->def->looping && !sit->has_sounds);
+    assert(animation_frame_at(sit, 5000) == 0);
+
+    // none of these add anything
+    const char *bad[] = {
+        "[empty]\ncell_width=8\ncell_height=8\n",
+        "[bad]\ncell_width=8\ncell_height=8\nframe=quick 2\n",
+        "[typo]\ncell_widht=8\ncell_height=8\nframe=1 0\n",
+        "[sized]\nframe=1 0\n",
+        "[fine]\ncell_width=8\ncell_height=8\nframe=1 0\n"
+        "[idle]\ncell_width=8\ncell_height=8\nframe=1 0\n",
+        "[twice]\ncell_width=8\ncell_height=8\nframe=1 0\n"
+        "[twice]\ncell_width=8\ncell_height=8\nframe=1 0\n",
+        "cell_width=8\n",
+    };
+    for (u32 i = 0; i < sizeof(bad) / sizeof(*bad); i++)
+    {
+        err[0] = '\0';
+        assert(!animation_defs_load_string(bad[i], err));
+        assert(err[0] != '\0');
+        assert(animation_defs_count() == count + 2);
+    }
+}
+
+// stepping each character's frame along by the time since the last frame, at
+// most one frame at a time
+typedef struct
+{
+    f32 wait_time;
+    u32 current_frame;
+    QuadEntry quad;
+} SteppedCharacter;
+
+static void benchmark(WGPUResources *resources)
+{
+    static SteppedCharacter stepped[CHARACTERS];
+
+    QuadManager quads;
+    quad_manager_init(&quads, resources);
+    Quad quad = {.rect = rect_from_size((vec2s){.x = 8, .y = 8}),
+                 .tex_coords = RECT_UNIT_TEX_COORDS};
+
+    Animations animations;
+    animations_init(&animations);
+    for (u32 i = 0; i < CHARACTERS; i++)
+    {
+        // started at different times, so they aren't all in step
+        u32 start = i % 400;
+        stepped[i] = (SteppedCharacter){
+            .wait_time = WALK.frames[0].frame_time - start / 1000.0f,
+            .quad = quad_manager_add(&quads, quad),
+        };
+        animations_play_quad(&animations, walk_type, 400 - start, 1.0,
+                             quad_manager_add(&quads, quad), quad.rect, 64,
+                             8);
+    }
+    quad_manager_upload_dirty(&quads, resources);
+
+    u32 stepped_changes = 0;
+    clock_t start = clock();
+    for (u32 frame = 0; frame < FRAMES; frame++)
+    {
+        u32 delta = frame % HITCH_EVERY == 0 ? HITCH_MILLIS : FRAME_MILLIS;
+        for (u32 i = 0; i < CHARACTERS; i++)
+        {
+            SteppedCharacter *character = &stepped[i];
+            character->wait_time -= delta / 1000.0f;
+            if (character->wait_time > 0.0)
+                continue;
+
+            character->current_frame =
+                (character->current_frame + 1) % WALK.frame_count;
+            character->wait_time =
+                WALK.frames[character->current_frame].frame_time;
+            quad.tex_coords =
+                tex_coords_for(&WALK, character->current_frame, 64, 8);
+            quad_manager_update(&quads, character->quad, quad);
+            stepped_changes++;
+        }
+        quad_manager_upload_dirty(&quads, resources);
+    }
+    f64 stepped_seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+
+    u32 batched_changes = 0;
+    u32 time = 400;
+    start = clock();
+    for (u32 frame = 0; frame < FRAMES; frame++)
+    {
+        time += frame % HITCH_EVERY == 0 ? HITCH_MILLIS : FRAME_MILLIS;
+        animations_update(&animations, time);
+        animations_update_quads(&animations, &quads);
+        quad_manager_upload_dirty(&quads, resources);
+        batched_changes += animations.changed.len;
+    }
+    f64 batched_seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+
+    // every hitch leaves the stepped characters further behind
+    u32 behind = 0;
+    for (u32 i = 0; i < CHARACTERS; i++)
+    {
+        u32 expected = animation_frame_at(walk, time - 400 + i % 400);
+        assert(animations_frame(&animations, i) == expected);
+        if (stepped[i].current_frame != expected)
+            behind++;
+    }
+
+    printf("%d animated characters, %d frames with a %dms hitch every %d: "
+           "%.3fms per frame stepping each one (%u frame changes, %u "
+           "characters on the wrong frame at the end), %.3fms updating them "
+           "all at once (%u frame changes, none wrong)\n",
+           CHARACTERS, FRAMES, HITCH_MILLIS, HITCH_EVERY,
+           stepped_seconds * 1000.0 / FRAMES, stepped_changes, behind,
+           batched_seconds * 1000.0 / FRAMES, batched_changes);
+
+    animations_free(&animations);
+    quad_manager_free(&quads);
+}
+
+int main()
+{
+    WGPUResources resources;
+    memset(&resources, 0, sizeof(resources));
+    animation_defs_init();
+    walk = animation_get(walk_type = animation_defs_add(&WALK, false));
+    die = animation_get(die_type = animation_defs_add(&DIE, false));
+    run = animation_get(run_type = animation_defs_add(&RUN, false));
+
+    test_tables();
+    test_playing(&resources);
+    test_loading();
+    benchmark(&resources);
+
+    animation_defs_free();
+}
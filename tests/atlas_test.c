@@ -0,0 +1,176 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "graphics/atlas.h"
+
+// checks the atlas packer never overlaps anything (padding included), reuses
+// what's removed, and gives empty shelves back. then packs a game's worth of
+// icons, sprites and text labels to see how many textures they'd have been,
+// and churns labels like a textbox does.
+
+#define ICONS 200
+#define SPRITES 100
+#define LABELS 400
+#define CHURN 100000
+
+// a little xorshift, so runs are the same everywhere
+static u32 seed = 12345;
+static u32 next_rand(u32 max)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed % max;
+}
+
+static bool overlaps(AtlasRegion a, AtlasRegion b)
+{
+    if (a.page != b.page)
+        return false;
+    // padding's to the right and below
+    return a.x < b.x + b.width + ATLAS_PADDING &&
+           b.x < a.x + a.width + ATLAS_PADDING &&
+           a.y < b.y + b.height + ATLAS_PADDING &&
+           b.y < a.y + a.height + ATLAS_PADDING;
+}
+
+static void check_regions(Atlas *atlas, AtlasRegion *regions, u32 count)
+{
+    for (u32 i = 0; i < count; i++)
+    {
+        if (regions[i].page == ATLAS_NONE)
+            continue;
+        assert(regions[i].page < atlas->pages.len);
+        assert(regions[i].x + regions[i].width <= atlas->page_size);
+        assert(regions[i].y + regions[i].height <= atlas->page_size);
+        for (u32 j = i + 1; j < count; j++)
+            if (regions[j].page != ATLAS_NONE)
+                assert(!overlaps(regions[i], regions[j]));
+    }
+}
+
+static void test_packing(void)
+{
+    Atlas atlas;
+    atlas_init(&atlas, 128);
+
+    assert(atlas_fits(&atlas, 32, 32));
+    assert(!atlas_fits(&atlas, 128, 8));
+    assert(!atlas_fits(&atlas, 0, 8));
+
+    // the same height goes on the same shelf
+    AtlasRegion a = atlas_add(&atlas, 30, 16);
+    AtlasRegion b = atlas_add(&atlas, 30, 16);
+    assert(a.page == 0 && a.x == 0 && a.y == 0);
+    assert(b.y == 0 && b.x == 30 + ATLAS_PADDING);
+    // too tall for it, so it starts a new one
+    AtlasRegion c = atlas_add(&atlas, 10, 40);
+    assert(c.y == 16 + ATLAS_PADDING);
+    // short enough to share the first shelf
+    AtlasRegion d = atlas_add(&atlas, 10, 10);
+    assert(d.y == 0);
+
+    // removing something leaves a gap the same size can go in
+    atlas_remove(&atlas, b);
+    AtlasRegion e = atlas_add(&atlas, 30, 16);
+    assert(e.x == b.x && e.y == b.y);
+
+    AtlasRegion regions[] = {a, c, d, e};
+    check_regions(&atlas, regions, 4);
+    assert(atlas_occupancy(&atlas, 0) ==
+           (f32)(30 * 16 * 2 + 10 * 40 + 10 * 10) / (128 * 128));
+
+    // everything gone gives the whole page back
+    atlas_remove(&atlas, a);
+    atlas_remove(&atlas, c);
+    atlas_remove(&atlas, d);
+    atlas_remove(&atlas, e);
+    AtlasPage *page = vec_get(&atlas.pages, 0);
+    assert(page->shelves.len == 0 && page->top == 0 && page->regions == 0);
+    assert(atlas_occupancy(&atlas, 0) == 0.0);
+
+    // so something as tall as the page fits again
+    AtlasRegion tall = atlas_add(&atlas, 8, 127);
+    assert(tall.page == 0 && tall.y == 0);
+    // and when there's no room a new page gets made
+    AtlasRegion wide = atlas_add(&atlas, 127, 8);
+    assert(wide.page == 1);
+    assert(atlas.pages.len == 2);
+
+    atlas_free(&atlas);
+}
+
+static void test_random(void)
+{
+    static AtlasRegion regions[2000];
+    Atlas atlas;
+    atlas_init(&atlas, 256);
+
+    for (u32 i = 0; i < 2000; i++)
+        regions[i] = atlas_add(&atlas, 1 + next_rand(60), 1 + next_rand(60));
+    check_regions(&atlas, regions, 2000);
+
+    // take half of them out, and put different sizes back in
+    for (u32 i = 0; i < 2000; i += 2)
+    {
+        atlas_remove(&atlas, regions[i]);
+        regions[i].page = ATLAS_NONE;
+    }
+    usize pages = atlas.pages.len;
+    for (u32 i = 0; i < 2000; i += 4)
+        regions[i] = atlas_add(&atlas, 1 + next_rand(30), 1 + next_rand(30));
+    check_regions(&atlas, regions, 2000);
+    // they all fit in what was freed
+    assert(atlas.pages.len == pages);
+
+    atlas_free(&atlas);
+}
+
+static void benchmark(void)
+{
+    static AtlasRegion regions[ICONS + SPRITES + LABELS];
+    u32 count = 0;
+
+    Atlas atlas;
+    atlas_init(&atlas, ATLAS_PAGE_SIZE);
+    for (u32 i = 0; i < ICONS; i++)
+        regions[count++] = atlas_add(&atlas, 32, 32);
+    for (u32 i = 0; i < SPRITES; i++)
+        regions[count++] =
+            atlas_add(&atlas, 8 + next_rand(57), 8 + next_rand(57));
+    // a line of text
+    for (u32 i = 0; i < LABELS; i++)
+        regions[count++] = atlas_add(&atlas, 20 + next_rand(300), 16);
+    check_regions(&atlas, regions, count);
+
+    f32 occupancy = 0.0;
+    for (u32 i = 0; i < atlas.pages.len; i++)
+        occupancy += atlas_occupancy(&atlas, i);
+    occupancy /= atlas.pages.len;
+
+    // labels come and go as textboxes change
+    clock_t start = clock();
+    for (u32 i = 0; i < CHURN; i++)
+    {
+        u32 label = ICONS + SPRITES + next_rand(LABELS);
+        atlas_remove(&atlas, regions[label]);
+        regions[label] = atlas_add(&atlas, 20 + next_rand(300), 16);
+    }
+    f64 churn_seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+    check_regions(&atlas, regions, count);
+
+    printf("%d icons, %d sprites and %d labels: %u atlas pages instead of %u "
+           "textures (%.1f%% full), %.3fus to swap a label out\n",
+           ICONS, SPRITES, LABELS, (u32)atlas.pages.len, count,
+           occupancy * 100.0, churn_seconds * 1000000.0 / CHURN);
+
+    atlas_free(&atlas);
+}
+
+int main()
+{
+    test_packing();
+    test_random();
+    benchmark();
+}
@@ -0,0 +1,162 @@
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include "fake_wgpu.h"
+#include "graphics/bind_group_cache.h"
+#include "graphics/quad_manager.h"
+#include "graphics/tex_manager.h"
+#include "graphics/transform_manager.h"
+
+// checks that cached bind groups only get rebuilt when something they were
+// built from changes, and never on an idle frame. the generations come from
+// the real texture, quad and transform managers, running on the fake wgpu.
+
+#define IDLE_FRAMES 1000
+
+// there's no gpu here, so bind groups are just numbers
+static uintptr_t next_bind_group = 1;
+static u32 released = 0;
+
+void wgpuBindGroupRelease(WGPUBindGroup bind_group)
+{
+    assert(bind_group != NULL);
+    released++;
+}
+
+static WGPUBindGroup build(void *userdata)
+{
+    u32 *builds = userdata;
+    (*builds)++;
+    return (WGPUBindGroup)next_bind_group++;
+}
+
+typedef struct
+{
+    WGPUResources wgpu;
+    TextureManager textures;
+    QuadManager quads;
+    TransformManager transforms;
+    // bumped whenever the quad or transform buffer is remade
+    u32 buffer_generation;
+    BindGroupCache bind_groups;
+} TestGraphics;
+
+static Quad test_quad(void)
+{
+    return (Quad){
+        .rect = rect_from_min_size(GLMS_VEC2_ZERO, (vec2s){.x = 16, .y = 16}),
+        .tex_coords = RECT_UNIT_TEX_COORDS,
+    };
+}
+
+// the same as graphics_render, up to getting the bind groups
+static WGPUBindGroup frame(TestGraphics *graphics)
+{
+    texture_manager_upload_loaded(&graphics->textures, &graphics->wgpu);
+
+    if (quad_manager_upload_dirty(&graphics->quads, &graphics->wgpu))
+        graphics->buffer_generation++;
+    if (transform_manager_upload_dirty(&graphics->transforms, &graphics->wgpu))
+        graphics->buffer_generation++;
+
+    u64 sprite_generation = bind_group_generation(
+        graphics->textures.generation, graphics->buffer_generation);
+    WGPUBindGroup sprite = bind_group_cache_get(
+        &graphics->bind_groups, BindGroup_Sprite, sprite_generation);
+    bind_group_cache_get(&graphics->bind_groups, BindGroup_Light, 0);
+    bind_group_cache_get(&graphics->bind_groups, BindGroup_HdrTonemap, 0);
+    return sprite;
+}
+
+// nothing changes, so nothing should be rebuilt, reuploaded or regenerated
+static void idle(TestGraphics *graphics, WGPUBindGroup sprite)
+{
+    u32 rebuilds = graphics->bind_groups.rebuilds;
+    u32 textures = graphics->textures.generation;
+    u32 buffers = graphics->buffer_generation;
+    u64 uploaded = fake_wgpu.uploaded;
+    for (u32 i = 0; i < IDLE_FRAMES; i++)
+        assert(frame(graphics) == sprite);
+    assert(graphics->bind_groups.rebuilds == rebuilds);
+    assert(graphics->textures.generation == textures);
+    assert(graphics->buffer_generation == buffers);
+    assert(fake_wgpu.uploaded == uploaded);
+}
+
+int main()
+{
+    static TestGraphics graphics;
+    memset(&graphics.wgpu, 0, sizeof(graphics.wgpu));
+    texture_manager_init(&graphics.textures);
+    quad_manager_init(&graphics.quads, &graphics.wgpu);
+    transform_manager_init(&graphics.transforms, &graphics.wgpu);
+    graphics.buffer_generation = 0;
+
+    u32 builds = 0;
+    bind_group_cache_init(&graphics.bind_groups, &builds);
+    for (u32 i = 0; i < BindGroup_Max; i++)
+        bind_group_cache_set_builder(&graphics.bind_groups, i, build);
+
+    // a player
+    TextureEntry *texture = texture_manager_register(
+        &graphics.textures, fake_texture(32, 32), "player");
+    QuadEntry quad = quad_manager_add(&graphics.quads, test_quad());
+    TransformEntry transform = transform_manager_add(
+        &graphics.transforms, transform_from_xyz(0, 0, 0));
+
+    // everything gets built the first time it's used
+    WGPUBindGroup sprite = frame(&graphics);
+    assert(graphics.bind_groups.rebuilds == BindGroup_Max);
+    assert(builds == BindGroup_Max);
+    idle(&graphics, sprite);
+    assert(released == 0);
+
+    // moving things around only uploads the changes, the buffers stay the same
+    quad_manager_update(&graphics.quads, quad, test_quad());
+    transform_manager_update(&graphics.transforms, transform,
+                             transform_from_xyz(8, 8, 0));
+    u64 uploaded = fake_wgpu.uploaded;
+    assert(frame(&graphics) == sprite);
+    assert(fake_wgpu.uploaded > uploaded);
+    assert(graphics.bind_groups.rebuilds == BindGroup_Max);
+
+    // loading a texture only rebuilds the sprite bind group
+    TextureEntry *other = texture_manager_register(
+        &graphics.textures, fake_texture(32, 32), "other");
+    WGPUBindGroup rebuilt = frame(&graphics);
+    assert(rebuilt != sprite);
+    assert(graphics.bind_groups.rebuilds == BindGroup_Max + 1);
+    assert(released == 1);
+    sprite = rebuilt;
+    idle(&graphics, sprite);
+
+    // so does unloading one
+    texture_manager_unload(&graphics.textures, other);
+    sprite = frame(&graphics);
+    assert(graphics.bind_groups.rebuilds == BindGroup_Max + 2);
+    idle(&graphics, sprite);
+
+    // and the quad buffer being remade, once there's more quads than fit
+    u32 buffers_made = fake_wgpu.buffers_made;
+    usize cap = graphics.quads.entries.cap;
+    for (usize i = 0; i < cap; i++)
+        quad_manager_add(&graphics.quads, test_quad());
+    sprite = frame(&graphics);
+    assert(fake_wgpu.buffers_made == buffers_made + 1);
+    assert(graphics.bind_groups.rebuilds == BindGroup_Max + 3);
+    idle(&graphics, sprite);
+
+    // a texture generation and a buffer generation can't be mistaken for each
+    // other
+    assert(bind_group_generation(1, 0) != bind_group_generation(0, 1));
+
+    texture_manager_unload(&graphics.textures, texture);
+    bind_group_cache_free(&graphics.bind_groups);
+    assert(released == 3 + BindGroup_Max);
+    assert(builds == graphics.bind_groups.rebuilds);
+
+    transform_manager_free(&graphics.transforms);
+    quad_manager_free(&graphics.quads);
+    texture_manager_free(&graphics.textures);
+    assert(fake_wgpu.live_textures == 0);
+}
@@ -0,0 +1,164 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "events/compiler.h"
+#include "events/globals.h"
+#include "events/vm.h"
+#include "events/vm_pool.h"
+#include "fake_commands.h"
+#include "utility/intern.h"
+
+// checks that events.txt compiles to well formed bytecode, and reports how big
+// it is and how fast the vm runs through it.
+
+// what instructions used to look like, before they were packed into bytes
+typedef struct
+{
+    InstructionCode code;
+    union
+    {
+        u32 position;
+        char *string;
+        struct
+        {
+            Command command;
+            u32 arg_count;
+        } call;
+    } data;
+} UnpackedInstruction;
+
+static char *read_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    assert(file);
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *source = calloc(len + 1, 1);
+    usize read = fread(source, 1, len, file);
+    assert(read == (usize)len);
+    fclose(file);
+    return source;
+}
+
+static void check_events(const char *path)
+{
+    char *source = read_file(path);
+
+    Compiler compiler;
+    compiler_init(&compiler, source);
+
+    usize code_bytes = 0, constant_bytes = 0;
+    usize unpacked_bytes = 0, unpacked_string_bytes = 0;
+    u32 events = 0, instructions = 0;
+
+    Event event;
+    while (compiler_compile(&compiler, &event))
+    {
+        // find where every instruction starts
+        bool *starts = calloc(event.code_len + 1, sizeof(bool));
+        u32 ip = 0;
+        while (ip < event.code_len)
+        {
+            starts[ip] = true;
+
+            Instruction insn;
+            ip = instruction_decode(event.code, ip, &insn);
+            instructions++;
+
+            if (insn.code == Code_String)
+                unpacked_string_bytes +=
+                    strlen(event.constants[insn.data.constant].data.string) +
+                    1;
+            if (insn.code == Code_Float || insn.code == Code_String)
+                assert(insn.data.constant < event.constant_count);
+        }
+        // the last instruction shouldn't run off the end
+        assert(ip == event.code_len);
+        starts[ip] = true;
+
+        // every jump has to land on an instruction
+        ip = 0;
+        while (ip < event.code_len)
+        {
+            Instruction insn;
+            ip = instruction_decode(event.code, ip, &insn);
+            if (insn.code == Code_Goto || insn.code == Code_GotoIfFalse ||
+                insn.code == Code_GotoIfTrue)
+                assert(starts[insn.data.position]);
+        }
+
+        // constants are deduplicated
+        for (u32 i = 0; i < event.constant_count; i++)
+        {
+            for (u32 j = i + 1; j < event.constant_count; j++)
+                assert(!value_is_eq(event.constants[i], event.constants[j]));
+        }
+
+        code_bytes += event.code_len;
+        constant_bytes += event.constant_count * sizeof(Value);
+        events++;
+
+        free(starts);
+        event_free(&event);
+    }
+    unpacked_bytes = instructions * sizeof(UnpackedInstruction);
+
+    printf("%s: %u events, %u instructions\n", path, events, instructions);
+    printf("  bytecode: %zu bytes of code + %zu bytes of constants\n",
+           code_bytes, constant_bytes);
+    printf("  unpacked: %zu bytes of instructions + %zu bytes of strings\n",
+           unpacked_bytes, unpacked_string_bytes);
+
+    free(source);
+}
+
+static void check_throughput(void)
+{
+    const char *source =
+        "event \"bench\" {"
+        "  total = 0;"
+        "  name = \"willow\";"
+        "  for i = 0; i < 1000000; i++ {"
+        "    if i % 3 == 0 { total += 2; } else { total -= 1; }"
+        "    if name == \"willow\" & i != 7 { total += 0.5; }"
+        "  }"
+        "}";
+
+    Compiler compiler;
+    compiler_init(&compiler, source);
+    Event event;
+    bool compiled = compiler_compile(&compiler, &event);
+    assert(compiled);
+
+    VMPool pool;
+    vm_pool_init(&pool);
+    VM *vm = vm_pool_get(&pool, event);
+
+    clock_t start = clock();
+    bool finished = vm_execute(vm, NULL);
+    f64 seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+    assert(finished);
+
+    // 333,334 += 2s, 666,666 -= 1s, and 999,999 += 0.5s
+    assert(vm->slots[0].type == Val_Float);
+    assert(vm->slots[0].data._float == 500001.5f);
+
+    printf("vm: 1,000,000 loop iterations in %.2fms\n", seconds * 1000.0);
+
+    vm_pool_put(&pool, vm);
+    vm_pool_free(&pool);
+    event_free(&event);
+}
+
+int main()
+{
+    // paths are relative to the source directory
+    check_events("assets/events.txt");
+    check_throughput();
+
+    global_names_free();
+    intern_free();
+}
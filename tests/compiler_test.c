@@ -0,0 +1,303 @@
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "events/compiler.h"
+#include "events/instruction.h"
+#include "events/keywords.h"
+#include "utility/intern.h"
+
+// checks the lexer and compiler front end, and benchmarks how fast they get
+// through a few megabytes of generated script.
+
+#define EVENTS 64
+#define VARIABLES 250
+#define LABELS 2000
+
+typedef struct
+{
+    char *data;
+    usize len, capacity;
+} Buffer;
+
+static void append(Buffer *buffer, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    va_list args_copy;
+    va_copy(args_copy, args);
+    usize len = vsnprintf(NULL, 0, format, args_copy);
+    va_end(args_copy);
+
+    if (buffer->len + len + 1 > buffer->capacity)
+    {
+        buffer->capacity = (buffer->len + len + 1) * 2;
+        buffer->data = realloc(buffer->data, buffer->capacity);
+    }
+    vsnprintf(buffer->data + buffer->len, len + 1, format, args);
+    buffer->len += len;
+    va_end(args);
+}
+
+static Event compile_one(const char *source)
+{
+    Compiler compiler;
+    compiler_init(&compiler, source);
+    Event event;
+    bool compiled = compiler_compile(&compiler, &event);
+    assert(compiled);
+    return event;
+}
+
+static void check_keywords(void)
+{
+    const char *keywords[] = {"event", "goto", "if",   "else", "loop",
+                              "while", "for",  "none", "true", "false"};
+    for (u32 i = 0; i < sizeof(keywords) / sizeof(char *); i++)
+    {
+        const Keyword *keyword =
+            keyword_lookup(keywords[i], strlen(keywords[i]));
+        assert(keyword && !keyword->is_command);
+        assert(!strcmp(keyword->name, keywords[i]));
+    }
+
+    for (Command command = 0; command < Command_Max_Val; command++)
+    {
+        const char *name = COMMAND_NAMES[command];
+        const Keyword *keyword = keyword_lookup(name, strlen(name));
+        assert(keyword && keyword->is_command);
+        assert(keyword->data.command == command);
+    }
+
+    // prefixes and extensions of keywords aren't keywords
+    const char *not_keywords[] = {"", "e", "even", "events", "iff", "fo",
+                                  "texts", "move_", "x", "printf_"};
+    for (u32 i = 0; i < sizeof(not_keywords) / sizeof(char *); i++)
+        assert(!keyword_lookup(not_keywords[i], strlen(not_keywords[i])));
+
+    // the text doesn't need to be null terminated
+    assert(keyword_lookup("ifx", 2)->data.token == Token_If);
+}
+
+static void check_lexer_edges(void)
+{
+    // strings and comments that straddle the 16 byte blocks the lexer scans,
+    // and a comment right at the end of the source without a newline
+    for (u32 padding = 0; padding < 32; padding++)
+    {
+        char source[256];
+        snprintf(source, sizeof(source),
+                 "%*s\tevent \"edge\" {\r\n  # a comment with \"quotes\"\n"
+                 "  x = \"%.*s#not a comment\"; }  # done",
+                 padding, "", padding, "abcdefghijklmnopqrstuvwxyz0123456789!?");
+
+        Event event = compile_one(source);
+        assert(!strcmp(event.name, "edge"));
+        assert(event.slot_count == 1);
+        assert(event.constant_count == 1);
+        const char *string = event.constants[0].data.string;
+        assert(strlen(string) == padding + strlen("#not a comment"));
+        assert(!strcmp(string + padding, "#not a comment"));
+        event_free(&event);
+    }
+}
+
+// type errors are reported along with the line they're on, rather than taking
+// the whole game down
+static void check_type_errors(void)
+{
+    const char *source = "event \"fine\" { x = 7 % 2; }\n"
+                         "event \"broken\" {\n"
+                         "  x = 1;\n"
+                         "  y = 2.5 % x;\n"
+                         "}\n";
+
+    Compiler compiler;
+    compiler_init(&compiler, source);
+    Event event;
+    assert(compiler_compile(&compiler, &event));
+    assert(!compiler.failed);
+    event_free(&event);
+
+    assert(!compiler_compile(&compiler, &event));
+    assert(compiler.failed);
+    assert(compiler.error_line == 4);
+    assert(strstr(compiler.error, "'broken'"));
+    assert(strstr(compiler.error, "must be integers (got float and int)"));
+}
+
+// variables start out as none, so on the first pass through a loop they can
+// look like the wrong type until the loop comes back around. that's not an
+// error
+static void check_loop_types(void)
+{
+    const char *source = "event \"counter\" {\n"
+                         "  loop {\n"
+                         "    if started { count = count + 1; }\n"
+                         "    else { count = 0; started = true; }\n"
+                         "    yield();\n"
+                         "  }\n"
+                         "}\n"
+                         "event \"total\" {\n"
+                         "  for i = 0; i < 3; i++ {\n"
+                         "    if i > 0 { t = t + 1; } else { t = 0; }\n"
+                         "  }\n"
+                         "}\n";
+
+    Compiler compiler;
+    compiler_init(&compiler, source);
+    Event event;
+    for (u32 i = 0; i < 2; i++)
+    {
+        bool compiled = compiler_compile(&compiler, &event);
+        if (compiler.failed)
+            fprintf(stderr, "line %u: %s\n", compiler.error_line,
+                    compiler.error);
+        assert(compiled && !compiler.failed);
+        event_free(&event);
+    }
+}
+
+// broken events are reported with what's wrong and where, and don't leak
+// anything
+static void check_errors(void)
+{
+    struct
+    {
+        const char *source;
+        u32 line;
+        const char *error;
+    } cases[] = {
+        {"event \"a\" {\n  x = ;\n}", 2, "Expected expression"},
+        {"event \"b\" {\n  x = 1;\n  goto nowhere;\n}", 3,
+         "Undefined label nowhere"},
+        {"event \"c\" {\n  x = \"s\"\n  y = 2;\n}", 3,
+         "Expected ';' after expression, got 'y'"},
+        {"event \"d\" {\n  frobnicate(1);\n}", 2,
+         "Unrecognized command 'frobnicate'"},
+        {"event \"e\" {\n  x = 1 @ 2;\n}", 2, "Unexpected character"},
+        {"event \"f\" {\n  text(\"oops);\n}", 2, "Unterminated string"},
+        {"event \"g\" {\n  x = 1;\n", 3,
+         "Expected '}' after block, got the end of the file"},
+        {"event \"h\" {\n  here:\n  here:\n}", 3,
+         "Label here already defined"},
+        {"event \"i\" {\n  event \"j\" {}\n}", 2,
+         "Event definition is not allowed inside events"},
+    };
+
+    for (u32 i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        Compiler compiler;
+        compiler_init(&compiler, cases[i].source);
+        Event event;
+        assert(!compiler_compile(&compiler, &event));
+        assert(compiler.failed);
+        if (compiler.error_line != cases[i].line ||
+            !strstr(compiler.error, cases[i].error))
+        {
+            fprintf(stderr, "expected '%s' on line %u, got '%s' on line %u\n",
+                    cases[i].error, cases[i].line, compiler.error,
+                    compiler.error_line);
+            assert(false);
+        }
+        // and it stays failed
+        assert(!compiler_compile(&compiler, &event));
+    }
+}
+
+// every event reads and writes a lot of variables, and jumps between a lot of
+// labels, both forwards and backwards. this is the worst case for a compiler
+// that looks names up by scanning everything it's seen so far
+static char *generate_script(usize *len)
+{
+    Buffer buffer = {0};
+    for (u32 e = 0; e < EVENTS; e++)
+    {
+        append(&buffer, "# generated event %u\nevent \"event_%u\" {\n", e, e);
+        for (u32 v = 0; v < VARIABLES; v++)
+            append(&buffer, "    variable_number_%u = %u; # set it up\n", v,
+                   v);
+
+        for (u32 l = 0; l < LABELS; l++)
+        {
+            append(&buffer, "  label_number_%u:\n", l);
+            u32 v = (l * 7) % VARIABLES;
+            append(&buffer,
+                   "    variable_number_%u += variable_number_%u * 2;\n", v,
+                   (v + 1) % VARIABLES);
+            if (l % 16 == 0)
+                append(&buffer,
+                       "    text(\"a reasonably long line of dialogue, number "
+                       "%u, that the player will read\");\n",
+                       l);
+            // jump forwards to a label that hasn't been seen yet, or back to
+            // one that has
+            if (l % 2)
+                append(&buffer, "    goto label_number_%u;\n",
+                       (l * 31) % LABELS);
+        }
+        append(&buffer, "}\n\n");
+    }
+
+    *len = buffer.len;
+    return buffer.data;
+}
+
+static void check_throughput(void)
+{
+    usize len;
+    char *source = generate_script(&len);
+
+    Compiler compiler;
+    compiler_init(&compiler, source);
+
+    u32 events = 0;
+    usize code_bytes = 0;
+    Event event;
+
+    clock_t start = clock();
+    while (compiler_compile(&compiler, &event))
+    {
+        assert(event.slot_count == VARIABLES);
+        assert(!strcmp(event.slots[0], "variable_number_0"));
+        assert(!strcmp(event.slots[VARIABLES - 1], "variable_number_249"));
+
+        // every goto was resolved to somewhere in the event
+        u32 ip = 0;
+        while (ip < event.code_len)
+        {
+            Instruction insn;
+            ip = instruction_decode(event.code, ip, &insn);
+            if (insn.code == Code_Goto)
+                assert(insn.data.position < event.code_len);
+        }
+
+        code_bytes += event.code_len;
+        events++;
+        event_free(&event);
+    }
+    f64 seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+    assert(events == EVENTS);
+
+    f64 megabytes = len / (1024.0 * 1024.0);
+    printf("compiled %.2fMB of script (%u events, %zu bytes of code) in "
+           "%.2fms, %.1fMB/s\n",
+           megabytes, events, code_bytes, seconds * 1000.0,
+           megabytes / seconds);
+
+    free(source);
+}
+
+int main()
+{
+    check_keywords();
+    check_lexer_edges();
+    check_type_errors();
+    check_loop_types();
+    check_errors();
+    check_throughput();
+
+    intern_free();
+}
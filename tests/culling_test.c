@@ -0,0 +1,234 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "fake_wgpu.h"
+#include "graphics/culling.h"
+#include "graphics/layer.h"
+#include "graphics/quad_manager.h"
+#include "graphics/transform_manager.h"
+
+// checks that culled layers only batch what's on screen (including things
+// with parallax, and things that move on or off screen), and benchmarks a map
+// with lots of props that are nowhere near the camera.
+// there's no gpu here, so the managers' wgpu calls are stubbed out.
+
+#define OFF_SCREEN_PROPS 10000
+#define ON_SCREEN_PROPS 20
+#define FRAMES 1000
+
+typedef struct
+{
+    TransformEntry transform;
+    QuadEntry quad;
+    vec2s parallax;
+} TestProp;
+
+static void prop_cull_keys(void *thing, CullKeys *keys)
+{
+    TestProp *prop = thing;
+    keys->transform = prop->transform;
+    keys->quad = prop->quad;
+    keys->parallax = prop->parallax;
+}
+
+static void batch_prop(void *thing, void *batch)
+{
+    vec_push(batch, &thing);
+}
+
+static TransformManager transforms;
+static QuadManager quads;
+
+static TestProp make_prop(f32 x, f32 y)
+{
+    Quad quad = {
+        .rect = rect_from_min_size(GLMS_VEC2_ZERO, (vec2s){.x = 16, .y = 16}),
+        .tex_coords = RECT_UNIT_TEX_COORDS,
+    };
+    return (TestProp){
+        .transform =
+            transform_manager_add(&transforms, transform_from_xyz(x, y, 0)),
+        .quad = quad_manager_add(&quads, quad),
+        .parallax = GLMS_VEC2_ONE,
+    };
+}
+
+// what graphics_render does every frame
+static void end_frame(WGPUResources *resources)
+{
+    transform_manager_upload_dirty(&transforms, resources);
+    quad_manager_upload_dirty(&quads, resources);
+}
+
+static void test_culling(WGPUResources *resources)
+{
+    static TestProp props[6];
+    Layer layer;
+    layer_init_batched(&layer, batch_prop);
+    layer_enable_culling(&layer, prop_cull_keys);
+
+    CullView view = {.position = {.x = 1000, .y = 1000},
+                     .size = {.x = 320, .y = 180}};
+
+    props[0] = make_prop(1100, 1100);  // on screen
+    props[1] = make_prop(5000, 1100);  // way off to the right
+    props[2] = make_prop(1310, 1170);  // poking in from the bottom right
+    props[3] = make_prop(1100, 1100);  // on screen, but parallaxed away
+    props[3].parallax = (vec2s){.x = 0.5, .y = 0.5};
+    props[4] = make_prop(550, 550);    // off screen, but parallaxed onto it
+    props[4].parallax = (vec2s){.x = 0.5, .y = 0.5};
+    props[5] = make_prop(-2000, 1100); // off to the left
+
+    LayerEntry entries[6];
+    for (u32 i = 0; i < 6; i++)
+        entries[i] = layer_add(&layer, &props[i]);
+
+    vec batched;
+    vec_init(&batched, sizeof(TestProp *));
+    CullStats stats = {0};
+
+    layer_culling_refresh(layer.culling, &transforms, &quads);
+    end_frame(resources);
+    layer_batch_visible(&layer, &batched, view, &stats);
+    assert(stats.submitted == 6 && stats.visible == 3);
+    // still in layer order
+    TestProp **visible = (TestProp **)batched.data;
+    assert(visible[0] == &props[0]);
+    assert(visible[1] == &props[2]);
+    assert(visible[2] == &props[4]);
+
+    // moving something on screen gets noticed, even though it wasn't being
+    // looked at
+    transform_manager_update(&transforms, props[1].transform,
+                             transform_from_xyz(1200, 1050, 0));
+    // and so does changing a quad
+    Quad big = {.rect = rect_from_min_size(GLMS_VEC2_ZERO,
+                                           (vec2s){.x = 3500, .y = 16}),
+                .tex_coords = RECT_UNIT_TEX_COORDS};
+    quad_manager_update(&quads, props[5].quad, big);
+    // and removing things
+    layer_remove(&layer, entries[2]);
+
+    layer_culling_refresh(layer.culling, &transforms, &quads);
+    end_frame(resources);
+    vec_clear(&batched);
+    stats = (CullStats){0};
+    layer_batch_visible(&layer, &batched, view, &stats);
+    assert(stats.submitted == 5 && stats.visible == 4);
+    visible = (TestProp **)batched.data;
+    assert(visible[0] == &props[0]);
+    assert(visible[1] == &props[1]);
+    assert(visible[2] == &props[4]);
+    assert(visible[3] == &props[5]);
+
+    // nothing changed, so nothing gets recomputed, and it still works
+    layer_culling_refresh(layer.culling, &transforms, &quads);
+    vec_clear(&batched);
+    layer_batch_visible(&layer, &batched, view, &stats);
+    assert(batched.len == 4);
+
+    // the removed entry gets reused
+    props[2] = make_prop(1000, 1000);
+    assert(layer_add(&layer, &props[2]) == entries[2]);
+    layer_culling_refresh(layer.culling, &transforms, &quads);
+    end_frame(resources);
+    vec_clear(&batched);
+    layer_batch_visible(&layer, &batched, view, &stats);
+    assert(batched.len == 5);
+
+    vec_free(&batched);
+    layer_free(&layer);
+}
+
+static void benchmark(WGPUResources *resources)
+{
+    static TestProp props[OFF_SCREEN_PROPS + ON_SCREEN_PROPS];
+
+    Layer culled, unculled;
+    layer_init_batched(&culled, batch_prop);
+    layer_enable_culling(&culled, prop_cull_keys);
+    layer_init_batched(&unculled, batch_prop);
+
+    // a 100x100 grid of props spread out over a big map, with the camera
+    // somewhere none of them are
+    for (u32 i = 0; i < OFF_SCREEN_PROPS; i++)
+    {
+        props[i] = make_prop(4000 + (i % 100) * 64, (i / 100) * 64);
+        layer_add(&culled, &props[i]);
+        layer_add(&unculled, &props[i]);
+    }
+    for (u32 i = 0; i < ON_SCREEN_PROPS; i++)
+    {
+        TestProp *prop = &props[OFF_SCREEN_PROPS + i];
+        *prop = make_prop(i * 16, 50);
+        layer_add(&culled, prop);
+        layer_add(&unculled, prop);
+    }
+    layer_culling_refresh(culled.culling, &transforms, &quads);
+    end_frame(resources);
+
+    CullView view = {.position = GLMS_VEC2_ZERO,
+                     .size = {.x = 320, .y = 180}};
+    vec batched;
+    vec_init(&batched, sizeof(TestProp *));
+
+    // both loops move the player and upload, so the difference is just the
+    // culling
+    clock_t start = clock();
+    for (u32 i = 0; i < FRAMES; i++)
+    {
+        transform_manager_update(&transforms,
+                                 props[OFF_SCREEN_PROPS].transform,
+                                 transform_from_xyz(i % 300, 50, 0));
+        end_frame(resources);
+
+        vec_clear(&batched);
+        layer_batch(&unculled, &batched);
+    }
+    f64 unculled_seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+    assert(batched.len == OFF_SCREEN_PROPS + ON_SCREEN_PROPS);
+
+    CullStats stats = {0};
+    start = clock();
+    for (u32 i = 0; i < FRAMES; i++)
+    {
+        transform_manager_update(&transforms,
+                                 props[OFF_SCREEN_PROPS].transform,
+                                 transform_from_xyz(i % 300, 50, 0));
+        layer_culling_refresh(culled.culling, &transforms, &quads);
+        end_frame(resources);
+
+        vec_clear(&batched);
+        layer_batch_visible(&culled, &batched, view, &stats);
+    }
+    f64 culled_seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+    assert(batched.len == ON_SCREEN_PROPS);
+    assert(stats.visible == ON_SCREEN_PROPS * FRAMES);
+    assert(stats.submitted == (OFF_SCREEN_PROPS + ON_SCREEN_PROPS) * FRAMES);
+
+    printf("%d off screen props, %d frames: %.3fms per frame batching "
+           "everything, %.3fms culled (%u of %u sprites sent)\n",
+           OFF_SCREEN_PROPS, FRAMES, unculled_seconds * 1000.0 / FRAMES,
+           culled_seconds * 1000.0 / FRAMES, ON_SCREEN_PROPS,
+           OFF_SCREEN_PROPS + ON_SCREEN_PROPS);
+
+    vec_free(&batched);
+    layer_free(&culled);
+    layer_free(&unculled);
+}
+
+int main()
+{
+    WGPUResources resources;
+    memset(&resources, 0, sizeof(resources));
+    transform_manager_init(&transforms, &resources);
+    quad_manager_init(&quads, &resources);
+
+    test_culling(&resources);
+    benchmark(&resources);
+
+    transform_manager_free(&transforms);
+    quad_manager_free(&quads);
+}
@@ -0,0 +1,254 @@
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "events/aot.h"
+#include "events/compiler.h"
+#include "events/globals.h"
+#include "events/vm.h"
+#include "events/vm_pool.h"
+#include "fake_commands.h"
+#include "utility/intern.h"
+#include "utility/vec.h"
+
+// runs every shipped event through both the vm and its aot translated
+// version, and checks that they do exactly the same thing.
+//
+// the real commands need an entire game running, so every command is replaced
+// with one that records what it was called with into a trace.
+
+static vec trace; // vec<char>
+static i32 next_rand;
+
+static void trace_printf(const char *fmt, ...)
+{
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    for (int i = 0; i < len && i < (int)sizeof(buf) - 1; i++)
+        vec_push(&trace, &buf[i]);
+}
+
+static void trace_value(Value value)
+{
+    switch (value.type)
+    {
+    case Val_None:
+        trace_printf("none");
+        break;
+    case Val_Int:
+        trace_printf("%d", value.data._int);
+        break;
+    case Val_Float:
+        trace_printf("%a", value.data._float);
+        break;
+    case Val_String:
+        trace_printf("\"%s\"", value.data.string);
+        break;
+    case Val_True:
+        trace_printf("true");
+        break;
+    case Val_False:
+        trace_printf("false");
+        break;
+    }
+}
+
+static bool record(Command command, VM *vm, Value *out, u32 arg_count,
+                   bool yields, bool exits)
+{
+    // commands that wait on something yield exactly once
+    bool *did_yield = &vm->command_ctx.yield.did_yield;
+    if (yields && !*did_yield)
+    {
+        *did_yield = true;
+        trace_printf("%s yield @%d\n", COMMAND_NAMES[command], vm->ip);
+        return true;
+    }
+    *did_yield = false;
+
+    trace_printf("%s(", COMMAND_NAMES[command]);
+    for (u32 i = 0; i < arg_count; i++)
+    {
+        trace_value(vm_pop(vm));
+        trace_printf(i + 1 < arg_count ? ", " : "");
+    }
+    trace_printf(")\n");
+
+    if (command == CMD_Rand)
+        *out = INT_VAL(next_rand++);
+    if (exits)
+        vm->ip = vm->event.code_len;
+
+    return false;
+}
+
+#define STUB(command, yields, exits)                                           \
+    static bool stub_##command(VM *vm, Value *out, u32 arg_count,              \
+                               Resources *resources)                           \
+    {                                                                          \
+        (void)resources;                                                       \
+        return record(command, vm, out, arg_count, yields, exits);             \
+    }
+
+STUB(CMD_Printf, false, false)
+STUB(CMD_Text, true, false)
+STUB(CMD_Wait, true, false)
+STUB(CMD_Yield, true, false)
+STUB(CMD_Rand, false, false)
+STUB(CMD_MoveL, false, false)
+STUB(CMD_MoveR, false, false)
+STUB(CMD_Move, false, false)
+STUB(CMD_ChangeMap, false, true)
+STUB(CMD_Exit, false, true)
+STUB(CMD_SetItem, false, false)
+STUB(CMD_Call, true, false)
+STUB(CMD_Unimplemented, false, false)
+
+// runs an event to completion, and returns its trace. getting paused for
+// running out of budget shouldn't change anything the event does, so it doesn't
+// show up in the trace
+static char *run(VMPool *pool, Event event, u32 budget)
+{
+    static Resources resources;
+
+    vec_clear(&trace);
+    next_rand = 0;
+    globals_clear(&resources.globals);
+
+    VM *vm = vm_pool_get(pool, event);
+
+    u32 ticks = 0, pauses = 0;
+    vm->budget = budget;
+    while (!vm_execute(vm, &resources))
+    {
+        if (vm->preempted)
+        {
+            pauses++;
+            assert(pauses < 1000000);
+            continue;
+        }
+        trace_printf("tick %d\n", ticks);
+        ticks++;
+        assert(ticks < 100000);
+    }
+
+    trace_printf("finished, slots:");
+    for (u32 i = 0; i < event.slot_count; i++)
+    {
+        trace_printf(" ");
+        trace_value(vm->slots[i]);
+    }
+    trace_printf(", globals:");
+    for (u32 i = 0; i < event.global_count; i++)
+    {
+        trace_printf(" $%s=", global_name(event.globals[i]));
+        trace_value(resources.globals.values[event.globals[i]]);
+    }
+    vm_pool_put(pool, vm);
+
+    char terminator = '\0';
+    vec_push(&trace, &terminator);
+    return strdup(trace.data);
+}
+
+static void check_source(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    assert(file);
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *source = calloc(len + 1, 1);
+    usize read = fread(source, 1, len, file);
+    assert(read == (usize)len);
+    fclose(file);
+
+    vec events;
+    vec_init(&events, sizeof(Event));
+
+    VMPool pool;
+    vm_pool_init(&pool);
+
+    // if this fails, the translated file is out of date
+    u32 aot_source = aot_find_source(path, source);
+    assert(aot_source != AOT_NO_SOURCE);
+
+    // the same way the event index finds them
+    Compiler compiler;
+    compiler_init(&compiler, source);
+    Event event;
+    while (compiler_compile(&compiler, &event))
+    {
+        event.aot = aot_find_event(aot_source, event.name);
+        vec_push(&events, &event);
+    }
+    assert(!compiler.failed);
+
+    for (u32 i = 0; i < events.len; i++)
+    {
+        Event *event = vec_get(&events, i);
+        assert(event->aot);
+
+        Event interpreted = *event;
+        interpreted.aot = NULL;
+        char *vm_trace = run(&pool, interpreted, UINT32_MAX);
+
+        // and again, getting paused at every loop
+        char *traces[] = {
+            run(&pool, *event, UINT32_MAX),
+            run(&pool, interpreted, 1),
+            run(&pool, *event, 1),
+        };
+        const char *names[] = {"aot", "paused vm", "paused aot"};
+
+        for (u32 t = 0; t < 3; t++)
+        {
+            if (strcmp(traces[t], vm_trace))
+            {
+                fprintf(stderr,
+                        "event %s differs!\n== vm ==\n%s\n== %s ==\n%s\n",
+                        event->name, vm_trace, names[t], traces[t]);
+                assert(false);
+            }
+            free(traces[t]);
+        }
+        free(vm_trace);
+        event_free(event);
+    }
+
+    vm_pool_free(&pool);
+    vec_free(&events);
+    free(source);
+}
+
+int main()
+{
+    fake_commands[CMD_Printf] = stub_CMD_Printf;
+    fake_commands[CMD_Text] = stub_CMD_Text;
+    fake_commands[CMD_Wait] = stub_CMD_Wait;
+    fake_commands[CMD_Yield] = stub_CMD_Yield;
+    fake_commands[CMD_Rand] = stub_CMD_Rand;
+    fake_commands[CMD_MoveL] = stub_CMD_MoveL;
+    fake_commands[CMD_MoveR] = stub_CMD_MoveR;
+    fake_commands[CMD_Move] = stub_CMD_Move;
+    fake_commands[CMD_ChangeMap] = stub_CMD_ChangeMap;
+    fake_commands[CMD_Exit] = stub_CMD_Exit;
+    fake_commands[CMD_SetItem] = stub_CMD_SetItem;
+    fake_commands[CMD_Call] = stub_CMD_Call;
+    fake_commands[CMD_Unimplemented] = stub_CMD_Unimplemented;
+
+    vec_init(&trace, sizeof(char));
+
+    // paths are relative to the source directory
+    for (u32 i = 0; i < AOT_SOURCE_COUNT; i++)
+        check_source(AOT_SOURCES[i].path);
+
+    vec_free(&trace);
+    global_names_free();
+    intern_free();
+}
@@ -0,0 +1,333 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "events/aot.h"
+#include "events/event_index.h"
+#include "events/scheduler.h"
+#include "events/vm.h"
+#include "fake_commands.h"
+#include "utility/intern.h"
+
+// checks that lazily compiled events come out the same as compiling everything
+// up front, and measures how much startup time skipping that saves. also checks
+// that hot reloading only touches the events that changed.
+
+// nothing in here has been translated to C
+const AotSource AOT_SOURCES[] = {{0}};
+const u32 AOT_SOURCE_COUNT = 0;
+const AotEvent AOT_EVENTS[] = {{0}};
+const u32 AOT_EVENT_COUNT = 0;
+
+#define SCRIPT_PATH "event_index_test_script.txt"
+#define RELOAD_PATH "event_index_test_reload.txt"
+#define EVENTS 5000
+
+static bool stub_yield(VM *vm, Value *out, u32 arg_count, Resources *resources)
+{
+    (void)out;
+    (void)resources;
+    assert(arg_count == 0);
+
+    bool *did_yield = &vm->command_ctx.yield.did_yield;
+    *did_yield = !*did_yield;
+    return *did_yield;
+}
+
+// looks like a lot of map dialogue. braces in strings and comments are there
+// to trip up the pre-scan
+static usize write_script(void)
+{
+    FILE *file = fopen(SCRIPT_PATH, "wb");
+    assert(file);
+
+    for (u32 e = 0; e < EVENTS; e++)
+    {
+        fprintf(file, "# dialogue for npc %u }}}\nevent \"npc_%u\" {\n", e, e);
+        fprintf(file, "    talked = rand(1, 3);\n");
+        fprintf(file, "    if talked > 1 {\n");
+        fprintf(file, "        text(\"we've already talked {%u times}\");\n",
+                e);
+        fprintf(file, "        goto done;\n    }\n");
+        for (u32 line = 0; line < 12; line++)
+            fprintf(file,
+                    "    text(\"line %u of what npc %u has to say, which goes "
+                    "on for a while\"); # {\n",
+                    line, e);
+        fprintf(file, "    for i = 0; i < 3; i++ { wait(0.5); }\n");
+        fprintf(file, "  done:\n}\n\n");
+    }
+
+    // one broken event shouldn't stop anything else from loading
+    fprintf(file, "event \"broken\" { x = ; }\n");
+    // and neither should one that only fails the type check
+    fprintf(file, "event \"mistyped\" {\n    x = 1.5 %% 2;\n}\n");
+
+    usize len = ftell(file);
+    fclose(file);
+    return len;
+}
+
+// npc_<changed> says something different (or forgets a bracket, if it's
+// `broken`), npc_<removed> is gone, and there's an extra event at the end
+static void write_reload_script(u32 changed, u32 removed, bool spinner_changed,
+                                bool broken)
+{
+    FILE *file = fopen(RELOAD_PATH, "wb");
+    assert(file);
+
+    fprintf(file, "event \"spinner\" {\n");
+    if (spinner_changed)
+        fprintf(file, "    spun = true;\n");
+    fprintf(file, "    while true { yield(); }\n}\n");
+
+    for (u32 e = 0; e < EVENTS; e++)
+    {
+        if (e == removed)
+            continue;
+        fprintf(file, "event \"npc_%u\" {\n", e);
+        fprintf(file, "    text(\"%s from npc %u\"%s;\n",
+                e == changed ? "goodbye" : "hello", e,
+                e == changed && broken ? "" : ")");
+        fprintf(file, "}\n");
+    }
+    if (changed != UINT32_MAX)
+        fprintf(file, "event \"new\" { text(\"i'm new\"); }\n");
+
+    fclose(file);
+}
+
+static f64 ms_since(clock_t start)
+{
+    return (f64)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static void check_same(EventIndex *lazy, EventIndex *eager, const char *name)
+{
+    Event a, b;
+    assert(event_index_get(lazy, name, &a));
+    assert(event_index_get(eager, name, &b));
+
+    assert(!strcmp(a.name, name));
+    assert(!strcmp(a.name, b.name));
+    assert(a.code_len == b.code_len);
+    assert(!memcmp(a.code, b.code, a.code_len));
+    assert(a.constant_count == b.constant_count);
+    assert(a.slot_count == b.slot_count);
+    assert(a.stack_max == b.stack_max);
+}
+
+static void check_hot_reload(void)
+{
+    write_reload_script(UINT32_MAX, UINT32_MAX, false, false);
+
+    EventIndex index;
+    event_index_init(&index, false);
+    event_index_add_file(&index, RELOAD_PATH);
+    assert(event_index_count(&index) == EVENTS + 1);
+
+    Scheduler scheduler;
+    scheduler_init(&scheduler);
+
+    // something's running the old version of the spinner when it changes
+    Event old_spinner, old_npc_0, old_npc_1;
+    assert(event_index_get(&index, "spinner", &old_spinner));
+    assert(event_index_get(&index, "npc_0", &old_npc_0));
+    assert(event_index_get(&index, "npc_1", &old_npc_1));
+    assert(event_line(&old_npc_0, 0) == 5);
+    ScriptHandle spinning = scheduler_spawn(&scheduler, old_spinner, NULL);
+    scheduler_tick(&scheduler, NULL);
+
+    write_reload_script(1, 2, true, false);
+    clock_t start = clock();
+    event_index_reload_file(&index, RELOAD_PATH);
+    f64 reload_ms = ms_since(start);
+    printf("reloading %u events with 4 changes: %.2fms\n", EVENTS + 1,
+           reload_ms);
+
+    // spinner and npc_1 changed, npc_2 was removed, new was added
+    assert(index.reloaded_count == 4);
+    assert(event_index_count(&index) == EVENTS + 1);
+    assert(index.retired.len == 2);
+
+    Event event;
+    assert(!event_index_get(&index, "npc_2", &event));
+    assert(event_index_get(&index, "new", &event));
+
+    // things that didn't change don't get recompiled
+    assert(event_index_get(&index, "npc_0", &event));
+    assert(event.code == old_npc_0.code);
+    // but the spinner got a line longer, so it moved down
+    assert(event_line(&event, 0) == 6);
+
+    // things that did do
+    assert(event_index_get(&index, "npc_1", &event));
+    assert(event.code != old_npc_1.code);
+    Event new_spinner;
+    assert(event_index_get(&index, "spinner", &new_spinner));
+    assert(new_spinner.code != old_spinner.code);
+    assert(new_spinner.slot_count == 1);
+
+    // the running spinner keeps its old code, so that can't be freed yet
+    for (u32 i = 0; i < 10; i++)
+        scheduler_tick(&scheduler, NULL);
+    assert(scheduler_is_running(&scheduler, spinning));
+    event_index_poll(&index, &scheduler);
+    assert(index.retired.len == 1);
+
+    scheduler_kill(&scheduler, spinning);
+    event_index_poll(&index, &scheduler);
+    assert(index.retired.len == 0);
+
+    // a half finished edit doesn't change anything
+    FILE *file = fopen(RELOAD_PATH, "ab");
+    fprintf(file, "event \"half\" { text(\"unterminated); }\n");
+    fclose(file);
+    u32 reloaded = index.reloaded_count;
+    event_index_reload_file(&index, RELOAD_PATH);
+    assert(index.reloaded_count == reloaded);
+    assert(!event_index_get(&index, "half", &event));
+    assert(event_index_get(&index, "npc_1", &event));
+
+    // an edit that scans fine but doesn't compile leaves the old version of
+    // the event running
+    Event working;
+    assert(event_index_get(&index, "npc_1", &working));
+    u32 retired = index.retired.len;
+    write_reload_script(1, 2, true, true);
+    event_index_reload_file(&index, RELOAD_PATH);
+    assert(index.retired.len == retired);
+    assert(event_index_get(&index, "npc_1", &event));
+    assert(event.code == working.code);
+
+    // until it's fixed
+    write_reload_script(1, 2, true, false);
+    event_index_reload_file(&index, RELOAD_PATH);
+    assert(index.retired.len == retired + 1);
+    assert(event_index_get(&index, "npc_1", &event));
+    assert(event.code != working.code);
+    assert(event.code_len == working.code_len);
+
+    scheduler_free(&scheduler);
+    event_index_free(&index);
+    remove(RELOAD_PATH);
+}
+
+int main()
+{
+    fake_commands[CMD_Yield] = stub_yield;
+
+    usize script_len = write_script();
+
+    // the old way: compile everything at startup (minus the broken event,
+    // which used to stop the game from starting at all)
+    EventIndex eager;
+    clock_t start = clock();
+    event_index_init(&eager, false);
+    event_index_add_file(&eager, SCRIPT_PATH);
+    for (u32 e = 0; e < EVENTS; e++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "npc_%u", e);
+        Event event;
+        assert(event_index_get(&eager, name, &event));
+    }
+    f64 eager_ms = ms_since(start);
+    assert(eager.compiled_count == EVENTS);
+
+    // the new way: only scan
+    EventIndex lazy;
+    start = clock();
+    event_index_init(&lazy, false);
+    event_index_add_file(&lazy, SCRIPT_PATH);
+    f64 lazy_ms = ms_since(start);
+
+    assert(event_index_count(&lazy) == EVENTS + 2);
+    assert(lazy.compiled_count == 0);
+
+    printf("%.2fMB, %u events: %.2fms to compile everything, %.2fms to "
+           "index\n",
+           script_len / (1024.0 * 1024.0), EVENTS, eager_ms, lazy_ms);
+
+    // looking things up compiles them, exactly once
+    check_same(&lazy, &eager, "npc_0");
+    check_same(&lazy, &eager, "npc_4999");
+    check_same(&lazy, &eager, "npc_0");
+    assert(lazy.compiled_count == 2);
+
+    Event missing;
+    assert(!event_index_get(&lazy, "npc_5000", &missing));
+    assert(!event_index_get(&lazy, "npc", &missing));
+
+    // events that don't compile fail every lookup, but only get compiled once
+    assert(!event_index_get(&lazy, "mistyped", &missing));
+    assert(!event_index_get(&lazy, "mistyped", &missing));
+    assert(!event_index_get(&lazy, "broken", &missing));
+    assert(lazy.compiled_count == 2);
+    u32 mistyped;
+    for (mistyped = 0; mistyped < lazy.entries.len; mistyped++)
+        if (!strcmp(((EventEntry *)vec_get(&lazy.entries, mistyped))->name,
+                    "mistyped"))
+            break;
+    EventEntry *entry = vec_get(&lazy.entries, mistyped);
+    assert(entry->state == EventState_Failed);
+    assert(strstr(entry->error, SCRIPT_PATH ":"));
+
+    // prefetching compiles on the worker, and lookups wait for it if they
+    // have to
+    for (u32 e = 100; e < 200; e++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "npc_%u", e);
+        event_index_prefetch(&lazy, name);
+    }
+    event_index_prefetch(&lazy, "not an event");
+    assert(lazy.prefetched_count == 100);
+    for (u32 e = 100; e < 200; e++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "npc_%u", e);
+        check_same(&lazy, &eager, name);
+    }
+    assert(lazy.compiled_count == 102);
+
+    // loading a save while the worker is compiling doesn't trip over the
+    // names or strings the compiler is adding
+    static Globals globals;
+    globals_clear(&globals);
+    globals.values[global_index("loaded")] = (Value){
+        .type = Val_String,
+        .data.string = intern_string("from a save"),
+    };
+    vec saved;
+    vec_init(&saved, sizeof(u8));
+    globals_serialize(&globals, &saved);
+    globals_clear(&globals);
+    for (u32 e = 200; e < 300; e++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "npc_%u", e);
+        event_index_prefetch(&lazy, name);
+    }
+    assert(event_index_load_globals(&lazy, &globals, (u8 *)saved.data,
+                                    saved.len));
+    for (u32 e = 200; e < 300; e++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "npc_%u", e);
+        check_same(&lazy, &eager, name);
+    }
+    assert(globals.values[global_index("loaded")].data.string ==
+           intern_string("from a save"));
+    vec_free(&saved);
+
+    event_index_free(&lazy);
+    event_index_free(&eager);
+    remove(SCRIPT_PATH);
+
+    check_hot_reload();
+
+    global_names_free();
+    intern_free();
+}
@@ -0,0 +1,56 @@
+#include "fake_commands.h"
+#include <assert.h>
+#include <stdio.h>
+
+command_fn fake_commands[Command_Max_Val] = {0};
+
+static bool run(Command command, VM *vm, Value *out, u32 arg_count,
+                Resources *resources)
+{
+    command_fn fn = fake_commands[command];
+    if (!fn)
+    {
+        fprintf(stderr, "%s() was called, but the test doesn't expect it\n",
+                COMMAND_NAMES[command]);
+        assert(false);
+        return false;
+    }
+    return fn(vm, out, arg_count, resources);
+}
+
+#define FORWARD(command)                                                       \
+    static bool forward_##command(VM *vm, Value *out, u32 arg_count,           \
+                                  Resources *resources)                        \
+    {                                                                          \
+        return run(command, vm, out, arg_count, resources);                    \
+    }
+
+FORWARD(CMD_Printf)
+FORWARD(CMD_Text)
+FORWARD(CMD_Wait)
+FORWARD(CMD_Yield)
+FORWARD(CMD_Rand)
+FORWARD(CMD_MoveL)
+FORWARD(CMD_MoveR)
+FORWARD(CMD_Move)
+FORWARD(CMD_ChangeMap)
+FORWARD(CMD_Exit)
+FORWARD(CMD_SetItem)
+FORWARD(CMD_Call)
+FORWARD(CMD_Unimplemented)
+
+const CommandData COMMANDS[Command_Max_Val] = {
+    [CMD_Printf] = {forward_CMD_Printf},
+    [CMD_Text] = {forward_CMD_Text},
+    [CMD_Wait] = {forward_CMD_Wait},
+    [CMD_Yield] = {forward_CMD_Yield},
+    [CMD_Rand] = {forward_CMD_Rand},
+    [CMD_MoveL] = {forward_CMD_MoveL},
+    [CMD_MoveR] = {forward_CMD_MoveR},
+    [CMD_Move] = {forward_CMD_Move},
+    [CMD_ChangeMap] = {forward_CMD_ChangeMap},
+    [CMD_Exit] = {forward_CMD_Exit},
+    [CMD_SetItem] = {forward_CMD_SetItem},
+    [CMD_Call] = {forward_CMD_Call},
+    [CMD_Unimplemented] = {forward_CMD_Unimplemented},
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "events/commands/commands.h"
+
+// the event tests don't link the real commands (or everything they need), so
+// tests/fake_commands.c has a COMMANDS that runs these instead. any command a
+// test hasn't set fails the test if a script calls it.
+extern command_fn fake_commands[Command_Max_Val];
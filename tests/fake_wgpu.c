@@ -0,0 +1,247 @@
+#include "fake_wgpu.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utility/graphics.h"
+
+#define MAX_BUFFERS 256
+
+FakeWGPU fake_wgpu = {0};
+
+// ---  ---
+
+typedef struct
+{
+    u64 size;
+    u8 *data; // NULL once it's released
+} FakeBuffer;
+
+// buffers are an index into this, plus one so none of them are NULL
+static FakeBuffer buffers[MAX_BUFFERS];
+
+static FakeBuffer *get_buffer(WGPUBuffer buffer)
+{
+    uintptr_t index = (uintptr_t)buffer - 1;
+    assert(index < fake_wgpu.buffers_made);
+    assert(buffers[index].data != NULL);
+    return &buffers[index];
+}
+
+WGPUBuffer wgpuDeviceCreateBuffer(WGPUDevice device,
+                                  WGPUBufferDescriptor const *descriptor)
+{
+    (void)device;
+    assert(fake_wgpu.buffers_made < MAX_BUFFERS);
+    FakeBuffer *buffer = &buffers[fake_wgpu.buffers_made++];
+    buffer->size = descriptor->size;
+    // so empty buffers still count as made
+    buffer->data = calloc(1, descriptor->size ? descriptor->size : 1);
+    fake_wgpu.live_buffers++;
+    return (WGPUBuffer)(uintptr_t)fake_wgpu.buffers_made;
+}
+
+void wgpuBufferRelease(WGPUBuffer buffer)
+{
+    FakeBuffer *fake = get_buffer(buffer);
+    free(fake->data);
+    fake->data = NULL;
+    fake_wgpu.live_buffers--;
+}
+
+uint64_t wgpuBufferGetSize(WGPUBuffer buffer)
+{
+    return get_buffer(buffer)->size;
+}
+
+void wgpuQueueWriteBuffer(WGPUQueue queue, WGPUBuffer buffer,
+                          uint64_t offset, void const *data, size_t size)
+{
+    (void)queue;
+    FakeBuffer *fake = get_buffer(buffer);
+    assert(offset + size <= fake->size);
+    memcpy(fake->data + offset, data, size);
+    fake_wgpu.uploaded += size;
+}
+
+u8 *fake_buffer_data(WGPUBuffer buffer) { return get_buffer(buffer)->data; }
+
+// ---  ---
+
+// bind groups and their layouts are just numbers
+static uintptr_t next_bind_group = 1;
+
+WGPUBindGroupLayout
+wgpuDeviceCreateBindGroupLayout(WGPUDevice device,
+                                WGPUBindGroupLayoutDescriptor const *descriptor)
+{
+    (void)device;
+    (void)descriptor;
+    return (WGPUBindGroupLayout)next_bind_group++;
+}
+
+WGPUBindGroup
+wgpuDeviceCreateBindGroup(WGPUDevice device,
+                          WGPUBindGroupDescriptor const *descriptor)
+{
+    (void)device;
+    (void)descriptor;
+    return (WGPUBindGroup)next_bind_group++;
+}
+
+// ---  ---
+
+typedef struct
+{
+    u32 width, height;
+} FakeTexture;
+
+WGPUTexture fake_texture(u32 width, u32 height)
+{
+    FakeTexture *texture = malloc(sizeof(FakeTexture));
+    *texture = (FakeTexture){width, height};
+    fake_wgpu.live_textures++;
+    return (WGPUTexture)texture;
+}
+
+WGPUTexture texture_from_surface(SDL_Surface *surface, WGPUTextureUsage usage,
+                                 WGPUResources *wgpu)
+{
+    (void)usage;
+    (void)wgpu;
+    return fake_texture(surface->w, surface->h);
+}
+
+WGPUTexture blank_texture(u32 w, u32 h, WGPUTextureUsage usage,
+                          WGPUResources *wgpu)
+{
+    (void)usage;
+    (void)wgpu;
+    return fake_texture(w, h);
+}
+
+void write_surface_to_texture_at(u32 x, u32 y, SDL_Surface *surface,
+                                 WGPUTexture texture, WGPUResources *wgpu)
+{
+    (void)wgpu;
+    FakeTexture *fake = (FakeTexture *)texture;
+    assert(x + surface->w <= fake->width && y + surface->h <= fake->height);
+}
+
+uint32_t wgpuTextureGetWidth(WGPUTexture texture)
+{
+    return ((FakeTexture *)texture)->width;
+}
+
+uint32_t wgpuTextureGetHeight(WGPUTexture texture)
+{
+    return ((FakeTexture *)texture)->height;
+}
+
+// views are the texture
+WGPUTextureView wgpuTextureCreateView(WGPUTexture texture,
+                                      WGPUTextureViewDescriptor const *desc)
+{
+    (void)desc;
+    return (WGPUTextureView)texture;
+}
+
+void wgpuTextureViewRelease(WGPUTextureView view) { (void)view; }
+
+void wgpuTextureRelease(WGPUTexture texture)
+{
+    free(texture);
+    fake_wgpu.live_textures--;
+}
+
+// ---  ---
+
+void wgpuRenderPassEncoderSetPipeline(WGPURenderPassEncoder pass,
+                                      WGPURenderPipeline pipeline)
+{
+    (void)pass;
+    (void)pipeline;
+    fake_wgpu.pipelines_set++;
+}
+
+void wgpuRenderPassEncoderSetBindGroup(WGPURenderPassEncoder pass,
+                                       uint32_t index, WGPUBindGroup group,
+                                       size_t offset_count,
+                                       uint32_t const *offsets)
+{
+    (void)pass;
+    (void)index;
+    (void)group;
+    (void)offset_count;
+    (void)offsets;
+    fake_wgpu.bind_groups_set++;
+}
+
+void wgpuRenderPassEncoderSetVertexBuffer(WGPURenderPassEncoder pass,
+                                          uint32_t slot, WGPUBuffer buffer,
+                                          uint64_t offset, uint64_t size)
+{
+    (void)pass;
+    (void)slot;
+    (void)buffer;
+    (void)offset;
+    (void)size;
+    fake_wgpu.vertex_buffers_set++;
+}
+
+void wgpuRenderPassEncoderSetIndexBuffer(WGPURenderPassEncoder pass,
+                                         WGPUBuffer buffer,
+                                         WGPUIndexFormat format,
+                                         uint64_t offset, uint64_t size)
+{
+    (void)pass;
+    (void)buffer;
+    (void)format;
+    (void)offset;
+    (void)size;
+    fake_wgpu.index_buffers_set++;
+}
+
+void wgpuRenderPassEncoderSetPushConstants(WGPURenderPassEncoder pass,
+                                           WGPUShaderStageFlags stages,
+                                           uint32_t offset, uint32_t size,
+                                           void const *data)
+{
+    (void)pass;
+    (void)stages;
+    (void)offset;
+    (void)size;
+    (void)data;
+}
+
+static void draw(u32 vertex_count, u32 instance_count, u32 first_instance)
+{
+    fake_wgpu.draws++;
+    fake_wgpu.instances_drawn += instance_count;
+    fake_wgpu.last_draw = (FakeDraw){
+        .vertex_count = vertex_count,
+        .instance_count = instance_count,
+        .first_instance = first_instance,
+    };
+}
+
+void wgpuRenderPassEncoderDraw(WGPURenderPassEncoder pass,
+                               uint32_t vertex_count, uint32_t instance_count,
+                               uint32_t first_vertex, uint32_t first_instance)
+{
+    (void)pass;
+    (void)first_vertex;
+    draw(vertex_count, instance_count, first_instance);
+}
+
+void wgpuRenderPassEncoderDrawIndexed(WGPURenderPassEncoder pass,
+                                      uint32_t index_count,
+                                      uint32_t instance_count,
+                                      uint32_t first_index, int32_t base_vertex,
+                                      uint32_t first_instance)
+{
+    (void)pass;
+    (void)first_index;
+    (void)base_vertex;
+    draw(index_count, instance_count, first_instance);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <wgpu.h>
+#include "sensible_nums.h"
+
+// there's no gpu in the tests, so tests/fake_wgpu.c stands in for the wgpu
+// calls the graphics code makes. buffers are plain memory, so what got
+// uploaded can be looked at, and textures are just their size.
+// everything it does gets counted here. tests can reset the counts whenever
+// they like.
+
+typedef struct
+{
+    // index_count for indexed draws
+    u32 vertex_count;
+    u32 instance_count;
+    u32 first_instance;
+} FakeDraw;
+
+typedef struct
+{
+    u32 buffers_made, live_buffers;
+    // bytes written with wgpuQueueWriteBuffer
+    u64 uploaded;
+
+    u32 live_textures;
+
+    // the wgpuRenderPassEncoderSet* calls that got through
+    u32 pipelines_set, bind_groups_set, vertex_buffers_set, index_buffers_set;
+    // indexed or not
+    u32 draws, instances_drawn;
+    FakeDraw last_draw;
+} FakeWGPU;
+
+extern FakeWGPU fake_wgpu;
+
+// what's in a buffer made with wgpuDeviceCreateBuffer
+u8 *fake_buffer_data(WGPUBuffer buffer);
+
+// for textures that don't come from a surface, like ones a test registers
+WGPUTexture fake_texture(u32 width, u32 height);
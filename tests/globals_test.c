@@ -0,0 +1,275 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "events/compiler.h"
+#include "events/globals.h"
+#include "events/vm.h"
+#include "events/vm_pool.h"
+#include "fake_commands.h"
+#include "utility/hashmap.h"
+#include "utility/intern.h"
+
+// checks that globals last between events, that every event sees the same
+// index for the same global, and that saving and loading them works no matter
+// what order globals got their indices in. also measures flag-heavy scripts
+// using globals against keeping flags in commands.
+
+#define ITERATIONS 100000
+
+static Resources resources;
+
+// before globals, flags lived behind commands that looked them up by name.
+// set_item(name, value) and rand(name, 0) stand in for those here
+static HashMap flags; // HashMap<char*, Value>
+
+static bool stub_set_flag(VM *vm, Value *out, u32 arg_count,
+                          Resources *resources)
+{
+    (void)out;
+    (void)resources;
+    assert(arg_count == 2);
+    Value value = vm_pop(vm);
+    char *name = vm_pop(vm).data.string;
+    void *existing = hashmap_get(&flags, &name);
+    if (existing)
+        memcpy(existing, &value, sizeof(Value));
+    else
+        hashmap_insert(&flags, &name, &value);
+    return false;
+}
+
+static bool stub_get_flag(VM *vm, Value *out, u32 arg_count,
+                          Resources *resources)
+{
+    (void)resources;
+    assert(arg_count == 2);
+    vm_pop(vm);
+    char *name = vm_pop(vm).data.string;
+    void *value = hashmap_get(&flags, &name);
+    // hashmap values aren't aligned
+    if (value)
+        memcpy(out, value, sizeof(Value));
+    return false;
+}
+
+static Event compile(const char *source)
+{
+    Compiler compiler;
+    compiler_init(&compiler, source);
+    Event event;
+    bool compiled = compiler_compile(&compiler, &event);
+    assert(compiled);
+    return event;
+}
+
+static void run(VMPool *pool, Event event)
+{
+    VM *vm = vm_pool_get(pool, event);
+    bool finished = vm_execute(vm, &resources);
+    assert(finished);
+    vm_pool_put(pool, vm);
+}
+
+static Value get(const char *name)
+{
+    return resources.globals.values[global_index(name)];
+}
+
+// the index the first global instruction in `event` uses
+static u32 first_global(Event *event)
+{
+    u32 ip = 0;
+    while (ip < event->code_len)
+    {
+        Instruction insn;
+        u32 next = instruction_decode(event->code, ip, &insn);
+        if (insn.code == Code_FetchGlobal || insn.code == Code_SetGlobal)
+            return insn.data.global;
+        ip = next;
+    }
+    assert(false);
+}
+
+static void check_globals(VMPool *pool)
+{
+    Event first = compile("event \"first\" {"
+                          "  $count = 1;"
+                          "  $count += 2;"
+                          "  $name = \"willow\";"
+                          "  $ratio = 0.5;"
+                          "  $seen = true;"
+                          "  local = $count;"
+                          "}");
+    // globals can be called anything, even keywords
+    Event second = compile("event \"second\" {"
+                           "  if $seen { $count++; }"
+                           "  $if = $never_set == none;"
+                           "}");
+
+    // the same global gets the same index everywhere, and it's right there in
+    // the bytecode
+    assert(first_global(&first) == global_index("count"));
+    assert(first_global(&second) == global_index("seen"));
+    assert(first.global_count == 4);
+    assert(first.globals[0] == global_index("count"));
+    assert(first.globals[3] == global_index("seen"));
+    // globals don't take up slots
+    assert(first.slot_count == 1);
+    assert(second.global_count == 4);
+
+    run(pool, first);
+    assert(get("count").type == Val_Int && get("count").data._int == 3);
+    assert(get("name").data.string == intern_string("willow"));
+
+    run(pool, second);
+    assert(get("count").data._int == 4);
+    assert(VAL_IS_TRUE(get("if")));
+    assert(VAL_IS_NONE(get("never_set")));
+
+    event_free(&first);
+    event_free(&second);
+}
+
+static void check_save(void)
+{
+    vec saved;
+    vec_init(&saved, sizeof(u8));
+    globals_serialize(&resources.globals, &saved);
+
+    // start over, with the same names getting different indices
+    globals_clear(&resources.globals);
+    global_names_free();
+    global_index("something_else");
+    assert(global_index("count") != 0);
+
+    u8 *data = (u8 *)saved.data;
+    assert(globals_deserialize(&resources.globals, data, saved.len));
+    assert(get("count").type == Val_Int && get("count").data._int == 4);
+    assert(get("name").data.string == intern_string("willow"));
+    assert(get("ratio").type == Val_Float && get("ratio").data._float == 0.5f);
+    assert(VAL_IS_TRUE(get("seen")));
+    assert(VAL_IS_TRUE(get("if")));
+    assert(VAL_IS_NONE(get("never_set")));
+    assert(VAL_IS_NONE(get("something_else")));
+
+    // saving again gives back the same globals (not necessarily in the same
+    // order, since that depends on the indices)
+    vec again;
+    vec_init(&again, sizeof(u8));
+    globals_serialize(&resources.globals, &again);
+    assert(again.len == saved.len);
+    vec_free(&again);
+
+    // broken saves don't change anything
+    u8 *broken = malloc(saved.len + 1);
+    memcpy(broken, saved.data, saved.len);
+    for (usize len = 0; len < saved.len; len++)
+    {
+        assert(!globals_deserialize(&resources.globals, broken, len));
+        assert(get("count").data._int == 4);
+    }
+    broken[saved.len] = 0;
+    assert(!globals_deserialize(&resources.globals, broken, saved.len + 1));
+    broken[0] = 'X';
+    assert(!globals_deserialize(&resources.globals, broken, saved.len));
+    assert(get("count").data._int == 4);
+
+    // a save that's fine, but has more new names than there's room for, is
+    // turned down rather than running out of indices halfway through
+    static Globals before;
+    before = resources.globals;
+    global_names_free();
+    // leaves room for one more
+    u32 last = 0;
+    for (u32 i = 0; last < GLOBAL_MAX - 2; i++)
+    {
+        char filler[32];
+        snprintf(filler, sizeof(filler), "filler_%u", i);
+        last = global_index(filler);
+    }
+    assert(!globals_deserialize(&resources.globals, data, saved.len));
+    assert(memcmp(&before, &resources.globals, sizeof(Globals)) == 0);
+
+    global_names_free();
+    assert(globals_deserialize(&resources.globals, data, saved.len));
+    assert(get("count").data._int == 4);
+
+    free(broken);
+    vec_free(&saved);
+}
+
+static f64 time_event(VMPool *pool, const char *source)
+{
+    Event event = compile(source);
+    clock_t start = clock();
+    run(pool, event);
+    f64 ms = (f64)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    event_free(&event);
+    return ms;
+}
+
+#define LOOP "  for i = 0; i < 100000; i++ {"
+
+// the same flag juggling three ways
+static void check_benchmark(VMPool *pool)
+{
+    f64 locals_ms = time_event(pool, "event \"locals\" {"
+                                     "  talks = 0; met_lou = false;"
+                                     LOOP
+                                     "    if !met_lou { talks += 1; }"
+                                     "    met_lou = i % 4 == 0;"
+                                     "  }"
+                                     "}");
+
+    f64 globals_ms = time_event(pool, "event \"globals\" {"
+                                      "  $talks = 0; $met_lou = false;"
+                                      LOOP
+                                      "    if !$met_lou { $talks += 1; }"
+                                      "    $met_lou = i % 4 == 0;"
+                                      "  }"
+                                      "}");
+    assert(get("talks").data._int == ITERATIONS / 4 * 3);
+
+    f64 commands_ms = time_event(
+        pool, "event \"commands\" {"
+              "  set_item(\"talks\", 0); set_item(\"met_lou\", false);"
+              LOOP
+              "    if !rand(\"met_lou\", 0) {"
+              "      set_item(\"talks\", rand(\"talks\", 0) + 1);"
+              "    }"
+              "    set_item(\"met_lou\", i % 4 == 0);"
+              "  }"
+              "}");
+    char *talks = intern_string("talks");
+    Value value;
+    memcpy(&value, hashmap_get(&flags, &talks), sizeof(Value));
+    assert(value.data._int == get("talks").data._int);
+
+    printf("%d iterations of flag checks: %.2fms with locals, %.2fms with "
+           "globals, %.2fms with commands\n",
+           ITERATIONS, locals_ms, globals_ms, commands_ms);
+}
+
+int main()
+{
+    fake_commands[CMD_Rand] = stub_get_flag;
+    fake_commands[CMD_SetItem] = stub_set_flag;
+
+    globals_clear(&resources.globals);
+    hashmap_init(&flags, fnv_cstr_ptr_hash_function, cstr_ptr_eq_function,
+                 sizeof(char *), sizeof(Value));
+
+    VMPool pool;
+    vm_pool_init(&pool);
+
+    check_globals(&pool);
+    check_save();
+    check_benchmark(&pool);
+
+    vm_pool_free(&pool);
+    hashmap_free(&flags);
+    global_names_free();
+    intern_free();
+}
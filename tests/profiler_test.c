@@ -0,0 +1,278 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "events/compiler.h"
+#include "events/profiler.h"
+#include "events/scheduler.h"
+#include "events/vm.h"
+#include "events/vm_pool.h"
+#include "fake_commands.h"
+#include "utility/intern.h"
+
+// checks that the profiler puts instructions down to the right event, line and
+// opcode, times commands, counts yields and wakes, and measures what turning it
+// on costs.
+
+#define CSV_PATH "profiler_test.csv"
+
+static Resources resources;
+
+// opens a "textbox" the first time, and waits for it to close
+static bool stub_text(VM *vm, Value *out, u32 arg_count, Resources *resources)
+{
+    (void)out;
+    (void)resources;
+    assert(arg_count == 1);
+
+    bool *started = &vm->command_ctx.yield.did_yield;
+    if (*started)
+    {
+        *started = false;
+        vm_pop(vm);
+        return false;
+    }
+
+    Instant start = vm_profiler_scope_begin();
+    // pretend to lay out some text
+    volatile u32 work = 0;
+    for (u32 i = 0; i < 10000; i++)
+        work += i;
+    vm_profiler_scope_end(start, "pretend_display");
+
+    *started = true;
+    vm_wait_signal(vm, Signal_TextboxClosed);
+    return true;
+}
+
+// starts on line 3 of the file
+#define COUNTER_SOURCE                                                         \
+    "# a comment\n"                                                            \
+    "\n"                                                                       \
+    "event \"counter\" {\n"                                                    \
+    "    total = 0;\n"                                                         \
+    "    for i = 0; i < 1000; i++ {\n"                                         \
+    "        total += i;\n"                                                    \
+    "    }\n"                                                                  \
+    "    text(\"done\");\n"                                                    \
+    "}\n"
+
+static Event compile(const char *source)
+{
+    Compiler compiler;
+    compiler_init(&compiler, source);
+    Event event;
+    bool compiled = compiler_compile(&compiler, &event);
+    assert(compiled);
+    return event;
+}
+
+// how many instructions came from `line`
+static u32 instructions_on_line(Event *event, u32 line)
+{
+    u32 count = 0;
+    u32 ip = 0;
+    while (ip < event->code_len)
+    {
+        Instruction insn;
+        u32 next = instruction_decode(event->code, ip, &insn);
+        count += event_line(event, ip) == line;
+        ip = next;
+    }
+    return count;
+}
+
+static void check_line_table(Event *event)
+{
+    assert(event->line_count > 0);
+    for (u32 i = 1; i < event->line_count; i++)
+    {
+        assert(event->lines[i].ip > event->lines[i - 1].ip);
+        assert(event->lines[i].line > event->lines[i - 1].line);
+    }
+
+    // `total = 0;` is the first thing in the event
+    assert(event_line(event, 0) == 4);
+
+    // the call to text() is on line 8
+    u32 ip = 0;
+    bool found = false;
+    while (ip < event->code_len)
+    {
+        Instruction insn;
+        u32 next = instruction_decode(event->code, ip, &insn);
+        if (insn.code == Code_Call)
+        {
+            assert(event_line(event, ip) == 8);
+            found = true;
+        }
+        ip = next;
+    }
+    assert(found);
+
+    // the body of the loop is on its own line, and jumping back to the top is
+    // put down to the closing brace
+    assert(instructions_on_line(event, 6) > 0);
+    assert(instructions_on_line(event, 7) > 0);
+}
+
+static void check_counts(Event counter, VMProfiler *profiler)
+{
+    Scheduler *scheduler = &resources.scheduler;
+
+    vm_profiler = profiler;
+    ScriptHandle script = scheduler_spawn(scheduler, counter, NULL);
+    scheduler_tick(scheduler, &resources);
+    scheduler_signal(scheduler, Signal_TextboxClosed);
+    scheduler_tick(scheduler, &resources);
+    assert(!scheduler_is_running(scheduler, script));
+    vm_profiler = NULL;
+
+    EventProfile *profile = vm_profiler_event(profiler, "counter");
+    assert(profile->runs.calls == 2);
+    assert(profile->yields == 1);
+    assert(profile->wakes == 1);
+    assert(profile->preemptions == 0);
+    assert(profile->runs.time.inner > 0);
+
+    // every instruction is counted once by opcode, and once by line
+    u64 opcodes = 0;
+    for (u32 op = 0; op < CODE_COUNT; op++)
+        opcodes += profiler->opcodes[op];
+    assert(opcodes == profile->instructions);
+
+    u64 lines = 0;
+    for (u32 i = 0; i < profile->line_counts.len; i++)
+        lines += *(u64 *)vec_get(&profile->line_counts, i);
+    assert(lines == profile->instructions);
+
+    // the loop body ran 1000 times, and the first line ran once
+    u64 *counts = (u64 *)profile->line_counts.data;
+    assert(counts[6 - profile->first_line] ==
+           1000 * instructions_on_line(&counter, 6));
+    assert(counts[4 - profile->first_line] ==
+           instructions_on_line(&counter, 4));
+
+    // text() gets called once to open the textbox, and again once it's closed
+    assert(profiler->commands[CMD_Text].calls == 2);
+    assert(profiler->scopes.len == 1);
+    ScopeProfile *scope = vec_get(&profiler->scopes, 0);
+    assert(!strcmp(scope->name, "pretend_display"));
+    assert(scope->profile.calls == 1);
+    assert(!duration_is_gt(scope->profile.time,
+                           profiler->commands[CMD_Text].time));
+
+    // nothing gets counted while it's off
+    u64 instructions = profile->instructions;
+    script = scheduler_spawn(scheduler, counter, NULL);
+    scheduler_tick(scheduler, &resources);
+    scheduler_kill(scheduler, script);
+    assert(profile->instructions == instructions);
+    assert(profiler->commands[CMD_Text].calls == 2);
+
+    // running out of budget is counted separately from yielding
+    vm_profiler = profiler;
+    scheduler->instruction_budget = 100;
+    script = scheduler_spawn(scheduler, counter, NULL);
+    scheduler_tick(scheduler, &resources);
+    scheduler_kill(scheduler, script);
+    scheduler->instruction_budget = DEFAULT_INSTRUCTION_BUDGET;
+    vm_profiler = NULL;
+    assert(profile->preemptions == 1);
+    assert(profile->yields == 1);
+}
+
+static char *read_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    assert(file);
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = calloc(len + 1, 1);
+    usize read = fread(data, 1, len, file);
+    assert(read == (usize)len);
+    fclose(file);
+    return data;
+}
+
+static void check_csv(VMProfiler *profiler)
+{
+    assert(vm_profiler_export_csv(profiler, CSV_PATH));
+    char *csv = read_file(CSV_PATH);
+
+    assert(!strncmp(csv, "kind,name,line,calls,instructions,time_ms,yields,"
+                         "preemptions,wakes\n",
+                    strlen("kind,name,line,")));
+    assert(strstr(csv, "\nopcode,AddInt,"));
+    assert(strstr(csv, "\nevent,\"counter\",,3,"));
+    assert(strstr(csv, "\nline,\"counter\",6,,"));
+    assert(strstr(csv, "\nline,\"counter\",7,"));
+    assert(!strstr(csv, "\nline,\"counter\",9,"));
+    assert(strstr(csv, "\ncommand,\"text\",,2,"));
+    assert(strstr(csv, "\nscope,\"pretend_display\",,1,"));
+
+    free(csv);
+    remove(CSV_PATH);
+
+    // resetting throws everything away
+    vm_profiler_reset(profiler);
+    assert(profiler->events.len == 0);
+    assert(profiler->commands[CMD_Text].calls == 0);
+    assert(vm_profiler_event(profiler, "counter")->instructions == 0);
+}
+
+static void check_overhead(VMProfiler *profiler)
+{
+    Event bench = compile("event \"bench\" {"
+                          "  total = 0;"
+                          "  for i = 0; i < 1000000; i++ {"
+                          "    if i % 3 == 0 { total += 2; } else { total -= 1; }"
+                          "  }"
+                          "}");
+
+    VMPool pool;
+    vm_pool_init(&pool);
+
+    f64 ms[2];
+    for (u32 profiling = 0; profiling < 2; profiling++)
+    {
+        vm_profiler = profiling ? profiler : NULL;
+        VM *vm = vm_pool_get(&pool, bench);
+        Instant start = instant_now();
+        bool finished = vm_execute(vm, NULL);
+        ms[profiling] = duration_as_secs_f64(instant_elapsed(start)) * 1000.0;
+        assert(finished);
+        vm_pool_put(&pool, vm);
+    }
+    vm_profiler = NULL;
+
+    printf("vm: 1,000,000 loop iterations in %.2fms, %.2fms while profiling\n",
+           ms[0], ms[1]);
+
+    vm_pool_free(&pool);
+    event_free(&bench);
+}
+
+int main()
+{
+    fake_commands[CMD_Text] = stub_text;
+
+    scheduler_init(&resources.scheduler);
+    // the counts here shouldn't depend on how fast the machine is
+    resources.scheduler.time_budget = (Duration){0};
+
+    VMProfiler profiler;
+    vm_profiler_init(&profiler);
+
+    Event counter = compile(COUNTER_SOURCE);
+    check_line_table(&counter);
+    check_counts(counter, &profiler);
+    check_csv(&profiler);
+    check_overhead(&profiler);
+
+    vm_profiler_free(&profiler);
+    scheduler_free(&resources.scheduler);
+    event_free(&counter);
+    intern_free();
+}
@@ -0,0 +1,238 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "fake_wgpu.h"
+#include "graphics/render_queue.h"
+#include "graphics/render_state.h"
+
+// checks the render queue's radix sort against qsort, that things with the
+// same key stay in submission order, and that drawing a frame the way
+// graphics_render does only sets each pipeline/bind group/buffer when it
+// actually changes. there's no gpu here, so the wgpu calls are stubbed out and
+// just counted.
+
+static int compare_entries(const void *a, const void *b)
+{
+    const RenderSortEntry *left = a, *right = b;
+    if (left->key != right->key)
+        return left->key < right->key ? -1 : 1;
+    // qsort isn't stable, so compare the submission order too
+    return left->item < right->item ? -1 : left->item > right->item;
+}
+
+#define SORT_ENTRIES 5000
+
+static void test_sort(void)
+{
+    static RenderSortEntry entries[SORT_ENTRIES], expected[SORT_ENTRIES],
+        scratch[SORT_ENTRIES];
+
+    srand(1234);
+    for (u32 i = 0; i < SORT_ENTRIES; i++)
+    {
+        // only a few different values in each field, so lots of keys are the
+        // same and lots of bytes get skipped
+        RenderKey key = {
+            .pass = rand() % 2,
+            .layer = rand() % 3,
+            .pipeline = rand() % 3,
+            .texture = rand() % 4 == 0 ? rand() : 0,
+            .depth = rand() % 8,
+        };
+        entries[i] = (RenderSortEntry){.key = render_key_pack(key), .item = i};
+        expected[i] = entries[i];
+    }
+
+    render_sort_entries(entries, scratch, SORT_ENTRIES);
+    qsort(expected, SORT_ENTRIES, sizeof(RenderSortEntry), compare_entries);
+    for (u32 i = 0; i < SORT_ENTRIES; i++)
+    {
+        assert(entries[i].key == expected[i].key);
+        assert(entries[i].item == expected[i].item);
+    }
+
+    // nothing to sort
+    render_sort_entries(entries, scratch, 0);
+
+    // every key the same, which skips every byte
+    for (u32 i = 0; i < 10; i++)
+        entries[i] = (RenderSortEntry){.key = 42, .item = 9 - i};
+    render_sort_entries(entries, scratch, 10);
+    for (u32 i = 0; i < 10; i++)
+        assert(entries[i].item == 9 - i);
+}
+
+static void test_key_order(void)
+{
+    RenderKey a = {.pass = RenderPass_Deferred, .layer = 2, .depth = 0xFFFFFF};
+    RenderKey b = {.pass = RenderPass_Screen};
+    assert(render_key_pack(a) < render_key_pack(b));
+
+    // tilemaps before sprites on the same layer, but not before the layer
+    // below
+    RenderKey tilemap = {.layer = 1, .pipeline = RenderPipeline_Tilemap};
+    RenderKey sprite = {.layer = 1, .pipeline = RenderPipeline_Sprite};
+    RenderKey below = {.layer = 0, .pipeline = RenderPipeline_Sprite};
+    assert(render_key_pack(tilemap) < render_key_pack(sprite));
+    assert(render_key_pack(below) < render_key_pack(tilemap));
+
+    // depth only gets 24 bits, and doesn't spill into the texture
+    RenderKey deep = {.depth = 0x1000001};
+    assert(render_key_pack(deep) == 1);
+}
+
+// the order things get drawn in
+static u32 drawn[64];
+static u32 drawn_count = 0;
+
+static void draw_thing(void *thing, void *ctx, RenderState *state)
+{
+    (void)ctx;
+    drawn[drawn_count++] = (u32)(uintptr_t)thing;
+    render_state_draw(state, 6, 1, 0);
+}
+
+static void test_frame(void)
+{
+    WGPURenderPipeline tilemap = (WGPURenderPipeline)1;
+    WGPURenderPipeline sprite = (WGPURenderPipeline)2;
+    WGPURenderPipeline ui_sprite = (WGPURenderPipeline)3;
+    WGPUBindGroup sprite_bind_group = (WGPUBindGroup)1;
+
+    RenderQueue queue;
+    render_queue_init(&queue);
+
+    // the ui gets submitted first, to check it still ends up in its own pass
+    for (u8 layer = 0; layer < 3; layer++)
+    {
+        RenderKey key = {.pass = RenderPass_Screen,
+                         .layer = layer,
+                         .pipeline = RenderPipeline_UiSprite};
+        RenderItem item = {.key = render_key_pack(key),
+                           .pipeline = ui_sprite,
+                           .bind_group = sprite_bind_group,
+                           .draw = draw_thing,
+                           .thing = (void *)(uintptr_t)(100 + layer)};
+        render_queue_push(&queue, &item);
+    }
+
+    // each layer has a sprite batch and two tilemaps, where the sprites are
+    // submitted before the tilemaps
+    for (u8 layer = 0; layer < 3; layer++)
+    {
+        RenderKey key = {.pass = RenderPass_Deferred,
+                         .layer = layer,
+                         .pipeline = RenderPipeline_Sprite};
+        RenderItem item = {.key = render_key_pack(key),
+                           .pipeline = sprite,
+                           .bind_group = sprite_bind_group,
+                           .draw = draw_thing,
+                           .thing = (void *)(uintptr_t)(layer * 10 + 9)};
+        render_queue_push(&queue, &item);
+
+        for (u32 depth = 0; depth < 2; depth++)
+        {
+            key = (RenderKey){.pass = RenderPass_Deferred,
+                              .layer = layer,
+                              .pipeline = RenderPipeline_Tilemap,
+                              .depth = depth};
+            item = (RenderItem){.key = render_key_pack(key),
+                                .pipeline = tilemap,
+                                .bind_group = sprite_bind_group,
+                                .draw = draw_thing,
+                                .thing = (void *)(uintptr_t)(layer * 10 +
+                                                             depth)};
+            render_queue_push(&queue, &item);
+        }
+    }
+
+    render_queue_sort(&queue);
+
+    RenderStats stats = {0};
+    RenderState state;
+    render_state_begin(&state, NULL, &stats);
+    render_queue_execute(&queue, RenderPass_Deferred, &state);
+
+    u32 expected[] = {0, 1, 9, 10, 11, 19, 20, 21, 29};
+    assert(drawn_count == 9);
+    for (u32 i = 0; i < 9; i++)
+        assert(drawn[i] == expected[i]);
+
+    // the bind group only gets set once, and pipelines only when they change
+    // between tilemaps and sprites
+    assert(fake_wgpu.bind_groups_set == 1);
+    assert(stats.bind_groups_skipped == 8);
+    assert(fake_wgpu.pipelines_set == 6);
+    assert(stats.pipelines_skipped == 3);
+    assert(stats.draws == 9);
+
+    // a new pass starts with nothing bound
+    render_state_begin(&state, NULL, &stats);
+    render_queue_execute(&queue, RenderPass_Screen, &state);
+    assert(drawn_count == 12);
+    assert(drawn[9] == 100 && drawn[11] == 102);
+    assert(fake_wgpu.pipelines_set == 7);
+    assert(fake_wgpu.bind_groups_set == 2);
+
+    printf("drew %u things with %u pipeline and %u bind group changes "
+           "(%u and %u skipped)\n",
+           stats.draws, stats.pipelines, stats.bind_groups,
+           stats.pipelines_skipped, stats.bind_groups_skipped);
+
+    // the queue gets reused every frame
+    render_queue_clear(&queue);
+    render_queue_sort(&queue);
+    render_queue_execute(&queue, RenderPass_Deferred, &state);
+    assert(drawn_count == 12);
+
+    render_queue_free(&queue);
+}
+
+// what the box2d debug draw does for every circle
+static void test_repeated_draws(void)
+{
+    WGPURenderPipeline circle = (WGPURenderPipeline)4;
+    WGPUBuffer quads = (WGPUBuffer)1;
+    WGPUBuffer indices = (WGPUBuffer)2;
+
+    RenderStats stats = {0};
+    RenderState state;
+    render_state_begin(&state, NULL, &stats);
+
+    u32 pipelines_before = fake_wgpu.pipelines_set;
+    u32 vertex_buffers_before = fake_wgpu.vertex_buffers_set;
+    u32 index_buffers_before = fake_wgpu.index_buffers_set;
+    for (u32 i = 0; i < 100; i++)
+    {
+        render_state_set_pipeline(&state, circle);
+        render_state_set_push_constants(&state, 4, &i);
+        render_state_set_vertex_buffer(&state, 0, quads, 0, 256);
+        render_state_set_index_buffer(&state, indices, WGPUIndexFormat_Uint16,
+                                      0, 16);
+        render_state_draw_indexed(&state, 6, 1, 0, 4);
+    }
+    assert(fake_wgpu.pipelines_set - pipelines_before == 1);
+    assert(fake_wgpu.vertex_buffers_set - vertex_buffers_before == 1);
+    assert(fake_wgpu.index_buffers_set - index_buffers_before == 1);
+    assert(stats.pipelines_skipped == 99);
+    assert(stats.vertex_buffers_skipped == 99);
+    assert(stats.index_buffers_skipped == 99);
+    assert(stats.draws == 100);
+
+    // a different range of the same buffer does need setting
+    render_state_set_vertex_buffer(&state, 0, quads, 64, 192);
+    assert(fake_wgpu.vertex_buffers_set - vertex_buffers_before == 2);
+    // and so does a different index format
+    render_state_set_index_buffer(&state, indices, WGPUIndexFormat_Uint32, 0,
+                                  16);
+    assert(fake_wgpu.index_buffers_set - index_buffers_before == 2);
+}
+
+int main()
+{
+    test_sort();
+    test_key_order();
+    test_frame();
+    test_repeated_draws();
+}
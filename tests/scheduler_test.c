@@ -0,0 +1,407 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "events/compiler.h"
+#include "events/scheduler.h"
+#include "events/vm.h"
+#include "fake_commands.h"
+#include "utility/intern.h"
+
+// checks that scripts wake up exactly when they should, that thousands of
+// sleeping scripts don't cost anything on ticks where none of them wake up, and
+// that scripts stuck in a loop can't hold up a tick.
+//
+// the real commands need an entire game running, so the commands used here are
+// replaced with ones that talk to the scheduler directly.
+
+#define SLEEPERS 10000
+
+typedef struct
+{
+    // how long wait() sleeps for
+    u32 ticks;
+    // the tick printf() was called on
+    u64 woke_at;
+    u32 wakes;
+} Sleeper;
+
+static Resources resources;
+
+static bool stub_wait(VM *vm, Value *out, u32 arg_count, Resources *resources)
+{
+    (void)out;
+    (void)resources;
+    assert(arg_count == 1);
+
+    bool *started = &vm->command_ctx.yield.did_yield;
+    if (*started)
+    {
+        *started = false;
+        vm_pop(vm);
+        return false;
+    }
+
+    Sleeper *sleeper = vm->vm_ctx;
+    *started = true;
+    vm_wait_ticks(vm, sleeper->ticks);
+    return true;
+}
+
+static bool stub_text(VM *vm, Value *out, u32 arg_count, Resources *resources)
+{
+    (void)out;
+    (void)resources;
+    assert(arg_count == 1);
+
+    bool *started = &vm->command_ctx.yield.did_yield;
+    if (*started)
+    {
+        *started = false;
+        vm_pop(vm);
+        return false;
+    }
+
+    *started = true;
+    vm_wait_signal(vm, Signal_TextboxClosed);
+    return true;
+}
+
+static bool stub_printf(VM *vm, Value *out, u32 arg_count,
+                        Resources *resources)
+{
+    (void)out;
+    assert(arg_count == 1);
+    vm_pop(vm);
+
+    Sleeper *sleeper = vm->vm_ctx;
+    sleeper->woke_at = resources->scheduler.now;
+    sleeper->wakes++;
+    return false;
+}
+
+static bool stub_yield(VM *vm, Value *out, u32 arg_count, Resources *resources)
+{
+    (void)out;
+    (void)resources;
+    assert(arg_count == 0);
+
+    bool *did_yield = &vm->command_ctx.yield.did_yield;
+    *did_yield = !*did_yield;
+    return *did_yield;
+}
+
+static Event compile(const char *source)
+{
+    Compiler compiler;
+    compiler_init(&compiler, (char *)source);
+    Event event;
+    bool compiled = compiler_compile(&compiler, &event);
+    assert(compiled);
+    return event;
+}
+
+static ScriptHandle spawn(Event event, Sleeper *sleeper)
+{
+    return scheduler_spawn(&resources.scheduler, event, sleeper);
+}
+
+static f64 seconds_since(clock_t start)
+{
+    return (f64)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void test_sleepers(Event sleep)
+{
+    Scheduler *scheduler = &resources.scheduler;
+    Sleeper *sleepers = calloc(SLEEPERS, sizeof(Sleeper));
+
+    // time a run of idle ticks with nothing scheduled, to compare against
+    const u32 idle_ticks = 100000;
+    clock_t start = clock();
+    for (u32 i = 0; i < idle_ticks; i++)
+        scheduler_tick(scheduler, &resources);
+    f64 empty_time = seconds_since(start);
+
+    u64 spawned_at = scheduler->now;
+    u64 last_deadline = 0;
+    for (u32 i = 0; i < SLEEPERS; i++)
+    {
+        // spread the sleepers out over every level of the wheel
+        sleepers[i].ticks = 1 + (u32)(((u64)i * 7919) % 400000);
+        spawn(sleep, &sleepers[i]);
+
+        // they all run wait() on the next tick
+        u64 deadline = spawned_at + 1 + sleepers[i].ticks;
+        if (deadline > last_deadline)
+            last_deadline = deadline;
+    }
+
+    scheduler_tick(scheduler, &resources);
+    assert(scheduler->ran_last_tick == SLEEPERS);
+    assert(scheduler_sleeping_count(scheduler) == SLEEPERS);
+
+    u32 ran = 0;
+    u64 ticks = 0;
+    start = clock();
+    while (scheduler->now < last_deadline)
+    {
+        scheduler_tick(scheduler, &resources);
+        ran += scheduler->ran_last_tick;
+        ticks++;
+    }
+    f64 sleeping_time = seconds_since(start);
+
+    // everything woke up exactly once, exactly when it should have
+    assert(ran == SLEEPERS);
+    for (u32 i = 0; i < SLEEPERS; i++)
+    {
+        assert(sleepers[i].wakes == 1);
+        assert(sleepers[i].woke_at == spawned_at + 1 + sleepers[i].ticks);
+    }
+    assert(scheduler_sleeping_count(scheduler) == 0);
+    assert(scheduler_running_count(scheduler) == 0);
+
+    // most of these ticks have nothing to wake up, so this should be about
+    // the same as an empty tick
+    printf("average tick: %.1fns with nothing scheduled, %.1fns with %d "
+           "sleeping (over %llu ticks)\n",
+           empty_time / idle_ticks * 1e9, sleeping_time / ticks * 1e9,
+           SLEEPERS, (unsigned long long)ticks);
+
+    free(sleepers);
+}
+
+static void test_signals(Event talk)
+{
+    Scheduler *scheduler = &resources.scheduler;
+    Sleeper talkers[16] = {0};
+
+    for (u32 i = 0; i < 16; i++)
+        spawn(talk, &talkers[i]);
+
+    scheduler_tick(scheduler, &resources);
+    assert(scheduler_waiting_count(scheduler) == 16);
+
+    // nothing runs until the signal comes in
+    for (u32 i = 0; i < 100; i++)
+    {
+        scheduler_tick(scheduler, &resources);
+        assert(scheduler->ran_last_tick == 0);
+    }
+
+    scheduler_signal(scheduler, Signal_TextboxClosed);
+    u64 signaled_at = scheduler->now;
+    scheduler_tick(scheduler, &resources);
+    assert(scheduler->ran_last_tick == 16);
+    assert(scheduler_waiting_count(scheduler) == 0);
+
+    for (u32 i = 0; i < 16; i++)
+    {
+        assert(talkers[i].wakes == 1);
+        assert(talkers[i].woke_at == signaled_at + 1);
+    }
+}
+
+static void test_budgets(Event hog, Event spin)
+{
+    Scheduler *scheduler = &resources.scheduler;
+    Sleeper hogger = {0}, spinner = {0};
+
+    // a script that never yields gets paused, and doesn't stop anything else
+    // from running
+    scheduler->instruction_budget = 1000;
+    ScriptHandle hogging = spawn(hog, &hogger);
+    ScriptHandle spinning = spawn(spin, &spinner);
+    u32 overruns = scheduler->overrun_count;
+
+    scheduler_tick(scheduler, &resources);
+    assert(scheduler->ran_last_tick == 2);
+    assert(scheduler->preempted_last_tick == 1);
+    assert(scheduler_is_running(scheduler, hogging));
+    assert(hogger.wakes > 0);
+    // the loop is a handful of instructions, so it should get through about
+    // 1000 / that many iterations
+    assert(hogger.wakes < 1000);
+
+    BudgetOverrun *overrun = scheduler_overrun(scheduler, 0);
+    assert(scheduler->overrun_count == overruns + 1);
+    assert(overrun->type == Overrun_Instructions);
+    assert(!strcmp(overrun->event, "hog"));
+    assert(overrun->ip < hog.code_len);
+    assert(overrun->tick == scheduler->now);
+
+    // it picks up where it left off, with a fresh budget
+    u32 first_tick = hogger.wakes;
+    scheduler_tick(scheduler, &resources);
+    assert(scheduler->ran_last_tick == 2);
+    assert(hogger.wakes == first_tick * 2);
+
+    // how long a runaway script can hold up a tick with the default budget
+    scheduler->instruction_budget = DEFAULT_INSTRUCTION_BUDGET;
+    scheduler_tick(scheduler, &resources);
+    printf("a script stuck in a loop costs %.3fms a tick (%u iterations)\n",
+           duration_as_secs_f64(scheduler->ran_for_last_tick) * 1000.0,
+           hogger.wakes - first_tick * 2);
+
+    scheduler_kill(scheduler, hogging);
+    scheduler_kill(scheduler, spinning);
+
+    // once the tick's out of time, the rest wait until next tick, and go first
+    // then so everything gets a turn
+    Sleeper hoggers[10] = {0};
+    ScriptHandle handles[10];
+    for (u32 i = 0; i < 10; i++)
+        handles[i] = spawn(hog, &hoggers[i]);
+    Duration time_budget = scheduler->time_budget;
+    scheduler->time_budget = duration_new(1);
+
+    for (u32 tick = 0; tick < 10; tick++)
+    {
+        scheduler_tick(scheduler, &resources);
+        assert(scheduler->ran_last_tick == 1);
+        assert(scheduler->deferred_last_tick == 9);
+        assert(scheduler_overrun(scheduler, 0)->type == Overrun_Time);
+        for (u32 i = 0; i < 10; i++)
+            assert((hoggers[i].wakes > 0) == (i <= tick));
+    }
+
+    for (u32 i = 0; i < 10; i++)
+        scheduler_kill(scheduler, handles[i]);
+    scheduler->time_budget = time_budget;
+}
+
+static void test_yield_and_kill(Event spin, Event sleep)
+{
+    Scheduler *scheduler = &resources.scheduler;
+    Sleeper spinner = {0};
+    Sleeper sleeper = {.ticks = 1000};
+
+    ScriptHandle spinning = spawn(spin, &spinner);
+    ScriptHandle sleeping = spawn(sleep, &sleeper);
+
+    // yielding scripts run every tick
+    for (u32 i = 0; i < 10; i++)
+    {
+        scheduler_tick(scheduler, &resources);
+        assert(scheduler->ran_last_tick == (i == 0 ? 2 : 1));
+    }
+    assert(scheduler_is_running(scheduler, spinning));
+    assert(scheduler_is_running(scheduler, sleeping));
+
+    scheduler_kill(scheduler, spinning);
+    scheduler_kill(scheduler, sleeping);
+    assert(!scheduler_is_running(scheduler, spinning));
+    assert(!scheduler_is_running(scheduler, sleeping));
+    assert(scheduler_sleeping_count(scheduler) == 0);
+
+    // the slots get reused, but the old handles stay dead
+    ScriptHandle reused = spawn(sleep, &sleeper);
+    assert(reused.index == spinning.index || reused.index == sleeping.index);
+    assert(!scheduler_is_running(scheduler, spinning));
+    assert(!scheduler_is_running(scheduler, sleeping));
+    assert(scheduler_is_running(scheduler, reused));
+
+    ScriptHandle none = {0};
+    assert(!scheduler_is_running(scheduler, none));
+
+    scheduler_kill(scheduler, reused);
+    assert(spinner.wakes == 0);
+    assert(sleeper.wakes == 0);
+}
+
+// what a vm used to take up, back when every vm had room for 32 stack values,
+// 32 slots and 64 bytes of command context
+#define FIXED_VM_SIZE                                                          \
+    (sizeof(Event) + 64 * sizeof(Value) + 64 + sizeof(void *) +               \
+     2 * sizeof(u32))
+
+static void test_autorun_map(Event autorun)
+{
+    // start from an empty pool, so we know exactly what this map costs
+    Scheduler *scheduler = &resources.scheduler;
+    scheduler_free(scheduler);
+    scheduler_init(scheduler);
+    scheduler->time_budget = (Duration){0};
+
+    VMPool *pool = &scheduler->vms;
+    const u32 autoruns = 1000;
+
+    // load the same map twice. the second time around, every vm should come
+    // out of the pool
+    u32 first_allocations = 0;
+    for (u32 load = 0; load < 2; load++)
+    {
+        u32 allocations = pool->allocations;
+
+        for (u32 i = 0; i < autoruns; i++)
+            scheduler_spawn(scheduler, autorun, NULL);
+        assert(pool->live == autoruns);
+
+        // every autorun opens a textbox, waits, and opens another one
+        scheduler_tick(scheduler, &resources);
+        assert(scheduler_waiting_count(scheduler) == autoruns);
+        usize live_bytes = pool->bytes;
+
+        scheduler_signal(scheduler, Signal_TextboxClosed);
+        for (u32 i = 0; i < 70; i++)
+            scheduler_tick(scheduler, &resources);
+        assert(scheduler_waiting_count(scheduler) == autoruns);
+
+        scheduler_signal(scheduler, Signal_TextboxClosed);
+        scheduler_tick(scheduler, &resources);
+        assert(pool->live == 0);
+
+        allocations = pool->allocations - allocations;
+        if (load == 0)
+            first_allocations = allocations;
+        else
+            assert(allocations == 0);
+
+        printf("%u autoruns (load %u): %u allocations, %zu bytes of vms "
+               "(%zu bytes each, vs %zu with fixed size vms)\n",
+               autoruns, load + 1, allocations, live_bytes,
+               live_bytes / autoruns, FIXED_VM_SIZE);
+    }
+    assert(first_allocations == autoruns);
+    assert(vm_pool_pooled_count(pool) == autoruns);
+}
+
+int main()
+{
+    fake_commands[CMD_Printf] = stub_printf;
+    fake_commands[CMD_Text] = stub_text;
+    fake_commands[CMD_Wait] = stub_wait;
+    fake_commands[CMD_Yield] = stub_yield;
+
+    scheduler_init(&resources.scheduler);
+    // the other tests count exactly which scripts run on which tick, which
+    // they can't do if slow machines run out of time
+    resources.scheduler.time_budget = (Duration){0};
+
+    Event sleep = compile("event \"sleep\" { wait(0); printf(0); }");
+    Event talk = compile("event \"talk\" { text(\"hi\"); printf(0); }");
+    Event spin = compile("event \"spin\" { while true { yield(); } }");
+    Event hog = compile("event \"hog\" { while true { printf(0); } }");
+    // the same as the autorun event in events.txt
+    Event autorun = compile("event \"autorun\" {"
+                            "  text(\"automatic beyond belief\");"
+                            "  for i = 0; i < 64; i++ { yield(); }"
+                            "  text(\"toaster\");"
+                            "}");
+
+    test_sleepers(sleep);
+    test_signals(talk);
+    test_budgets(hog, spin);
+    test_yield_and_kill(spin, sleep);
+    test_autorun_map(autorun);
+
+    scheduler_free(&resources.scheduler);
+    event_free(&sleep);
+    event_free(&talk);
+    event_free(&spin);
+    event_free(&hog);
+    event_free(&autorun);
+    intern_free();
+}
@@ -0,0 +1,247 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "animation/definition.h"
+#include "fake_wgpu.h"
+#include "graphics/binding_helper.h"
+#include "graphics/quad_manager.h"
+#include "graphics/sprite_animations.h"
+
+// checks the animation timing the cpu uses for sounds lands on the same frames
+// as the tables sprite.wgsl reads, then compares animating 5000 characters by
+// updating their quads every frame against leaving it to the shader.
+// there's no gpu here, so the wgpu calls are stubbed out and uploads are just
+// counted.
+
+#define CHARACTERS 5000
+#define FRAMES 1000
+// 60fps
+#define FRAME_MILLIS 16
+
+#ifdef __clang__
+#pragma clang diagnostic ignored "-Wgnu-flexible-array-initializer"
+#endif
+
+static const AnimationDef WALK = {
+    .name = "walk",
+    .cell_width = 8,
+    .cell_height = 8,
+    .looping = true,
+    .frame_count = 3,
+    .frames =
+        {
+            {0.1, 4, NULL},
+            {0.2, 5, "event:/sfx/step"},
+            {0.1, 6, NULL},
+        },
+};
+
+static const AnimationDef DIE = {
+    .name = "die",
+    .cell_width = 8,
+    .cell_height = 8,
+    .looping = false,
+    .frame_count = 2,
+    .frames =
+        {
+            {0.5, 0, NULL},
+            {0.5, 1, NULL},
+        },
+};
+
+static CompiledAnimation *walk, *die;
+
+static void test_timing(void)
+{
+    assert(animation_frame_end(&WALK, 0) == 100);
+    assert(animation_frame_end(&WALK, 1) == 300);
+    assert(animation_frame_end(&WALK, 2) == 400);
+
+    assert(animation_frame_at(walk, 0) == 0);
+    assert(animation_frame_at(walk, 99) == 0);
+    assert(animation_frame_at(walk, 100) == 1);
+    assert(animation_frame_at(walk, 299) == 1);
+    assert(animation_frame_at(walk, 300) == 2);
+    // loops
+    assert(animation_frame_at(walk, 400) == 0);
+    assert(animation_frame_at(walk, 4000 + 150) == 1);
+
+    // doesn't loop, so it stays on the last frame
+    assert(animation_frame_at(die, 499) == 0);
+    assert(animation_frame_at(die, 500) == 1);
+    assert(animation_frame_at(die, 100000) == 1);
+}
+
+// what sprite.wgsl does with the tables
+static u32 shader_cell(SpriteAnimation *animation,
+                       SpriteAnimationFrame *frames, u32 time)
+{
+    if (animation->looping && animation->duration > 0)
+        time %= animation->duration;
+    for (u32 i = 0; i < animation->count; i++)
+        if (time < frames[animation->first + i].end)
+            return frames[animation->first + i].cell;
+    return frames[animation->first + animation->count - 1].cell;
+}
+
+static void test_table(WGPUResources *resources)
+{
+    vec animations, frames;
+    vec_init(&animations, sizeof(SpriteAnimation));
+    vec_init(&frames, sizeof(SpriteAnimationFrame));
+    sprite_animations_build(&animations, &frames);
+    assert(animations.len == animation_defs_count());
+    SpriteAnimationFrame *table = (SpriteAnimationFrame *)frames.data;
+
+    for (AnimationType type = 0; type < animation_defs_count(); type++)
+    {
+        CompiledAnimation *compiled = animation_get(type);
+        const AnimationDef *def = compiled->def;
+        SpriteAnimation *animation = vec_get(&animations, type);
+        assert(animation->count == def->frame_count);
+        assert(animation->cell_width == def->cell_width);
+        assert(animation->looping == def->looping);
+
+        for (u32 time = 0; time < 10000; time += 7)
+        {
+            u32 frame = animation_frame_at(compiled, time);
+            assert(shader_cell(animation, table, time) ==
+                   def->frames[frame].cell);
+        }
+    }
+
+    // and that's what the gpu gets
+    SpriteAnimations gpu;
+    sprite_animations_init(&gpu, resources);
+    assert(memcmp(fake_buffer_data(gpu.animations), animations.data,
+                  animations.len * sizeof(SpriteAnimation)) == 0);
+    assert(memcmp(fake_buffer_data(gpu.frames), frames.data,
+                  frames.len * sizeof(SpriteAnimationFrame)) == 0);
+    sprite_animations_free(&gpu);
+
+    // wgpu can't make empty buffers, so empty tables get one zeroed element
+    vec_clear(&animations);
+    WGPUBuffer empty = storage_buffer_from_vec(
+        &animations, resources->device, resources->queue, "empty table");
+    assert(wgpuBufferGetSize(empty) == sizeof(SpriteAnimation));
+    SpriteAnimation zero = {0};
+    assert(memcmp(fake_buffer_data(empty), &zero, sizeof(zero)) == 0);
+    wgpuBufferRelease(empty);
+
+    vec_free(&animations);
+    vec_free(&frames);
+}
+
+// stepping each character's frame along and updating its quad
+typedef struct
+{
+    f32 wait_time;
+    u32 current_frame;
+    QuadEntry quad;
+} CpuCharacter;
+
+// just keeping track of the frame, like animations_update does
+typedef struct
+{
+    u32 start_time;
+    u32 current_frame;
+} GpuCharacter;
+
+static void benchmark(WGPUResources *resources)
+{
+    static CpuCharacter cpu[CHARACTERS];
+    static GpuCharacter gpu[CHARACTERS];
+
+    QuadManager quads;
+    quad_manager_init(&quads, resources);
+    Quad quad = {.rect = rect_from_size((vec2s){.x = 8, .y = 8}),
+                 .tex_coords = RECT_UNIT_TEX_COORDS};
+    for (u32 i = 0; i < CHARACTERS; i++)
+    {
+        // started at different times, so they aren't all in step
+        u32 start = i % 400;
+        cpu[i] = (CpuCharacter){
+            .wait_time = WALK.frames[0].frame_time - start / 1000.0f,
+            .quad = quad_manager_add(&quads, quad),
+        };
+        gpu[i] = (GpuCharacter){.start_time = start};
+    }
+    quad_manager_upload_dirty(&quads, resources);
+
+    fake_wgpu.uploaded = 0;
+    u32 cpu_changes = 0;
+    clock_t start = clock();
+    for (u32 frame = 0; frame < FRAMES; frame++)
+    {
+        for (u32 i = 0; i < CHARACTERS; i++)
+        {
+            CpuCharacter *character = &cpu[i];
+            character->wait_time -= FRAME_MILLIS / 1000.0f;
+            if (character->wait_time > 0.0)
+                continue;
+
+            character->current_frame =
+                (character->current_frame + 1) % WALK.frame_count;
+            character->wait_time +=
+                WALK.frames[character->current_frame].frame_time;
+            quad.tex_coords =
+                tex_coords_for(&WALK, character->current_frame, 64, 8);
+            quad_manager_update(&quads, character->quad, quad);
+            cpu_changes++;
+        }
+        quad_manager_upload_dirty(&quads, resources);
+    }
+    f64 cpu_seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+    u64 cpu_uploaded = fake_wgpu.uploaded;
+
+    fake_wgpu.uploaded = 0;
+    u32 gpu_changes = 0;
+    start = clock();
+    for (u32 frame = 0; frame < FRAMES; frame++)
+    {
+        u32 time = 400 + frame * FRAME_MILLIS;
+        for (u32 i = 0; i < CHARACTERS; i++)
+        {
+            GpuCharacter *character = &gpu[i];
+            u32 current =
+                animation_frame_at(walk, time - character->start_time);
+            if (current != character->current_frame)
+            {
+                character->current_frame = current;
+                gpu_changes++;
+            }
+        }
+    }
+    f64 gpu_seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+
+    // both went through the same frames, but only one uploaded anything
+    assert(cpu_changes > CHARACTERS * (FRAMES * FRAME_MILLIS / 400));
+    assert(gpu_changes > CHARACTERS * (FRAMES * FRAME_MILLIS / 400));
+    assert(fake_wgpu.uploaded == 0);
+
+    printf("%d animated characters, %d frames: %.3fms and %.1fkb uploaded per "
+           "frame updating quads, %.3fms and nothing uploaded on the gpu (%u "
+           "vs %u frame changes)\n",
+           CHARACTERS, FRAMES, cpu_seconds * 1000.0 / FRAMES,
+           cpu_uploaded / 1024.0 / FRAMES, gpu_seconds * 1000.0 / FRAMES,
+           cpu_changes, gpu_changes);
+
+    quad_manager_free(&quads);
+}
+
+int main()
+{
+    WGPUResources resources;
+    memset(&resources, 0, sizeof(resources));
+    animation_defs_init();
+    walk = animation_get(animation_defs_add(&WALK, false));
+    die = animation_get(animation_defs_add(&DIE, false));
+
+    test_timing();
+    test_table(&resources);
+    benchmark(&resources);
+
+    animation_defs_free();
+}
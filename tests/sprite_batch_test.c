@@ -0,0 +1,136 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "fake_wgpu.h"
+#include "graphics/layer.h"
+#include "graphics/sprite_batch.h"
+
+// checks that a whole layer of sprites gets drawn with one draw call, and that
+// every sprite ends up in the instance buffer in the order the layer has them.
+// there's no gpu here, so the wgpu calls the batch makes are stubbed out and
+// just counted.
+
+#define STRESS_SPRITES 1000
+
+typedef struct
+{
+    u32 id;
+    f32 parallax;
+} TestSprite;
+
+static void batch_test_sprite(void *thing, void *batch)
+{
+    TestSprite *sprite = thing;
+    SpriteInstance instance = {
+        .transform_index = sprite->id,
+        .texture_index = sprite->id % 7,
+        .quad_index = sprite->id,
+        .opacity = 1.0,
+        .parallax = {.x = sprite->parallax, .y = sprite->parallax},
+    };
+    vec_push(batch, &instance);
+}
+
+// what drawing a layer used to cost: one draw call per sprite
+static u32 unbatched_draw_calls = 0;
+static void draw_test_sprite(void *thing, void *ctx, RenderState *state)
+{
+    (void)thing;
+    (void)ctx;
+    (void)state;
+    unbatched_draw_calls++;
+}
+
+int main()
+{
+    static TestSprite sprites[STRESS_SPRITES];
+    WGPUResources resources;
+    memset(&resources, 0, sizeof(resources));
+
+    SpriteBatch batch;
+    sprite_batch_init(&batch, &resources);
+
+    // props in the background, characters in the middle, nothing in front
+    Layer background, middle, foreground, unbatched;
+    layer_init_batched(&background, batch_test_sprite);
+    layer_init_batched(&middle, batch_test_sprite);
+    layer_init_batched(&foreground, batch_test_sprite);
+    layer_init(&unbatched, draw_test_sprite);
+
+    LayerEntry entries[STRESS_SPRITES];
+    for (u32 i = 0; i < STRESS_SPRITES; i++)
+    {
+        sprites[i] = (TestSprite){.id = i, .parallax = i % 2 ? 0.5 : 1.0};
+        entries[i] = layer_add(i < 900 ? &background : &middle, &sprites[i]);
+        layer_add(&unbatched, &sprites[i]);
+    }
+    // removed sprites don't get drawn
+    layer_remove(&background, entries[10]);
+
+    // none of these are culled, so the view doesn't matter
+    CullView view = {0};
+    CullStats cull_stats = {0};
+    sprite_batch_begin(&batch);
+    SpriteBatchRange ranges[] = {
+        sprite_batch_add_layer(&batch, &background, view, &cull_stats),
+        sprite_batch_add_layer(&batch, &middle, view, &cull_stats),
+        sprite_batch_add_layer(&batch, &foreground, view, &cull_stats),
+    };
+    fake_wgpu.uploaded = 0;
+    sprite_batch_upload(&batch, &resources);
+
+    assert(ranges[0].first == 0 && ranges[0].count == 899);
+    assert(ranges[1].first == 899 && ranges[1].count == 100);
+    assert(ranges[2].count == 0);
+    assert(cull_stats.submitted == 0);
+    assert(fake_wgpu.uploaded == (STRESS_SPRITES - 1) * sizeof(SpriteInstance));
+    // the buffer grew to fit
+    assert(fake_wgpu.buffers_made == 2 && fake_wgpu.live_buffers == 1);
+
+    SpriteInstance *instances = (SpriteInstance *)batch.instances.data;
+    assert(instances[9].transform_index == 9);
+    assert(instances[10].transform_index == 11);
+    assert(instances[899].quad_index == 900);
+    assert(instances[899].parallax.x == 1.0f);
+
+    RenderStats stats = {0};
+    RenderState state;
+    render_state_begin(&state, NULL, &stats);
+    // each layer starts where its instances are
+    u32 first_instances[] = {0, 899, 0};
+    for (u32 i = 0; i < 3; i++)
+    {
+        sprite_batch_draw(&batch, ranges[i], &state);
+        if (ranges[i].count == 0)
+            continue;
+        assert(fake_wgpu.last_draw.vertex_count == 6);
+        assert(fake_wgpu.last_draw.instance_count == ranges[i].count);
+        assert(fake_wgpu.last_draw.first_instance == first_instances[i]);
+    }
+    // and the instance buffer is only bound once
+    assert(stats.vertex_buffers == 1 && stats.vertex_buffers_skipped == 1);
+    assert(fake_wgpu.instances_drawn == STRESS_SPRITES - 1);
+    assert(stats.draws == 2);
+
+    layer_draw(&unbatched, NULL, &state);
+    printf("%d sprites: %u draw calls unbatched, %u batched\n", STRESS_SPRITES,
+           unbatched_draw_calls, fake_wgpu.draws);
+    assert(fake_wgpu.draws == 2);
+
+    // stats are kept for the last full frame, and the buffer doesn't need to
+    // grow again
+    sprite_batch_begin(&batch);
+    assert(batch.last_sprites == STRESS_SPRITES - 1);
+    assert(batch.last_draw_calls == 2);
+    sprite_batch_add_layer(&batch, &background, view, &cull_stats);
+    sprite_batch_upload(&batch, &resources);
+    assert(fake_wgpu.buffers_made == 2);
+
+    layer_free(&background);
+    layer_free(&middle);
+    layer_free(&foreground);
+    layer_free(&unbatched);
+    sprite_batch_free(&batch);
+    assert(fake_wgpu.live_buffers == 0);
+}
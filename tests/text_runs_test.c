@@ -0,0 +1,104 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "events/compiler.h"
+#include "events/globals.h"
+#include "events/text_runs.h"
+#include "utility/intern.h"
+
+// checks that textbox escape codes get split out of text when events are
+// compiled, and that only strings passed straight to text() get split.
+
+static void check_run(const TextRuns *runs, u32 index, TextRunType type,
+                      u16 value)
+{
+    assert(index < runs->run_count);
+    assert(runs->runs[index].type == type);
+    assert(runs->runs[index].value == value);
+}
+
+static void check_parse(void)
+{
+    TextRuns runs;
+
+    text_runs_parse(&runs, "");
+    assert(runs.len == 0 && runs.run_count == 0);
+    assert(!strcmp(runs.text, ""));
+    text_runs_free(&runs);
+
+    text_runs_parse(&runs, "no codes here");
+    assert(runs.len == 13 && !strcmp(runs.text, "no codes here"));
+    assert(runs.run_count == 1);
+    check_run(&runs, 0, TextRun_Text, 13);
+    text_runs_free(&runs);
+
+    text_runs_parse(&runs, "Ugh... \\.it always\\.\\. goes");
+    assert(!strcmp(runs.text, "Ugh... it always goes"));
+    assert(runs.len == strlen(runs.text));
+    assert(runs.run_count == 6);
+    check_run(&runs, 0, TextRun_Text, 7);
+    check_run(&runs, 1, TextRun_Pause, TEXT_PAUSE_LENGTH);
+    check_run(&runs, 2, TextRun_Text, 9);
+    check_run(&runs, 3, TextRun_Pause, TEXT_PAUSE_LENGTH);
+    check_run(&runs, 4, TextRun_Pause, TEXT_PAUSE_LENGTH);
+    check_run(&runs, 5, TextRun_Text, 5);
+    text_runs_free(&runs);
+
+    // unknown codes and a trailing \ are dropped, and text either side of
+    // them ends up in one run
+    text_runs_parse(&runs, "\\.a\\qb\\");
+    assert(!strcmp(runs.text, "ab") && runs.len == 2);
+    assert(runs.run_count == 2);
+    check_run(&runs, 0, TextRun_Pause, TEXT_PAUSE_LENGTH);
+    check_run(&runs, 1, TextRun_Text, 2);
+    text_runs_free(&runs);
+}
+
+static Event compile(const char *source)
+{
+    Compiler compiler;
+    compiler_init(&compiler, source);
+    Event event;
+    bool compiled = compiler_compile(&compiler, &event);
+    assert(compiled);
+    return event;
+}
+
+static void check_compiler(void)
+{
+    Event event = compile("event \"talk\" {"
+                          "  text(\"one\\. two\");"
+                          "  text(\"one\\. two\");"
+                          "  text(\"plain\");"
+                          "  printf(\"not\\. text\");"
+                          "  x = \"from\\. a variable\";"
+                          "  text(x);"
+                          "}");
+
+    // only the two different literals, once each
+    assert(event.text_count == 2);
+
+    const TextRuns *runs = event_text(&event, intern_string("one\\. two"));
+    assert(runs);
+    assert(!strcmp(runs->text, "one two"));
+    assert(runs->run_count == 3);
+    check_run(runs, 1, TextRun_Pause, TEXT_PAUSE_LENGTH);
+
+    runs = event_text(&event, intern_string("plain"));
+    assert(runs && runs->run_count == 1);
+
+    // everything else gets parsed when it's shown
+    assert(!event_text(&event, intern_string("not\\. text")));
+    assert(!event_text(&event, intern_string("from\\. a variable")));
+
+    event_free(&event);
+}
+
+int main()
+{
+    check_parse();
+    check_compiler();
+
+    global_names_free();
+    intern_free();
+}
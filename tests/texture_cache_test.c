@@ -0,0 +1,266 @@
+#include <SDL3_image/SDL_image.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fake_wgpu.h"
+#include "graphics/tex_manager.h"
+#include "utility/macros.h"
+
+// checks textures nothing uses get cached and found again by path, that the
+// least recently used ones get released to stay under the budget, and that
+// turning the cache off releases everything right away like it used to.
+// then goes back and forth between two maps 100 times, the way scene_change
+// does (freeing one map before loading the next), with and without the cache.
+// the pngs are real and really get decoded, but there's no gpu here, so
+// textures are just their size.
+
+#define TRANSITIONS 100
+#define MAP_TEXTURES 32
+
+// some noise over a gradient, so it doesn't compress to nothing
+static void write_png(const char *path, u32 width, u32 height, u32 seed)
+{
+    SDL_Surface *surface =
+        SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32);
+    SDL_PTR_ERRCHK(surface, "failed to make a surface");
+    for (u32 y = 0; y < height; y++)
+    {
+        u8 *row = (u8 *)surface->pixels + y * surface->pitch;
+        for (u32 x = 0; x < width; x++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            row[x * 4 + 0] = x + (seed >> 28);
+            row[x * 4 + 1] = y + (seed >> 29);
+            row[x * 4 + 2] = (x ^ y) & 0xF0;
+            row[x * 4 + 3] = 255;
+        }
+    }
+    if (!IMG_SavePNG(surface, path))
+        FATAL("failed to write %s: %s\n", path, SDL_GetError());
+    SDL_DestroySurface(surface);
+}
+
+typedef struct
+{
+    char path[64];
+    bool packed;
+} TestTexture;
+
+typedef struct
+{
+    TestTexture textures[MAP_TEXTURES];
+    u32 count;
+    TextureEntry *loaded[MAP_TEXTURES];
+} TestMap;
+
+static void map_add(TestMap *map, const char *path, u32 width, u32 height,
+                    bool packed)
+{
+    TestTexture *texture = &map->textures[map->count++];
+    snprintf(texture->path, sizeof(texture->path), "%s", path);
+    texture->packed = packed;
+    // both maps share some of them
+    FILE *exists = fopen(path, "rb");
+    if (exists)
+        fclose(exists);
+    else
+        write_png(path, width, height, map->count);
+}
+
+// a tileset, the player, the textbox and ui that every map has, and some
+// characters that are only on this map
+static void make_map(TestMap *map, char name)
+{
+    char path[64];
+    map->count = 0;
+    snprintf(path, sizeof(path), "texture_cache_tileset_%c.png", name);
+    map_add(map, path, 512, 512, false);
+    map_add(map, "texture_cache_player.png", 256, 128, false);
+    map_add(map, "texture_cache_textbox.png", 96, 48, true);
+    for (u32 i = 0; i < 12; i++)
+    {
+        snprintf(path, sizeof(path), "texture_cache_icon_%u.png", i);
+        map_add(map, path, 32, 32, true);
+    }
+    for (u32 i = 0; i < 8; i++)
+    {
+        snprintf(path, sizeof(path), "texture_cache_npc_%c%u.png", name, i);
+        map_add(map, path, 128, 64, false);
+    }
+}
+
+static void map_load(TestMap *map, TextureManager *manager)
+{
+    for (u32 i = 0; i < map->count; i++)
+        map->loaded[i] =
+            map->textures[i].packed
+                ? texture_manager_load_packed(manager, map->textures[i].path,
+                                              NULL)
+                : texture_manager_load(manager, map->textures[i].path, NULL);
+}
+
+static void map_free(TestMap *map, TextureManager *manager)
+{
+    for (u32 i = 0; i < map->count; i++)
+        texture_manager_unload(manager, map->loaded[i]);
+}
+
+static void test_cache(void)
+{
+    write_png("texture_cache_a.png", 64, 64, 1);
+    write_png("texture_cache_b.png", 64, 64, 2);
+    write_png("texture_cache_c.png", 64, 64, 3);
+    write_png("texture_cache_small.png", 16, 16, 4);
+    u64 bytes = 64 * 64 * 4;
+
+    TextureManager manager;
+    texture_manager_init(&manager);
+    texture_manager_set_cache_budget(&manager, bytes * 2);
+
+    TextureEntry *a =
+        texture_manager_load(&manager, "texture_cache_a.png", NULL);
+    assert(manager.stats.misses == 1 && manager.stats.hits == 0);
+    assert(texture_manager_load(&manager, "texture_cache_a.png", NULL) == a);
+    assert(a->ref_count == 2 && manager.stats.hits == 1);
+    texture_manager_unload(&manager, a);
+    texture_manager_unload(&manager, a);
+
+    // still there, and still in the binding array where it was
+    assert(fake_wgpu.live_textures == 1);
+    assert(manager.stats.cached == 1 && manager.stats.cached_bytes == bytes);
+    u32 generation = manager.generation;
+    u32 index = a->index;
+    assert(texture_manager_load(&manager, "texture_cache_a.png", NULL) == a);
+    assert(a->ref_count == 1 && a->index == index);
+    assert(manager.generation == generation);
+    assert(manager.stats.cached == 0 && manager.stats.misses == 1);
+
+    // a is the oldest, so it goes when c is cached
+    TextureEntry *b =
+        texture_manager_load(&manager, "texture_cache_b.png", NULL);
+    TextureEntry *c =
+        texture_manager_load(&manager, "texture_cache_c.png", NULL);
+    texture_manager_unload(&manager, a);
+    texture_manager_unload(&manager, b);
+    assert(manager.stats.evictions == 0);
+    texture_manager_unload(&manager, c);
+    assert(manager.stats.evictions == 1 && manager.stats.cached == 2);
+    assert(manager.oldest == b && manager.newest == c);
+    assert(fake_wgpu.live_textures == 2);
+    assert(manager.stats.resident_bytes == bytes * 2);
+
+    // so it has to be decoded again
+    u32 misses = manager.stats.misses;
+    a = texture_manager_load(&manager, "texture_cache_a.png", NULL);
+    assert(manager.stats.misses == misses + 1);
+    texture_manager_unload(&manager, a);
+    assert(manager.oldest == c && manager.newest == a);
+
+    // packed textures are cached too, and keep their spot in the atlas
+    TextureEntry *small =
+        texture_manager_load_packed(&manager, "texture_cache_small.png", NULL);
+    assert(small->region.page == 0);
+    AtlasRegion region = small->region;
+    texture_manager_unload(&manager, small);
+    assert(manager.newest == small);
+    small =
+        texture_manager_load_packed(&manager, "texture_cache_small.png", NULL);
+    assert(small->region.x == region.x && small->region.y == region.y);
+    texture_manager_unload(&manager, small);
+
+    // registered textures can't be loaded again, so they're never cached
+    TextureEntry *registered =
+        texture_manager_register(&manager, fake_texture(8, 8), "registered");
+    u32 textures = fake_wgpu.live_textures;
+    texture_manager_unload(&manager, registered);
+    assert(fake_wgpu.live_textures == textures - 1);
+
+    // no cache is the old behaviour. only the atlas page is left
+    texture_manager_set_cache_budget(&manager, 0);
+    assert(manager.stats.cached == 0 && manager.stats.cached_bytes == 0);
+    assert(manager.newest == NULL && manager.oldest == NULL);
+    assert(fake_wgpu.live_textures == 1);
+    assert(manager.packed.len == 0);
+    a = texture_manager_load(&manager, "texture_cache_a.png", NULL);
+    texture_manager_unload(&manager, a);
+    assert(fake_wgpu.live_textures == 1);
+
+    texture_manager_free(&manager);
+    assert(fake_wgpu.live_textures == 0);
+
+    remove("texture_cache_a.png");
+    remove("texture_cache_b.png");
+    remove("texture_cache_c.png");
+    remove("texture_cache_small.png");
+}
+
+static u32 shared_textures(TestMap *maps)
+{
+    u32 shared = 0;
+    for (u32 i = 0; i < maps[0].count; i++)
+        for (u32 j = 0; j < maps[1].count; j++)
+            if (strcmp(maps[0].textures[i].path, maps[1].textures[j].path) == 0)
+                shared++;
+    return shared;
+}
+
+static void ping_pong(TestMap *maps, u64 budget, f64 *seconds, u32 *misses)
+{
+    TextureManager manager;
+    texture_manager_init(&manager);
+    texture_manager_set_cache_budget(&manager, budget);
+
+    map_load(&maps[0], &manager);
+    clock_t start = clock();
+    for (u32 i = 0; i < TRANSITIONS; i++)
+    {
+        map_free(&maps[i % 2], &manager);
+        map_load(&maps[(i + 1) % 2], &manager);
+    }
+    *seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+    *misses = manager.stats.misses;
+
+    if (budget > 0)
+    {
+        // both maps fit, so nothing's decoded after the first visit to each
+        assert(manager.stats.misses ==
+               maps[0].count + maps[1].count - shared_textures(maps));
+        assert(manager.stats.evictions == 0);
+    }
+    else
+        assert(manager.stats.misses == maps[0].count * (TRANSITIONS + 1));
+
+    map_free(&maps[TRANSITIONS % 2], &manager);
+    texture_manager_free(&manager);
+}
+
+static void benchmark(void)
+{
+    static TestMap maps[2];
+    make_map(&maps[0], 'a');
+    make_map(&maps[1], 'b');
+
+    f64 uncached_seconds, cached_seconds;
+    u32 uncached_misses, cached_misses;
+    ping_pong(maps, 0, &uncached_seconds, &uncached_misses);
+    ping_pong(maps, TEXTURE_CACHE_BUDGET, &cached_seconds, &cached_misses);
+
+    printf("%d map changes: %.3fms per change and %u decodes without the "
+           "cache, %.3fms per change and %u decodes with it\n",
+           TRANSITIONS, uncached_seconds * 1000.0 / TRANSITIONS,
+           uncached_misses, cached_seconds * 1000.0 / TRANSITIONS,
+           cached_misses);
+
+    for (u32 i = 0; i < 2; i++)
+        for (u32 j = 0; j < maps[i].count; j++)
+            remove(maps[i].textures[j].path);
+}
+
+int main()
+{
+    test_cache();
+    benchmark();
+}
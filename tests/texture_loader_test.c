@@ -0,0 +1,282 @@
+#include <SDL3_image/SDL_image.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fake_wgpu.h"
+#include "graphics/tex_manager.h"
+#include "utility/macros.h"
+
+// checks async loads start out as the placeholder with the right size, get
+// uploaded within the budget, follow the placeholder if it moves, and can be
+// unloaded before they're done. then loads a texture heavy map (a big tileset
+// and lots of character sprites) both ways, and measures how long the map
+// takes to load and how long until everything's on the gpu.
+// the pngs are real and really get decoded, but there's no gpu here, so
+// textures are just their size.
+
+#define MAP_SPRITES 63
+#define RUNS 5
+
+// some noise over a gradient, so it doesn't compress to nothing
+static void write_png(const char *path, u32 width, u32 height, u32 seed)
+{
+    SDL_Surface *surface =
+        SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32);
+    SDL_PTR_ERRCHK(surface, "failed to make a surface");
+    for (u32 y = 0; y < height; y++)
+    {
+        u8 *row = (u8 *)surface->pixels + y * surface->pitch;
+        for (u32 x = 0; x < width; x++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            row[x * 4 + 0] = x + (seed >> 28);
+            row[x * 4 + 1] = y + (seed >> 29);
+            row[x * 4 + 2] = (x ^ y) & 0xF0;
+            row[x * 4 + 3] = 255;
+        }
+    }
+    if (!IMG_SavePNG(surface, path))
+        FATAL("failed to write %s: %s\n", path, SDL_GetError());
+    SDL_DestroySurface(surface);
+}
+
+static f64 ms_since(u64 start)
+{
+    return (f64)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+           SDL_GetPerformanceFrequency();
+}
+
+// so uploads can be checked against the budget
+static void wait_until_decoded(TextureManager *manager, u32 count)
+{
+    TextureLoader *loader = &manager->loader;
+    for (;;)
+    {
+        SDL_LockMutex(loader->lock);
+        bool done = loader->decoded.len >= count;
+        SDL_UnlockMutex(loader->lock);
+        if (done)
+            return;
+        SDL_Delay(1);
+    }
+}
+
+static void test_png_size(void)
+{
+    u32 width, height;
+    assert(texture_loader_png_size("texture_loader_a.png", &width, &height));
+    assert(width == 64 && height == 32);
+
+    FILE *file = fopen("texture_loader_not_a.png", "wb");
+    fputs("definitely not a png, but long enough to be one", file);
+    fclose(file);
+    assert(!texture_loader_png_size("texture_loader_not_a.png", &width,
+                                    &height));
+    assert(!texture_loader_png_size("texture_loader_missing.png", &width,
+                                    &height));
+    remove("texture_loader_not_a.png");
+}
+
+static void test_async(void)
+{
+    TextureManager manager;
+    texture_manager_init(&manager);
+    // something before the placeholder, so it can be moved later
+    TextureEntry *first =
+        texture_manager_register(&manager, fake_texture(8, 8), "first");
+    manager.placeholder =
+        texture_manager_register(&manager, fake_texture(8, 8), "placeholder");
+
+    TextureEntry *a =
+        texture_manager_load_async(&manager, "texture_loader_a.png", NULL);
+    assert(a->index == manager.placeholder->index);
+    assert(a->width == 64 && a->height == 32);
+    assert(a->loading && manager.loading.len == 1);
+    assert(manager.stats.misses == 1);
+    // the same entry, whether it's loaded async or not
+    assert(texture_manager_load_async(&manager, "texture_loader_a.png",
+                                      NULL) == a);
+    assert(texture_manager_load(&manager, "texture_loader_a.png", NULL) == a);
+    assert(a->ref_count == 3 && manager.stats.hits == 2);
+
+    // everything loading moves with the placeholder
+    texture_manager_unload(&manager, first);
+    assert(manager.placeholder->index == 0);
+    assert(a->index == 0);
+
+    TextureEntry *b =
+        texture_manager_load_async(&manager, "texture_loader_b.png", NULL);
+    TextureEntry *c =
+        texture_manager_load_async(&manager, "texture_loader_c.png", NULL);
+
+    // 64x32 textures are 8kb, so two fit in 12kb
+    manager.upload_budget = 12 * 1024;
+    wait_until_decoded(&manager, 3);
+    u32 generation = manager.generation;
+    texture_manager_upload_loaded(&manager, NULL);
+    assert(manager.load_stats.uploads == 2);
+    assert(manager.load_stats.uploaded_bytes == 2 * 64 * 32 * 4);
+    assert(manager.load_stats.loading == 1);
+    assert(manager.generation == generation + 2);
+    // in whatever order they finished decoding
+    TextureEntry *entries[] = {a, b, c};
+    TextureEntry *waiting = NULL;
+    for (u32 i = 0; i < 3; i++)
+    {
+        bool loading = entries[i]->loading != NULL;
+        assert(loading ==
+               (entries[i]->index == manager.placeholder->index));
+        if (loading)
+            waiting = entries[i];
+    }
+    assert(waiting);
+    assert(manager.stats.resident_bytes == 8 * 8 * 4 + 2 * 64 * 32 * 4);
+
+    // something bigger than the budget still gets uploaded
+    manager.upload_budget = 1;
+    texture_manager_upload_loaded(&manager, NULL);
+    assert(manager.load_stats.uploads == 1);
+    assert(!waiting->loading && manager.loading.len == 0);
+    texture_manager_upload_loaded(&manager, NULL);
+    assert(manager.load_stats.uploads == 0);
+
+    // unloaded before it's done, with nothing cached. it's just thrown away
+    texture_manager_set_cache_budget(&manager, 0);
+    u32 textures = fake_wgpu.live_textures;
+    TextureEntry *d =
+        texture_manager_load_async(&manager, "texture_loader_d.png", NULL);
+    texture_manager_unload(&manager, d);
+    assert(manager.loading.len == 0);
+    texture_manager_finish_loading(&manager, NULL);
+    assert(fake_wgpu.live_textures == textures);
+
+    // with the cache, it's uploaded and kept for next time
+    texture_manager_set_cache_budget(&manager, TEXTURE_CACHE_BUDGET);
+    d = texture_manager_load_async(&manager, "texture_loader_d.png", NULL);
+    texture_manager_unload(&manager, d);
+    // it's counted as what it'll take up
+    assert(manager.stats.cached == 1);
+    assert(manager.stats.cached_bytes == 64 * 32 * 4);
+    texture_manager_finish_loading(&manager, NULL);
+    assert(fake_wgpu.live_textures == textures + 1);
+    assert(manager.stats.cached_bytes == 64 * 32 * 4);
+    u32 misses = manager.stats.misses;
+    assert(texture_manager_load_async(&manager, "texture_loader_d.png",
+                                      NULL) == d);
+    assert(manager.stats.misses == misses);
+    texture_manager_unload(&manager, d);
+
+    texture_manager_unload(&manager, a);
+    texture_manager_unload(&manager, a);
+    texture_manager_unload(&manager, a);
+    texture_manager_unload(&manager, b);
+    texture_manager_unload(&manager, c);
+
+    // still loading when the manager's freed
+    texture_manager_load_async(&manager, "texture_loader_e.png", NULL);
+    texture_manager_free(&manager);
+    assert(fake_wgpu.live_textures == 0);
+}
+
+typedef struct
+{
+    // until the map's loaded and the first frame can be drawn
+    f64 load_ms;
+    // until every texture is on the gpu
+    f64 resident_ms;
+    // the most time spent uploading in a frame
+    f64 worst_frame_ms;
+    u32 frames;
+} MapLoad;
+
+static void load_map(char paths[][64], bool async, MapLoad *out)
+{
+    TextureManager manager;
+    texture_manager_init(&manager);
+    manager.placeholder =
+        texture_manager_register(&manager, fake_texture(8, 8), "placeholder");
+    TextureEntry *entries[MAP_SPRITES + 1];
+
+    u64 start = SDL_GetPerformanceCounter();
+    for (u32 i = 0; i < MAP_SPRITES + 1; i++)
+        entries[i] =
+            async ? texture_manager_load_async(&manager, paths[i], NULL)
+                  : texture_manager_load(&manager, paths[i], NULL);
+    out->load_ms = ms_since(start);
+
+    // frames carry on while the rest decode
+    out->worst_frame_ms = 0.0;
+    out->frames = 0;
+    while (manager.loading.len)
+    {
+        u64 frame_start = SDL_GetPerformanceCounter();
+        texture_manager_upload_loaded(&manager, NULL);
+        f64 frame_ms = ms_since(frame_start);
+        if (frame_ms > out->worst_frame_ms)
+            out->worst_frame_ms = frame_ms;
+        out->frames++;
+        SDL_Delay(1);
+    }
+    out->resident_ms = ms_since(start);
+
+    for (u32 i = 0; i < MAP_SPRITES + 1; i++)
+        assert(entries[i]->index != manager.placeholder->index);
+    texture_manager_free(&manager);
+}
+
+static void benchmark(void)
+{
+    static char paths[MAP_SPRITES + 1][64];
+    snprintf(paths[0], sizeof(paths[0]), "texture_loader_tileset.png");
+    write_png(paths[0], 1024, 1024, 1);
+    for (u32 i = 0; i < MAP_SPRITES; i++)
+    {
+        snprintf(paths[i + 1], sizeof(paths[i + 1]),
+                 "texture_loader_sprite_%u.png", i);
+        write_png(paths[i + 1], 256, 128, i + 2);
+    }
+
+    // the best of a few runs, so the disk cache is warm for both
+    MapLoad sync = {.load_ms = 1e9}, async = {.load_ms = 1e9};
+    for (u32 i = 0; i < RUNS; i++)
+    {
+        MapLoad run;
+        load_map(paths, false, &run);
+        if (run.load_ms < sync.load_ms)
+            sync = run;
+        load_map(paths, true, &run);
+        if (run.load_ms < async.load_ms)
+            async = run;
+    }
+
+    printf("map with a 1024x1024 tileset and %d 256x128 sprites: %.2fms to "
+           "load decoding on the main thread, %.2fms async (%.2fms until "
+           "everything was uploaded, %u frames, at most %.3fms uploading a "
+           "frame)\n",
+           MAP_SPRITES, sync.load_ms, async.load_ms, async.resident_ms,
+           async.frames, async.worst_frame_ms);
+
+    for (u32 i = 0; i < MAP_SPRITES + 1; i++)
+        remove(paths[i]);
+}
+
+int main()
+{
+    write_png("texture_loader_a.png", 64, 32, 1);
+    write_png("texture_loader_b.png", 64, 32, 2);
+    write_png("texture_loader_c.png", 64, 32, 3);
+    write_png("texture_loader_d.png", 64, 32, 4);
+    write_png("texture_loader_e.png", 64, 32, 5);
+
+    test_png_size();
+    test_async();
+    benchmark();
+
+    remove("texture_loader_a.png");
+    remove("texture_loader_b.png");
+    remove("texture_loader_c.png");
+    remove("texture_loader_d.png");
+    remove("texture_loader_e.png");
+}
@@ -0,0 +1,64 @@
+#include <assert.h>
+#include "graphics/tilemap_animations.h"
+
+// checks animated tiles land on the right frame at any point in time (this
+// is what tilemap.wgsl does on the gpu), and that tiles without animations
+// are left alone.
+
+static void test_animations(void)
+{
+    TilemapAnimations animations;
+    tilemap_animations_init(&animations);
+
+    // water: 3 frames of different lengths
+    TilemapAnimationFrame water[] = {
+        {.tile = 10, .duration = 100},
+        {.tile = 11, .duration = 200},
+        {.tile = 12, .duration = 100},
+    };
+    tilemap_animations_add(&animations, 10, water, 3);
+    // a torch that isn't one of its own frames
+    TilemapAnimationFrame torch[] = {
+        {.tile = 20, .duration = 50},
+        {.tile = 21, .duration = 50},
+    };
+    tilemap_animations_add(&animations, 3, torch, 2);
+    // doesn't take any time, so it's skipped
+    TilemapAnimationFrame broken[] = {{.tile = 1, .duration = 0}};
+    tilemap_animations_add(&animations, 5, broken, 1);
+
+    // only goes up to the last tile that animates
+    assert(animations.animations.len == 11);
+    assert(animations.frames.len == 5);
+    TilemapAnimation *animation = vec_get(&animations.animations, 10);
+    assert(animation->first == 0 && animation->count == 3);
+    assert(animation->duration == 400);
+    animation = vec_get(&animations.animations, 5);
+    assert(animation->count == 0);
+
+    assert(tilemap_animations_frame(&animations, 10, 0) == 10);
+    assert(tilemap_animations_frame(&animations, 10, 99) == 10);
+    assert(tilemap_animations_frame(&animations, 10, 100) == 11);
+    assert(tilemap_animations_frame(&animations, 10, 299) == 11);
+    assert(tilemap_animations_frame(&animations, 10, 300) == 12);
+    // loops
+    assert(tilemap_animations_frame(&animations, 10, 400) == 10);
+    assert(tilemap_animations_frame(&animations, 10, 4000 + 150) == 11);
+    // even when the time wraps around
+    assert(tilemap_animations_frame(&animations, 3, UINT32_MAX) == 21);
+
+    assert(tilemap_animations_frame(&animations, 3, 0) == 20);
+    assert(tilemap_animations_frame(&animations, 3, 75) == 21);
+
+    // not animated, or past the end of the table
+    assert(tilemap_animations_frame(&animations, 0, 1234) == 0);
+    assert(tilemap_animations_frame(&animations, 5, 1234) == 5);
+    assert(tilemap_animations_frame(&animations, 500, 1234) == 500);
+
+    tilemap_animations_free(&animations);
+}
+
+int main()
+{
+    test_animations();
+}
@@ -0,0 +1,199 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "graphics/tilemap_chunks.h"
+
+// checks tilemaps are split into chunks with only their non-empty tiles in
+// them (packed, flip flags and all), that only chunks in view get drawn, and
+// that the uv table lines up with the tileset. then counts how many instances
+// get drawn per frame on a big map, compared to drawing every tile.
+
+#define BIG_MAP_SIZE 1000
+#define FRAMES 1000
+
+// the other way from tilemap_tile_pack
+static u32 tile_id(TilemapTile tile) { return tile & 0xFFFF; }
+static u32 tile_flips(TilemapTile tile) { return (tile >> 16) & 0x7; }
+static u32 tile_x(TilemapTile tile) { return (tile >> 19) & 0x1F; }
+static u32 tile_y(TilemapTile tile) { return (tile >> 24) & 0x1F; }
+
+static void test_chunks(void)
+{
+    // 2 layers of 40x40, so 2x2 chunks with the right and bottom ones only
+    // partly filled
+    enum
+    {
+        W = 40,
+        H = 40,
+    };
+    // gids, so 0 is empty and everything else is one more than the tile
+    static u32 map[W * H * 2];
+    // layer 0: a tile in the top left and bottom right chunks, the second one
+    // flipped both ways
+    map[1 * W + 2] = 8;
+    map[39 * W + 39] = 9 | TILEMAP_FLIP_HORIZONTAL | TILEMAP_FLIP_DIAGONAL;
+    // layer 1: a whole row along the top
+    for (u32 x = 0; x < W; x++)
+        map[W * H + x] = 4;
+
+    TilemapChunks chunks;
+    vec tiles;
+    vec_init(&tiles, sizeof(TilemapTile));
+    tilemap_chunks_build(&chunks, W, H, 2, map, &tiles);
+
+    assert(chunks.chunks_w == 2 && chunks.chunks_h == 2);
+    assert(chunks.chunks.len == 8);
+    assert(tiles.len == 2 + W);
+    assert(*(u32 *)vec_get(&chunks.layer_tiles, 0) == 2);
+    assert(*(u32 *)vec_get(&chunks.layer_chunks, 0) == 2);
+    assert(*(u32 *)vec_get(&chunks.layer_chunks, 1) == 2);
+
+    // positions are in the chunk
+    TilemapTile tile = *(TilemapTile *)vec_get(&tiles, 0);
+    assert(tile_id(tile) == 7 && tile_flips(tile) == 0);
+    assert(tile_x(tile) == 2 && tile_y(tile) == 1);
+    tile = *(TilemapTile *)vec_get(&tiles, 1);
+    assert(tile_id(tile) == 8 && tile_flips(tile) == (1 | 4));
+    assert(tile_x(tile) == 7 && tile_y(tile) == 7);
+    tile = *(TilemapTile *)vec_get(&tiles, 2 + 35);
+    assert(tile_id(tile) == 3 && tile_x(tile) == 3 && tile_y(tile) == 0);
+
+    // the chunk bounds only cover the tiles that are there
+    TilemapChunk *chunk = vec_get(&chunks.chunks, 0);
+    assert(chunk->first == 0 && chunk->count == 1);
+    assert(chunk->bounds.min.x == 16 && chunk->bounds.min.y == 8);
+    assert(chunk->bounds.max.x == 24 && chunk->bounds.max.y == 16);
+    chunk = vec_get(&chunks.chunks, 1);
+    assert(chunk->count == 0);
+
+    vec draws;
+    vec_init(&draws, sizeof(TilemapDraw));
+    CullStats chunk_stats = {0}, tile_stats = {0};
+
+    // just the top left corner
+    Rect view = rect_from_min_size(GLMS_VEC2_ZERO, (vec2s){.x = 64, .y = 64});
+    tilemap_chunks_visible(&chunks, 0, view, &draws, &chunk_stats,
+                           &tile_stats);
+    assert(draws.len == 1);
+    TilemapDraw *draw = vec_get(&draws, 0);
+    assert(draw->first == 0 && draw->count == 1);
+    assert(draw->x == 0 && draw->y == 0);
+    assert(chunk_stats.submitted == 2 && chunk_stats.visible == 1);
+    assert(tile_stats.submitted == W * H && tile_stats.visible == 1);
+
+    // in the top left chunk, but nowhere near its only tile
+    view = rect_from_min_size((vec2s){.x = 100, .y = 100},
+                              (vec2s){.x = 64, .y = 64});
+    tilemap_chunks_visible(&chunks, 0, view, &draws, &chunk_stats,
+                           &tile_stats);
+    assert(draws.len == 0);
+
+    // everything. the top row of layer 1 is two chunks, so two draws
+    view = rect_from_min_size((vec2s){.x = -50, .y = -50},
+                              (vec2s){.x = 1000, .y = 1000});
+    tilemap_chunks_visible(&chunks, 1, view, &draws, &chunk_stats,
+                           &tile_stats);
+    assert(draws.len == 2);
+    draw = vec_get(&draws, 0);
+    assert(draw->first == 2 && draw->count == TILEMAP_CHUNK_SIZE);
+    assert(draw->x == 0 && draw->y == 0);
+    draw = vec_get(&draws, 1);
+    assert(draw->first == 2 + TILEMAP_CHUNK_SIZE);
+    assert(draw->count == W - TILEMAP_CHUNK_SIZE);
+    assert(draw->x == TILEMAP_CHUNK_SIZE && draw->y == 0);
+
+    // off the map entirely
+    view = rect_from_min_size((vec2s){.x = -500, .y = 0},
+                              (vec2s){.x = 320, .y = 180});
+    tilemap_chunks_visible(&chunks, 1, view, &draws, &chunk_stats,
+                           &tile_stats);
+    assert(draws.len == 0);
+
+    vec_free(&draws);
+    vec_free(&tiles);
+    tilemap_chunks_free(&chunks);
+}
+
+static void test_uv_table(void)
+{
+    // 4x2 tiles, plus a few pixels that don't make a whole tile
+    vec uvs;
+    vec_init(&uvs, sizeof(TilemapUv));
+    tilemap_uv_table(&uvs, 35, 16);
+    assert(uvs.len == 8);
+
+    TilemapUv *uv = vec_get(&uvs, 0);
+    assert(fabsf(uv->min.x - 0.01f / 35) < 1e-6 &&
+           fabsf(uv->min.y - 0.01f / 16) < 1e-6);
+    assert(fabsf(uv->max.x - 7.99f / 35) < 1e-6 &&
+           fabsf(uv->max.y - 7.99f / 16) < 1e-6);
+    // tiles go along the rows
+    uv = vec_get(&uvs, 5);
+    assert(fabsf(uv->min.x - 8.01f / 35) < 1e-6 &&
+           fabsf(uv->min.y - 8.01f / 16) < 1e-6);
+    assert(fabsf(uv->max.x - 15.99f / 35) < 1e-6 &&
+           fabsf(uv->max.y - 15.99f / 16) < 1e-6);
+
+    vec_free(&uvs);
+}
+
+static void benchmark(void)
+{
+    // a big map where about a third of the tiles are empty, with the camera
+    // walking along it
+    u32 *map = malloc(sizeof(u32) * BIG_MAP_SIZE * BIG_MAP_SIZE);
+    srand(1234);
+    for (u32 i = 0; i < BIG_MAP_SIZE * BIG_MAP_SIZE; i++)
+        map[i] = rand() % 3 == 0 ? 0 : rand() % 64 + 1;
+
+    TilemapChunks chunks;
+    vec tiles;
+    vec_init(&tiles, sizeof(TilemapTile));
+    clock_t start = clock();
+    tilemap_chunks_build(&chunks, BIG_MAP_SIZE, BIG_MAP_SIZE, 1, map, &tiles);
+    f64 build_seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+
+    vec draws;
+    vec_init(&draws, sizeof(TilemapDraw));
+    CullStats chunk_stats = {0}, tile_stats = {0};
+    u32 draw_count = 0;
+    start = clock();
+    for (u32 i = 0; i < FRAMES; i++)
+    {
+        Rect view = rect_from_min_size((vec2s){.x = i * 7, .y = i * 3},
+                                       (vec2s){.x = 320, .y = 180});
+        tilemap_chunks_visible(&chunks, 0, view, &draws, &chunk_stats,
+                               &tile_stats);
+        draw_count += draws.len;
+    }
+    f64 seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+
+    // a 320x180 view can touch at most 3x2 chunks
+    assert(chunk_stats.visible <= 6 * FRAMES);
+    assert(tile_stats.visible <= 6 * 32 * 32 * FRAMES);
+    assert(tile_stats.submitted == (u32)BIG_MAP_SIZE * BIG_MAP_SIZE * FRAMES);
+
+    printf("%dx%d map: %u tiles (built in %.1fms, %.1fmb), %u instances "
+           "(%.1fkb) and %.1f draws per frame instead of %d (%.4fms per "
+           "frame)\n",
+           BIG_MAP_SIZE, BIG_MAP_SIZE, (u32)tiles.len, build_seconds * 1000.0,
+           tiles.len * sizeof(TilemapTile) / (1024.0 * 1024.0),
+           tile_stats.visible / FRAMES,
+           tile_stats.visible / FRAMES * sizeof(TilemapTile) / 1024.0,
+           (f64)draw_count / FRAMES, BIG_MAP_SIZE * BIG_MAP_SIZE,
+           seconds * 1000.0 / FRAMES);
+
+    vec_free(&draws);
+    vec_free(&tiles);
+    tilemap_chunks_free(&chunks);
+    free(map);
+}
+
+int main()
+{
+    test_chunks();
+    test_uv_table();
+    benchmark();
+}
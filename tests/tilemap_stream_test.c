@@ -0,0 +1,264 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fake_wgpu.h"
+#include "graphics/tilemap_stream.h"
+
+// checks streamed tilemaps upload the right tiles into the chunk pool, stick
+// to the upload budget, and replace the least recently used chunks when the
+// pool is full. then walks a camera across a generated 8192x8192 map and
+// measures how much gpu memory that takes and how much gets uploaded a frame.
+// there's no gpu here, so the pool is just some memory.
+
+#define BIG_MAP_SIZE 8192
+#define FRAMES 2000
+
+// the gid of a tile in the test maps
+static u32 test_tile(int x, int y)
+{
+    // big patches of the same tile, with some empty bits, and every other
+    // column of patches flipped
+    if ((x / 5 + y / 7) % 6 == 0)
+        return 0;
+    u32 flip = (x / 16) % 2 ? TILEMAP_FLIP_VERTICAL : 0;
+    return (((x / 16) * 3 + (y / 16)) % 50 + 1) | flip;
+}
+
+static u32 test_tile_in_layer(int layer, int x, int y)
+{
+    if (layer == 0)
+        return test_tile(x, y);
+    return x == y ? 2 : 0;
+}
+
+static void add_map(TilemapStream *stream, int map_w, int map_h, int layers)
+{
+    u32 *rows = malloc(sizeof(u32) * map_w * TILEMAP_CHUNK_SIZE);
+    for (int layer = 0; layer < layers; layer++)
+    {
+        for (int chunk_y = 0; chunk_y < stream->chunks_h; chunk_y++)
+        {
+            for (int y = 0; y < TILEMAP_CHUNK_SIZE; y++)
+            {
+                int map_y = chunk_y * TILEMAP_CHUNK_SIZE + y;
+                for (int x = 0; x < map_w && map_y < map_h; x++)
+                    rows[y * map_w + x] = test_tile_in_layer(layer, x, map_y);
+            }
+            tilemap_stream_add_rows(stream, layer, chunk_y, rows);
+        }
+    }
+    free(rows);
+}
+
+// everything drawn has the tile it should, in the right place
+static u32 check_draws(TilemapStream *stream, vec *draws, int layer)
+{
+    u32 drawn = 0;
+    TilemapTile *tiles = (TilemapTile *)fake_buffer_data(stream->pool);
+    for (usize i = 0; i < draws->len; i++)
+    {
+        TilemapDraw *draw = vec_get(draws, i);
+        assert(draw->first % TILEMAP_CHUNK_TILES == 0);
+        for (u32 j = 0; j < draw->count; j++)
+        {
+            TilemapTile tile = tiles[draw->first + j];
+            int x = draw->x + ((tile >> 19) & 0x1F);
+            int y = draw->y + ((tile >> 24) & 0x1F);
+            assert(tile == tilemap_tile_pack(test_tile_in_layer(layer, x, y),
+                                             x - draw->x, y - draw->y));
+            drawn++;
+        }
+    }
+    return drawn;
+}
+
+static void test_stream(WGPUResources *resources)
+{
+    // 100x70 tiles is 4x3 chunks, with the edges only partly there
+    TilemapStreamSettings settings = {
+        .pool_chunks = 8,
+        .margin = 0,
+        .upload_budget = 3 * TILEMAP_SLOT_SIZE,
+    };
+    TilemapStream stream;
+    tilemap_stream_init(&stream, resources, 100, 70, 2, settings);
+    add_map(&stream, 100, 70, 2);
+    assert(stream.chunks_w == 4 && stream.chunks_h == 3);
+    assert(wgpuBufferGetSize(stream.pool) == 8 * TILEMAP_SLOT_SIZE);
+    // layer 1 is just a diagonal line, through 3 chunks
+    assert(*(u32 *)vec_get(&stream.layer_chunks, 1) == 3);
+    // runs compress it
+    assert(stream.compressed.len < 100 * 70 * 2 * sizeof(u32) / 4);
+
+    vec draws;
+    vec_init(&draws, sizeof(TilemapDraw));
+    CullStats chunk_stats = {0}, tile_stats = {0};
+
+    // the top left 2x2 chunks of layer 0
+    Rect view = rect_from_min_size((vec2s){.x = 10, .y = 10},
+                                   (vec2s){.x = 320, .y = 300});
+    u64 frame = 1;
+    fake_wgpu.uploaded = 0;
+    tilemap_stream_request(&stream, 0, view, frame);
+    tilemap_stream_flush(&stream, resources);
+    // only 3 fit in the budget
+    assert(stream.stats.uploads == 3);
+    assert(fake_wgpu.uploaded <= settings.upload_budget);
+    tilemap_stream_visible(&stream, 0, view, &draws, &chunk_stats, &tile_stats);
+    assert(stream.stats.missing == 1);
+    assert(check_draws(&stream, &draws, 0) == tile_stats.visible);
+
+    // and the last one comes in next frame
+    frame++;
+    tilemap_stream_request(&stream, 0, view, frame);
+    tilemap_stream_flush(&stream, resources);
+    assert(stream.stats.uploads == 1);
+    // flushing again doesn't do anything
+    tilemap_stream_flush(&stream, resources);
+    assert(stream.stats.uploads == 1);
+    tile_stats = (CullStats){0};
+    tilemap_stream_visible(&stream, 0, view, &draws, &chunk_stats, &tile_stats);
+    assert(stream.stats.missing == 0);
+    assert(check_draws(&stream, &draws, 0) == tile_stats.visible);
+    assert(stream.resident == 4);
+
+    // the diagonal on layer 1 as well
+    frame++;
+    Rect everything = rect_from_min_size(GLMS_VEC2_ZERO,
+                                         (vec2s){.x = 800, .y = 560});
+    tilemap_stream_request(&stream, 1, everything, frame);
+    tilemap_stream_flush(&stream, resources);
+    assert(stream.stats.uploads == 3);
+    tilemap_stream_visible(&stream, 1, everything, &draws, &chunk_stats,
+                           &tile_stats);
+    assert(check_draws(&stream, &draws, 1) == 70);
+    assert(stream.resident == 7);
+
+    // moving to the right side of layer 0 needs 4 more, and there's only one
+    // free slot, so the 3 that were used longest ago go. that's the top left
+    // of layer 0, not the diagonal that was just drawn
+    view = rect_from_min_size((vec2s){.x = 520, .y = 10},
+                              (vec2s){.x = 250, .y = 300});
+    for (u32 i = 0; i < 2; i++)
+    {
+        frame++;
+        tilemap_stream_request(&stream, 0, view, frame);
+        tilemap_stream_flush(&stream, resources);
+    }
+    assert(stream.resident == 8);
+    u32 evicted = 0;
+    for (int y = 0; y < 2; y++)
+    {
+        for (int x = 0; x < 2; x++)
+        {
+            StreamedChunk *chunk = vec_get(&stream.chunks, y * 4 + x);
+            if (chunk->slot == TILEMAP_SLOT_NONE)
+                evicted++;
+        }
+    }
+    assert(evicted == 3);
+    for (int i = 0; i < 3; i++)
+    {
+        StreamedChunk *diagonal = vec_get(&stream.chunks, 12 + i * 4 + i);
+        assert(diagonal->slot != TILEMAP_SLOT_NONE);
+    }
+    tile_stats = (CullStats){0};
+    tilemap_stream_visible(&stream, 0, view, &draws, &chunk_stats, &tile_stats);
+    assert(stream.stats.missing == 0);
+    assert(check_draws(&stream, &draws, 0) == tile_stats.visible);
+
+    // asking for more than fits in the pool in one frame just draws what it
+    // can, rather than replacing chunks that are already being drawn
+    frame++;
+    tilemap_stream_request(&stream, 0, everything, frame);
+    tilemap_stream_request(&stream, 1, everything, frame);
+    tilemap_stream_flush(&stream, resources);
+    tilemap_stream_visible(&stream, 0, everything, &draws, &chunk_stats,
+                           &tile_stats);
+    check_draws(&stream, &draws, 0);
+    tilemap_stream_visible(&stream, 1, everything, &draws, &chunk_stats,
+                           &tile_stats);
+    check_draws(&stream, &draws, 1);
+    assert(stream.stats.missing == 12 + 3 - 8);
+
+    vec_free(&draws);
+    tilemap_stream_free(&stream);
+    assert(fake_wgpu.live_buffers == 0);
+}
+
+static void benchmark(WGPUResources *resources)
+{
+    TilemapStreamSettings settings = {
+        .pool_chunks = 256,
+        .margin = 2,
+        .upload_budget = 64 * 1024,
+    };
+    TilemapStream stream;
+    tilemap_stream_init(&stream, resources, BIG_MAP_SIZE, BIG_MAP_SIZE, 1,
+                        settings);
+
+    clock_t start = clock();
+    add_map(&stream, BIG_MAP_SIZE, BIG_MAP_SIZE, 1);
+    f64 compress_seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+
+    u64 full_bytes = 0;
+    for (usize i = 0; i < stream.chunks.len; i++)
+        full_bytes += ((StreamedChunk *)vec_get(&stream.chunks, i))->count *
+                      sizeof(TilemapTile);
+
+    vec draws;
+    vec_init(&draws, sizeof(TilemapDraw));
+    CullStats chunk_stats = {0}, tile_stats = {0};
+    u64 total_uploaded = 0, peak_uploaded = 0;
+    u32 missing = 0;
+    start = clock();
+    for (u64 frame = 1; frame <= FRAMES; frame++)
+    {
+        // running diagonally across the map at 4 pixels a frame (way faster
+        // than the player can move)
+        Rect view = rect_from_min_size(
+            (vec2s){.x = frame * 4.0f, .y = frame * 3.0f},
+            (vec2s){.x = 320, .y = 180});
+
+        fake_wgpu.uploaded = 0;
+        tilemap_stream_request(&stream, 0, view, frame);
+        tilemap_stream_flush(&stream, resources);
+        tilemap_stream_visible(&stream, 0, view, &draws, &chunk_stats,
+                               &tile_stats);
+
+        assert(fake_wgpu.uploaded <= settings.upload_budget);
+        total_uploaded += fake_wgpu.uploaded;
+        if (fake_wgpu.uploaded > peak_uploaded)
+            peak_uploaded = fake_wgpu.uploaded;
+        missing += stream.stats.missing;
+    }
+    f64 seconds = (f64)(clock() - start) / CLOCKS_PER_SEC;
+    check_draws(&stream, &draws, 0);
+    assert(stream.stats.peak_uploaded_bytes == peak_uploaded);
+
+    printf("%dx%d map: %.1fmb of tiles, %.1fmb compressed (in %.0fms)\n",
+           BIG_MAP_SIZE, BIG_MAP_SIZE, full_bytes / 1048576.0,
+           stream.compressed.len / 1048576.0, compress_seconds * 1000.0);
+    printf("gpu memory: %.1fmb (%u chunk pool), uploads: %.0f bytes per frame "
+           "on average, %llu peak, %u chunks missing over %d frames "
+           "(%.4fms per frame)\n",
+           tilemap_stream_pool_bytes(&stream) / 1048576.0,
+           settings.pool_chunks, (f64)total_uploaded / FRAMES,
+           (unsigned long long)peak_uploaded, missing, FRAMES,
+           seconds * 1000.0 / FRAMES);
+
+    vec_free(&draws);
+    tilemap_stream_free(&stream);
+}
+
+int main()
+{
+    WGPUResources resources;
+    memset(&resources, 0, sizeof(resources));
+
+    test_stream(&resources);
+    benchmark(&resources);
+}
@@ -0,0 +1,442 @@
+// translates event scripts into C ahead of time. see src/events/aot.h
+//
+// usage: event_aot <output.c> <script> [scripts...]
+//
+// script paths are recorded as-is, and are matched against the paths the game
+// loads scripts from, so run this from the same directory the game runs from.
+
+#include "events/aot.h"
+#include "events/commands/command.h"
+#include "events/compiler.h"
+#include "events/globals.h"
+#include "events/instruction.h"
+#include "utility/vec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char *read_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        exit(1);
+    }
+
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *data = malloc(len + 1);
+    if (fread(data, 1, len, file) != (usize)len)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        exit(1);
+    }
+    data[len] = '\0';
+
+    fclose(file);
+    return data;
+}
+
+static void write_string_literal(FILE *out, const char *string)
+{
+    fputc('"', out);
+    for (const char *c = string; *c; c++)
+    {
+        switch (*c)
+        {
+        case '\\':
+            fputs("\\\\", out);
+            break;
+        case '"':
+            fputs("\\\"", out);
+            break;
+        case '\n':
+            fputs("\\n", out);
+            break;
+        case '\t':
+            fputs("\\t", out);
+            break;
+        default:
+            if (*c < ' ' || *c == 0x7F)
+                fprintf(out, "\\%03o", (u8)*c);
+            else
+                fputc(*c, out);
+            break;
+        }
+    }
+    fputc('"', out);
+}
+
+// the ops that don't touch control flow map straight onto vm_ops.h
+static const char *simple_op(InstructionCode code)
+{
+    switch (code)
+    {
+    case Code_Negate:
+        return "NEGATE_OP()";
+    case Code_Not:
+        return "NOT_OP()";
+    case Code_Add:
+        return "BINARY_OP(+)";
+    case Code_Sub:
+        return "BINARY_OP(-)";
+    case Code_Mul:
+        return "BINARY_OP(*)";
+    case Code_Div:
+        return "BINARY_OP(/)";
+    case Code_Mod:
+        return "MOD_OP()";
+    case Code_Eq:
+        return "EQ_OP(false)";
+    case Code_NotEq:
+        return "EQ_OP(true)";
+    case Code_Greater:
+        return "BINARY_CMP_OP(>)";
+    case Code_GreaterEq:
+        return "BINARY_CMP_OP(>=)";
+    case Code_Less:
+        return "BINARY_CMP_OP(<)";
+    case Code_LessEq:
+        return "BINARY_CMP_OP(<=)";
+    case Code_AddInt:
+        return "INT_OP(+)";
+    case Code_SubInt:
+        return "INT_OP(-)";
+    case Code_MulInt:
+        return "INT_OP(*)";
+    case Code_DivInt:
+        return "INT_OP(/)";
+    case Code_ModInt:
+        return "INT_OP(%)";
+    case Code_AddFloat:
+        return "FLOAT_OP(+)";
+    case Code_SubFloat:
+        return "FLOAT_OP(-)";
+    case Code_MulFloat:
+        return "FLOAT_OP(*)";
+    case Code_DivFloat:
+        return "FLOAT_OP(/)";
+    case Code_GreaterIntInt:
+        return "INT_CMP_OP(>)";
+    case Code_GreaterEqIntInt:
+        return "INT_CMP_OP(>=)";
+    case Code_LessIntInt:
+        return "INT_CMP_OP(<)";
+    case Code_LessEqIntInt:
+        return "INT_CMP_OP(<=)";
+    case Code_GreaterFloatFloat:
+        return "FLOAT_CMP_OP(>)";
+    case Code_GreaterEqFloatFloat:
+        return "FLOAT_CMP_OP(>=)";
+    case Code_LessFloatFloat:
+        return "FLOAT_CMP_OP(<)";
+    case Code_LessEqFloatFloat:
+        return "FLOAT_CMP_OP(<=)";
+    default:
+        return NULL;
+    }
+}
+
+// same contract as the vm: backwards jumps are where a script gets paused if it
+// runs out of budget. the vm counts every instruction it runs, which we can't
+// do cheaply here, so each loop iteration charges the number of instructions
+// in the loop instead
+static void write_jump(FILE *out, u32 ip, u32 target, const u32 *insn_index,
+                       const char *indent)
+{
+    if (target > ip)
+    {
+        fprintf(out, "%sgoto insn_%u;\n", indent, target);
+        return;
+    }
+    u32 cost = insn_index[ip] - insn_index[target] + 1;
+    fprintf(out, "%sexecuted += %u;\n", indent, cost);
+    fprintf(out, "%sif (executed >= vm->budget)\n%s{\n", indent, indent);
+    fprintf(out, "%s    vm->ip = %u;\n", indent, target);
+    fprintf(out, "%s    vm->preempted = true;\n", indent);
+    fprintf(out, "%s    return false;\n%s}\n", indent, indent);
+    fprintf(out, "%sgoto insn_%u;\n", indent, target);
+}
+
+static void translate_event(FILE *out, Event *event, const char *fn_name)
+{
+    u32 len = event->code_len;
+    u32 next;
+
+    // only instructions that something jumps to (or that can be resumed at)
+    // get a label, otherwise we'd drown in unused label warnings
+    bool *is_target = calloc(len + 1, sizeof(bool));
+    // instructions a paused script can pick back up from
+    bool *is_resume = calloc(len + 1, sizeof(bool));
+    // how many instructions come before each one, for working out what a loop
+    // costs
+    u32 *insn_index = calloc(len + 1, sizeof(u32));
+    u32 insn_count = 0;
+    for (u32 ip = 0; ip < len; ip = next)
+    {
+        Instruction insn;
+        next = instruction_decode(event->code, ip, &insn);
+        insn_index[ip] = insn_count++;
+        switch (insn.code)
+        {
+        case Code_Goto:
+        case Code_GotoIfFalse:
+        case Code_GotoIfTrue:
+            is_target[insn.data.position] = true;
+            if (insn.data.position <= ip)
+                is_resume[insn.data.position] = true;
+            break;
+        case Code_Call:
+            is_target[ip] = true;
+            is_resume[ip] = true;
+            break;
+        default:
+            break;
+        }
+    }
+
+    fprintf(out, "// event \"%s\"\n", event->name);
+    fprintf(out, "static bool %s(VM *vm, Resources *resources)\n{\n", fn_name);
+    fprintf(out, "    (void)resources;\n");
+    fprintf(out, "    u32 executed = 0;\n    (void)executed;\n\n");
+
+    // jump back to wherever we yielded or got paused
+    fprintf(out, "    switch (vm->ip)\n    {\n");
+    if (!is_resume[0])
+        fprintf(out, "    case 0:\n        break;\n");
+    for (u32 ip = 0; ip < len; ip = next)
+    {
+        Instruction insn;
+        next = instruction_decode(event->code, ip, &insn);
+        if (is_resume[ip])
+            fprintf(out, "    case %u:\n        goto insn_%u;\n", ip, ip);
+    }
+    fprintf(out, "    default:\n        return true;\n    }\n\n");
+
+    for (u32 ip = 0; ip < len; ip = next)
+    {
+        Instruction insn;
+        next = instruction_decode(event->code, ip, &insn);
+        if (is_target[ip])
+            fprintf(out, "insn_%u:\n", ip);
+
+        const char *op = simple_op(insn.code);
+        if (op)
+        {
+            fprintf(out, "    {\n        %s;\n    }\n", op);
+            continue;
+        }
+
+        switch (insn.code)
+        {
+        case Code_Goto:
+            write_jump(out, ip, insn.data.position, insn_index, "    ");
+            break;
+        case Code_GotoIfFalse:
+        case Code_GotoIfTrue:
+            fprintf(out, "    if (%s(peek(vm, vm->top - 1)))\n    {\n",
+                    insn.code == Code_GotoIfFalse ? "value_is_falsey"
+                                                  : "value_is_truthy");
+            write_jump(out, ip, insn.data.position, insn_index, "        ");
+            fprintf(out, "    }\n");
+            break;
+        case Code_Call:
+            // same contract as the vm: ip points past the call while the
+            // command runs, and back at it if the command yields
+            fprintf(out, "    {\n");
+            fprintf(out, "        // %s\n", COMMAND_NAMES[insn.data.call.command]);
+            fprintf(out, "        Value value = NONE_VAL;\n");
+            fprintf(out, "        vm->ip = %u;\n", next);
+            fprintf(out,
+                    "        if (COMMANDS[%u].fn(vm, &value, %u, resources))\n",
+                    insn.data.call.command, insn.data.call.arg_count);
+            fprintf(out, "        {\n            vm->ip = %u;\n", ip);
+            fprintf(out, "            return false;\n        }\n");
+            // commands only ever move the ip to exit the event
+            fprintf(out, "        if (vm->ip != %u)\n", next);
+            fprintf(out, "            return true;\n");
+            fprintf(out, "        push(vm, value);\n    }\n");
+            break;
+        case Code_Pop:
+            fprintf(out, "    pop(vm);\n");
+            break;
+        case Code_Fetch:
+            fprintf(out, "    push(vm, vm->slots[%u]);\n", insn.data.slot);
+            break;
+        case Code_Set:
+            fprintf(out, "    vm->slots[%u] = peek(vm, vm->top - 1);\n",
+                    insn.data.slot);
+            break;
+        case Code_FetchGlobal:
+        case Code_SetGlobal:
+        {
+            // the index in the bytecode is only good for this run of the
+            // translator, but the event's list of globals is in the same order
+            // every time
+            u32 local = 0;
+            while (event->globals[local] != insn.data.global)
+                local++;
+            fprintf(out, "    // $%s\n", global_name(insn.data.global));
+            if (insn.code == Code_FetchGlobal)
+                fprintf(out,
+                        "    push(vm, resources->globals.values[vm->event."
+                        "globals[%u]]);\n",
+                        local);
+            else
+                fprintf(out,
+                        "    resources->globals.values[vm->event.globals[%u]] "
+                        "= peek(vm, vm->top - 1);\n",
+                        local);
+            break;
+        }
+        case Code_Int:
+            fprintf(out, "    push(vm, INT_VAL(%d));\n", insn.data._int);
+            break;
+        case Code_Float:
+        {
+            // hex floats round trip exactly
+            f32 value = event->constants[insn.data.constant].data._float;
+            fprintf(out, "    push(vm, FLOAT_VAL((f32)%a));\n", (f64)value);
+            break;
+        }
+        case Code_String:
+        {
+            // strings need to be the interned copy, so they come from the
+            // event's constants rather than a literal
+            const char *value = event->constants[insn.data.constant].data.string;
+            fprintf(out, "    // ");
+            write_string_literal(out, value);
+            fprintf(out, "\n    push(vm, vm->event.constants[%u]);\n",
+                    insn.data.constant);
+            break;
+        }
+        case Code_True:
+            fprintf(out, "    push(vm, TRUE_VAL);\n");
+            break;
+        case Code_False:
+            fprintf(out, "    push(vm, FALSE_VAL);\n");
+            break;
+        case Code_None:
+            fprintf(out, "    push(vm, NONE_VAL);\n");
+            break;
+        default:
+            fprintf(stderr, "Unhandled instruction %d in event %s\n",
+                    insn.code, event->name);
+            exit(1);
+        }
+    }
+
+    if (is_target[len])
+        fprintf(out, "insn_%u:\n", len);
+    fprintf(out, "    vm->ip = %u;\n    return true;\n}\n\n", len);
+
+    free(is_target);
+    free(is_resume);
+    free(insn_index);
+}
+
+typedef struct
+{
+    char *name;
+    char *fn_name;
+    u32 source;
+} TranslatedEvent;
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <output.c> <script> [scripts...]\n",
+                argv[0]);
+        return 1;
+    }
+
+    FILE *out = fopen(argv[1], "w");
+    if (!out)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(out, "// generated by event_aot. do not edit!\n\n");
+    fprintf(out, "#include \"events/aot.h\"\n");
+    fprintf(out, "#include \"events/commands/commands.h\"\n");
+    fprintf(out, "#include \"events/vm_ops.h\"\n\n");
+
+    u32 source_count = argc - 2;
+    u64 *hashes = malloc(source_count * sizeof(u64));
+
+    vec translated;
+    vec_init(&translated, sizeof(TranslatedEvent));
+
+    for (u32 i = 0; i < source_count; i++)
+    {
+        char *source = read_file(argv[i + 2]);
+        hashes[i] = aot_source_hash(source);
+
+        Compiler compiler;
+        compiler_init(&compiler, source);
+
+        Event event;
+        u32 index = 0;
+        while (compiler_compile(&compiler, &event))
+        {
+            char fn_name[64];
+            snprintf(fn_name, sizeof(fn_name), "aot_event_%u_%u", i, index);
+            translate_event(out, &event, fn_name);
+
+            TranslatedEvent entry = {
+                .name = strdup(event.name),
+                .fn_name = strdup(fn_name),
+                .source = i,
+            };
+            vec_push(&translated, &entry);
+
+            event_free(&event);
+            index++;
+        }
+        if (compiler.failed)
+        {
+            fprintf(stderr, "%s:%u: %s\n", argv[i + 2], compiler.error_line,
+                    compiler.error);
+            exit(1);
+        }
+
+        free(source);
+    }
+
+    fprintf(out, "const AotSource AOT_SOURCES[] = {\n");
+    for (u32 i = 0; i < source_count; i++)
+    {
+        fprintf(out, "    {");
+        write_string_literal(out, argv[i + 2]);
+        fprintf(out, ", 0x%016llxull},\n", (unsigned long long)hashes[i]);
+    }
+    fprintf(out, "};\n");
+    fprintf(out, "const u32 AOT_SOURCE_COUNT = %u;\n\n", source_count);
+
+    fprintf(out, "const AotEvent AOT_EVENTS[] = {\n");
+    for (u32 i = 0; i < translated.len; i++)
+    {
+        TranslatedEvent *entry = vec_get(&translated, i);
+        fprintf(out, "    {");
+        write_string_literal(out, entry->name);
+        fprintf(out, ", %u, %s},\n", entry->source, entry->fn_name);
+        free(entry->name);
+        free(entry->fn_name);
+    }
+    // C doesn't allow empty arrays
+    if (translated.len == 0)
+        fprintf(out, "    {NULL, 0, NULL},\n");
+    fprintf(out, "};\n");
+    fprintf(out, "const u32 AOT_EVENT_COUNT = %u;\n", (u32)translated.len);
+
+    vec_free(&translated);
+    free(hashes);
+    fclose(out);
+
+    return 0;
+}